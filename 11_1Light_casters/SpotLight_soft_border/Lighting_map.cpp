@@ -2,6 +2,7 @@
 #include "stb_image.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -33,8 +34,9 @@ bool firstMouse = true;
 float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
 
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
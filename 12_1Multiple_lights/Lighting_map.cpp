@@ -2,7 +2,10 @@
 #include "stb_image.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -10,12 +13,18 @@
 
 #include "shader_m.h"
 #include "Camera_Class.h"
+#include "profiler.h"
+#include "dynamic_resolution.h"
+#include "frame_scheduler.h"
+#include "frame_pacer.h"
 
 using namespace std;
 void processInput(GLFWwindow *window);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+void printSchedulerStats(const char *name, const FrameSchedulerStats &stats);
 
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
@@ -31,9 +40,92 @@ Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 bool firstMouse = true;
 float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
 
-
-int main()
+// 按需渲染 --on-demand 时打开 回调函数中标记画面变化
+FrameScheduler scheduler(false);
+// P 暂停箱子的旋转
+bool paused = false;
+
+// 用法:
+//   ./Lighting_map.o                          原来的场景
+//   ./Lighting_map.o --profile                每5秒输出各阶段CPU和GPU耗时的 min/avg/p99
+//   ./Lighting_map.o --trace trace.json       退出时写出 Chrome trace_event 格式的时间线
+//   ./Lighting_map.o --dynamic-resolution 33  动态分辨率 每帧的目标GPU时间33毫秒 每秒输出缩放和GPU时间
+//   ./Lighting_map.o --min-scale 0.25         动态分辨率的最小缩放 默认0.5
+//   ./Lighting_map.o --sharpen                放大之后按局部对比度锐化 默认只用双线性
+//   ./Lighting_map.o --resolution-log res.csv 退出时写出每次调整的GPU时间和缩放
+//   ./Lighting_map.o --on-demand              按需渲染 画面没有变化时等待事件 P 暂停旋转
+//   ./Lighting_map.o --paused                 开始时暂停旋转
+//   ./Lighting_map.o --measure-idle 10        按需渲染 暂停10秒再旋转10秒 输出每分钟醒来的次数和画出的帧数
+//   ./Lighting_map.o --fps 60                 限制帧率 先睡眠再自旋等到每帧的截止时间 deltaTime 做平滑
+//   ./Lighting_map.o --pacing sleep           等待的方式 hybrid(默认) sleep spin
+//   ./Lighting_map.o --swap-interval 1        glfwSwapInterval 默认不设置
+//   ./Lighting_map.o --pacing-report          退出时输出帧间隔的统计 直方图和掉帧数
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
+    bool profile = false;
+    const char *tracePath = NULL;
+    bool dynamic = false;
+    bool sharpen = false;
+    const char *resolutionLogPath = NULL;
+    ResolutionSettings resolutionSettings;
+    double measureSeconds = 0.0;
+    bool pacing = false;
+    double targetFps = 0.0;
+    PacingMode pacingMode = PACING_HYBRID;
+    int swapInterval = -1;
+    bool pacingReport = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--profile") == 0)
+            profile = true;
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+        else if (strcmp(argv[i], "--dynamic-resolution") == 0 && i + 1 < argc)
+        {
+            dynamic = true;
+            resolutionSettings.TargetMs = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--min-scale") == 0 && i + 1 < argc)
+            resolutionSettings.MinScale = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--sharpen") == 0)
+            sharpen = true;
+        else if (strcmp(argv[i], "--resolution-log") == 0 && i + 1 < argc)
+            resolutionLogPath = argv[++i];
+        else if (strcmp(argv[i], "--on-demand") == 0)
+            scheduler.Enabled = true;
+        else if (strcmp(argv[i], "--paused") == 0)
+            paused = true;
+        else if (strcmp(argv[i], "--measure-idle") == 0 && i + 1 < argc)
+        {
+            scheduler.Enabled = true;
+            paused = true;
+            measureSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+        {
+            pacing = true;
+            targetFps = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "sleep") == 0)
+                pacingMode = PACING_SLEEP;
+            else if (strcmp(argv[i], "spin") == 0)
+                pacingMode = PACING_SPIN;
+            else
+                pacingMode = PACING_HYBRID;
+        }
+        else if (strcmp(argv[i], "--swap-interval") == 0 && i + 1 < argc)
+            swapInterval = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pacing-report") == 0)
+        {
+            pacing = true;
+            pacingReport = true;
+        }
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -50,6 +142,7 @@ int main()
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
     // 注册鼠标滚轮的回调函数
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -205,18 +298,97 @@ int main()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // 分析器中有查询对象 要在 glfwTerminate 之前释放 所以在堆上创建
+    Profiler *profiler = new Profiler();
+    profiler->Enabled = profile || tracePath != NULL;
+    float lastReport = 0.0f;
+
+    // 动态分辨率有FBO和查询对象 同样在堆上创建
+    DynamicResolution *dynamicResolution = NULL;
+    if (dynamic)
+        dynamicResolution = new DynamicResolution(SCR_WIDTH, SCR_HEIGHT, resolutionSettings, sharpen, "./upscale.vs", "./upscale.fs");
+    float lastResolutionReport = 0.0f;
+    // 帧率限制 只有 --pacing-report 时 TargetFps 为0 只统计帧间隔
+    FramePacer *pacer = NULL;
+    if (pacing)
+        pacer = new FramePacer(targetFps, pacingMode);
+    if (swapInterval >= 0)
+        glfwSwapInterval(swapInterval);
+
+    // 箱子旋转的时间 暂停时不变 没有暂停过时等于 glfwGetTime()
+    float animationTime = 0.0f;
+    float animationOffset = 0.0f;
+    // --measure-idle: 第0段暂停 第1段旋转 每段结束时输出统计
+    // 段的结束由另一个线程唤醒 不用 RedrawAt 空闲的一段里调度器没有定时 一直在 glfwWaitEvents 中
+    int measurePhase = 0;
+    double phaseEnd = measureSeconds;
+    WakeupTimer *phaseTimer = NULL;
+    if (measureSeconds > 0.0)
+    {
+        phaseTimer = new WakeupTimer();
+        phaseTimer->WakeAt(scheduler, phaseEnd);
+    }
+
     while(!glfwWindowShouldClose(window))
     {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        if (pacer)
+            deltaTime = pacer->SmoothDelta(deltaTime);
+        if (paused)
+            animationOffset = currentFrame - animationTime;
+        else
+            animationTime = currentFrame - animationOffset;
+
+        if (measureSeconds > 0.0 && scheduler.Now() >= phaseEnd)
+        {
+            printSchedulerStats(measurePhase == 0 ? "idle" : "animated", scheduler.Stats());
+            if (++measurePhase == 2)
+            {
+                glfwSetWindowShouldClose(window, true);
+                continue;
+            }
+            paused = false;
+            phaseEnd += measureSeconds;
+            phaseTimer->WakeAt(scheduler, phaseEnd);
+            scheduler.ResetStats();
+        }
+
+        // 按需渲染: 先处理输入 画面没有变化时等待事件 不画这一帧
+        if (scheduler.Enabled)
+        {
+            processInput(window);
+            scheduler.TrackCamera(camera);
+            scheduler.SetAnimating(!paused);
+            if (!scheduler.ShouldRender())
+            {
+                scheduler.Wait();
+                // 等待的时间不算作上一帧的时间 否则醒来后第一次移动会跳一大步
+                lastFrame = glfwGetTime();
+                if (pacer)
+                    pacer->Restart();
+                continue;
+            }
+        }
+
+        profiler->BeginFrame();
+        // 之后的绘制都画到缩小的FBO中
+        if (dynamicResolution)
+            dynamicResolution->BeginFrame();
         // 输入
-        processInput(window);
+        if (!scheduler.Enabled)
+        {
+            CPUScope scope(*profiler, "input");
+            processInput(window);
+        }
 
         // 渲染
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        profiler->BeginCPU("uniforms");
+        profiler->BeginGPU("uniforms");
         CubeShader.use();
         CubeShader.setVec3("viewPos", camera.Position);
         CubeShader.setFloat("material.shininess", 32.0f);
@@ -287,37 +459,95 @@ int main()
         glBindTexture(GL_TEXTURE_2D, diffuseMap);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, specularMap);
+        profiler->EndGPU();
+        profiler->EndCPU();
 
-        glBindVertexArray(cubeVAO);
-        for(unsigned int i = 0; i < 10; i++)
         {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, cubePositions[i]);
-            float angle = 20.0f * i + 10.0f;
-            model = glm::rotate(model, (float)glfwGetTime() * glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            CubeShader.setMat4("model", model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            CPUScope cpuScope(*profiler, "cube pass");
+            GPUScope gpuScope(*profiler, "cube pass");
+            glBindVertexArray(cubeVAO);
+            for(unsigned int i = 0; i < 10; i++)
+            {
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, cubePositions[i]);
+                float angle = 20.0f * i + 10.0f;
+                model = glm::rotate(model, animationTime * glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+                CubeShader.setMat4("model", model);
+
+                glDrawArrays(GL_TRIANGLES, 0, 36);
+            }
         }
 
 
-        glBindVertexArray(lightVAO);
-        for(int i = 0; i < 4; i++)
         {
-        LightShader.use();
-        LightShader.setMat4("projection", projection);
-        LightShader.setMat4("view", view);
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, pointLightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
-            LightShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            CPUScope cpuScope(*profiler, "light pass");
+            GPUScope gpuScope(*profiler, "light pass");
+            glBindVertexArray(lightVAO);
+            for(int i = 0; i < 4; i++)
+            {
+            LightShader.use();
+            LightShader.setMat4("projection", projection);
+            LightShader.setMat4("view", view);
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, pointLightPositions[i]);
+                model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
+                LightShader.setMat4("model", model);
+                glDrawArrays(GL_TRIANGLES, 0, 36);
+            }
+        }
+
+        if (dynamicResolution)
+        {
+            CPUScope cpuScope(*profiler, "upscale");
+            GPUScope gpuScope(*profiler, "upscale");
+            dynamicResolution->Upscale();
         }
 
         // 交换缓冲并查询IO事件
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            CPUScope scope(*profiler, "swap");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        if (pacer)
+        {
+            CPUScope scope(*profiler, "pace");
+            pacer->Wait();
+        }
+        if (dynamicResolution)
+            dynamicResolution->EndFrame();
+        profiler->EndFrame();
+
+        if (dynamicResolution && currentFrame - lastResolutionReport >= 1.0f)
+        {
+            cout << "scale " << dynamicResolution->Scale() << " (" << dynamicResolution->ScaledWidth() << "x"
+                 << dynamicResolution->ScaledHeight() << "), GPU " << dynamicResolution->GpuMs() << " ms, target "
+                 << resolutionSettings.TargetMs << " ms" << endl;
+            lastResolutionReport = currentFrame;
+        }
+
+        if (profile && currentFrame - lastReport >= 5.0f)
+        {
+            profiler->Print(cout);
+            lastReport = currentFrame;
+        }
     }
+    if (measureSeconds > 0.0 && measurePhase < 2)
+        printSchedulerStats(measurePhase == 0 ? "idle" : "animated", scheduler.Stats());
+    else if (scheduler.Enabled && measureSeconds <= 0.0)
+        printSchedulerStats("on-demand", scheduler.Stats());
+    if (pacingReport)
+        pacer->Print(cout);
+    delete pacer;
+    delete phaseTimer;
+    if (profile)
+        profiler->Print(cout);
+    if (tracePath)
+        profiler->WriteTrace(tracePath);
+    delete profiler;
+    if (dynamicResolution && resolutionLogPath)
+        dynamicResolution->WriteLog(resolutionLogPath);
+    delete dynamicResolution;
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteVertexArrays(1, &lightVAO);
     glDeleteBuffers(1, &VBO);
@@ -330,6 +560,28 @@ int main()
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    scheduler.Invalidate();
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+    {
+        paused = !paused;
+        scheduler.Invalidate();
+    }
+}
+
+void printSchedulerStats(const char *name, const FrameSchedulerStats &stats)
+{
+    cout << name << ": " << stats.seconds << " s, " << stats.wakeups << " wakeups (" << stats.WakeupsPerMinute()
+         << "/min), " << stats.frames << " frames (" << stats.FramesPerMinute() << "/min)";
+    for (unsigned int i = 0; i < REDRAW_REASONS; i++)
+    {
+        if (stats.reasonFrames[i])
+            cout << ", " << RedrawReasonName(i) << " " << stats.reasonFrames[i];
+    }
+    cout << endl;
 }
 
 void processInput(GLFWwindow *window)
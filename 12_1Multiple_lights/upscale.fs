@@ -0,0 +1,37 @@
+// 把动态分辨率的场景放大到窗口
+// 场景只画在纹理左下角 uvScale 的区域 定义 SHARPEN 时双线性放大之后再按局部对比度锐化
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D scene;
+uniform vec2 uvScale;      // 画出的区域占纹理的比例
+uniform vec2 texelSize;    // 1 / 纹理大小
+uniform vec2 outputSize;   // 窗口大小
+
+// 锐化的强度 0到1
+const float SHARPNESS = 0.5;
+
+vec3 fetch(vec2 uv)
+{
+    // 离区域的边缘至少半个像素 双线性不会读到上一帧留在区域外的内容
+    return texture(scene, clamp(uv, 0.5 * texelSize, uvScale - 0.5 * texelSize)).rgb;
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / outputSize * uvScale;
+    vec3 color = fetch(uv);
+#ifdef SHARPEN
+    vec3 up = fetch(uv + vec2(0.0, texelSize.y));
+    vec3 down = fetch(uv - vec2(0.0, texelSize.y));
+    vec3 left = fetch(uv - vec2(texelSize.x, 0.0));
+    vec3 right = fetch(uv + vec2(texelSize.x, 0.0));
+    vec3 lo = min(color, min(min(up, down), min(left, right)));
+    vec3 hi = max(color, max(max(up, down), max(left, right)));
+    // 周围的差别小时锐化多 接近0或1(强边缘)时锐化少 结果不会超出周围的范围太多
+    vec3 amount = sqrt(clamp(min(lo, 1.0 - hi) / max(hi, 1.0e-4), 0.0, 1.0));
+    vec3 weight = -amount * mix(0.125, 0.2, SHARPNESS);
+    color = clamp((color + (up + down + left + right) * weight) / (1.0 + 4.0 * weight), 0.0, 1.0);
+#endif
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,547 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cfloat>
+#include <random>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "vertex_format.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+vector<float> makeRandomVertices(unsigned int vertexCount);
+int checkErrorBounds(const float *vertices, unsigned int vertexCount);
+void bandwidthBenchmark(const float *vertices, unsigned int vertexCount);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+float vertices[] = {
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+    0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f,
+    0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+    0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+    0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+    0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+    0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+    0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+    0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+    0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f,
+    0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+    0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f,
+    0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f,
+    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+    0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f
+};
+
+// 用法:
+//   ./Vertex_compression.o              以unorm16位置运行12_1的场景
+//   ./Vertex_compression.o --half       以half位置运行
+//   ./Vertex_compression.o --check      检验编解码误差是否在理论上界内 不需要窗口
+//   ./Vertex_compression.o --bench      对比32字节与16字节顶点的取顶点带宽
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    Position_Format format = POSITION_UNORM16;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--half") == 0)
+            format = POSITION_HALF;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--check") == 0)
+        {
+            vector<float> randomVertices = makeRandomVertices(100000);
+            return checkErrorBounds(randomVertices.data(), 100000);
+        }
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Vertex compression", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    if (bench)
+    {
+        bandwidthBenchmark(vertices, 36);
+        glfwTerminate();
+        return 0;
+    }
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+    glm::vec3 pointLightPositions[] = {
+        glm::vec3( 0.7f,  0.2f,  2.0f),
+        glm::vec3( 2.3f, -3.3f, -4.0f),
+        glm::vec3(-4.0f,  2.0f, -12.0f),
+        glm::vec3( 0.0f,  0.0f, -3.0f)
+    };
+
+    // 把32字节的顶点压缩成16字节
+    PackedMesh cube(vertices, 36, format);
+
+    unsigned int VBO, cubeVAO;
+    glGenVertexArrays(1, &cubeVAO);
+    glGenBuffers(1, &VBO);
+
+    glBindVertexArray(cubeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, cube.SizeInBytes(), cube.Vertices.data(), GL_STATIC_DRAW);
+    // 步长不再是 8 * sizeof(float) 而是 sizeof(PackedVertex)
+    cube.SetupAttributes();
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+    cube.SetDecodeUniforms(CubeShader);
+
+    LightShader.use();
+    LightShader.setVec3("positionMin", cube.PositionMin);
+    LightShader.setVec3("positionExtent", cube.PositionExtent);
+
+    unsigned int lightVAO;
+    glGenVertexArrays(1, &lightVAO);
+    glBindVertexArray(lightVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    cube.SetupPositionAttribute();
+
+    while(!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        CubeShader.use();
+        CubeShader.setVec3("viewPos", camera.Position);
+        CubeShader.setFloat("material.shininess", 32.0f);
+        // 定向光源
+        CubeShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+        CubeShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+        CubeShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+        CubeShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+        // 点光源
+        for (int i = 0; i < 4; i++)
+        {
+            string name = "pointLights[" + to_string(i) + "]";
+            CubeShader.setVec3(name + ".position", pointLightPositions[i]);
+            CubeShader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+            CubeShader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+            CubeShader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+            CubeShader.setFloat(name + ".constant", 1.0f);
+            CubeShader.setFloat(name + ".linear", 0.09f);
+            CubeShader.setFloat(name + ".quadratic", 0.032f);
+        }
+        // 聚光
+        CubeShader.setVec3("spotLight.position", camera.Position);
+        CubeShader.setVec3("spotLight.direction", camera.Front);
+        CubeShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+        CubeShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+        CubeShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+        CubeShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+        CubeShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+        CubeShader.setMat4("projection", projection);
+        CubeShader.setMat4("view", view);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+
+        glBindVertexArray(cubeVAO);
+        for(unsigned int i = 0; i < 10; i++)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, cubePositions[i]);
+            float angle = 20.0f * i + 10.0f;
+            model = glm::rotate(model, (float)glfwGetTime() * glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+            CubeShader.setMat4("model", model);
+
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        glBindVertexArray(lightVAO);
+        for(int i = 0; i < 4; i++)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, pointLightPositions[i]);
+            model = glm::scale(model, glm::vec3(0.2f));
+            LightShader.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    glDeleteVertexArrays(1, &cubeVAO);
+    glDeleteVertexArrays(1, &lightVAO);
+    glDeleteBuffers(1, &VBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+// 误差检验
+// 对立方体的顶点和大量随机方向的法线做 编码->解码 比较与原始值的最大误差
+// 任何一项超过理论上界就返回非0
+// 立方体的坐标(±0.5)和纹理坐标(0或1)都能精确编码 测不出误差
+// 检查用不以原点为中心 各轴长度不同的包围盒中的伪随机顶点 纹理坐标和法线也是随机的
+vector<float> makeRandomVertices(unsigned int vertexCount)
+{
+    mt19937 random(20240601);
+    uniform_real_distribution<float> x(-3.7f, 12.3f), y(0.2f, 0.9f), z(-250.0f, -40.0f), unit(0.0f, 1.0f);
+    normal_distribution<float> gauss(0.0f, 1.0f);
+    vector<float> result(vertexCount * 8);
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        float *v = &result[i * 8];
+        glm::vec3 n(gauss(random), gauss(random), gauss(random));
+        n = glm::length(n) > 1e-6f ? glm::normalize(n) : glm::vec3(0.0f, 0.0f, 1.0f);
+        v[0] = x(random); v[1] = y(random); v[2] = z(random);
+        v[3] = n.x; v[4] = n.y; v[5] = n.z;
+        v[6] = unit(random); v[7] = unit(random);
+    }
+    return result;
+}
+
+// half 最近舍入 误差不超过半个ulp: |x| 在 [2^e, 2^(e+1)) 时为 2^(e-11) 小于最小正规数 2^-14 时按 2^-14 算
+float halfFloatErrorBound(float x)
+{
+    int exponent;
+    frexpf(fabsf(x), &exponent);
+    return ldexpf(1.0f, glm::max(exponent - 1, -14) - 11);
+}
+
+// 每个顶点的每个分量与它自己的理论上界比较:
+//   half:    半个ulp
+//   unorm16: 包围盒尺寸 / 65535 / 2
+//   纹理坐标: 1 / 65535 / 2
+// 解码时的float运算(min + t * extent)另外允许几个float的ulp
+int checkErrorBounds(const float *vertices, unsigned int vertexCount)
+{
+    int failed = 0;
+    glm::vec3 boundsMin(vertices[0], vertices[1], vertices[2]), boundsMax = boundsMin;
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        glm::vec3 p(vertices[i * 8], vertices[i * 8 + 1], vertices[i * 8 + 2]);
+        boundsMin = glm::min(boundsMin, p);
+        boundsMax = glm::max(boundsMax, p);
+    }
+    glm::vec3 extent = boundsMax - boundsMin;
+    glm::vec3 decodeSlack = (glm::abs(boundsMin) + extent) * (4.0f * FLT_EPSILON);
+    float uvBound = 0.5f / 65535.0f + 4.0f * FLT_EPSILON;
+    cout << vertexCount << " random vertices, bounds (" << boundsMin.x << ", " << boundsMin.y << ", " << boundsMin.z << ") - ("
+         << boundsMax.x << ", " << boundsMax.y << ", " << boundsMax.z << ")" << endl;
+
+    Position_Format formats[] = { POSITION_HALF, POSITION_UNORM16 };
+    const char *names[] = { "half", "unorm16" };
+    for (int f = 0; f < 2; f++)
+    {
+        PackedMesh mesh(vertices, vertexCount, formats[f]);
+        // 误差除以上界 不超过1为通过
+        float posRatio = 0.0f, uvRatio = 0.0f;
+        float posError = 0.0f, uvError = 0.0f;
+        float normalError = 0.0f;
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const float *v = vertices + i * 8;
+            glm::vec3 p(v[0], v[1], v[2]);
+            glm::vec3 error = glm::abs(mesh.DecodePosition(i) - p);
+            for (int k = 0; k < 3; k++)
+            {
+                float bound = formats[f] == POSITION_HALF ? halfFloatErrorBound(p[k]) : extent[k] * (0.5f / 65535.0f) + decodeSlack[k];
+                posRatio = glm::max(posRatio, error[k] / bound);
+                posError = glm::max(posError, error[k]);
+            }
+            glm::vec2 uv = glm::abs(mesh.DecodeTexCoords(i) - glm::vec2(v[6], v[7]));
+            uvRatio = glm::max(uvRatio, glm::max(uv.x, uv.y) / uvBound);
+            uvError = glm::max(uvError, glm::max(uv.x, uv.y));
+            float d = glm::clamp(glm::dot(mesh.DecodeNormal(i), glm::vec3(v[3], v[4], v[5])), -1.0f, 1.0f);
+            normalError = glm::max(normalError, acosf(d));
+        }
+        bool ok = posRatio <= 1.0f && uvRatio <= 1.0f && normalError <= PackedMesh::NormalErrorBound();
+        cout << names[f] << " position error " << posError << " (" << posRatio * 100.0f << "% of bound)"
+             << "  uv error " << uvError << " (" << uvRatio * 100.0f << "% of bound)"
+             << "  normal error " << normalError << " rad" << (ok ? "  PASS" : "  FAIL") << endl;
+        if (!ok)
+            failed = 1;
+    }
+
+    // 球面上均匀分布的法线 黄金角螺旋采样
+    float maxAngle = 0.0f;
+    const int samples = 1000000;
+    for (int i = 0; i < samples; i++)
+    {
+        float z = 1.0f - 2.0f * (i + 0.5f) / samples;
+        float r = sqrtf(1.0f - z * z);
+        float phi = i * 2.39996323f;
+        glm::vec3 n(r * cosf(phi), r * sinf(phi), z);
+        float d = glm::clamp(glm::dot(UnpackNormal(PackNormal(n)), n), -1.0f, 1.0f);
+        maxAngle = glm::max(maxAngle, acosf(d));
+    }
+    bool ok = maxAngle <= PackedMesh::NormalErrorBound();
+    cout << "octahedral normal max error " << glm::degrees(maxAngle) << " deg over " << samples
+         << " samples (bound " << glm::degrees(PackedMesh::NormalErrorBound()) << " deg)"
+         << (ok ? "  PASS" : "  FAIL") << endl;
+    if (!ok)
+        failed = 1;
+    return failed;
+}
+
+// 带宽对比
+// 把立方体复制成一个很大的网格 分别用32字节和16字节的顶点绘制
+// 视口只有1x1 光栅化几乎没有开销 时间主要花在取顶点和顶点着色上
+void bandwidthBenchmark(const float *vertices, unsigned int vertexCount)
+{
+    const int gridSize = 64;
+    const int layers = 8;
+    std::vector<float> big;
+    big.reserve((size_t)gridSize * gridSize * layers * vertexCount * 8);
+    for (int z = 0; z < layers; z++)
+        for (int y = 0; y < gridSize; y++)
+            for (int x = 0; x < gridSize; x++)
+                for (unsigned int i = 0; i < vertexCount; i++)
+                {
+                    const float *v = vertices + i * 8;
+                    big.push_back(v[0] + x * 1.5f);
+                    big.push_back(v[1] + y * 1.5f);
+                    big.push_back(v[2] - z * 1.5f);
+                    for (int c = 3; c < 8; c++)
+                        big.push_back(v[c]);
+                }
+    unsigned int bigCount = (unsigned int)(big.size() / 8);
+
+    Shader rawShader("./shader2.vs", "./shader.fs");
+    Shader packedShader("./shader.vs", "./shader.fs");
+
+    unsigned int VAO[3], VBO[3];
+    glGenVertexArrays(3, VAO);
+    glGenBuffers(3, VBO);
+
+    glBindVertexArray(VAO[0]);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+    glBufferData(GL_ARRAY_BUFFER, big.size() * sizeof(float), big.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+
+    PackedMesh halfMesh(big.data(), bigCount, POSITION_HALF);
+    PackedMesh unormMesh(big.data(), bigCount, POSITION_UNORM16);
+    const PackedMesh *packed[] = { &halfMesh, &unormMesh };
+    for (int i = 0; i < 2; i++)
+    {
+        glBindVertexArray(VAO[i + 1]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[i + 1]);
+        glBufferData(GL_ARRAY_BUFFER, packed[i]->SizeInBytes(), packed[i]->Vertices.data(), GL_STATIC_DRAW);
+        packed[i]->SetupAttributes();
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(48.0f, 48.0f, 150.0f), glm::vec3(48.0f, 48.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glViewport(0, 0, 1, 1);
+
+    const char *names[] = { "float32 (32 bytes)", "half    (16 bytes)", "unorm16 (16 bytes)" };
+    size_t strides[] = { 8 * sizeof(float), sizeof(PackedVertex), sizeof(PackedVertex) };
+    const int frames = 100;
+    unsigned int query;
+    glGenQueries(1, &query);
+
+    cout << bigCount << " vertices, " << frames << " draws each" << endl;
+    for (int i = 0; i < 3; i++)
+    {
+        Shader &shader = i == 0 ? rawShader : packedShader;
+        shader.use();
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+        shader.setMat4("model", glm::mat4(1.0f));
+        if (i > 0)
+            packed[i - 1]->SetDecodeUniforms(shader);
+        glBindVertexArray(VAO[i]);
+
+        // 预热一次 避免首次绘制的驱动开销
+        glDrawArrays(GL_TRIANGLES, 0, bigCount);
+        glFinish();
+
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        for (int f = 0; f < frames; f++)
+            glDrawArrays(GL_TRIANGLES, 0, bigCount);
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+        double ms = elapsed / 1.0e6 / frames;
+        double bytes = (double)bigCount * strides[i];
+        cout << names[i] << ": " << ms << " ms/draw, "
+             << bytes / (1024.0 * 1024.0) << " MB fetched, "
+             << bytes / (elapsed / 1.0e9 / frames) / 1.0e9 << " GB/s" << endl;
+    }
+
+    glDeleteQueries(1, &query);
+    glDeleteVertexArrays(3, VAO);
+    glDeleteBuffers(3, VBO);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,16 @@
+// 灯的顶点着色器 只需要解码位置
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 positionMin;
+uniform vec3 positionExtent;
+
+void main()
+{
+    vec3 position = positionMin + aPos * positionExtent;
+    gl_Position = projection * view * model * vec4(position, 1.0);
+}
@@ -0,0 +1,43 @@
+// 压缩顶点格式的顶点着色器
+// 位置: half 或 unorm16 在包围盒内归一化 需要用 positionMin/positionExtent 还原
+// 法线: 八面体编码存在 GL_INT_2_10_10_10_REV 的 x y 两个10位分量中
+// 纹理坐标: unorm16 在uv范围内归一化
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform vec3 positionMin;
+uniform vec3 positionExtent;
+uniform vec2 texCoordMin;
+uniform vec2 texCoordExtent;
+
+// 八面体解码 与 vertex_format.h 中的 OctDecode 一致
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 position = positionMin + aPos * positionExtent;
+    // 法线属性以非归一化整数读取 [-511, 511]
+    vec3 normal = OctDecode(clamp(aNormal.xy / 511.0, -1.0, 1.0));
+
+    FragPos = vec3(model * vec4(position, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+    Normal = mat3(transpose(inverse(model))) * normal;
+    TexCoords = texCoordMin + aTexCoords * texCoordExtent;
+}
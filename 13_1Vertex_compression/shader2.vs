@@ -0,0 +1,27 @@
+// 未压缩的32字节顶点格式 与12_1相同
+// 只在带宽对比测试中使用
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+
+// 需要片段的位置
+// 需要在世界空间中进行所有的光照计算
+// 因此需要一个在世界空间中顶点位置
+// 可以通过把所有顶点位置属性乘以模型矩阵来将其变换到世界空间坐标
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoords = aTexCoords;
+}
@@ -0,0 +1,511 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "instanced_renderer.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+vector<glm::vec3> makeCubePositions(unsigned int count);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 一帧所需的全部对象
+struct Scene {
+    Shader *CubeShader;
+    Shader *LightShader;
+    Shader *LoopCubeShader;
+    Shader *LoopLightShader;
+    unsigned int cubeVAO, lightVAO;
+    unsigned int loopCubeVAO, loopLightVAO;
+    unsigned int diffuseMap, specularMap;
+    InstancedRenderer *Cubes;
+    InstancedRenderer *Lights;
+    vector<glm::vec3> Positions;
+};
+
+void renderInstanced(Scene &scene, float time);
+void renderLoop(Scene &scene, float time);
+void benchmark(GLFWwindow *window, Scene &scene);
+
+// 用法:
+//   ./Instancing.o                 实例化绘制12_1的场景
+//   ./Instancing.o --count 100000  绘制更多的箱子 前10个与12_1相同 其余随机分布
+//   ./Instancing.o --loop          使用原来的逐个物体绘制 用于对比
+//   ./Instancing.o --bench         从10到1000000个箱子 输出两种方式的帧时间
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int count = 10;
+    bool loop = false;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--loop") == 0)
+            loop = true;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Instancing", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+    Shader LoopCubeShader("./shader2.vs", "./shader.fs");
+    Shader LoopLightShader("./light2.vs", "./light.fs");
+
+    float vertices[] = {
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    // 实例化与逐个绘制各用一套VAO 共享同一个VBO
+    unsigned int VAOs[4];
+    glGenVertexArrays(4, VAOs);
+    for (int i = 0; i < 4; i++)
+    {
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // 灯的VAO只需要位置
+        if (i % 2 == 0)
+        {
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+            glEnableVertexAttribArray(2);
+        }
+    }
+
+    // 实例缓冲在这个作用域结束时析构 此时上下文仍然有效
+    {
+        InstancedRenderer cubes(1024);
+        InstancedRenderer lights(4);
+        cubes.AttachTo(VAOs[0]);
+        lights.AttachTo(VAOs[1], 3, false);
+
+        Scene scene;
+        scene.CubeShader = &CubeShader;
+        scene.LightShader = &LightShader;
+        scene.LoopCubeShader = &LoopCubeShader;
+        scene.LoopLightShader = &LoopLightShader;
+        scene.cubeVAO = VAOs[0];
+        scene.lightVAO = VAOs[1];
+        scene.loopCubeVAO = VAOs[2];
+        scene.loopLightVAO = VAOs[3];
+        scene.diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+        scene.specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+        scene.Cubes = &cubes;
+        scene.Lights = &lights;
+        scene.Positions = makeCubePositions(count);
+
+        Shader *cubeShaders[] = { &CubeShader, &LoopCubeShader };
+        for (int i = 0; i < 2; i++)
+        {
+            cubeShaders[i]->use();
+            cubeShaders[i]->setInt("material.diffuse", 0);
+            cubeShaders[i]->setInt("material.specular", 1);
+        }
+
+        if (bench)
+            benchmark(window, scene);
+
+        while(!bench && !glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            if (loop)
+                renderLoop(scene, currentFrame);
+            else
+                renderInstanced(scene, currentFrame);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+    }
+    glDeleteVertexArrays(4, VAOs);
+    glDeleteBuffers(1, &VBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+// 前10个位置与12_1相同 之后的在一个随箱子数量增大的立方体区域内随机分布
+vector<glm::vec3> makeCubePositions(unsigned int count)
+{
+    vector<glm::vec3> positions;
+    positions.reserve(count);
+    for (unsigned int i = 0; i < count && i < 10; i++)
+        positions.push_back(cubePositions[i]);
+
+    float halfSize = 2.0f * cbrtf((float)count);
+    unsigned int seed = 12345u;
+    while (positions.size() < count)
+    {
+        glm::vec3 p;
+        for (int c = 0; c < 3; c++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            p[c] = ((seed >> 8) / 16777216.0f * 2.0f - 1.0f) * halfSize;
+        }
+        p.z -= halfSize;
+        positions.push_back(p);
+    }
+    return positions;
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+glm::mat4 cubeModel(const glm::vec3 &position, unsigned int i, float time)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, position);
+    float angle = 20.0f * (i % 10) + 10.0f;
+    model = glm::rotate(model, time * glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    return model;
+}
+
+// 实例化: 所有箱子一次绘制 所有灯一次绘制
+void renderInstanced(Scene &scene, float time)
+{
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+
+    scene.CubeShader->use();
+    setLightUniforms(*scene.CubeShader);
+    scene.CubeShader->setMat4("projection", projection);
+    scene.CubeShader->setMat4("view", view);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.diffuseMap);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.specularMap);
+
+    scene.Cubes->Clear();
+    for (unsigned int i = 0; i < scene.Positions.size(); i++)
+        scene.Cubes->Add(cubeModel(scene.Positions[i], i, time));
+    scene.Cubes->Upload();
+    scene.Cubes->Draw(scene.cubeVAO, GL_TRIANGLES, 0, 36);
+
+    scene.LightShader->use();
+    scene.LightShader->setMat4("projection", projection);
+    scene.LightShader->setMat4("view", view);
+    scene.Lights->Clear();
+    for (int i = 0; i < 4; i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, pointLightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.2f));
+        scene.Lights->Add(model);
+    }
+    scene.Lights->Upload();
+    scene.Lights->Draw(scene.lightVAO, GL_TRIANGLES, 0, 36);
+}
+
+// 与12_1相同的逐个物体绘制
+void renderLoop(Scene &scene, float time)
+{
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+
+    scene.LoopCubeShader->use();
+    setLightUniforms(*scene.LoopCubeShader);
+    scene.LoopCubeShader->setMat4("projection", projection);
+    scene.LoopCubeShader->setMat4("view", view);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.diffuseMap);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.specularMap);
+
+    glBindVertexArray(scene.loopCubeVAO);
+    for (unsigned int i = 0; i < scene.Positions.size(); i++)
+    {
+        scene.LoopCubeShader->setMat4("model", cubeModel(scene.Positions[i], i, time));
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    scene.LoopLightShader->use();
+    scene.LoopLightShader->setMat4("projection", projection);
+    scene.LoopLightShader->setMat4("view", view);
+    glBindVertexArray(scene.loopLightVAO);
+    for (int i = 0; i < 4; i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, pointLightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.2f));
+        scene.LoopLightShader->setMat4("model", model);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+}
+
+// 帧时间测试
+// CPU: 计算矩阵 上传 提交绘制命令所用的时间
+// 帧: 再加上 glFinish 等待GPU画完的总时间
+// 逐个绘制在十万以上时太慢 不再测试
+void benchmark(GLFWwindow *window, Scene &scene)
+{
+    unsigned int counts[] = { 10, 100, 1000, 10000, 100000, 1000000 };
+    camera.Position = glm::vec3(0.0f, 0.0f, 3.0f);
+
+    cout << "cubes      mode        cpu ms    frame ms" << endl;
+    for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        scene.Positions = makeCubePositions(counts[c]);
+        int frames = counts[c] >= 100000 ? 5 : 30;
+        for (int mode = 0; mode < 2; mode++)
+        {
+            if (mode == 1 && counts[c] > 100000)
+                continue;
+            double cpuTotal = 0.0, frameTotal = 0.0;
+            // 第一帧用于预热 不计入
+            for (int f = 0; f <= frames; f++)
+            {
+                auto start = chrono::steady_clock::now();
+                if (mode == 0)
+                    renderInstanced(scene, (float)glfwGetTime());
+                else
+                    renderLoop(scene, (float)glfwGetTime());
+                auto submitted = chrono::steady_clock::now();
+                glFinish();
+                auto finished = chrono::steady_clock::now();
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                if (f == 0)
+                    continue;
+                cpuTotal += chrono::duration<double, milli>(submitted - start).count();
+                frameTotal += chrono::duration<double, milli>(finished - start).count();
+            }
+            cout.width(10);
+            cout << left << counts[c] << " " << (mode == 0 ? "instanced" : "loop     ") << "   ";
+            cout.width(9);
+            cout << cpuTotal / frames << " ";
+            cout.width(9);
+            cout << frameTotal / frames << endl;
+        }
+    }
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,426 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "gl_ext.h"
+#include "mesh.h"
+#include "mesh_batcher.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+GLFWwindow *createWindow(bool allowModernContext);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 场景中的一个物体: 使用哪个网格 放在哪里
+struct Object {
+    unsigned int mesh;
+    glm::vec3 position;
+    float angle;
+};
+
+vector<Object> makeObjects(unsigned int count, unsigned int meshCount);
+glm::mat4 objectModel(const Object &object, float time);
+
+// 用法:
+//   ./Multi_draw_indirect.o                 1000个由5种网格组成的物体 一次绘制调用
+//   ./Multi_draw_indirect.o --count 20000   更多的物体
+//   ./Multi_draw_indirect.o --gl33          强制使用3.3的上下文 走逐个绘制的退回路径
+//   ./Multi_draw_indirect.o --bench         对比逐个绘制与多重间接绘制的CPU提交时间 100 1000 10000个物体 --count 大于10000时再加一行
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int count = 1000;
+    bool modernContext = true;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--gl33") == 0)
+            modernContext = false;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+    }
+
+    glfwInit();
+    GLFWwindow* window = createWindow(modernContext);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    // glad只加载了3.3的函数 多重间接绘制和持久映射需要额外加载
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    // 有的驱动即使请求3.3也会返回更高版本的上下文 这里当作3.3处理
+    if (!modernContext)
+        glext = GLExt();
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    // 批处理器在这个作用域结束时析构 此时上下文仍然有效
+    {
+        // 所有网格放进同一个大缓冲
+        vector<MeshData> meshes;
+        meshes.push_back(MakeCube());
+        meshes.push_back(MakeSphere());
+        meshes.push_back(MakeCylinder());
+        meshes.push_back(MakeTorus());
+        meshes.push_back(MakePyramid());
+
+        // --bench 从100测到10000个物体 物体和批处理器按测到的最大数量准备
+        unsigned int objectCount = bench && count < 10000 ? 10000 : count;
+        unsigned int maxDraws = objectCount > 4 ? objectCount : 4;
+        MeshBatcher batcher(maxDraws);
+        for (unsigned int i = 0; i < meshes.size(); i++)
+            batcher.AddMesh(meshes[i]);
+        batcher.Build();
+
+        MeshBatcher lightBatcher(4);
+        unsigned int lightMesh = lightBatcher.AddMesh(meshes[0]);
+        lightBatcher.Build();
+
+        cout << "OpenGL " << glext.Major << "." << glext.Minor << ", "
+             << (batcher.UseMultiDraw ? "glMultiDrawElementsIndirect" : "glDrawElementsBaseVertex fallback")
+             << (batcher.Persistent ? ", persistent mapped buffers" : "") << endl;
+
+        Shader CubeShader(batcher.UseMultiDraw ? "./shader.vs" : "./shader330.vs", "./shader.fs");
+        Shader LightShader(batcher.UseMultiDraw ? "./light.vs" : "./light330.vs", "./light.fs");
+
+        unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+        unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+        CubeShader.use();
+        CubeShader.setInt("material.diffuse", 0);
+        CubeShader.setInt("material.specular", 1);
+
+        vector<Object> objects = makeObjects(objectCount, (unsigned int)meshes.size());
+
+        if (bench)
+        {
+            // 逐个绘制需要的每个网格自己的VAO 与章节中的写法相同
+            vector<unsigned int> VAOs(meshes.size()), VBOs(meshes.size()), EBOs(meshes.size());
+            for (unsigned int i = 0; i < meshes.size(); i++)
+                UploadMesh(meshes[i], VAOs[i], VBOs[i], EBOs[i]);
+            Shader LoopShader("./shader2.vs", "./shader.fs");
+            LoopShader.use();
+            LoopShader.setInt("material.diffuse", 0);
+            LoopShader.setInt("material.specular", 1);
+
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 200.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, diffuseMap);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, specularMap);
+
+            const int frames = 20;
+            cout << "draws      per-draw cpu ms   multi-draw cpu ms   per-draw frame ms   multi-draw frame ms" << endl;
+            unsigned int counts[] = { 100, 1000, 10000, count };
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                unsigned int n = counts[c];
+                // 最后一行只在 --count 大于10000时测
+                if (c == 3 && n <= 10000)
+                    break;
+                double cpu[2] = { 0.0, 0.0 }, total[2] = { 0.0, 0.0 };
+                for (int mode = 0; mode < 2; mode++)
+                {
+                    Shader &shader = mode == 0 ? LoopShader : CubeShader;
+                    shader.use();
+                    setLightUniforms(shader);
+                    shader.setMat4("projection", projection);
+                    shader.setMat4("view", view);
+                    for (int f = 0; f <= frames; f++)
+                    {
+                        float time = (float)glfwGetTime();
+                        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                        auto start = chrono::steady_clock::now();
+                        if (mode == 0)
+                        {
+                            unsigned int bound = ~0u;
+                            for (unsigned int i = 0; i < n; i++)
+                            {
+                                const Object &object = objects[i];
+                                if (object.mesh != bound)
+                                {
+                                    glBindVertexArray(VAOs[object.mesh]);
+                                    bound = object.mesh;
+                                }
+                                shader.setMat4("model", objectModel(object, time));
+                                glDrawElements(GL_TRIANGLES, (GLsizei)meshes[object.mesh].indices.size(), GL_UNSIGNED_INT, 0);
+                            }
+                        }
+                        else
+                        {
+                            batcher.Begin();
+                            for (unsigned int i = 0; i < n; i++)
+                                batcher.Draw(objects[i].mesh, objectModel(objects[i], time));
+                            batcher.Submit(shader);
+                        }
+                        auto submitted = chrono::steady_clock::now();
+                        glFinish();
+                        auto finished = chrono::steady_clock::now();
+                        glfwSwapBuffers(window);
+                        glfwPollEvents();
+                        // 第一帧预热
+                        if (f == 0)
+                            continue;
+                        cpu[mode] += chrono::duration<double, milli>(submitted - start).count();
+                        total[mode] += chrono::duration<double, milli>(finished - start).count();
+                    }
+                }
+                cout.width(10);
+                cout << left << n << " ";
+                cout.width(17);
+                cout << cpu[0] / frames << " ";
+                cout.width(19);
+                cout << cpu[1] / frames << " ";
+                cout.width(19);
+                cout << total[0] / frames << " ";
+                cout << total[1] / frames << endl;
+            }
+            for (unsigned int i = 0; i < meshes.size(); i++)
+            {
+                glDeleteVertexArrays(1, &VAOs[i]);
+                glDeleteBuffers(1, &VBOs[i]);
+                glDeleteBuffers(1, &EBOs[i]);
+            }
+        }
+
+        while(!bench && !glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 200.0f);
+            glm::mat4 view = camera.GetViewMatrix();
+
+            CubeShader.use();
+            setLightUniforms(CubeShader);
+            CubeShader.setMat4("projection", projection);
+            CubeShader.setMat4("view", view);
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, diffuseMap);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, specularMap);
+
+            // 记录所有物体 一次提交
+            batcher.Begin();
+            for (unsigned int i = 0; i < objects.size(); i++)
+                batcher.Draw(objects[i].mesh, objectModel(objects[i], currentFrame));
+            batcher.Submit(CubeShader);
+
+            LightShader.use();
+            LightShader.setMat4("projection", projection);
+            LightShader.setMat4("view", view);
+            lightBatcher.Begin();
+            for (int i = 0; i < 4; i++)
+            {
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, pointLightPositions[i]);
+                model = glm::scale(model, glm::vec3(0.2f));
+                lightBatcher.Draw(lightMesh, model);
+            }
+            lightBatcher.Submit(LightShader);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+// 依次尝试更高版本的上下文 驱动不支持时 glfwCreateWindow 返回NULL 再降低版本
+GLFWwindow *createWindow(bool allowModernContext)
+{
+    int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+    for (int i = allowModernContext ? 0 : 3; i < 4; i++)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, versions[i][0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, versions[i][1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Multi draw indirect", NULL, NULL);
+        if (window != NULL)
+            return window;
+    }
+    return NULL;
+}
+
+// 物体排成一个立方体网格 网格种类轮流使用
+vector<Object> makeObjects(unsigned int count, unsigned int meshCount)
+{
+    vector<Object> objects(count);
+    unsigned int side = 1;
+    while (side * side * side < count)
+        side++;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int x = i % side, y = (i / side) % side, z = i / (side * side);
+        objects[i].mesh = i % meshCount;
+        objects[i].position = glm::vec3((x - side * 0.5f) * 1.5f, (y - side * 0.5f) * 1.5f, -2.0f - z * 1.5f);
+        objects[i].angle = 20.0f * (i % 10) + 10.0f;
+    }
+    return objects;
+}
+
+glm::mat4 objectModel(const Object &object, float time)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, object.position);
+    model = glm::rotate(model, time * glm::radians(object.angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    return model;
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
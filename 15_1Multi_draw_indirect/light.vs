@@ -0,0 +1,16 @@
+// 多重间接绘制的灯 只需要模型矩阵
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer drawData;
+
+void main()
+{
+    int base = gl_DrawIDARB * 7;
+    mat4 model = mat4(texelFetch(drawData, base), texelFetch(drawData, base + 1),
+                      texelFetch(drawData, base + 2), texelFetch(drawData, base + 3));
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
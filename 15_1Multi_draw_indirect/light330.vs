@@ -0,0 +1,16 @@
+// 不支持多重间接绘制时的灯
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer drawData;
+uniform int drawID;
+
+void main()
+{
+    int base = drawID * 7;
+    mat4 model = mat4(texelFetch(drawData, base), texelFetch(drawData, base + 1),
+                      texelFetch(drawData, base + 2), texelFetch(drawData, base + 3));
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,32 @@
+// 多重间接绘制的顶点着色器
+// 一次 glMultiDrawElementsIndirect 中的每条命令有自己的 gl_DrawID
+// 用它从缓冲纹理中取出这次绘制的模型矩阵与法线矩阵
+// GL 4.6 中直接叫 gl_DrawID 这里用 GL_ARB_shader_draw_parameters 提供的 gl_DrawIDARB 兼容4.3~4.5的驱动
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+// 每次绘制7个texel: 模型矩阵4列 法线矩阵3列
+uniform samplerBuffer drawData;
+
+void main()
+{
+    int base = gl_DrawIDARB * 7;
+    mat4 model = mat4(texelFetch(drawData, base), texelFetch(drawData, base + 1),
+                      texelFetch(drawData, base + 2), texelFetch(drawData, base + 3));
+    mat3 normalMatrix = mat3(texelFetch(drawData, base + 4).xyz, texelFetch(drawData, base + 5).xyz,
+                             texelFetch(drawData, base + 6).xyz);
+
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+    Normal = normalMatrix * aNormal;
+    TexCoords = aTexCoords;
+}
@@ -0,0 +1,29 @@
+// 不支持多重间接绘制时的顶点着色器
+// 每次绘制前由CPU设置 drawID 代替 gl_DrawID 其余与 shader.vs 相同
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer drawData;
+uniform int drawID;
+
+void main()
+{
+    int base = drawID * 7;
+    mat4 model = mat4(texelFetch(drawData, base), texelFetch(drawData, base + 1),
+                      texelFetch(drawData, base + 2), texelFetch(drawData, base + 3));
+    mat3 normalMatrix = mat3(texelFetch(drawData, base + 4).xyz, texelFetch(drawData, base + 5).xyz,
+                             texelFetch(drawData, base + 6).xyz);
+
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+    Normal = normalMatrix * aNormal;
+    TexCoords = aTexCoords;
+}
@@ -0,0 +1,567 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+
+#include <sys/resource.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "model_loader.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+bool generateModel(const char *path, unsigned int triangles, bool binary);
+int benchmark(const char *path, unsigned int threads);
+bool loadObjNaive(const char *path, MeshData &mesh);
+glm::mat4 fitModel(const MeshData &mesh);
+double peakMemoryMB();
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 用法:
+//   ./Model_loading.o model.obj                          导入模型并显示
+//   ./Model_loading.o model.ply --threads 4              指定解析线程数 默认使用全部核心
+//   ./Model_loading.o --generate big.obj 2000000         生成一个约两百万个三角形的测试模型
+//   ./Model_loading.o --generate big.ply 2000000 --binary 生成二进制PLY
+//   ./Model_loading.o --bench big.obj                    测量不同线程数的解析速度(MB/s)与内存峰值
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    const char *path = NULL;
+    const char *generatePath = NULL;
+    unsigned int generateTriangles = 1000000;
+    unsigned int threads = 0;
+    bool binary = false;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc)
+        {
+            generatePath = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                generateTriangles = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--binary") == 0)
+            binary = true;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else
+            path = argv[i];
+    }
+
+    // 生成与测速都不需要窗口
+    if (generatePath)
+        return generateModel(generatePath, generateTriangles, binary) ? 0 : -1;
+    if (path == NULL)
+    {
+        cout << "usage: ./Model_loading.o model.obj|model.ply [--threads N] [--bench]" << endl;
+        cout << "       ./Model_loading.o --generate out.obj|out.ply [triangles] [--binary]" << endl;
+        return -1;
+    }
+    if (bench)
+        return benchmark(path, threads);
+
+    auto start = chrono::steady_clock::now();
+    MeshData model;
+    if (!LoadModel(path, model, threads))
+        return -1;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << path << ": " << model.VertexCount() << " vertices, " << model.indices.size() / 3 << " triangles, "
+         << seconds * 1000.0 << " ms" << endl;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Model loading", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    // 导入的网格与其他章节的网格一样 交给 UploadMesh 生成VAO
+    unsigned int modelVAO, modelVBO, modelEBO;
+    UploadMesh(model, modelVAO, modelVBO, modelEBO);
+    GLsizei modelIndexCount = (GLsizei)model.indices.size();
+    // 模型缩放到原点附近一个单位大小
+    glm::mat4 modelMatrix = fitModel(model);
+    // 数据已经在显存里了
+    MeshData().vertices.swap(model.vertices);
+    MeshData().indices.swap(model.indices);
+
+    MeshData cube = MakeCube();
+    unsigned int lightVAO, lightVBO, lightEBO;
+    UploadMesh(cube, lightVAO, lightVBO, lightEBO);
+
+    Shader ModelShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+    ModelShader.use();
+    ModelShader.setInt("material.diffuse", 0);
+    ModelShader.setInt("material.specular", 1);
+
+    while(!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        ModelShader.use();
+        setLightUniforms(ModelShader);
+        ModelShader.setMat4("projection", projection);
+        ModelShader.setMat4("view", view);
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), currentFrame * glm::radians(20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        ModelShader.setMat4("model", rotation * modelMatrix);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+
+        glBindVertexArray(modelVAO);
+        glDrawElements(GL_TRIANGLES, modelIndexCount, GL_UNSIGNED_INT, 0);
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        glBindVertexArray(lightVAO);
+        for (int i = 0; i < 4; i++)
+        {
+            glm::mat4 lightModel = glm::mat4(1.0f);
+            lightModel = glm::translate(lightModel, pointLightPositions[i]);
+            lightModel = glm::scale(lightModel, glm::vec3(0.2f));
+            LightShader.setMat4("model", lightModel);
+            glDrawElements(GL_TRIANGLES, (GLsizei)cube.indices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glDeleteVertexArrays(1, &modelVAO);
+    glDeleteBuffers(1, &modelVBO);
+    glDeleteBuffers(1, &modelEBO);
+    glDeleteVertexArrays(1, &lightVAO);
+    glDeleteBuffers(1, &lightVBO);
+    glDeleteBuffers(1, &lightEBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+// 以包围盒中心为原点 最长边缩放为2
+glm::mat4 fitModel(const MeshData &mesh)
+{
+    glm::vec3 minimum(1e30f), maximum(-1e30f);
+    for (size_t i = 0; i < mesh.vertices.size(); i += 8)
+    {
+        glm::vec3 p(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]);
+        minimum = glm::min(minimum, p);
+        maximum = glm::max(maximum, p);
+    }
+    glm::vec3 extent = maximum - minimum;
+    float size = glm::max(extent.x, glm::max(extent.y, extent.z));
+    float scale = size > 0.0f ? 2.0f / size : 1.0f;
+    glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(scale));
+    return glm::translate(model, -(minimum + maximum) * 0.5f);
+}
+
+// 峰值常驻内存 Linux上 ru_maxrss 的单位是KB
+double peakMemoryMB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// 生成一个表面有起伏的球 三角形数约为 triangles
+// OBJ 中 v vt vn 使用相同的编号 PLY 中每个顶点带法线和纹理坐标
+bool generateModel(const char *path, unsigned int triangles, bool binary)
+{
+    string name(path);
+    bool ply = name.size() > 4 && name.substr(name.size() - 4) == ".ply";
+    unsigned int rings = 2;
+    while (4ull * rings * rings < triangles)
+        rings++;
+    unsigned int sectors = rings * 2;
+    unsigned int vertexCount = (rings + 1) * (sectors + 1);
+    unsigned int triangleCount = rings * sectors * 2;
+
+    FILE *file = fopen(path, binary ? "wb" : "w");
+    if (file == NULL)
+    {
+        cout << "ERROR::MODEL::FILE_NOT_SUCCESFULLY_WRITTEN " << path << endl;
+        return false;
+    }
+    if (ply)
+    {
+        fprintf(file, "ply\nformat %s 1.0\ncomment Model_loading --generate\n", binary ? "binary_little_endian" : "ascii");
+        fprintf(file, "element vertex %u\n", vertexCount);
+        fprintf(file, "property float x\nproperty float y\nproperty float z\n");
+        fprintf(file, "property float nx\nproperty float ny\nproperty float nz\n");
+        fprintf(file, "property float u\nproperty float v\n");
+        fprintf(file, "element face %u\nproperty list uchar int vertex_indices\nend_header\n", triangleCount);
+    }
+    else
+    {
+        fprintf(file, "# Model_loading --generate %u triangles\no sphere\n", triangleCount);
+    }
+
+    const float PI = 3.14159265358979f;
+    for (unsigned int r = 0; r <= rings; r++)
+    {
+        float phi = PI * r / rings;
+        for (unsigned int s = 0; s <= sectors; s++)
+        {
+            float theta = 2.0f * PI * s / sectors;
+            glm::vec3 direction(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta));
+            float radius = 1.0f + 0.05f * sin(theta * 12.0f) * sin(phi * 9.0f);
+            glm::vec3 p = direction * radius;
+            glm::vec2 uv((float)s / sectors * 4.0f, (float)r / rings * 2.0f);
+            if (ply && binary)
+            {
+                float values[8] = { p.x, p.y, p.z, direction.x, direction.y, direction.z, uv.x, uv.y };
+                fwrite(values, sizeof(float), 8, file);
+            }
+            else if (ply)
+                fprintf(file, "%.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f\n", p.x, p.y, p.z, direction.x, direction.y, direction.z, uv.x, uv.y);
+            else
+                fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", p.x, p.y, p.z, uv.x, uv.y, direction.x, direction.y, direction.z);
+        }
+    }
+    for (unsigned int r = 0; r < rings; r++)
+    {
+        for (unsigned int s = 0; s < sectors; s++)
+        {
+            unsigned int a = r * (sectors + 1) + s;
+            unsigned int b = a + sectors + 1;
+            unsigned int faces[2][3] = { { a, a + 1, b }, { a + 1, b + 1, b } };
+            for (int f = 0; f < 2; f++)
+            {
+                if (ply && binary)
+                {
+                    unsigned char count = 3;
+                    int indices[3] = { (int)faces[f][0], (int)faces[f][1], (int)faces[f][2] };
+                    fwrite(&count, 1, 1, file);
+                    fwrite(indices, sizeof(int), 3, file);
+                }
+                else if (ply)
+                    fprintf(file, "3 %u %u %u\n", faces[f][0], faces[f][1], faces[f][2]);
+                else
+                    fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n",
+                            faces[f][0] + 1, faces[f][0] + 1, faces[f][0] + 1,
+                            faces[f][1] + 1, faces[f][1] + 1, faces[f][1] + 1,
+                            faces[f][2] + 1, faces[f][2] + 1, faces[f][2] + 1);
+            }
+        }
+    }
+    long size = ftell(file);
+    fclose(file);
+    cout << path << ": " << vertexCount << " vertices, " << triangleCount << " triangles, "
+         << size / (1024.0 * 1024.0) << " MB" << endl;
+    return true;
+}
+
+// 教程里常见的写法: ifstream 逐行读取 再用 stringstream 拆分
+// 只用来对比速度和检查结果
+bool loadObjNaive(const char *path, MeshData &mesh)
+{
+    ifstream file(path);
+    if (!file)
+        return false;
+    vector<glm::vec3> positions, normals;
+    vector<glm::vec2> texCoords;
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    string line;
+    while (getline(file, line))
+    {
+        istringstream stream(line);
+        string type;
+        stream >> type;
+        if (type == "v")
+        {
+            glm::vec3 p;
+            stream >> p.x >> p.y >> p.z;
+            positions.push_back(p);
+        }
+        else if (type == "vt")
+        {
+            glm::vec2 uv;
+            stream >> uv.x >> uv.y;
+            texCoords.push_back(uv);
+        }
+        else if (type == "vn")
+        {
+            glm::vec3 n;
+            stream >> n.x >> n.y >> n.z;
+            normals.push_back(n);
+        }
+        else if (type == "f")
+        {
+            // 只处理 v/vt/vn 三个编号相同的三角形 即 --generate 生成的文件
+            string corner;
+            while (stream >> corner)
+            {
+                int index = atoi(corner.c_str()) - 1;
+                mesh.indices.push_back((unsigned int)index);
+            }
+        }
+    }
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        glm::vec3 n = i < normals.size() ? normals[i] : glm::vec3(0.0f);
+        glm::vec2 uv = i < texCoords.size() ? texCoords[i] : glm::vec2(0.0f);
+        mesh.AddVertex(positions[i], n, uv);
+    }
+    return true;
+}
+
+int benchmark(const char *path, unsigned int threads)
+{
+    double sizeMB;
+    {
+        MappedFile file(path);
+        if (!file.IsOpen())
+        {
+            cout << "ERROR::MODEL::FILE_NOT_SUCCESFULLY_READ " << path << endl;
+            return -1;
+        }
+        sizeMB = file.Size / (1024.0 * 1024.0);
+    }
+    double baseMemory = peakMemoryMB();
+
+    // 先用全部线程导入一次 此时的峰值内存只包含这一次导入
+    MeshData reference;
+    auto start = chrono::steady_clock::now();
+    if (!LoadModel(path, reference, threads))
+        return -1;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double meshMB = (reference.vertices.size() * sizeof(float) + reference.indices.size() * sizeof(unsigned int)) / (1024.0 * 1024.0);
+    cout << path << ": " << sizeMB << " MB, " << reference.VertexCount() << " vertices, "
+         << reference.indices.size() / 3 << " triangles" << endl;
+    cout << "mesh data " << meshMB << " MB, peak memory " << peakMemoryMB() << " MB (" << baseMemory << " MB before loading)" << endl;
+    cout << LoaderThreadCount(threads) << " threads: " << seconds * 1000.0 << " ms, " << sizeMB / seconds << " MB/s" << endl;
+
+    const int runs = 3;
+    double fastest = seconds;
+    cout << "threads    ms          MB/s" << endl;
+    vector<unsigned int> threadCounts;
+    unsigned int maxThreads = LoaderThreadCount(threads);
+    for (unsigned int t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    for (unsigned int i = 0; i < threadCounts.size(); i++)
+    {
+        unsigned int t = threadCounts[i];
+        double best = 1e30;
+        for (int run = 0; run < runs; run++)
+        {
+            MeshData mesh;
+            auto begin = chrono::steady_clock::now();
+            LoadModel(path, mesh, t);
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            if (elapsed < best)
+                best = elapsed;
+            if (elapsed < fastest)
+                fastest = elapsed;
+            if (mesh.vertices != reference.vertices || mesh.indices != reference.indices)
+            {
+                cout << "ERROR::MODEL::RESULT_DEPENDS_ON_THREAD_COUNT " << t << endl;
+                return -1;
+            }
+        }
+        cout.width(10);
+        cout << left << t << " ";
+        cout.width(11);
+        cout << best * 1000.0 << " " << sizeMB / best << endl;
+    }
+
+    // ifstream + stringstream 的写法作为对照 结果应当一致
+    string name(path);
+    if (name.size() > 4 && name.substr(name.size() - 4) == ".obj")
+    {
+        MeshData naive;
+        auto begin = chrono::steady_clock::now();
+        if (!loadObjNaive(path, naive))
+            return -1;
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        cout << "ifstream + stringstream: " << elapsed * 1000.0 << " ms, " << sizeMB / elapsed << " MB/s, "
+             << elapsed / fastest << "x slower" << endl;
+
+        // 法线由生成的文件给出 与快速解析的结果逐个比较
+        float maxError = 0.0f;
+        bool sameTopology = naive.indices == reference.indices && naive.vertices.size() == reference.vertices.size();
+        for (size_t i = 0; sameTopology && i < naive.vertices.size(); i++)
+            maxError = glm::max(maxError, glm::abs(naive.vertices[i] - reference.vertices[i]));
+        cout << "compared with ifstream: " << (sameTopology ? "same indices" : "DIFFERENT indices")
+             << ", max attribute difference " << maxError << endl;
+        if (!sameTopology || maxError > 1e-6f)
+            return -1;
+    }
+    return 0;
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
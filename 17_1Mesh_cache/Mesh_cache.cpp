@@ -0,0 +1,433 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "model_loader.h"
+#include "mesh_cache.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+string cachePathFor(const string &path);
+int benchmark(const char *path, int runs);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 用法:
+//   ./Mesh_cache.o model.obj                        使用 model.obj.mesh 缓存 不存在或过期时先生成
+//   ./Mesh_cache.o model.mesh                       直接打开缓存
+//   ./Mesh_cache.o --convert model.ply model.mesh   转换工具 把OBJ/PLY写成缓存
+//   ./Mesh_cache.o --bench model.obj                对比文本导入与缓存的加载时间(含上传到VBO)
+// 测试用的大模型可以用 ../16_1Model_loading 的 --generate 生成
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    const char *path = NULL;
+    const char *convertSource = NULL;
+    const char *convertTarget = NULL;
+    bool bench = false;
+    int runs = 5;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--convert") == 0 && i + 2 < argc)
+        {
+            convertSource = argv[++i];
+            convertTarget = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            runs = atoi(argv[++i]);
+        else
+            path = argv[i];
+    }
+
+    // 转换不需要窗口
+    if (convertSource)
+    {
+        auto start = chrono::steady_clock::now();
+        if (!ConvertToMeshCache(convertSource, convertTarget))
+            return -1;
+        MeshCache cache(convertTarget);
+        if (!cache.IsValid())
+            return -1;
+        cout << convertTarget << ": " << cache.VertexCount() << " vertices, " << cache.IndexCount() / 3 << " triangles, "
+             << cache.SizeInBytes() / (1024.0 * 1024.0) << " MB, "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+        return 0;
+    }
+    if (path == NULL)
+    {
+        cout << "usage: ./Mesh_cache.o model.obj|model.ply|model.mesh [--bench [--runs N]]" << endl;
+        cout << "       ./Mesh_cache.o --convert model.obj model.mesh" << endl;
+        return -1;
+    }
+
+    // 模型文件自动使用旁边的缓存
+    string cachePath = cachePathFor(path);
+    if (!bench && cachePath != path && MeshCacheIsStale(cachePath.c_str(), path))
+    {
+        cout << "converting " << path << " -> " << cachePath << endl;
+        if (!ConvertToMeshCache(path, cachePath.c_str()))
+            return -1;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Mesh cache", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    if (bench)
+    {
+        int result = benchmark(path, runs);
+        glfwTerminate();
+        return result;
+    }
+
+    // 映射文件 直接上传 之后映射就可以释放了
+    unsigned int modelVAO, modelVBO, modelEBO;
+    GLsizei modelIndexCount;
+    glm::mat4 modelMatrix;
+    {
+        auto start = chrono::steady_clock::now();
+        MeshCache *cache = new MeshCache(cachePath.c_str());
+        // 文件头正确但内容损坏时 从模型文件重新生成一次 映射要先释放
+        if (!cache->IsValid() && cachePath != path)
+        {
+            delete cache;
+            cache = NULL;
+            cout << "converting " << path << " -> " << cachePath << endl;
+            if (ConvertToMeshCache(path, cachePath.c_str()))
+                cache = new MeshCache(cachePath.c_str());
+        }
+        if (cache == NULL || !cache->IsValid())
+        {
+            delete cache;
+            glfwTerminate();
+            return -1;
+        }
+        cache->Upload(modelVAO, modelVBO, modelEBO);
+        glFinish();
+        cout << cachePath << ": " << cache->VertexCount() << " vertices, " << cache->IndexCount() / 3 << " triangles, "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+        // 整个模型只绘制第0级细节
+        modelIndexCount = (GLsizei)cache->Lod(0).indexCount;
+        // 包围盒存在文件里 不需要遍历顶点
+        glm::vec3 extent = cache->BoundsMax() - cache->BoundsMin();
+        float size = glm::max(extent.x, glm::max(extent.y, extent.z));
+        modelMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(size > 0.0f ? 2.0f / size : 1.0f));
+        modelMatrix = glm::translate(modelMatrix, -(cache->BoundsMin() + cache->BoundsMax()) * 0.5f);
+        delete cache;
+    }
+
+    MeshData cube = MakeCube();
+    unsigned int lightVAO, lightVBO, lightEBO;
+    UploadMesh(cube, lightVAO, lightVBO, lightEBO);
+
+    Shader ModelShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+    ModelShader.use();
+    ModelShader.setInt("material.diffuse", 0);
+    ModelShader.setInt("material.specular", 1);
+
+    while(!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        ModelShader.use();
+        setLightUniforms(ModelShader);
+        ModelShader.setMat4("projection", projection);
+        ModelShader.setMat4("view", view);
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), currentFrame * glm::radians(20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        ModelShader.setMat4("model", rotation * modelMatrix);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+
+        glBindVertexArray(modelVAO);
+        glDrawElements(GL_TRIANGLES, modelIndexCount, GL_UNSIGNED_INT, 0);
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        glBindVertexArray(lightVAO);
+        for (int i = 0; i < 4; i++)
+        {
+            glm::mat4 lightModel = glm::mat4(1.0f);
+            lightModel = glm::translate(lightModel, pointLightPositions[i]);
+            lightModel = glm::scale(lightModel, glm::vec3(0.2f));
+            LightShader.setMat4("model", lightModel);
+            glDrawElements(GL_TRIANGLES, (GLsizei)cube.indices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glDeleteVertexArrays(1, &modelVAO);
+    glDeleteBuffers(1, &modelVBO);
+    glDeleteBuffers(1, &modelEBO);
+    glDeleteVertexArrays(1, &lightVAO);
+    glDeleteBuffers(1, &lightVBO);
+    glDeleteBuffers(1, &lightEBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+// model.obj -> model.obj.mesh  已经是 .mesh 的保持不变
+string cachePathFor(const string &path)
+{
+    if (path.size() > 5 && path.substr(path.size() - 5) == ".mesh")
+        return path;
+    return path + ".mesh";
+}
+
+// 两种方式都从文件开始 到数据进入VBO(glFinish)为止
+// 文件在系统的页缓存中 测的是解析与复制的开销 而不是磁盘速度
+int benchmark(const char *path, int runs)
+{
+    string cachePath = cachePathFor(path);
+    if (cachePath == path)
+    {
+        cout << "--bench needs the source model (.obj/.ply)" << endl;
+        return -1;
+    }
+    if (!ConvertToMeshCache(path, cachePath.c_str()))
+        return -1;
+
+    double textLoad = 1e30, textUpload = 1e30, cacheLoad = 1e30, cacheUpload = 1e30;
+    unsigned int triangles = 0;
+    size_t textSize = 0, cacheSize = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        unsigned int VAO, VBO, EBO;
+        // 文本导入: 解析成 MeshData 再上传
+        {
+            auto start = chrono::steady_clock::now();
+            MeshData mesh;
+            if (!LoadModel(path, mesh))
+                return -1;
+            auto loaded = chrono::steady_clock::now();
+            UploadMesh(mesh, VAO, VBO, EBO);
+            glFinish();
+            auto uploaded = chrono::steady_clock::now();
+            textLoad = glm::min(textLoad, chrono::duration<double, milli>(loaded - start).count());
+            textUpload = glm::min(textUpload, chrono::duration<double, milli>(uploaded - loaded).count());
+            triangles = (unsigned int)(mesh.indices.size() / 3);
+            MappedFile file(path);
+            textSize = file.Size;
+        }
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+
+        // 缓存: 映射文件 检查文件头 直接上传
+        {
+            auto start = chrono::steady_clock::now();
+            MeshCache cache(cachePath.c_str());
+            if (!cache.IsValid())
+                return -1;
+            auto loaded = chrono::steady_clock::now();
+            cache.Upload(VAO, VBO, EBO);
+            glFinish();
+            auto uploaded = chrono::steady_clock::now();
+            cacheLoad = glm::min(cacheLoad, chrono::duration<double, milli>(loaded - start).count());
+            cacheUpload = glm::min(cacheUpload, chrono::duration<double, milli>(uploaded - loaded).count());
+            cacheSize = cache.SizeInBytes();
+        }
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+    cout << path << ": " << triangles << " triangles, best of " << runs << " runs" << endl;
+    cout << "source       MB        load ms     upload ms   total ms" << endl;
+    double sizes[2] = { textSize / (1024.0 * 1024.0), cacheSize / (1024.0 * 1024.0) };
+    double loads[2] = { textLoad, cacheLoad }, uploads[2] = { textUpload, cacheUpload };
+    const char *names[2] = { "text", "cache" };
+    for (int i = 0; i < 2; i++)
+    {
+        cout.width(12);
+        cout << left << names[i] << " ";
+        cout.width(9);
+        cout << sizes[i] << " ";
+        cout.width(11);
+        cout << loads[i] << " ";
+        cout.width(11);
+        cout << uploads[i] << " ";
+        cout << loads[i] + uploads[i] << endl;
+    }
+    cout << "cache is " << (textLoad + textUpload) / (cacheLoad + cacheUpload) << "x faster" << endl;
+    return 0;
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
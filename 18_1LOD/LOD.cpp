@@ -0,0 +1,483 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "model_loader.h"
+#include "mesh_cache.h"
+#include "mesh_simplify.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 1.5f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 场景中的一个物体 level 是上一帧选择的细节级别
+struct Object {
+    glm::vec3 position;
+    float scale;
+    float angle;
+    unsigned int level;
+};
+
+// 一帧的统计
+struct FrameStats {
+    unsigned long long triangles;
+    unsigned int switches;
+    vector<unsigned int> objectsPerLevel;
+};
+
+vector<Object> makeObjects(unsigned int count);
+glm::mat4 objectModel(const Object &object);
+FrameStats drawObjects(const Shader &shader, vector<Object> &objects, const LodSelector &selector, float radius, bool useLod, bool hysteresis);
+
+// 用法:
+//   ./LOD.o                          一片很多个高精度圆环 按距离选择细节级别
+//   ./LOD.o --count 2500             物体数量
+//   ./LOD.o --nolod                  全部使用原始网格
+//   ./LOD.o --pixel 2                允许的屏幕误差(像素) 默认1
+//   ./LOD.o --model model.obj        使用导入的模型
+//   ./LOD.o --save torus.mesh        把带细节级别的网格写成缓存(见17_1)
+//   ./LOD.o --bench                  相机沿固定路径前后移动 对比不使用LOD 使用LOD 不带滞后的LOD
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int count = 900;
+    bool useLod = true;
+    bool bench = false;
+    float pixelError = 1.0f;
+    const char *modelPath = NULL;
+    const char *savePath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--nolod") == 0)
+            useLod = false;
+        else if (strcmp(argv[i], "--pixel") == 0 && i + 1 < argc)
+            pixelError = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc)
+            modelPath = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            savePath = argv[++i];
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+    }
+
+    // 网格与细节级别在CPU上生成 不需要上下文
+    MeshData mesh;
+    if (modelPath)
+    {
+        if (!LoadModel(modelPath, mesh))
+            return -1;
+    }
+    else
+    {
+        mesh = MakeTorus(128, 64);
+    }
+    // 包围球: 以包围盒中心为球心 导入的模型缩放到与圆环差不多的大小
+    glm::vec3 minimum(1e30f), maximum(-1e30f);
+    for (size_t i = 0; i < mesh.vertices.size(); i += 8)
+    {
+        glm::vec3 p(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]);
+        minimum = glm::min(minimum, p);
+        maximum = glm::max(maximum, p);
+    }
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i < mesh.vertices.size(); i += 8)
+        radius = glm::max(radius, glm::length(glm::vec3(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2]) - center));
+    float fitScale = modelPath && radius > 0.0f ? 0.5f / radius : 1.0f;
+    radius *= fitScale;
+    // 导入的模型移到原点
+    for (size_t i = 0; i < mesh.vertices.size(); i += 8)
+    {
+        mesh.vertices[i] -= center.x;
+        mesh.vertices[i + 1] -= center.y;
+        mesh.vertices[i + 2] -= center.z;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<MeshCacheLod> lods = GenerateLods(mesh);
+    double simplifyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+
+    cout << "simplified in " << simplifyMs << " ms" << endl;
+    cout << "level   triangles   error       1px distance" << endl;
+    LodSelector selector(lods, pixelError);
+    selector.Update(camera, (float)SCR_HEIGHT);
+    for (unsigned int i = 0; i < lods.size(); i++)
+    {
+        // 误差恰好为 PixelError 个像素时的距离 超过它就可以切换到这一级
+        float pixelsPerUnit = SCR_HEIGHT / (2.0f * tan(glm::radians(camera.Zoom) * 0.5f));
+        cout.width(7);
+        cout << left << i << " ";
+        cout.width(11);
+        cout << lods[i].indexCount / 3 << " ";
+        cout.width(11);
+        cout << lods[i].error * fitScale << " ";
+        cout << lods[i].error * fitScale * pixelsPerUnit / pixelError << endl;
+    }
+    if (savePath)
+    {
+        if (!WriteMeshCache(savePath, mesh, lods))
+            return -1;
+        cout << "saved " << savePath << endl;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LOD", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    // 所有级别共用一个VBO 索引依次放在同一个EBO中
+    unsigned int VAO, VBO, EBO;
+    UploadMesh(mesh, VAO, VBO, EBO);
+    MeshData cube = MakeCube();
+    unsigned int lightVAO, lightVBO, lightEBO;
+    UploadMesh(cube, lightVAO, lightVBO, lightEBO);
+
+    Shader ObjectShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+    ObjectShader.use();
+    ObjectShader.setInt("material.diffuse", 0);
+    ObjectShader.setInt("material.specular", 1);
+
+    vector<Object> objects = makeObjects(count);
+    for (unsigned int i = 0; i < objects.size(); i++)
+        objects[i].scale *= fitScale;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, diffuseMap);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, specularMap);
+
+    if (bench)
+    {
+        // 三种方式: 不使用LOD 使用LOD 不带滞后的LOD
+        // 相机一边前进一边小幅前后晃动 物体在切换距离附近时 没有滞后就会来回切换
+        const int frames = 120;
+        const char *names[3] = { "full detail", "lod", "lod, no hysteresis" };
+        cout << "mode                 triangles/frame   frame ms   switches/frame" << endl;
+        for (int mode = 0; mode < 3; mode++)
+        {
+            for (unsigned int i = 0; i < objects.size(); i++)
+                objects[i].level = 0;
+            double triangles = 0.0, milliseconds = 0.0, switches = 0.0;
+            for (int f = 0; f <= frames; f++)
+            {
+                camera.Position = glm::vec3(0.0f, 1.5f, 3.0f - 0.05f * f + 0.4f * sin(f * 0.9f));
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                auto begin = chrono::steady_clock::now();
+                ObjectShader.use();
+                setLightUniforms(ObjectShader);
+                ObjectShader.setMat4("projection", glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 200.0f));
+                ObjectShader.setMat4("view", camera.GetViewMatrix());
+                selector.Update(camera, (float)SCR_HEIGHT);
+                glBindVertexArray(VAO);
+                FrameStats stats = drawObjects(ObjectShader, objects, selector, radius, mode != 0, mode == 1);
+                glFinish();
+                double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                // 第一帧预热 所有物体都从第0级开始 也不计入切换次数
+                if (f == 0)
+                    continue;
+                triangles += stats.triangles;
+                milliseconds += elapsed;
+                switches += stats.switches;
+            }
+            cout.width(20);
+            cout << left << names[mode] << " ";
+            cout.width(17);
+            cout << (unsigned long long)(triangles / frames) << " ";
+            cout.width(10);
+            cout << milliseconds / frames << " ";
+            cout << switches / frames << endl;
+        }
+    }
+
+    float lastReport = 0.0f;
+    unsigned int framesSinceReport = 0;
+    while(!bench && !glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 200.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        ObjectShader.use();
+        setLightUniforms(ObjectShader);
+        ObjectShader.setMat4("projection", projection);
+        ObjectShader.setMat4("view", view);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+
+        // 视野(滚轮缩放)变化后切换距离也跟着变化
+        selector.Update(camera, (float)SCR_HEIGHT);
+        glBindVertexArray(VAO);
+        FrameStats stats = drawObjects(ObjectShader, objects, selector, radius, useLod, true);
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        glBindVertexArray(lightVAO);
+        for (int i = 0; i < 4; i++)
+        {
+            glm::mat4 model = glm::mat4(1.0f);
+            model = glm::translate(model, pointLightPositions[i]);
+            model = glm::scale(model, glm::vec3(0.2f));
+            LightShader.setMat4("model", model);
+            glDrawElements(GL_TRIANGLES, (GLsizei)cube.indices.size(), GL_UNSIGNED_INT, 0);
+        }
+
+        // 每秒输出一次帧率 每帧的三角形数 各级别的物体数
+        framesSinceReport++;
+        if (currentFrame - lastReport >= 1.0f)
+        {
+            cout << framesSinceReport / (currentFrame - lastReport) << " fps, " << stats.triangles << " triangles, levels:";
+            for (unsigned int i = 0; i < stats.objectsPerLevel.size(); i++)
+                cout << " " << stats.objectsPerLevel[i];
+            cout << endl;
+            lastReport = currentFrame;
+            framesSinceReport = 0;
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteVertexArrays(1, &lightVAO);
+    glDeleteBuffers(1, &lightVBO);
+    glDeleteBuffers(1, &lightEBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+// 物体在地面上排成方阵 向 -z 方向延伸
+vector<Object> makeObjects(unsigned int count)
+{
+    vector<Object> objects(count);
+    unsigned int side = 1;
+    while (side * side < count)
+        side++;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int x = i % side, z = i / side;
+        objects[i].position = glm::vec3((x - side * 0.5f) * 1.5f, 0.0f, -2.0f - z * 1.5f);
+        objects[i].scale = 1.0f + 0.5f * ((i * 7) % 5) / 4.0f;
+        objects[i].angle = 37.0f * i;
+        objects[i].level = 0;
+    }
+    return objects;
+}
+
+glm::mat4 objectModel(const Object &object)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, object.position);
+    model = glm::rotate(model, glm::radians(object.angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    model = glm::scale(model, glm::vec3(object.scale));
+    return model;
+}
+
+// 每个物体按到相机的距离选择细节级别 绘制对应的一段索引
+FrameStats drawObjects(const Shader &shader, vector<Object> &objects, const LodSelector &selector, float radius, bool useLod, bool hysteresis)
+{
+    FrameStats stats;
+    stats.triangles = 0;
+    stats.switches = 0;
+    stats.objectsPerLevel.assign(selector.LevelCount(), 0);
+    for (unsigned int i = 0; i < objects.size(); i++)
+    {
+        Object &object = objects[i];
+        unsigned int level = 0;
+        if (useLod)
+        {
+            // 到包围球表面的距离 相机在球内时为0 使用最精细的一级
+            float distance = glm::length(object.position - camera.Position) - radius * object.scale;
+            level = hysteresis ? selector.Select(distance, object.scale, object.level) : selector.Select(distance, object.scale);
+        }
+        if (level != object.level)
+            stats.switches++;
+        object.level = level;
+        const MeshCacheLod &lod = selector.Level(level);
+        shader.setMat4("model", objectModel(object));
+        glDrawElements(GL_TRIANGLES, (GLsizei)lod.indexCount, GL_UNSIGNED_INT, (void*)(lod.firstIndex * sizeof(unsigned int)));
+        stats.triangles += lod.indexCount / 3;
+        stats.objectsPerLevel[level]++;
+    }
+    return stats;
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
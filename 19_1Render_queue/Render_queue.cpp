@@ -0,0 +1,484 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "render_queue.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+const float FAR_PLANE = 200.0f;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 场景中的一个物体: 网格 材质 位置
+struct Object {
+    unsigned int mesh;
+    unsigned int material;
+    glm::vec3 position;
+    float angle;
+};
+
+// 场景用到的资源 网格和材质都用编号引用
+struct Scene {
+    vector<MeshData> meshes;
+    vector<unsigned int> VAOs, VBOs, EBOs;
+    vector<RenderMaterial> materials;
+    vector<Object> objects;
+    unsigned int cubeMesh;
+};
+
+vector<Object> makeObjects(unsigned int count, unsigned int meshCount, unsigned int materialCount);
+glm::mat4 objectModel(const Object &object, float time);
+void submitScene(RenderQueue &queue, const Scene &scene, const vector<unsigned int> &materialIds, unsigned int objectProgram, unsigned int lightProgram, float time);
+RenderQueueStats renderImmediate(const Scene &scene, const Shader &objectShader, const Shader &lightShader, float time);
+
+// 用法:
+//   ./Render_queue.o                 5种网格 4种材质 2000个物体 排序后绘制 每秒输出状态切换次数
+//   ./Render_queue.o --count 10000   物体数量
+//   ./Render_queue.o --unsorted      按提交顺序绘制(只跳过重复的状态)
+//   ./Render_queue.o --bench         对比逐个设置状态 不排序的队列 排序的队列
+//   ./Render_queue.o --bench --small 视口缩小到1/8 减少光栅化的影响 只比较CPU提交的开销
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int count = 2000;
+    bool sorted = true;
+    bool bench = false;
+    bool small = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--unsorted") == 0)
+            sorted = false;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Render queue", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    if (small)
+        glViewport(0, 0, SCR_WIDTH / 8, SCR_HEIGHT / 8);
+    else
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Scene scene;
+    scene.meshes.push_back(MakeCube());
+    scene.meshes.push_back(MakeSphere());
+    scene.meshes.push_back(MakeCylinder());
+    scene.meshes.push_back(MakeTorus());
+    scene.meshes.push_back(MakePyramid());
+    scene.cubeMesh = 0;
+    unsigned int meshCount = (unsigned int)scene.meshes.size();
+    scene.VAOs.resize(meshCount);
+    scene.VBOs.resize(meshCount);
+    scene.EBOs.resize(meshCount);
+    for (unsigned int i = 0; i < meshCount; i++)
+        UploadMesh(scene.meshes[i], scene.VAOs[i], scene.VBOs[i], scene.EBOs[i]);
+
+    // 漫反射贴图 镜面光贴图 反光度
+    const char *textures[4][2] = {
+        { "../12_1Multiple_lights/container2.png", "../12_1Multiple_lights/container2_specular.png" },
+        { "../3_1Textures/container.jpg", "../10_1Lighting_maps/container2_specular_colored.png" },
+        { "../3_1Textures/bricks2.jpg", "../12_1Multiple_lights/container2_specular.png" },
+        { "../3_1Textures/awesomeface.png", "../10_1Lighting_maps/exercise2/matrix.jpg" }
+    };
+    float shininess[4] = { 32.0f, 64.0f, 8.0f, 16.0f };
+    for (int i = 0; i < 4; i++)
+    {
+        RenderMaterial material;
+        memset(&material, 0, sizeof(material));
+        material.textures[0] = loadTexture(textures[i][0]);
+        material.textures[1] = loadTexture(textures[i][1]);
+        material.textureCount = 2;
+        material.shininess = shininess[i];
+        scene.materials.push_back(material);
+    }
+    scene.objects = makeObjects(count, meshCount, (unsigned int)scene.materials.size());
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+
+    // 着色器在每帧第一次使用时设置投影 观察矩阵和光源
+    RenderQueue queue;
+    unsigned int objectProgram = queue.RegisterProgram(&CubeShader, [](const Shader &shader) {
+        shader.setMat4("projection", glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE));
+        shader.setMat4("view", camera.GetViewMatrix());
+        setLightUniforms(shader);
+    });
+    unsigned int lightProgram = queue.RegisterProgram(&LightShader, [](const Shader &shader) {
+        shader.setMat4("projection", glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE));
+        shader.setMat4("view", camera.GetViewMatrix());
+    });
+    vector<unsigned int> materialIds;
+    for (unsigned int i = 0; i < scene.materials.size(); i++)
+        materialIds.push_back(queue.RegisterMaterial(scene.materials[i]));
+    for (unsigned int i = 0; i < meshCount; i++)
+        queue.RegisterVAO(scene.VAOs[i]);
+
+    if (bench)
+    {
+        const int frames = 20;
+        const char *names[3] = { "immediate", "queue, unsorted", "queue, sorted" };
+        cout << count << " objects, " << meshCount << " meshes, " << scene.materials.size() << " materials, 2 programs" << endl;
+        cout << "mode              programs   materials  textures   VAOs       sort ms    cpu ms     frame ms" << endl;
+        for (int mode = 0; mode < 3; mode++)
+        {
+            queue.Sort = mode == 2;
+            RenderQueueStats total;
+            memset(&total, 0, sizeof(total));
+            double cpu = 0.0, frame = 0.0;
+            for (int f = 0; f <= frames; f++)
+            {
+                float time = (float)glfwGetTime();
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                auto start = chrono::steady_clock::now();
+                RenderQueueStats stats;
+                if (mode == 0)
+                    stats = renderImmediate(scene, CubeShader, LightShader, time);
+                else
+                {
+                    submitScene(queue, scene, materialIds, objectProgram, lightProgram, time);
+                    queue.Flush();
+                    stats = queue.Stats();
+                }
+                auto submitted = chrono::steady_clock::now();
+                glFinish();
+                auto finished = chrono::steady_clock::now();
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                // 第一帧预热
+                if (f == 0)
+                    continue;
+                total.programChanges += stats.programChanges;
+                total.materialChanges += stats.materialChanges;
+                total.textureChanges += stats.textureChanges;
+                total.vaoChanges += stats.vaoChanges;
+                total.sortMs += stats.sortMs;
+                cpu += chrono::duration<double, milli>(submitted - start).count();
+                frame += chrono::duration<double, milli>(finished - start).count();
+            }
+            cout.width(17);
+            cout << left << names[mode] << " ";
+            cout.width(10);
+            cout << total.programChanges / frames << " ";
+            cout.width(10);
+            cout << total.materialChanges / frames << " ";
+            cout.width(10);
+            cout << total.textureChanges / frames << " ";
+            cout.width(10);
+            cout << total.vaoChanges / frames << " ";
+            cout.width(10);
+            cout << total.sortMs / frames << " ";
+            cout.width(10);
+            cout << cpu / frames << " ";
+            cout << frame / frames << endl;
+        }
+    }
+
+    queue.Sort = sorted;
+    float lastReport = 0.0f;
+    while(!bench && !glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // 记录 排序 回放
+        submitScene(queue, scene, materialIds, objectProgram, lightProgram, currentFrame);
+        queue.Flush();
+
+        if (currentFrame - lastReport >= 1.0f)
+        {
+            const RenderQueueStats &stats = queue.Stats();
+            cout << stats.draws << " draws: " << stats.programChanges << " programs, " << stats.materialChanges << " materials, "
+                 << stats.textureChanges << " textures, " << stats.vaoChanges << " VAOs, sort " << stats.sortMs << " ms" << endl;
+            lastReport = currentFrame;
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        glDeleteVertexArrays(1, &scene.VAOs[i]);
+        glDeleteBuffers(1, &scene.VBOs[i]);
+        glDeleteBuffers(1, &scene.EBOs[i]);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+// 物体排成一个立方体网格 网格和材质的组合打乱 提交顺序中状态频繁变化
+vector<Object> makeObjects(unsigned int count, unsigned int meshCount, unsigned int materialCount)
+{
+    vector<Object> objects(count);
+    unsigned int side = 1;
+    while (side * side * side < count)
+        side++;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int x = i % side, y = (i / side) % side, z = i / (side * side);
+        objects[i].mesh = i % meshCount;
+        objects[i].material = (i * 7 + i / 3) % materialCount;
+        objects[i].position = glm::vec3((x - side * 0.5f) * 1.5f, (y - side * 0.5f) * 1.5f, -2.0f - z * 1.5f);
+        objects[i].angle = 20.0f * (i % 10) + 10.0f;
+    }
+    return objects;
+}
+
+glm::mat4 objectModel(const Object &object, float time)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, object.position);
+    model = glm::rotate(model, time * glm::radians(object.angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    return model;
+}
+
+// 按场景中的顺序记录所有绘制 光源穿插在物体之间
+void submitScene(RenderQueue &queue, const Scene &scene, const vector<unsigned int> &materialIds, unsigned int objectProgram, unsigned int lightProgram, float time)
+{
+    unsigned int lightInterval = (unsigned int)scene.objects.size() / 4 + 1;
+    for (unsigned int i = 0; i < scene.objects.size(); i++)
+    {
+        const Object &object = scene.objects[i];
+        DrawCommand command;
+        command.model = objectModel(object, time);
+        command.mode = GL_TRIANGLES;
+        command.count = (GLsizei)scene.meshes[object.mesh].indices.size();
+        command.first = 0;
+        command.indexed = true;
+        float depth = glm::length(object.position - camera.Position) / FAR_PLANE;
+        queue.Submit(PASS_OPAQUE, objectProgram, materialIds[object.material], object.mesh, depth, command);
+
+        if (i % lightInterval == 0)
+        {
+            unsigned int light = i / lightInterval;
+            DrawCommand lightCommand;
+            lightCommand.model = glm::scale(glm::translate(glm::mat4(1.0f), pointLightPositions[light]), glm::vec3(0.2f));
+            lightCommand.mode = GL_TRIANGLES;
+            lightCommand.count = (GLsizei)scene.meshes[scene.cubeMesh].indices.size();
+            lightCommand.first = 0;
+            lightCommand.indexed = true;
+            float lightDepth = glm::length(pointLightPositions[light] - camera.Position) / FAR_PLANE;
+            queue.Submit(PASS_LIGHTS, lightProgram, 0, scene.cubeMesh, lightDepth, lightCommand);
+        }
+    }
+}
+
+// 不用队列 每个物体都完整地设置一遍状态 相当于把章节中的循环套用到多种网格和材质上
+RenderQueueStats renderImmediate(const Scene &scene, const Shader &objectShader, const Shader &lightShader, float time)
+{
+    RenderQueueStats stats;
+    memset(&stats, 0, sizeof(stats));
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+    glm::mat4 view = camera.GetViewMatrix();
+    objectShader.use();
+    setLightUniforms(objectShader);
+    objectShader.setMat4("projection", projection);
+    objectShader.setMat4("view", view);
+    lightShader.use();
+    lightShader.setMat4("projection", projection);
+    lightShader.setMat4("view", view);
+    unsigned int lightInterval = (unsigned int)scene.objects.size() / 4 + 1;
+    for (unsigned int i = 0; i < scene.objects.size(); i++)
+    {
+        const Object &object = scene.objects[i];
+        const RenderMaterial &material = scene.materials[object.material];
+        objectShader.use();
+        objectShader.setFloat("material.shininess", material.shininess);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, material.textures[0]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, material.textures[1]);
+        glBindVertexArray(scene.VAOs[object.mesh]);
+        objectShader.setMat4("model", objectModel(object, time));
+        glDrawElements(GL_TRIANGLES, (GLsizei)scene.meshes[object.mesh].indices.size(), GL_UNSIGNED_INT, 0);
+        stats.programChanges++;
+        stats.materialChanges++;
+        stats.textureChanges += 2;
+        stats.vaoChanges++;
+        stats.draws++;
+
+        if (i % lightInterval == 0)
+        {
+            unsigned int light = i / lightInterval;
+            lightShader.use();
+            glBindVertexArray(scene.VAOs[scene.cubeMesh]);
+            lightShader.setMat4("model", glm::scale(glm::translate(glm::mat4(1.0f), pointLightPositions[light]), glm::vec3(0.2f)));
+            glDrawElements(GL_TRIANGLES, (GLsizei)scene.meshes[scene.cubeMesh].indices.size(), GL_UNSIGNED_INT, 0);
+            stats.programChanges++;
+            stats.vaoChanges++;
+            stats.draws++;
+        }
+    }
+    return stats;
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
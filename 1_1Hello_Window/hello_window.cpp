@@ -1,11 +1,13 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 using namespace std;
 void processInput(GLFWwindow *window);
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit(); // Init GLFW
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
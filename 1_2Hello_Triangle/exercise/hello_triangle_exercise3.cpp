@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 using namespace std;
 void processInput(GLFWwindow *window);
@@ -24,8 +25,9 @@ const char *fragmentShaderSource2 = "#version 330 core\n"
     "   FragColor = vec4(1.0f, 1.0f, 0.0f, 1.0f);\n"
     "}\n\0";
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
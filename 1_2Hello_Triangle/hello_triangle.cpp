@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 using namespace std;
 void processInput(GLFWwindow *window);
@@ -52,8 +53,9 @@ const char *fragmentShaderSource = "#version 330 core\n"
     "}\n\0";
     // 两个着色器现在都已经
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
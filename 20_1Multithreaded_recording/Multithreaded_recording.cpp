@@ -0,0 +1,531 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "render_queue.h"
+#include "command_buffer.h"
+#include "thread_pool.h"
+#include "frustum.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+const float FAR_PLANE = 200.0f;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 场景中的一个物体: 网格 材质 位置
+struct Object {
+    unsigned int mesh;
+    unsigned int material;
+    glm::vec3 position;
+    float angle;
+};
+
+// 场景用到的资源 命令中的编号就是这里的下标
+struct Scene {
+    vector<MeshData> meshes;
+    vector<float> radius;          // 网格的包围球半径(绕原点旋转后仍然包住网格)
+    vector<unsigned int> VAOs, VBOs, EBOs;
+    vector<RenderMaterial> materials;
+    vector<Object> objects;
+    unsigned int objectProgram;
+    unsigned int lightProgram;
+    unsigned int cubeMesh;
+};
+
+// 一帧中所有线程共享的只读数据
+struct FrameContext {
+    Frustum frustum;
+    float time;
+};
+
+vector<Object> makeObjects(unsigned int count, unsigned int meshCount, unsigned int materialCount);
+glm::mat4 objectModel(const Object &object, float time);
+void recordSlice(CommandBuffer &buffer, const Scene &scene, const FrameContext &context, unsigned int first, unsigned int last);
+void recordLights(CommandBuffer &buffer, const Scene &scene);
+void setupPrograms(const Shader &objectShader, const Shader &lightShader);
+
+// 用法:
+//   ./Multithreaded_recording.o                    100000个物体 使用全部核心记录命令 每秒输出各阶段的耗时
+//   ./Multithreaded_recording.o --threads 4        记录命令的线程数(包括主线程)
+//   ./Multithreaded_recording.o --count 200000     物体数量
+//   ./Multithreaded_recording.o --bench            线程数为 1 2 4 ... 时 记录 回放 整帧的耗时
+//   ./Multithreaded_recording.o --bench --small    视口缩小到1/8 减少光栅化的影响
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int count = 100000;
+    unsigned int threads = 0;
+    bool bench = false;
+    bool small = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Multithreaded recording", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    if (small)
+        glViewport(0, 0, SCR_WIDTH / 8, SCR_HEIGHT / 8);
+    else
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Scene scene;
+    scene.meshes.push_back(MakeCube());
+    scene.meshes.push_back(MakeSphere());
+    scene.meshes.push_back(MakeCylinder());
+    scene.meshes.push_back(MakeTorus());
+    scene.meshes.push_back(MakePyramid());
+    scene.cubeMesh = 0;
+    unsigned int meshCount = (unsigned int)scene.meshes.size();
+    scene.VAOs.resize(meshCount);
+    scene.VBOs.resize(meshCount);
+    scene.EBOs.resize(meshCount);
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        UploadMesh(scene.meshes[i], scene.VAOs[i], scene.VBOs[i], scene.EBOs[i]);
+        float radius = 0.0f;
+        const vector<float> &vertices = scene.meshes[i].vertices;
+        for (size_t v = 0; v + 8 <= vertices.size(); v += 8)
+            radius = max(radius, glm::length(glm::vec3(vertices[v], vertices[v + 1], vertices[v + 2])));
+        scene.radius.push_back(radius);
+    }
+
+    // 漫反射贴图 镜面光贴图 反光度
+    const char *textures[4][2] = {
+        { "../12_1Multiple_lights/container2.png", "../12_1Multiple_lights/container2_specular.png" },
+        { "../3_1Textures/container.jpg", "../10_1Lighting_maps/container2_specular_colored.png" },
+        { "../3_1Textures/bricks2.jpg", "../12_1Multiple_lights/container2_specular.png" },
+        { "../3_1Textures/awesomeface.png", "../10_1Lighting_maps/exercise2/matrix.jpg" }
+    };
+    float shininess[4] = { 32.0f, 64.0f, 8.0f, 16.0f };
+    for (int i = 0; i < 4; i++)
+    {
+        RenderMaterial material;
+        memset(&material, 0, sizeof(material));
+        material.textures[0] = loadTexture(textures[i][0]);
+        material.textures[1] = loadTexture(textures[i][1]);
+        material.textureCount = 2;
+        material.shininess = shininess[i];
+        scene.materials.push_back(material);
+    }
+    scene.objects = makeObjects(count, meshCount, (unsigned int)scene.materials.size());
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+
+    // 资源按场景中的顺序注册 编号与 Scene 中的下标一致
+    GLCommandReplayer replayer;
+    scene.objectProgram = replayer.RegisterProgram(&CubeShader);
+    scene.lightProgram = replayer.RegisterProgram(&LightShader);
+    for (unsigned int i = 0; i < scene.materials.size(); i++)
+        replayer.RegisterMaterial(scene.materials[i]);
+    for (unsigned int i = 0; i < meshCount; i++)
+        replayer.RegisterVertexArray(scene.VAOs[i]);
+
+    // 场景切成若干连续的片段 每个片段有自己的命令缓冲和分配器
+    // 片段数多于线程数 先做完的线程可以继续领取 各线程的负载更均匀
+    // 回放按片段的顺序进行 结果与线程数无关
+    const unsigned int slicesPerThread = 4;
+    vector<CommandBuffer*> buffers;
+    CommandBuffer lightBuffer;
+
+    // 记录一帧: 各线程记录自己领取的片段 返回可见的物体数
+    auto record = [&](ThreadPool &pool, float time) {
+        unsigned int sliceCount = pool.Size() * slicesPerThread;
+        while (buffers.size() < sliceCount)
+            buffers.push_back(new CommandBuffer());
+        FrameContext context;
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+        context.frustum = Frustum(projection * camera.GetViewMatrix());
+        context.time = time;
+        unsigned int objectCount = (unsigned int)scene.objects.size();
+        pool.Run(sliceCount, [&](unsigned int slice, unsigned int) {
+            unsigned int first = (unsigned int)((unsigned long long)objectCount * slice / sliceCount);
+            unsigned int last = (unsigned int)((unsigned long long)objectCount * (slice + 1) / sliceCount);
+            recordSlice(*buffers[slice], scene, context, first, last);
+        });
+        recordLights(lightBuffer, scene);
+        unsigned int draws = 0;
+        for (unsigned int i = 0; i < sliceCount; i++)
+            draws += buffers[i]->Draws();
+        return draws;
+    };
+    auto replay = [&](unsigned int sliceCount) {
+        setupPrograms(CubeShader, LightShader);
+        replayer.Begin();
+        for (unsigned int i = 0; i < sliceCount; i++)
+            replayer.Replay(*buffers[i]);
+        replayer.Replay(lightBuffer);
+    };
+
+    if (bench)
+    {
+        const int frames = 20;
+        unsigned int hardware = std::thread::hardware_concurrency();
+        vector<unsigned int> threadCounts;
+        for (unsigned int t = 1; t <= max(hardware, 4u); t *= 2)
+            threadCounts.push_back(t);
+        if (hardware > 4 && threadCounts.back() != hardware)
+            threadCounts.push_back(hardware);
+        cout << count << " objects, " << hardware << " hardware threads" << endl;
+        cout << "threads    draws      commands   uniform KB record ms  replay ms  frame ms   speedup" << endl;
+        double baseRecord = 0.0;
+        unsigned int baseDraws = 0;
+        bool consistent = true;
+        for (size_t c = 0; c < threadCounts.size(); c++)
+        {
+            ThreadPool pool(threadCounts[c]);
+            unsigned int sliceCount = pool.Size() * slicesPerThread;
+            double recordMs = 0.0, replayMs = 0.0, frameMs = 0.0;
+            unsigned int draws = 0;
+            size_t commands = 0, uniforms = 0;
+            for (int f = 0; f <= frames; f++)
+            {
+                // 固定的时间 每种线程数绘制相同的画面
+                float time = f * 0.016f;
+                glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                auto start = chrono::steady_clock::now();
+                draws = record(pool, time);
+                auto recorded = chrono::steady_clock::now();
+                replay(sliceCount);
+                auto replayed = chrono::steady_clock::now();
+                glFinish();
+                auto finished = chrono::steady_clock::now();
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                // 第一帧预热
+                if (f == 0)
+                    continue;
+                recordMs += chrono::duration<double, milli>(recorded - start).count();
+                replayMs += chrono::duration<double, milli>(replayed - recorded).count();
+                frameMs += chrono::duration<double, milli>(finished - start).count();
+            }
+            commands = 0;
+            uniforms = 0;
+            for (unsigned int i = 0; i < sliceCount; i++)
+            {
+                commands += buffers[i]->Commands().size();
+                uniforms += buffers[i]->Uniforms.Used();
+            }
+            if (c == 0)
+            {
+                baseRecord = recordMs;
+                baseDraws = draws;
+            }
+            else if (draws != baseDraws)
+                consistent = false;
+            cout.width(10);
+            cout << left << threadCounts[c] << " ";
+            cout.width(10);
+            cout << draws << " ";
+            cout.width(10);
+            cout << commands << " ";
+            cout.width(10);
+            cout << uniforms / 1024 << " ";
+            cout.width(10);
+            cout << recordMs / frames << " ";
+            cout.width(10);
+            cout << replayMs / frames << " ";
+            cout.width(10);
+            cout << frameMs / frames << " ";
+            cout << baseRecord / recordMs << "x" << endl;
+        }
+        if (!consistent)
+            cout << "ERROR::COMMAND_BUFFER::DRAW_COUNT_MISMATCH" << endl;
+    }
+
+    ThreadPool pool(threads);
+    cout << "recording on " << pool.Size() << " threads" << endl;
+    float lastReport = 0.0f;
+    double recordTotal = 0.0, replayTotal = 0.0;
+    unsigned int reportFrames = 0;
+    while(!bench && !glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // 工作线程记录 主线程回放
+        auto start = chrono::steady_clock::now();
+        unsigned int draws = record(pool, currentFrame);
+        auto recorded = chrono::steady_clock::now();
+        replay(pool.Size() * slicesPerThread);
+        auto replayed = chrono::steady_clock::now();
+        recordTotal += chrono::duration<double, milli>(recorded - start).count();
+        replayTotal += chrono::duration<double, milli>(replayed - recorded).count();
+        reportFrames++;
+
+        if (currentFrame - lastReport >= 1.0f)
+        {
+            cout << draws << " visible, record " << recordTotal / reportFrames << " ms, replay " << replayTotal / reportFrames << " ms" << endl;
+            recordTotal = replayTotal = 0.0;
+            reportFrames = 0;
+            lastReport = currentFrame;
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    for (size_t i = 0; i < buffers.size(); i++)
+        delete buffers[i];
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        glDeleteVertexArrays(1, &scene.VAOs[i]);
+        glDeleteBuffers(1, &scene.VBOs[i]);
+        glDeleteBuffers(1, &scene.EBOs[i]);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+// 物体分布在相机周围的立方体网格中 大部分在视锥体之外
+// 创建后按 材质 网格 排序 连续的物体状态相同 每个片段内只有少量的状态切换
+vector<Object> makeObjects(unsigned int count, unsigned int meshCount, unsigned int materialCount)
+{
+    vector<Object> objects(count);
+    unsigned int side = 1;
+    while (side * side * side < count)
+        side++;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        unsigned int x = i % side, y = (i / side) % side, z = i / (side * side);
+        objects[i].mesh = i % meshCount;
+        objects[i].material = (i * 7 + i / 3) % materialCount;
+        objects[i].position = glm::vec3((x - side * 0.5f) * 2.0f, (y - side * 0.5f) * 2.0f, (z - side * 0.5f) * 2.0f);
+        objects[i].angle = 20.0f * (i % 10) + 10.0f;
+    }
+    stable_sort(objects.begin(), objects.end(), [](const Object &a, const Object &b) {
+        if (a.material != b.material)
+            return a.material < b.material;
+        return a.mesh < b.mesh;
+    });
+    return objects;
+}
+
+glm::mat4 objectModel(const Object &object, float time)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, object.position);
+    model = glm::rotate(model, time * glm::radians(object.angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    return model;
+}
+
+// 在工作线程上运行: 只读场景 只写自己的命令缓冲 不调用任何 gl 函数
+void recordSlice(CommandBuffer &buffer, const Scene &scene, const FrameContext &context, unsigned int first, unsigned int last)
+{
+    buffer.Reset();
+    buffer.BindProgram(scene.objectProgram);
+    for (unsigned int i = first; i < last; i++)
+    {
+        const Object &object = scene.objects[i];
+        if (!context.frustum.IntersectsSphere(object.position, scene.radius[object.mesh]))
+            continue;
+        buffer.BindMaterial(object.material);
+        buffer.BindVertexArray(object.mesh);
+        buffer.SetTransform(objectModel(object, context.time));
+        buffer.DrawIndexed((unsigned int)scene.meshes[object.mesh].indices.size(), 0);
+    }
+}
+
+// 光源只有4个 在主线程上记录
+void recordLights(CommandBuffer &buffer, const Scene &scene)
+{
+    buffer.Reset();
+    buffer.BindProgram(scene.lightProgram);
+    buffer.BindVertexArray(scene.cubeMesh);
+    for (int i = 0; i < 4; i++)
+    {
+        buffer.SetTransform(glm::scale(glm::translate(glm::mat4(1.0f), pointLightPositions[i]), glm::vec3(0.2f)));
+        buffer.DrawIndexed((unsigned int)scene.meshes[scene.cubeMesh].indices.size(), 0);
+    }
+}
+
+// 每帧不变的uniform 回放前设置一次
+void setupPrograms(const Shader &objectShader, const Shader &lightShader)
+{
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+    glm::mat4 view = camera.GetViewMatrix();
+    objectShader.use();
+    objectShader.setMat4("projection", projection);
+    objectShader.setMat4("view", view);
+    setLightUniforms(objectShader);
+    lightShader.use();
+    lightShader.setMat4("projection", projection);
+    lightShader.setMat4("view", view);
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,13 @@
+// 需要一个顶点着色器来绘制箱子
+// 不需要纹理坐标
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
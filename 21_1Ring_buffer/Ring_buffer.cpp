@@ -0,0 +1,605 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "gl_ext.h"
+#include "instanced_renderer.h"
+#include "ring_buffer.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+GLFWwindow *createWindow(bool allowModernContext);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 与着色器中 std140 的 uniform块 Frame 一一对应 成员全部是vec4 不需要额外填充
+struct DirLightData {
+    glm::vec4 direction;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+};
+
+struct PointLightData {
+    glm::vec4 position;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec4 attenuation;
+};
+
+struct SpotLightData {
+    glm::vec4 position;
+    glm::vec4 direction;
+    glm::vec4 ambient;
+    glm::vec4 diffuse;
+    glm::vec4 specular;
+    glm::vec4 cutOff;
+};
+
+struct FrameUniforms {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 viewPos;
+    DirLightData dirLight;
+    PointLightData pointLights[4];
+    SpotLightData spotLight;
+};
+
+// uniform块 Frame 的绑定点
+const GLuint FRAME_BINDING = 0;
+
+void fillFrameUniforms(FrameUniforms &frame, const glm::mat4 &projection);
+void setupInstanceAttributes(unsigned int VAO, unsigned int buffer, GLintptr offset, bool withNormalMatrix);
+vector<glm::vec3> makePositions(unsigned int count);
+glm::mat4 cubeModel(const glm::vec3 &position, unsigned int i, float time);
+void writeStreamVertices(float *out, const MeshData &cube, const vector<glm::vec3> &positions, float time);
+int runStress(GLFWwindow *window, const Shader &streamShader, unsigned int diffuseMap, unsigned int specularMap, float megabytes);
+
+// 用法:
+//   ./Ring_buffer.o                     1000个箱子 每帧的uniform和实例数据都从环形缓冲分配 每秒输出等待fence的次数
+//   ./Ring_buffer.o --count 20000       箱子数量
+//   ./Ring_buffer.o --gl33              强制使用3.3的上下文 每帧用 GL_MAP_UNSYNCHRONIZED_BIT 映射
+//   ./Ring_buffer.o --stress            每帧流式上传4MB顶点数据 对比 glBufferSubData 重新分配 环形缓冲的吞吐量
+//   ./Ring_buffer.o --stress --mb 16    每帧上传的MB数
+//   ./Ring_buffer.o --small             视口缩小到1/8 减少光栅化的影响
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int count = 1000;
+    bool modernContext = true;
+    bool stress = false;
+    bool small = false;
+    float megabytes = 4.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--gl33") == 0)
+            modernContext = false;
+        else if (strcmp(argv[i], "--stress") == 0)
+            stress = true;
+        else if (strcmp(argv[i], "--mb") == 0 && i + 1 < argc)
+            megabytes = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+    }
+
+    glfwInit();
+    GLFWwindow* window = createWindow(modernContext);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    // glad只加载了3.3的函数 glBufferStorage 需要额外加载
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    // 有的驱动即使请求3.3也会返回更高版本的上下文 这里当作3.3处理
+    if (!modernContext)
+        glext = GLExt();
+    glEnable(GL_DEPTH_TEST);
+
+    if (small)
+        glViewport(0, 0, SCR_WIDTH / 8, SCR_HEIGHT / 8);
+    else
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    cout << "OpenGL " << glext.Major << "." << glext.Minor << ", "
+         << (glext.BufferStorage ? "persistent mapped ring buffers" : "unsynchronized mapping fallback") << endl;
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+    Shader StreamShader("./stream.vs", "./shader.fs");
+    // 三个着色器的 Frame 块都使用同一个绑定点
+    const Shader *shaders[] = { &CubeShader, &LightShader, &StreamShader };
+    for (int i = 0; i < 3; i++)
+        glUniformBlockBinding(shaders[i]->ID, glGetUniformBlockIndex(shaders[i]->ID, "Frame"), FRAME_BINDING);
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+    CubeShader.setFloat("material.shininess", 32.0f);
+    StreamShader.use();
+    StreamShader.setInt("material.diffuse", 0);
+    StreamShader.setInt("material.specular", 1);
+    StreamShader.setFloat("material.shininess", 32.0f);
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+    if (stress)
+    {
+        int result = runStress(window, StreamShader, diffuseMap, specularMap, megabytes);
+        glfwTerminate();
+        return result;
+    }
+
+    // 环形缓冲在这个作用域结束时析构 此时上下文仍然有效
+    {
+        MeshData cube = MakeCube();
+        unsigned int cubeVAO, lightVAO, VBO, EBO, lightVBO, lightEBO;
+        UploadMesh(cube, cubeVAO, VBO, EBO);
+        UploadMesh(cube, lightVAO, lightVBO, lightEBO);
+
+        // 每帧的uniform块 以及箱子和光源的实例数据 各用一个环形缓冲
+        RingBuffer uniformRing(GL_UNIFORM_BUFFER, sizeof(FrameUniforms));
+        RingBuffer instanceRing(GL_ARRAY_BUFFER, (GLsizeiptr)(count + 4) * sizeof(InstanceData) + 64);
+
+        vector<glm::vec3> positions = makePositions(count);
+
+        float lastReport = 0.0f;
+        while(!glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            uniformRing.Begin();
+            instanceRing.Begin();
+
+            // 投影 观察矩阵和所有光源一次写入 替代十几次 glUniform* 调用
+            RingAllocation frameData = uniformRing.Allocate(sizeof(FrameUniforms));
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+            fillFrameUniforms(*(FrameUniforms*)frameData.Data, projection);
+
+            // 实例数据直接写进映射的内存 不经过中间的数组
+            RingAllocation cubeData = instanceRing.Allocate((GLsizeiptr)count * sizeof(InstanceData));
+            InstanceData *instances = (InstanceData*)cubeData.Data;
+            for (unsigned int i = 0; i < count; i++)
+            {
+                instances[i].model = cubeModel(positions[i], i, currentFrame);
+                instances[i].normalMatrix = glm::inverseTranspose(glm::mat3(instances[i].model));
+            }
+            RingAllocation lightData = instanceRing.Allocate(4 * sizeof(InstanceData));
+            InstanceData *lights = (InstanceData*)lightData.Data;
+            for (unsigned int i = 0; i < 4; i++)
+            {
+                lights[i].model = glm::scale(glm::translate(glm::mat4(1.0f), pointLightPositions[i]), glm::vec3(0.2f));
+                lights[i].normalMatrix = glm::mat3(1.0f);
+            }
+
+            uniformRing.Flush();
+            instanceRing.Flush();
+
+            uniformRing.BindRange(FRAME_BINDING, frameData);
+
+            // 每帧的数据在缓冲中的位置不同 实例属性的偏移要重新设置
+            CubeShader.use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, diffuseMap);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, specularMap);
+            setupInstanceAttributes(cubeVAO, instanceRing.ID, cubeData.Offset, true);
+            glBindVertexArray(cubeVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)cube.indices.size(), GL_UNSIGNED_INT, 0, (GLsizei)count);
+
+            LightShader.use();
+            setupInstanceAttributes(lightVAO, instanceRing.ID, lightData.Offset, false);
+            glBindVertexArray(lightVAO);
+            glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)cube.indices.size(), GL_UNSIGNED_INT, 0, 4);
+
+            uniformRing.End();
+            instanceRing.End();
+
+            if (currentFrame - lastReport >= 1.0f)
+            {
+                const RingBufferStats &u = uniformRing.Stats();
+                const RingBufferStats &s = instanceRing.Stats();
+                cout << s.frames << " frames, " << (u.bytes + s.bytes) / 1024 << " KB streamed, "
+                     << u.stalls + s.stalls << " stalls, " << u.stallMs + s.stallMs << " ms waiting, "
+                     << u.overflows + s.overflows << " overflows" << endl;
+                uniformRing.ResetStats();
+                instanceRing.ResetStats();
+                lastReport = currentFrame;
+            }
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        glDeleteVertexArrays(1, &cubeVAO);
+        glDeleteVertexArrays(1, &lightVAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &lightVBO);
+        glDeleteBuffers(1, &lightEBO);
+    }
+
+    glfwTerminate();
+    return 0;
+}
+
+// 流式上传顶点数据的压力测试
+// 每帧在CPU上把所有箱子的顶点变换到世界空间 上传后用一次 glDrawArrays 绘制
+// 三种上传方式写入的数据和绘制的内容完全相同:
+//   glBufferSubData  改写同一个缓冲 GPU还在读上一帧时驱动需要同步或复制
+//   orphaning        先 glBufferData(NULL) 丢弃旧的存储 再 glBufferSubData (InstancedRenderer 的做法)
+//   ring buffer      直接写进环形缓冲映射的内存 由fence保护
+int runStress(GLFWwindow *window, const Shader &streamShader, unsigned int diffuseMap, unsigned int specularMap, float megabytes)
+{
+    MeshData cube = MakeCube();
+    const size_t cubeFloats = cube.indices.size() * 8;
+    unsigned int cubes = (unsigned int)(megabytes * 1024.0f * 1024.0f / (cubeFloats * sizeof(float)));
+    if (cubes == 0)
+        cubes = 1;
+    const size_t frameBytes = (size_t)cubes * cubeFloats * sizeof(float);
+    const int frames = 60;
+    vector<glm::vec3> positions = makePositions(cubes);
+
+    // 镜头拉远 所有箱子都在画面中
+    camera = Camera(glm::vec3(0.0f, 0.0f, 40.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 200.0f);
+
+    cout << cubes << " cubes, " << frameBytes / (1024.0 * 1024.0) << " MB of vertices per frame, " << frames << " frames" << endl;
+    cout << "mode              MB/s       frame ms   stalls     stall ms" << endl;
+
+    const char *names[3] = { "glBufferSubData", "orphaning", "ring buffer" };
+    double ringRate = 0.0;
+    for (int mode = 0; mode < 3; mode++)
+    {
+        RingBuffer uniformRing(GL_UNIFORM_BUFFER, sizeof(FrameUniforms));
+        RingBuffer vertexRing(GL_ARRAY_BUFFER, mode == 2 ? (GLsizeiptr)frameBytes : 16);
+        unsigned int VAO, VBO;
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)frameBytes, NULL, GL_STREAM_DRAW);
+        vector<float> staging(mode == 2 ? 0 : frameBytes / sizeof(float));
+
+        double seconds = 0.0;
+        for (int f = 0; f <= frames; f++)
+        {
+            float time = f * 0.016f;
+            auto start = chrono::steady_clock::now();
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            uniformRing.Begin();
+            RingAllocation frameData = uniformRing.Allocate(sizeof(FrameUniforms));
+            fillFrameUniforms(*(FrameUniforms*)frameData.Data, projection);
+            uniformRing.Flush();
+            uniformRing.BindRange(FRAME_BINDING, frameData);
+
+            GLintptr offset = 0;
+            unsigned int buffer = VBO;
+            if (mode == 2)
+            {
+                vertexRing.Begin();
+                RingAllocation vertices = vertexRing.Allocate((GLsizeiptr)frameBytes);
+                writeStreamVertices((float*)vertices.Data, cube, positions, time);
+                vertexRing.Flush();
+                offset = vertices.Offset;
+                buffer = vertexRing.ID;
+            }
+            else
+            {
+                writeStreamVertices(staging.data(), cube, positions, time);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO);
+                if (mode == 1)
+                    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)frameBytes, NULL, GL_STREAM_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)frameBytes, staging.data());
+            }
+
+            glBindVertexArray(VAO);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)offset);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(offset + sizeof(float) * 3));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(offset + sizeof(float) * 6));
+            glEnableVertexAttribArray(2);
+
+            streamShader.use();
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, diffuseMap);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, specularMap);
+            glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(cubes * cube.indices.size()));
+
+            uniformRing.End();
+            if (mode == 2)
+                vertexRing.End();
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            // 第一帧预热 ResetStats 让统计只包含计时的帧
+            if (f == 0)
+            {
+                vertexRing.ResetStats();
+                continue;
+            }
+            seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        // 等待所有绘制完成后再删除缓冲
+        glFinish();
+        double rate = frameBytes * (double)frames / (1024.0 * 1024.0) / seconds;
+        if (mode == 2)
+            ringRate = rate;
+        const RingBufferStats &stats = vertexRing.Stats();
+        cout.width(17);
+        cout << left << names[mode] << " ";
+        cout.width(10);
+        cout << rate << " ";
+        cout.width(10);
+        cout << seconds * 1000.0 / frames << " ";
+        cout.width(10);
+        cout << (mode == 2 ? stats.stalls : 0) << " ";
+        cout << (mode == 2 ? stats.stallMs : 0.0) << endl;
+
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+    }
+    if (ringRate < 100.0)
+        cout << "ring buffer streamed " << ringRate << " MB/s, below 100 MB/s (try --small)" << endl;
+    return 0;
+}
+
+void fillFrameUniforms(FrameUniforms &frame, const glm::mat4 &projection)
+{
+    frame.projection = projection;
+    frame.view = camera.GetViewMatrix();
+    frame.viewPos = glm::vec4(camera.Position, 1.0f);
+    // 定向光源
+    frame.dirLight.direction = glm::vec4(-0.2f, -1.0f, -0.3f, 0.0f);
+    frame.dirLight.ambient = glm::vec4(0.05f, 0.05f, 0.05f, 0.0f);
+    frame.dirLight.diffuse = glm::vec4(0.4f, 0.4f, 0.4f, 0.0f);
+    frame.dirLight.specular = glm::vec4(0.5f, 0.5f, 0.5f, 0.0f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        frame.pointLights[i].position = glm::vec4(pointLightPositions[i], 1.0f);
+        frame.pointLights[i].ambient = glm::vec4(0.05f, 0.05f, 0.05f, 0.0f);
+        frame.pointLights[i].diffuse = glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+        frame.pointLights[i].specular = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        frame.pointLights[i].attenuation = glm::vec4(1.0f, 0.09f, 0.032f, 0.0f);
+    }
+    // 聚光
+    frame.spotLight.position = glm::vec4(camera.Position, 1.0f);
+    frame.spotLight.direction = glm::vec4(camera.Front, 0.0f);
+    frame.spotLight.ambient = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    frame.spotLight.diffuse = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    frame.spotLight.specular = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    frame.spotLight.cutOff = glm::vec4(glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(17.5f)), 0.0f, 0.0f);
+}
+
+// 把实例属性指向缓冲中 offset 处的 InstanceData 数组 布局与 InstancedRenderer::AttachTo 相同
+void setupInstanceAttributes(unsigned int VAO, unsigned int buffer, GLintptr offset, bool withNormalMatrix)
+{
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*)(offset + offsetof(InstanceData, model) + sizeof(glm::vec4) * i));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    if (withNormalMatrix)
+    {
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offset + offsetof(InstanceData, normalMatrix) + sizeof(glm::vec3) * i));
+            glEnableVertexAttribArray(7 + i);
+            glVertexAttribDivisor(7 + i, 1);
+        }
+    }
+}
+
+// 前10个与12_1的位置相同 其余排成立方体网格
+vector<glm::vec3> makePositions(unsigned int count)
+{
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+    vector<glm::vec3> positions(count);
+    unsigned int side = 1;
+    while (side * side * side < count)
+        side++;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (i < 10)
+        {
+            positions[i] = cubePositions[i];
+            continue;
+        }
+        unsigned int x = i % side, y = (i / side) % side, z = i / (side * side);
+        positions[i] = glm::vec3((x - side * 0.5f) * 1.5f, (y - side * 0.5f) * 1.5f, -20.0f - z * 1.5f);
+    }
+    return positions;
+}
+
+glm::mat4 cubeModel(const glm::vec3 &position, unsigned int i, float time)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, position);
+    float angle = 20.0f * (i % 10) + 10.0f;
+    model = glm::rotate(model, time * glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    return model;
+}
+
+// 按索引展开 每个箱子36个顶点 位置和法线变换到世界空间
+void writeStreamVertices(float *out, const MeshData &cube, const vector<glm::vec3> &positions, float time)
+{
+    for (unsigned int c = 0; c < positions.size(); c++)
+    {
+        glm::mat4 model = cubeModel(positions[c], c, time);
+        glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(model));
+        for (size_t i = 0; i < cube.indices.size(); i++)
+        {
+            const float *v = &cube.vertices[cube.indices[i] * 8];
+            glm::vec3 p = glm::vec3(model * glm::vec4(v[0], v[1], v[2], 1.0f));
+            glm::vec3 n = normalMatrix * glm::vec3(v[3], v[4], v[5]);
+            out[0] = p.x;
+            out[1] = p.y;
+            out[2] = p.z;
+            out[3] = n.x;
+            out[4] = n.y;
+            out[5] = n.z;
+            out[6] = v[6];
+            out[7] = v[7];
+            out += 8;
+        }
+    }
+}
+
+// 依次尝试更高版本的上下文 驱动不支持时 glfwCreateWindow 返回NULL 再降低版本
+GLFWwindow *createWindow(bool allowModernContext)
+{
+    int versions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 4 }, { 3, 3 } };
+    for (int i = allowModernContext ? 0 : 3; i < 4; i++)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, versions[i][0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, versions[i][1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Ring buffer", NULL, NULL);
+        if (window != NULL)
+            return window;
+    }
+    return NULL;
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
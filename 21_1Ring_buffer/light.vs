@@ -0,0 +1,44 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in mat4 aModel;
+
+// 每帧的uniform都在一个uniform块中 整块从环形缓冲分配 用 glBindBufferRange 绑定
+// std140 布局 所有成员都用vec4 C++中的结构体可以一一对应
+struct DirLight {
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+struct PointLight {
+    vec4 position;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation; // 常数项 一次项 二次项
+};
+
+struct SpotLight {
+    vec4 position;
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 cutOff;      // 切光角 外切光角
+};
+
+#define NR_POINT_LIGHTS 4
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+}
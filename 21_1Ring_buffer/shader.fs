@@ -0,0 +1,148 @@
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+uniform Material material;
+
+// 每帧的uniform都在一个uniform块中 整块从环形缓冲分配 用 glBindBufferRange 绑定
+// std140 布局 所有成员都用vec4 C++中的结构体可以一一对应
+struct DirLight {
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+};
+
+struct PointLight {
+    vec4 position;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 attenuation; // 常数项 一次项 二次项
+};
+
+struct SpotLight {
+    vec4 position;
+    vec4 direction;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular;
+    vec4 cutOff;      // 切光角 外切光角
+};
+
+#define NR_POINT_LIGHTS 4
+layout (std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec4 viewPos;
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+
+in vec2 TexCoords;
+
+void main()
+{
+    // 属性值设置
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
+
+    // 定向光照
+    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    // 四个点光源
+    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+    {
+        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+    }
+    // 聚光
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+
+    FragColor = vec4(result, 1.0);
+}
+
+// 计算定向光源
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+{
+    // 环境光
+    vec3 ambient = light.ambient.rgb * vec3(texture(material.diffuse, TexCoords));
+
+    // 漫反射
+    vec3 lightDir = normalize(-light.direction.xyz);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse.rgb * diff * vec3(texture(material.diffuse, TexCoords));
+
+    // 镜面反射
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = light.specular.rgb * spec * vec3(texture(material.specular, TexCoords));
+
+    vec3 result = ambient + diffuse + specular;
+    return result;
+}
+
+// 计算点光源
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    // 环境光
+    vec3 ambient = light.ambient.rgb * vec3(texture(material.diffuse, TexCoords));
+
+    // 漫反射
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse.rgb * diff * vec3(texture(material.diffuse, TexCoords));
+
+    // 镜面反射
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    //vec3 specular = light.specular.rgb * spec * texture(material.specualr, TexCoords).rgb;
+    vec3 specular = light.specular.rgb * spec * vec3(texture(material.specular, TexCoords));
+
+
+    
+    // 计算光源衰弱值
+    float distance = length(light.position.xyz - fragPos);
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+
+    vec3 result = (ambient + diffuse + specular) * attenuation;
+    return result;
+}
+
+// 计算聚光
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position.xyz - fragPos);
+    // 计算光源到片段与光线方向夹角 与 切光角比较 决定是否在聚光内部
+    float theta = dot(lightDir, normalize(-light.direction.xyz));
+    float epsilon = light.cutOff.x - light.cutOff.y;
+    // 现在已有一个在聚光外为负 在内圆锥内大于1.0的强度值
+    float intensity = clamp((theta - light.cutOff.y) / epsilon, 0.0, 1.0);
+    // 使用clamp函数将第一个参数约束在0.0到1.0之间
+
+    vec3 ambient = light.ambient.rgb * vec3(texture(material.diffuse, TexCoords));
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse.rgb * diff * vec3(texture(material.diffuse, TexCoords));
+
+
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = light.specular.rgb * spec * vec3(texture(material.specular, TexCoords));
+
+    // 不对环境光产生影响让其总有一些光
+    diffuse *= intensity;
+    specular *= intensity;
+
+    vec3 result = ambient + diffuse + specular;
+    return result;
+}
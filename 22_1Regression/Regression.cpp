@@ -0,0 +1,461 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+
+using namespace std;
+
+// 光照章节(7_1 ~ 12_1)的回归测试
+//
+// 每个章节用 --headless 在llvmpipe上渲染固定的帧数 摄像机停在初始位置 时间 = 帧号 * timestep
+// 最后一帧与 golden/ 中的参考图片比较 同时检查帧时间是否超出预算
+// 每次运行在 report/ 中写出实际图片 差异图片和 report.md
+//
+// 帧时间的毫秒数换一台机器就不能比较 regression.txt 的第一个章节(7_1)是校准场景
+// 每次运行都先测它 其他章节的帧时间除以它 得到与机器无关的相对值 再与基准比较
+// 同一台机器上两次运行也有几个百分点的波动 超出预算默认只是警告 --strict-time 时才算失败
+//
+// 章节需要先按README编译成 源代码.o (带 -lEGL)
+
+// 参考图片缩小到1/DOWNSAMPLE保存 2x2的平均也消除了光栅化边缘上单个像素的差别
+const int DOWNSAMPLE = 2;
+// 前几帧包含着色器编译和纹理上传 不计入帧时间
+const unsigned int WARMUP_FRAMES = 2;
+// 校准场景每帧只有1ms左右 一次运行的中位数也会差20% 运行几次取最快的一次
+const unsigned int CALIBRATION_RUNS = 5;
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    vector<unsigned char> pixels; // RGB 第一行在顶部
+};
+
+// regression.txt 中的一行
+struct Case {
+    string name;
+    string dir;
+    string executable;
+    unsigned int frames;
+    double timestep;
+    double baselineRatio;   // 帧时间是校准场景的几倍 0 表示还没有基准 只输出不检查
+    double budgetPercent;
+};
+
+struct CaseResult {
+    bool ran = false;
+    bool imagePassed = false;
+    bool timePassed = false;
+    double meanDeltaE = 0.0;
+    double maxDeltaE = 0.0;
+    double overRatio = 0.0;  // 超过阈值的像素比例
+    double frameMs = 0.0;    // 去掉预热帧后的中位数 不受个别被调度打断的帧影响
+    double ratio = 0.0;      // frameMs / 校准场景的 frameMs
+    string error;
+};
+
+bool readPPM(const string &path, Image &image);
+bool writePPM(const string &path, const Image &image);
+Image downsample(const Image &image, int factor);
+bool loadCases(const string &path, vector<Case> &cases, vector<string> &lines);
+bool saveCases(const string &path, const vector<Case> &cases, const vector<string> &lines);
+bool runCase(const string &root, const Case &c, const string &screenshot, vector<double> &frameMs, string &error);
+void compareImages(const Image &golden, const Image &actual, double threshold, CaseResult &result, Image &diff);
+void writeReport(const string &path, const vector<Case> &cases, const vector<CaseResult> &results, double threshold, double tolerance,
+                 bool strictTime);
+
+// 用法(在这个目录下运行):
+//   ./Regression.o                      运行所有章节 与参考图片和基准比较 图片不同或运行出错时返回1
+//   ./Regression.o --only 12_1          只运行名称或目录中包含12_1的章节
+//   ./Regression.o --update             重新生成参考图片 并把这次的相对帧时间写为基准
+//   ./Regression.o --strict-time        帧时间超出预算也算失败 默认只输出警告
+//   ./Regression.o --threshold 2.3      每个像素允许的色差(CIE76 delta E) 2.3约为人眼刚能分辨的差别
+//   ./Regression.o --tolerance 0.5      超过色差阈值的像素最多占的百分比
+//   ./Regression.o --root ..            章节所在的目录
+int main(int argc, char *argv[])
+{
+    string root = "..";
+    string only;
+    bool update = false;
+    bool strictTime = false;
+    double threshold = 2.3;
+    double tolerance = 0.5;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--update") == 0)
+            update = true;
+        else if (strcmp(argv[i], "--strict-time") == 0)
+            strictTime = true;
+        else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc)
+            only = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc)
+            root = argv[++i];
+    }
+
+    vector<Case> cases;
+    vector<string> lines;
+    if (!loadCases("regression.txt", cases, lines))
+        return -1;
+    filesystem::create_directories("report");
+    filesystem::create_directories("golden");
+
+    if (cases.empty())
+    {
+        cout << "ERROR::REGRESSION::NO_CASES" << endl;
+        return -1;
+    }
+
+    vector<CaseResult> results(cases.size());
+    bool failed = false;
+    bool timeWarning = false;
+    double calibrationMs = 0.0;
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        const Case &c = cases[i];
+        CaseResult &result = results[i];
+        // 校准场景总是要运行
+        bool calibration = i == 0;
+        if (!calibration && !only.empty() && c.name.find(only) == string::npos && c.dir.find(only) == string::npos)
+            continue;
+        cout << c.name << (calibration ? " (calibration)" : "") << " ... " << flush;
+
+        string actualPath = "report/" + c.name + ".ppm";
+        for (unsigned int run = 0; run < (calibration ? CALIBRATION_RUNS : 1); run++)
+        {
+            vector<double> frameMs;
+            if (!runCase(root, c, filesystem::absolute(actualPath).string(), frameMs, result.error))
+                break;
+            vector<double> measured(frameMs.begin() + min((size_t)WARMUP_FRAMES, frameMs.size()), frameMs.end());
+            if (measured.empty())
+                continue;
+            nth_element(measured.begin(), measured.begin() + measured.size() / 2, measured.end());
+            double median = measured[measured.size() / 2];
+            if (!result.ran || median < result.frameMs)
+                result.frameMs = median;
+            result.ran = true;
+        }
+        if (!result.ran)
+        {
+            if (result.error.empty())
+                result.error = "no frame times";
+            cout << "ERROR " << result.error << endl;
+            failed = true;
+            continue;
+        }
+        if (calibration)
+            calibrationMs = result.frameMs;
+        result.ratio = calibrationMs > 0.0 ? result.frameMs / calibrationMs : 0.0;
+
+        Image actual;
+        if (!readPPM(actualPath, actual))
+        {
+            result.error = "screenshot not written";
+            cout << "ERROR " << result.error << endl;
+            failed = true;
+            continue;
+        }
+        actual = downsample(actual, DOWNSAMPLE);
+        writePPM(actualPath, actual);
+
+        string goldenPath = "golden/" + c.name + ".ppm";
+        if (update)
+        {
+            writePPM(goldenPath, actual);
+            cases[i].baselineRatio = floor(result.ratio * 100.0 + 0.5) / 100.0;
+            result.imagePassed = result.timePassed = true;
+            cout << "updated, " << result.frameMs << " ms, " << result.ratio << "x calibration" << endl;
+            continue;
+        }
+
+        Image golden;
+        if (!readPPM(goldenPath, golden))
+        {
+            result.error = "no golden image, run --update";
+        }
+        else if (golden.width != actual.width || golden.height != actual.height)
+        {
+            result.error = "size differs from golden image";
+        }
+        else
+        {
+            Image diff;
+            compareImages(golden, actual, threshold, result, diff);
+            writePPM("report/" + c.name + "_diff.ppm", diff);
+            result.imagePassed = result.overRatio * 100.0 <= tolerance;
+        }
+        // 基准为0或校准场景没有测出时间时只记录帧时间
+        result.timePassed = c.baselineRatio <= 0.0 || result.ratio <= 0.0 ||
+                            result.ratio <= c.baselineRatio * (1.0 + c.budgetPercent / 100.0);
+        failed = failed || !result.imagePassed || (strictTime && !result.timePassed);
+        timeWarning = timeWarning || !result.timePassed;
+        cout << (result.imagePassed ? "image ok" : "image FAILED") << ", "
+             << (result.timePassed ? "time ok" : strictTime ? "time FAILED" : "time WARNING")
+             << " (" << result.frameMs << " ms, " << result.ratio << "x calibration)";
+        if (!result.error.empty())
+            cout << " " << result.error;
+        cout << endl;
+    }
+
+    if (update)
+        return saveCases("regression.txt", cases, lines) ? 0 : -1;
+    writeReport("report/report.md", cases, results, threshold, tolerance, strictTime);
+    cout << (failed ? "FAILED" : timeWarning ? "PASSED with frame time warnings" : "PASSED")
+         << ", report written to report/report.md" << endl;
+    return failed ? 1 : 0;
+}
+
+// 在章节目录下运行 从输出中读取每帧的时间
+bool runCase(const string &root, const Case &c, const string &screenshot, vector<double> &frameMs, string &error)
+{
+    ostringstream command;
+    command << "cd \"" << root << "/" << c.dir << "\" && ./" << c.executable
+            << " --headless --frames " << c.frames << " --timestep " << c.timestep
+            << " --screenshot \"" << screenshot << "\" 2>&1";
+    filesystem::remove(screenshot);
+    FILE *pipe = popen(command.str().c_str(), "r");
+    if (pipe == NULL)
+    {
+        error = "cannot run " + c.executable;
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), pipe))
+    {
+        unsigned int frame;
+        double ms;
+        if (sscanf(line, "frame %u: %lf ms", &frame, &ms) == 2)
+            frameMs.push_back(ms);
+    }
+    int status = pclose(pipe);
+    if (status != 0 || frameMs.size() != c.frames)
+    {
+        error = "exit status " + to_string(status) + ", " + to_string(frameMs.size()) + " frames";
+        return false;
+    }
+    return true;
+}
+
+// sRGB 转 CIELAB(D65)
+static void toLab(const unsigned char *rgb, double lab[3])
+{
+    double linear[3];
+    for (int i = 0; i < 3; i++)
+    {
+        double c = rgb[i] / 255.0;
+        linear[i] = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+    }
+    double xyz[3] = {
+        (0.4124 * linear[0] + 0.3576 * linear[1] + 0.1805 * linear[2]) / 0.95047,
+        (0.2126 * linear[0] + 0.7152 * linear[1] + 0.0722 * linear[2]),
+        (0.0193 * linear[0] + 0.1192 * linear[1] + 0.9505 * linear[2]) / 1.08883
+    };
+    for (int i = 0; i < 3; i++)
+        xyz[i] = xyz[i] > 0.008856 ? cbrt(xyz[i]) : 7.787 * xyz[i] + 16.0 / 116.0;
+    lab[0] = 116.0 * xyz[1] - 16.0;
+    lab[1] = 500.0 * (xyz[0] - xyz[1]);
+    lab[2] = 200.0 * (xyz[1] - xyz[2]);
+}
+
+// 按Lab空间中的距离比较 RGB的差值不符合人眼的感觉: 暗处很小的差值也很明显
+// 差异图片: 参考图片变暗作为背景 超过阈值的像素标成红色 越红差别越大
+void compareImages(const Image &golden, const Image &actual, double threshold, CaseResult &result, Image &diff)
+{
+    diff.width = golden.width;
+    diff.height = golden.height;
+    diff.pixels.resize(golden.pixels.size());
+    size_t count = (size_t)golden.width * golden.height;
+    size_t over = 0;
+    double total = 0.0, maximum = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const unsigned char *a = &golden.pixels[i * 3];
+        const unsigned char *b = &actual.pixels[i * 3];
+        double labA[3], labB[3];
+        toLab(a, labA);
+        toLab(b, labB);
+        double deltaE = sqrt((labA[0] - labB[0]) * (labA[0] - labB[0]) +
+                             (labA[1] - labB[1]) * (labA[1] - labB[1]) +
+                             (labA[2] - labB[2]) * (labA[2] - labB[2]));
+        total += deltaE;
+        maximum = deltaE > maximum ? deltaE : maximum;
+        unsigned char gray = (unsigned char)((a[0] + a[1] + a[2]) / 9);
+        unsigned char *d = &diff.pixels[i * 3];
+        if (deltaE > threshold)
+        {
+            over++;
+            d[0] = (unsigned char)(deltaE * 10.0 > 191.0 ? 255 : 64 + deltaE * 10.0);
+            d[1] = d[2] = 0;
+        }
+        else
+        {
+            d[0] = d[1] = d[2] = gray;
+        }
+    }
+    result.meanDeltaE = count ? total / count : 0.0;
+    result.maxDeltaE = maximum;
+    result.overRatio = count ? (double)over / count : 0.0;
+}
+
+void writeReport(const string &path, const vector<Case> &cases, const vector<CaseResult> &results, double threshold, double tolerance,
+                 bool strictTime)
+{
+    ofstream report(path);
+    report << "# 回归测试报告\n\n";
+    report << "色差阈值 " << threshold << " 允许超过阈值的像素 " << tolerance << "%\n\n";
+    report << "帧时间是去掉预热帧后的中位数 基准和实际的倍数都相对于校准场景 " << cases[0].name
+           << (strictTime ? " 超出预算算作失败" : " 超出预算只是警告") << "\n\n";
+    report << "| 章节 | 平均色差 | 最大色差 | 超过阈值 | 图片 | 实际(ms) | 基准(倍) | 实际(倍) | 变化 | 预算 | 帧时间 |\n";
+    report << "| --- | --- | --- | --- | --- | --- | --- | --- | --- | --- | --- |\n";
+    report.setf(ios::fixed);
+    report.precision(2);
+    for (size_t i = 0; i < cases.size(); i++)
+    {
+        const Case &c = cases[i];
+        const CaseResult &r = results[i];
+        if (!r.ran && r.error.empty())
+            continue;
+        report << "| " << c.name << " | ";
+        if (!r.ran)
+        {
+            report << "- | - | - | ERROR " << r.error << " | - | - | - | - | - | - |\n";
+            continue;
+        }
+        report << r.meanDeltaE << " | " << r.maxDeltaE << " | " << r.overRatio * 100.0 << "% | "
+               << (r.imagePassed ? "ok" : r.error.empty() ? "FAILED" : "FAILED " + r.error) << " | ";
+        report << r.frameMs << " | ";
+        if (c.baselineRatio > 0.0 && r.ratio > 0.0)
+            report << c.baselineRatio << " | " << r.ratio << " | "
+                   << (r.ratio / c.baselineRatio - 1.0) * 100.0 << "% | " << c.budgetPercent << "% | ";
+        else
+            report << "- | " << r.ratio << " | - | - | ";
+        report << (r.timePassed ? "ok" : strictTime ? "FAILED" : "WARNING") << " |\n";
+    }
+    report << "\n实际图片 `<章节>.ppm` 差异图片 `<章节>_diff.ppm` 与这个报告在同一目录\n";
+}
+
+// 读二进制PPM(P6) 允许头部有注释
+bool readPPM(const string &path, Image &image)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        return false;
+    string magic;
+    file >> magic;
+    if (magic != "P6")
+        return false;
+    int values[3];
+    for (int i = 0; i < 3; i++)
+    {
+        file >> ws;
+        while (file.peek() == '#')
+        {
+            string comment;
+            getline(file, comment);
+            file >> ws;
+        }
+        file >> values[i];
+    }
+    file.get();
+    if (!file || values[2] != 255)
+        return false;
+    image.width = values[0];
+    image.height = values[1];
+    image.pixels.resize((size_t)image.width * image.height * 3);
+    file.read((char*)image.pixels.data(), image.pixels.size());
+    return (size_t)file.gcount() == image.pixels.size();
+}
+
+bool writePPM(const string &path, const Image &image)
+{
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cout << "ERROR::REGRESSION::FILE_NOT_WRITTEN " << path << endl;
+        return false;
+    }
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+    file.write((const char*)image.pixels.data(), image.pixels.size());
+    return true;
+}
+
+// factor x factor 的像素取平均
+Image downsample(const Image &image, int factor)
+{
+    Image result;
+    result.width = image.width / factor;
+    result.height = image.height / factor;
+    result.pixels.resize((size_t)result.width * result.height * 3);
+    for (int y = 0; y < result.height; y++)
+        for (int x = 0; x < result.width; x++)
+            for (int c = 0; c < 3; c++)
+            {
+                unsigned int sum = 0;
+                for (int dy = 0; dy < factor; dy++)
+                    for (int dx = 0; dx < factor; dx++)
+                        sum += image.pixels[((size_t)(y * factor + dy) * image.width + x * factor + dx) * 3 + c];
+                result.pixels[((size_t)y * result.width + x) * 3 + c] = (unsigned char)((sum + factor * factor / 2) / (factor * factor));
+            }
+    return result;
+}
+
+// 每行: 名称 目录 可执行文件 帧数 每帧时间(s) 基准(校准场景帧时间的倍数) 预算(%)
+// 以#开头的行和空行原样保留
+bool loadCases(const string &path, vector<Case> &cases, vector<string> &lines)
+{
+    ifstream file(path);
+    if (!file)
+    {
+        cout << "ERROR::REGRESSION::MANIFEST_NOT_FOUND " << path << endl;
+        return false;
+    }
+    string line;
+    while (getline(file, line))
+    {
+        lines.push_back(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        Case c;
+        istringstream stream(line);
+        if (!(stream >> c.name >> c.dir >> c.executable >> c.frames >> c.timestep >> c.baselineRatio >> c.budgetPercent))
+        {
+            cout << "ERROR::REGRESSION::MANIFEST_PARSE " << line << endl;
+            return false;
+        }
+        cases.push_back(c);
+    }
+    return true;
+}
+
+// --update 之后写回新的基准 注释行不变
+bool saveCases(const string &path, const vector<Case> &cases, const vector<string> &lines)
+{
+    ofstream file(path);
+    if (!file)
+    {
+        cout << "ERROR::REGRESSION::FILE_NOT_WRITTEN " << path << endl;
+        return false;
+    }
+    size_t next = 0;
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+        if (lines[i].empty() || lines[i][0] == '#')
+        {
+            file << lines[i] << "\n";
+            continue;
+        }
+        const Case &c = cases[next++];
+        file << c.name << " " << c.dir << " " << c.executable << " " << c.frames << " "
+             << c.timestep << " " << c.baselineRatio << " " << c.budgetPercent << "\n";
+    }
+    return true;
+}
@@ -0,0 +1,691 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "point_lights.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+const float FAR_PLANE = 100.0f;
+const glm::vec3 BACKGROUND(0.1f, 0.1f, 0.1f);
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 10.0f, 24.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -30.0f);
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+enum Render_Mode {
+    MODE_FORWARD,     // 12_1的做法 每个片段遍历所有光源
+    MODE_FULLSCREEN,  // 延迟渲染 全屏一遍 每个像素遍历所有光源
+    MODE_VOLUMES,     // 延迟渲染 每个光源画一个球 一次实例化绘制
+    MODE_STENCIL      // 延迟渲染 每个光源先用模板标出球内的像素 再计算光照
+};
+const char *MODE_NAMES[] = { "forward", "fullscreen", "volumes", "stencil" };
+
+// G-buffer: 几何阶段写入三个颜色附件和深度模板
+// 光照阶段写入 lightFBO 它与G-buffer共用同一个深度模板缓冲 光源体积可以与场景的深度比较
+struct GBuffer {
+    unsigned int FBO;
+    unsigned int position;    // RGBA32F 世界空间位置
+    unsigned int normal;      // RGBA16F 法线
+    unsigned int albedoSpec;  // RGBA8 漫反射颜色和镜面光强度
+    unsigned int depthStencil;
+    unsigned int lightFBO;
+    unsigned int lightColor;  // RGBA16F 累加所有光源 不会在每次相加时截断到8位
+    int width;
+    int height;
+};
+
+struct Scene {
+    MeshData cube;
+    MeshData sphere;
+    unsigned int cubeVAO, cubeVBO, cubeEBO;
+    unsigned int sphereVAO, sphereVBO, sphereEBO;
+    unsigned int quadVAO;
+    unsigned int boxDiffuse, boxSpecular, floorDiffuse;
+    vector<glm::mat4> boxes;
+    glm::mat4 floor;
+};
+
+struct Renderer {
+    Shader forward;
+    Shader gbuffer;
+    Shader deferred;
+    Shader volume;
+    Shader stencil;
+    Shader light;
+    Renderer() : forward("./scene.vs", "./forward.fs"), gbuffer("./scene.vs", "./gbuffer.fs"),
+                 deferred("./quad.vs", "./deferred.fs"), volume("./volume.vs", "./volume.fs"),
+                 stencil("./volume.vs", "./stencil.fs"), light("./light.vs", "./light.fs") {}
+};
+
+bool createGBuffer(GBuffer &gbuffer, int width, int height);
+void deleteGBuffer(GBuffer &gbuffer);
+void makeScene(Scene &scene);
+void deleteScene(Scene &scene);
+vector<PointLight> makeLights(unsigned int count, vector<glm::vec3> &bases);
+void animateLights(vector<PointLight> &lights, const vector<glm::vec3> &bases, float time);
+void setupShaders(const Renderer &renderer);
+unsigned long long renderFrame(Render_Mode mode, const Scene &scene, const Renderer &renderer, const GBuffer &gbuffer,
+                               const PointLightBuffer &lightBuffer, unsigned int lightCount, unsigned int query);
+
+// 用法:
+//   ./Deferred_shading.o                       256个点光源 光源体积的延迟渲染 每秒输出帧时间
+//   ./Deferred_shading.o --lights 4096         光源数量
+//   ./Deferred_shading.o --mode forward        forward: 前向渲染 fullscreen: 全屏遍历所有光源
+//                                              volumes: 光源体积(默认) stencil: 模板标记的光源体积
+//   ./Deferred_shading.o --bench --small       4到4096个光源 对比四种方式的帧时间 --small 渲染1/8大小
+//   ./Deferred_shading.o --bench --max 1024    最多到1024个光源
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int lightCount = 256;
+    Render_Mode mode = MODE_VOLUMES;
+    bool bench = false;
+    bool small = false;
+    unsigned int maxLights = 4096;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+            lightCount = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (int m = 0; m < 4; m++)
+                if (strcmp(argv[i], MODE_NAMES[m]) == 0)
+                    mode = (Render_Mode)m;
+        }
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+        else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            maxLights = (unsigned int)atoi(argv[++i]);
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Deferred shading", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // G-buffer固定为窗口的初始大小 --small 时只渲染左下角的1/8
+    int width = small ? SCR_WIDTH / 8 : SCR_WIDTH;
+    int height = small ? SCR_HEIGHT / 8 : SCR_HEIGHT;
+    GBuffer gbuffer;
+    if (!createGBuffer(gbuffer, width, height))
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    Scene scene;
+    makeScene(scene);
+    // 着色器 查询对象和光源缓冲要在 glfwTerminate 之前释放 所以在堆上创建
+    Renderer *renderer = new Renderer();
+    setupShaders(*renderer);
+    PointLightBuffer *lightBuffer = new PointLightBuffer(bench ? maxLights : lightCount);
+    unsigned int query;
+    glGenQueries(1, &query);
+
+    if (bench)
+    {
+        const int frames = 5;
+        // 一帧超过这个时间后 这种方式不再测试更多的光源
+        const double slowMs = 3000.0;
+        bool slow[4] = { false, false, false, false };
+        // 每个像素: 位置16字节 法线8字节 颜色4字节 深度模板4字节 光照结果8字节
+        cout << width << "x" << height << ", G-buffer " << width * height * 40 / (1024.0 * 1024.0) << " MB, "
+             << scene.boxes.size() + 1 << " objects" << endl;
+        cout << "lights  mode        frame ms   light evaluations (M)" << endl;
+        for (unsigned int count = 4; count <= maxLights; count *= 4)
+        {
+            vector<glm::vec3> bases;
+            vector<PointLight> lights = makeLights(count, bases);
+            animateLights(lights, bases, 0.0f);
+            lightBuffer->Upload(lights);
+            for (int m = 0; m < 4; m++)
+            {
+                cout.setf(ios::left);
+                cout.width(8);
+                cout << count;
+                cout.width(12);
+                cout << MODE_NAMES[m];
+                if (slow[m])
+                {
+                    cout << "skipped" << endl;
+                    continue;
+                }
+                unsigned long long samples = 0;
+                double total = 0.0;
+                for (int f = 0; f <= frames; f++)
+                {
+                    auto start = chrono::steady_clock::now();
+                    samples = renderFrame((Render_Mode)m, scene, *renderer, gbuffer, *lightBuffer, count, query);
+                    glFinish();
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    // 第一帧包含着色器的编译和缓冲的分配 不计入
+                    if (f > 0)
+                        total += ms;
+                    if (ms > slowMs)
+                    {
+                        slow[m] = true;
+                        total = ms * frames;
+                        break;
+                    }
+                }
+                cout.width(11);
+                cout << total / frames;
+                if (m == MODE_STENCIL)
+                    cout << "-";
+                else
+                    cout << samples / 1.0e6;
+                cout << endl;
+            }
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window))
+                break;
+        }
+    }
+    else
+    {
+        vector<glm::vec3> bases;
+        vector<PointLight> lights = makeLights(lightCount, bases);
+        cout << MODE_NAMES[mode] << ", " << lightCount << " lights, radius " << lights[0].radius << endl;
+        float lastReport = 0.0f;
+        unsigned int frameCount = 0;
+        while (!glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            animateLights(lights, bases, currentFrame);
+            lightBuffer->Upload(lights);
+            renderFrame(mode, scene, *renderer, gbuffer, *lightBuffer, lightCount, 0);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            frameCount++;
+            if (currentFrame - lastReport >= 1.0f)
+            {
+                cout << MODE_NAMES[mode] << ", " << lightCount << " lights: "
+                     << (currentFrame - lastReport) * 1000.0f / frameCount << " ms/frame" << endl;
+                lastReport = currentFrame;
+                frameCount = 0;
+            }
+        }
+    }
+
+    glDeleteQueries(1, &query);
+    delete lightBuffer;
+    delete renderer;
+    deleteScene(scene);
+    deleteGBuffer(gbuffer);
+    glfwTerminate();
+    return 0;
+}
+
+// 着色器中不变的uniform: 纹理单元和方向光 聚光的参数
+void setupShaders(const Renderer &renderer)
+{
+    const Shader *lit[2] = { &renderer.forward, &renderer.deferred };
+    for (int i = 0; i < 2; i++)
+    {
+        const Shader &shader = *lit[i];
+        shader.use();
+        // 光源很多 定向光调暗
+        shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+        shader.setVec3("dirLight.ambient", 0.02f, 0.02f, 0.02f);
+        shader.setVec3("dirLight.diffuse", 0.05f, 0.05f, 0.05f);
+        shader.setVec3("dirLight.specular", 0.05f, 0.05f, 0.05f);
+        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+        shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+        shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+        shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+        shader.setInt("lights", 2);
+    }
+    renderer.forward.use();
+    renderer.forward.setInt("material.diffuse", 0);
+    renderer.forward.setInt("material.specular", 1);
+    renderer.forward.setFloat("material.shininess", 32.0f);
+    renderer.gbuffer.use();
+    renderer.gbuffer.setInt("material.diffuse", 0);
+    renderer.gbuffer.setInt("material.specular", 1);
+
+    const Shader *deferred[2] = { &renderer.deferred, &renderer.volume };
+    for (int i = 0; i < 2; i++)
+    {
+        const Shader &shader = *deferred[i];
+        shader.use();
+        shader.setInt("gPosition", 3);
+        shader.setInt("gNormal", 4);
+        shader.setInt("gAlbedoSpec", 5);
+        shader.setInt("lights", 2);
+        shader.setFloat("shininess", 32.0f);
+    }
+    renderer.deferred.use();
+    renderer.deferred.setVec3("background", BACKGROUND);
+    renderer.stencil.use();
+    renderer.stencil.setInt("lights", 2);
+    renderer.light.use();
+    renderer.light.setInt("lights", 2);
+}
+
+// 每帧变化的uniform
+static void setCameraUniforms(const Shader &shader, const glm::mat4 &projection, const glm::mat4 &view)
+{
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+}
+
+static void setViewUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+}
+
+static void drawScene(const Scene &scene, const Shader &shader)
+{
+    glBindVertexArray(scene.cubeVAO);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.floorDiffuse);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.boxSpecular);
+    shader.setMat4("model", scene.floor);
+    shader.setVec2("uvScale", 20.0f, 20.0f);
+    glDrawElements(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.boxDiffuse);
+    shader.setVec2("uvScale", 1.0f, 1.0f);
+    for (size_t i = 0; i < scene.boxes.size(); i++)
+    {
+        shader.setMat4("model", scene.boxes[i]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0);
+    }
+}
+
+// 画一帧 query 不为0时返回光照计算的次数(像素 * 光源)
+unsigned long long renderFrame(Render_Mode mode, const Scene &scene, const Renderer &renderer, const GBuffer &gbuffer,
+                               const PointLightBuffer &lightBuffer, unsigned int lightCount, unsigned int query)
+{
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+    glm::mat4 view = camera.GetViewMatrix();
+    GLuint64 samples = 0;
+    lightBuffer.Bind(2);
+    glViewport(0, 0, gbuffer.width, gbuffer.height);
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+
+    if (mode == MODE_FORWARD)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glClearColor(BACKGROUND.r, BACKGROUND.g, BACKGROUND.b, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        renderer.forward.use();
+        setCameraUniforms(renderer.forward, projection, view);
+        setViewUniforms(renderer.forward);
+        renderer.forward.setInt("pointLightCount", (int)lightCount);
+        // 通过深度测试的片段数 被后画的物体挡住的片段也已经遍历过所有光源
+        if (query)
+            glBeginQuery(GL_SAMPLES_PASSED, query);
+        drawScene(scene, renderer.forward);
+        if (query)
+        {
+            glEndQuery(GL_SAMPLES_PASSED);
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+            samples *= lightCount;
+        }
+    }
+    else
+    {
+        // 几何阶段
+        glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.FBO);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        renderer.gbuffer.use();
+        setCameraUniforms(renderer.gbuffer, projection, view);
+        drawScene(scene, renderer.gbuffer);
+
+        // 光照阶段 全屏计算定向光和聚光
+        glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.lightFBO);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D, gbuffer.position);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, gbuffer.normal);
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_2D, gbuffer.albedoSpec);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_DEPTH_TEST);
+        renderer.deferred.use();
+        setViewUniforms(renderer.deferred);
+        renderer.deferred.setInt("pointLightCount", mode == MODE_FULLSCREEN ? (int)lightCount : 0);
+        glBindVertexArray(scene.quadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (mode == MODE_FULLSCREEN)
+            samples = (GLuint64)gbuffer.width * gbuffer.height * lightCount;
+
+        // 点光源累加到上面的结果上
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        // 球超出远平面时不被裁掉
+        glEnable(GL_DEPTH_CLAMP);
+        glBindVertexArray(scene.sphereVAO);
+        GLsizei sphereIndices = (GLsizei)scene.sphere.indices.size();
+        if (mode == MODE_VOLUMES)
+        {
+            // 只画球的背面 背面在物体后面(深度 >= 物体)的像素才可能被照亮
+            // 摄像机在球内时正面被近平面裁掉 画背面仍然正确
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_GEQUAL);
+            renderer.volume.use();
+            setCameraUniforms(renderer.volume, projection, view);
+            renderer.volume.setVec3("viewPos", camera.Position);
+            renderer.volume.setInt("lightBase", 0);
+            if (query)
+                glBeginQuery(GL_SAMPLES_PASSED, query);
+            glDrawElementsInstanced(GL_TRIANGLES, sphereIndices, GL_UNSIGNED_INT, 0, lightCount);
+            if (query)
+            {
+                glEndQuery(GL_SAMPLES_PASSED);
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+            }
+            glDisable(GL_CULL_FACE);
+        }
+        else if (mode == MODE_STENCIL)
+        {
+            // 背面的深度测试只能排除球前面的像素 球后面的像素还要用模板排除
+            renderer.stencil.use();
+            setCameraUniforms(renderer.stencil, projection, view);
+            renderer.volume.use();
+            setCameraUniforms(renderer.volume, projection, view);
+            renderer.volume.setVec3("viewPos", camera.Position);
+            GLint stencilBase = glGetUniformLocation(renderer.stencil.ID, "lightBase");
+            GLint volumeBase = glGetUniformLocation(renderer.volume.ID, "lightBase");
+            glEnable(GL_STENCIL_TEST);
+            for (unsigned int i = 0; i < lightCount; i++)
+            {
+                // 模板: 背面在物体后面 +1 正面在物体后面 -1 物体在球内的像素不为0
+                glUseProgram(renderer.stencil.ID);
+                glUniform1i(stencilBase, (int)i);
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                glDisable(GL_BLEND);
+                glDisable(GL_CULL_FACE);
+                glEnable(GL_DEPTH_TEST);
+                glDepthFunc(GL_LESS);
+                glStencilFunc(GL_ALWAYS, 0, 0);
+                glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+                glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+                glDrawElements(GL_TRIANGLES, sphereIndices, GL_UNSIGNED_INT, 0);
+
+                // 光照: 只画模板不为0的像素 同时把模板清零 下一个光源不需要再清除模板
+                glUseProgram(renderer.volume.ID);
+                glUniform1i(volumeBase, (int)i);
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                glEnable(GL_BLEND);
+                glEnable(GL_CULL_FACE);
+                glCullFace(GL_FRONT);
+                glDisable(GL_DEPTH_TEST);
+                glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+                glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+                glDrawElements(GL_TRIANGLES, sphereIndices, GL_UNSIGNED_INT, 0);
+            }
+            glDisable(GL_STENCIL_TEST);
+            glDisable(GL_CULL_FACE);
+        }
+        glDisable(GL_DEPTH_CLAMP);
+        glDisable(GL_BLEND);
+
+        // 光照结果和深度复制到窗口 光源的小立方体还要与场景做深度测试
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer.lightFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, gbuffer.width, gbuffer.height, 0, 0, gbuffer.width, gbuffer.height,
+                          GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
+    // 前向绘制光源本身
+    renderer.light.use();
+    setCameraUniforms(renderer.light, projection, view);
+    glBindVertexArray(scene.cubeVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0, lightCount);
+    return samples;
+}
+
+static unsigned int createTarget(GLenum internalFormat, GLenum format, GLenum type, int width, int height)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+bool createGBuffer(GBuffer &gbuffer, int width, int height)
+{
+    gbuffer.width = width;
+    gbuffer.height = height;
+    gbuffer.position = createTarget(GL_RGBA32F, GL_RGBA, GL_FLOAT, width, height);
+    gbuffer.normal = createTarget(GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+    gbuffer.albedoSpec = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    gbuffer.lightColor = createTarget(GL_RGBA16F, GL_RGBA, GL_FLOAT, width, height);
+    glGenRenderbuffers(1, &gbuffer.depthStencil);
+    glBindRenderbuffer(GL_RENDERBUFFER, gbuffer.depthStencil);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glGenFramebuffers(1, &gbuffer.FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gbuffer.position, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gbuffer.normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gbuffer.albedoSpec, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, gbuffer.depthStencil);
+    // 片段着色器的三个输出分别写入三个附件
+    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, attachments);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    glGenFramebuffers(1, &gbuffer.lightFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.lightFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gbuffer.lightColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, gbuffer.depthStencil);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+        std::cout << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    return complete;
+}
+
+void deleteGBuffer(GBuffer &gbuffer)
+{
+    unsigned int framebuffers[2] = { gbuffer.FBO, gbuffer.lightFBO };
+    unsigned int textures[4] = { gbuffer.position, gbuffer.normal, gbuffer.albedoSpec, gbuffer.lightColor };
+    glDeleteFramebuffers(2, framebuffers);
+    glDeleteTextures(4, textures);
+    glDeleteRenderbuffers(1, &gbuffer.depthStencil);
+}
+
+// 40x40的地面上12x12个箱子 随机转一个角度 一部分上面再叠一个
+void makeScene(Scene &scene)
+{
+    scene.cube = MakeCube();
+    scene.sphere = MakeSphere(16, 8);
+    UploadMesh(scene.cube, scene.cubeVAO, scene.cubeVBO, scene.cubeEBO);
+    UploadMesh(scene.sphere, scene.sphereVAO, scene.sphereVBO, scene.sphereEBO);
+    // 全屏三角形不需要顶点数据 但核心模式下必须绑定一个VAO
+    glGenVertexArrays(1, &scene.quadVAO);
+
+    scene.boxDiffuse = loadTexture("../12_1Multiple_lights/container2.png");
+    scene.boxSpecular = loadTexture("../12_1Multiple_lights/container2_specular.png");
+    scene.floorDiffuse = loadTexture("../3_1Textures/bricks2.jpg");
+
+    scene.floor = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)), glm::vec3(40.0f, 0.2f, 40.0f));
+    srand(7);
+    for (int z = 0; z < 12; z++)
+        for (int x = 0; x < 12; x++)
+        {
+            glm::vec3 position(-16.5f + x * 3.0f, -0.4f, -16.5f + z * 3.0f);
+            float angle = (float)(rand() % 90);
+            glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+            scene.boxes.push_back(model);
+            if (rand() % 4 == 0)
+                scene.boxes.push_back(glm::rotate(glm::translate(model, glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+}
+
+void deleteScene(Scene &scene)
+{
+    unsigned int arrays[3] = { scene.cubeVAO, scene.sphereVAO, scene.quadVAO };
+    unsigned int buffers[4] = { scene.cubeVBO, scene.cubeEBO, scene.sphereVBO, scene.sphereEBO };
+    unsigned int textures[3] = { scene.boxDiffuse, scene.boxSpecular, scene.floorDiffuse };
+    glDeleteVertexArrays(3, arrays);
+    glDeleteBuffers(4, buffers);
+    glDeleteTextures(3, textures);
+}
+
+// 光源越多 每个越暗 照亮的范围越小 场景的总亮度大致不变
+vector<PointLight> makeLights(unsigned int count, vector<glm::vec3> &bases)
+{
+    float scale = 1.0f / sqrtf((float)count);
+    float intensity = fminf(1.0f, 16.0f * scale);
+    float range = fmaxf(2.5f, fminf(20.0f, 80.0f * scale));
+    vector<PointLight> lights = MakePointLights(count, glm::vec3(-18.0f, -0.6f, -18.0f), glm::vec3(18.0f, 1.5f, 18.0f), range, intensity);
+    bases.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+        bases[i] = lights[i].position;
+    return lights;
+}
+
+// 每个光源绕自己的初始位置转圈 速度和方向各不相同
+void animateLights(vector<PointLight> &lights, const vector<glm::vec3> &bases, float time)
+{
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        float speed = 0.3f + (i % 7) * 0.1f;
+        float angle = time * (i % 2 ? speed : -speed) + i * 2.39996f;
+        lights[i].position = bases[i] + glm::vec3(cosf(angle), 0.0f, sinf(angle)) * 1.5f;
+    }
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,103 @@
+// 光照阶段的全屏部分: 每个像素只计算一次定向光和聚光
+// pointLightCount 不为0时还要遍历所有点光源(不使用光源体积的做法 作为对比)
+#version 330 core
+out vec4 FragColor;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+
+uniform samplerBuffer lights;
+uniform int pointLightCount;
+uniform vec3 viewPos;
+uniform float shininess;
+uniform vec3 background;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+
+void main()
+{
+    // G-buffer与渲染的区域一样大 直接按像素读取
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 position = texelFetch(gPosition, pixel, 0);
+    if (position.w == 0.0)
+    {
+        FragColor = vec4(background, 1.0);
+        return;
+    }
+    vec3 FragPos = position.xyz;
+    vec3 norm = texelFetch(gNormal, pixel, 0).xyz;
+    vec4 albedoSpec = texelFetch(gAlbedoSpec, pixel, 0);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, albedoSpec.rgb, albedoSpec.a);
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, albedoSpec.rgb, albedoSpec.a);
+    for (int i = 0; i < pointLightCount; i++)
+        result += CalcPointLight(i, norm, FragPos, viewDir, albedoSpec.rgb, albedoSpec.a);
+
+    FragColor = vec4(result, 1.0);
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    return light.ambient * albedo + light.diffuse * diff * albedo + light.specular * spec * specularMask;
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    return light.ambient * albedo + (light.diffuse * diff * albedo + light.specular * spec * specularMask) * intensity;
+}
+
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec4 positionRadius = texelFetch(lights, index * 3);
+    vec4 colorConstant = texelFetch(lights, index * 3 + 1);
+    vec4 attenuationTerms = texelFetch(lights, index * 3 + 2);
+    float distance = length(positionRadius.xyz - fragPos);
+    if (distance > positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = (positionRadius.xyz - fragPos) / distance;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float attenuation = 1.0 / (colorConstant.w + attenuationTerms.x * distance + attenuationTerms.y * (distance * distance));
+
+    vec3 color = colorConstant.rgb;
+    return (0.05 * color * albedo + 0.8 * color * diff * albedo + color * spec * specularMask) * attenuation;
+}
@@ -0,0 +1,103 @@
+// 前向渲染: 与12_1的 shader.fs 相同 每个片段计算定向光 聚光和所有的点光源
+// 点光源从缓冲纹理读取 数量不再固定
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+uniform Material material;
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+
+// 每个光源3个纹素 布局见 include/point_lights.h
+uniform samplerBuffer lights;
+uniform int pointLightCount;
+uniform vec3 viewPos;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 albedo = texture(material.diffuse, TexCoords).rgb;
+    float specularMask = texture(material.specular, TexCoords).r;
+
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, albedo, specularMask);
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, albedo, specularMask);
+    // 深度测试之前每个片段都要遍历所有光源 即使它之后被挡住
+    for (int i = 0; i < pointLightCount; i++)
+        result += CalcPointLight(i, norm, FragPos, viewDir, albedo, specularMask);
+
+    FragColor = vec4(result, 1.0);
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return light.ambient * albedo + light.diffuse * diff * albedo + light.specular * spec * specularMask;
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return light.ambient * albedo + (light.diffuse * diff * albedo + light.specular * spec * specularMask) * intensity;
+}
+
+// 12_1中点光源的 ambient diffuse specular 为颜色的 0.05 0.8 1.0 倍
+// 超出半径的光照小于1/256 直接跳过
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec4 positionRadius = texelFetch(lights, index * 3);
+    vec4 colorConstant = texelFetch(lights, index * 3 + 1);
+    vec4 attenuationTerms = texelFetch(lights, index * 3 + 2);
+    float distance = length(positionRadius.xyz - fragPos);
+    if (distance > positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = (positionRadius.xyz - fragPos) / distance;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float attenuation = 1.0 / (colorConstant.w + attenuationTerms.x * distance + attenuationTerms.y * (distance * distance));
+
+    vec3 color = colorConstant.rgb;
+    return (0.05 * color * albedo + 0.8 * color * diff * albedo + color * spec * specularMask) * attenuation;
+}
@@ -0,0 +1,23 @@
+// 几何阶段: 不计算光照 只把光照需要的数据写进G-buffer的三个颜色附件
+#version 330 core
+layout (location = 0) out vec4 gPosition;   // 世界空间位置 w为1表示这个像素有物体
+layout (location = 1) out vec4 gNormal;     // 法线
+layout (location = 2) out vec4 gAlbedoSpec; // rgb 漫反射颜色 a 镜面光强度
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+};
+uniform Material material;
+
+void main()
+{
+    gPosition = vec4(FragPos, 1.0);
+    gNormal = vec4(normalize(Normal), 0.0);
+    gAlbedoSpec.rgb = texture(material.diffuse, TexCoords).rgb;
+    gAlbedoSpec.a = texture(material.specular, TexCoords).r;
+}
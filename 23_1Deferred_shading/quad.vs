@@ -0,0 +1,9 @@
+// 覆盖整个屏幕的三角形 不需要顶点数据
+// gl_VertexID 为 0 1 2 时位置为 (-1,-1) (3,-1) (-1,3)
+#version 330 core
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
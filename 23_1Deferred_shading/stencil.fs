@@ -0,0 +1,6 @@
+// 模板阶段只需要深度测试的结果 不输出颜色
+#version 330 core
+
+void main()
+{
+}
@@ -0,0 +1,47 @@
+// 一个点光源对它体积内的像素的贡献 用加法混合累加到光照结果上
+#version 330 core
+out vec4 FragColor;
+
+flat in int LightIndex;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform samplerBuffer lights;
+uniform vec3 viewPos;
+uniform float shininess;
+
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 position = texelFetch(gPosition, pixel, 0);
+    if (position.w == 0.0)
+        discard;
+    vec3 FragPos = position.xyz;
+    vec3 norm = texelFetch(gNormal, pixel, 0).xyz;
+    vec4 albedoSpec = texelFetch(gAlbedoSpec, pixel, 0);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    FragColor = vec4(CalcPointLight(LightIndex, norm, FragPos, viewDir, albedoSpec.rgb, albedoSpec.a), 0.0);
+}
+
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec4 positionRadius = texelFetch(lights, index * 3);
+    vec4 colorConstant = texelFetch(lights, index * 3 + 1);
+    vec4 attenuationTerms = texelFetch(lights, index * 3 + 2);
+    float distance = length(positionRadius.xyz - fragPos);
+    if (distance > positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = (positionRadius.xyz - fragPos) / distance;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    float attenuation = 1.0 / (colorConstant.w + attenuationTerms.x * distance + attenuationTerms.y * (distance * distance));
+
+    vec3 color = colorConstant.rgb;
+    return (0.05 * color * albedo + 0.8 * color * diff * albedo + color * spec * specularMask) * attenuation;
+}
@@ -0,0 +1,20 @@
+// 点光源的体积: 把球放大到光源的半径 只有球覆盖的像素才计算这个光源
+// 第 lightBase + gl_InstanceID 个光源 一次绘制可以画很多个光源
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer lights;
+uniform int lightBase;
+
+flat out int LightIndex;
+
+void main()
+{
+    LightIndex = lightBase + gl_InstanceID;
+    vec4 positionRadius = texelFetch(lights, LightIndex * 3);
+    // 网格是半径0.5的球 多边形的面在球面里面 放大10%保证包住整个半径
+    vec3 position = positionRadius.xyz + aPos * (positionRadius.w * 2.2);
+    gl_Position = projection * view * vec4(position, 1.0);
+}
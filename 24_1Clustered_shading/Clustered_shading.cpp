@@ -0,0 +1,531 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "point_lights.h"
+#include "thread_pool.h"
+#include "light_clusters.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+const float NEAR_PLANE = 0.1f;
+const float FAR_PLANE = 100.0f;
+const glm::vec3 BACKGROUND(0.1f, 0.1f, 0.1f);
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 10.0f, 24.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -30.0f);
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+enum Render_Mode {
+    MODE_FORWARD,    // 每个片段遍历所有光源
+    MODE_CLUSTERED   // 每个片段只遍历所在簇中的光源
+};
+const char *MODE_NAMES[] = { "forward", "clustered" };
+
+// 与23_1相同的场景: 地面和178个箱子
+struct Scene {
+    MeshData cube;
+    unsigned int cubeVAO, cubeVBO, cubeEBO;
+    unsigned int boxDiffuse, boxSpecular, floorDiffuse;
+    vector<glm::mat4> boxes;
+    glm::mat4 floor;
+};
+
+struct Renderer {
+    Shader forward;
+    Shader clustered;
+    Shader light;
+    Renderer() : forward("./scene.vs", "./forward.fs"), clustered("./scene.vs", "./clustered.fs"),
+                 light("./light.vs", "./light.fs") {}
+};
+
+void makeScene(Scene &scene);
+void deleteScene(Scene &scene);
+vector<PointLight> makeLights(unsigned int count, vector<glm::vec3> &bases);
+void animateLights(vector<PointLight> &lights, const vector<glm::vec3> &bases, float time);
+void setupShaders(const Renderer &renderer, const LightClusters &clusters);
+glm::mat4 projectionMatrix();
+void assignLights(LightClusters &clusters, const vector<PointLight> &lights, ThreadPool *pool);
+void renderFrame(Render_Mode mode, const Scene &scene, const Renderer &renderer, const LightClusters &clusters,
+                 const PointLightBuffer &lightBuffer, unsigned int lightCount, int width, int height, bool heatmap);
+
+// 用法:
+//   ./Clustered_shading.o                       1024个点光源 分簇渲染 每秒输出帧时间和簇的统计
+//   ./Clustered_shading.o --lights 10000        光源数量
+//   ./Clustered_shading.o --mode forward        forward: 每个片段遍历所有光源 clustered: 分簇(默认)
+//   ./Clustered_shading.o --heatmap             按每个簇中光源的数量着色
+//   ./Clustered_shading.o --threads 4           分配光源的线程数 默认使用全部核心 1为单线程
+//   ./Clustered_shading.o --bench --small       64到10000个光源 对比分配光源的时间和两种方式的帧时间
+//   ./Clustered_shading.o --bench --max 4096    最多到4096个光源
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int lightCount = 1024;
+    Render_Mode mode = MODE_CLUSTERED;
+    bool heatmap = false;
+    bool bench = false;
+    bool small = false;
+    unsigned int threads = 0;
+    unsigned int maxLights = 10000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+            lightCount = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (int m = 0; m < 2; m++)
+                if (strcmp(argv[i], MODE_NAMES[m]) == 0)
+                    mode = (Render_Mode)m;
+        }
+        else if (strcmp(argv[i], "--heatmap") == 0)
+            heatmap = true;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+        else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            maxLights = (unsigned int)atoi(argv[++i]);
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Clustered shading", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // 渲染的大小固定为窗口的初始大小 --small 时只渲染左下角的1/8
+    int width = small ? SCR_WIDTH / 8 : SCR_WIDTH;
+    int height = small ? SCR_HEIGHT / 8 : SCR_HEIGHT;
+
+    Scene scene;
+    makeScene(scene);
+    ThreadPool pool(threads);
+    // 着色器 簇和光源的缓冲要在 glfwTerminate 之前释放 所以在堆上创建
+    Renderer *renderer = new Renderer();
+    LightClusters *clusters = new LightClusters(16, 9, 24);
+    PointLightBuffer *lightBuffer = new PointLightBuffer(bench ? maxLights : lightCount);
+    assignLights(*clusters, vector<PointLight>(), NULL);
+    setupShaders(*renderer, *clusters);
+
+    if (bench)
+    {
+        const unsigned int counts[] = { 64, 256, 1024, 4096, 10000 };
+        const int frames = 5;
+        const int assignRuns = 20;
+        // 一帧超过这个时间后 这种方式不再测试更多的光源
+        const double slowMs = 3000.0;
+        bool slow[2] = { false, false };
+        cout << width << "x" << height << ", " << clusters->X << "x" << clusters->Y << "x" << clusters->Z << " clusters, "
+             << pool.Size() << " threads" << endl;
+        cout << "lights  visible  assign ms  (1 thread)  avg/cluster  max/cluster  forward ms  clustered ms" << endl;
+        for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]) && counts[c] <= maxLights; c++)
+        {
+            unsigned int count = counts[c];
+            vector<glm::vec3> bases;
+            vector<PointLight> lights = makeLights(count, bases);
+            animateLights(lights, bases, 0.0f);
+            lightBuffer->Upload(lights);
+
+            // 只有CPU的部分 多次取平均
+            double assignMs[2] = { 0.0, 0.0 };
+            for (int t = 0; t < 2; t++)
+                for (int r = 0; r < assignRuns; r++)
+                {
+                    assignLights(*clusters, lights, t == 0 ? &pool : NULL);
+                    assignMs[t] += clusters->Stats().assignMs / assignRuns;
+                }
+            const LightClusterStats &stats = clusters->Stats();
+            clusters->Upload();
+
+            double frameMs[2] = { 0.0, 0.0 };
+            for (int m = 0; m < 2; m++)
+            {
+                if (slow[m])
+                    continue;
+                for (int f = 0; f <= frames; f++)
+                {
+                    auto start = chrono::steady_clock::now();
+                    // 分簇的帧时间包括每帧在CPU上分配光源和上传
+                    if (m == MODE_CLUSTERED)
+                    {
+                        assignLights(*clusters, lights, &pool);
+                        clusters->Upload();
+                    }
+                    renderFrame((Render_Mode)m, scene, *renderer, *clusters, *lightBuffer, count, width, height, false);
+                    glFinish();
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    // 第一帧包含着色器的编译和缓冲的分配 不计入
+                    if (f > 0)
+                        frameMs[m] += ms / frames;
+                    if (ms > slowMs)
+                    {
+                        slow[m] = true;
+                        frameMs[m] = ms;
+                        break;
+                    }
+                }
+            }
+
+            cout.setf(ios::left);
+            cout.width(8);
+            cout << count;
+            cout.width(9);
+            cout << stats.visible;
+            cout.width(11);
+            cout << assignMs[0];
+            cout.width(12);
+            cout << assignMs[1];
+            cout.width(13);
+            cout << (stats.nonEmpty ? (double)stats.references / stats.nonEmpty : 0.0);
+            cout.width(13);
+            cout << stats.maxPerCluster;
+            cout.width(12);
+            if (frameMs[0] == 0.0)
+                cout << "skipped";
+            else
+                cout << frameMs[0];
+            cout << frameMs[1] << endl;
+            if (stats.dropped)
+                cout << "        index list over GL_MAX_TEXTURE_BUFFER_SIZE (" << clusters->MaxIndices << "), "
+                     << stats.dropped << " light references dropped" << endl;
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window))
+                break;
+        }
+    }
+    else
+    {
+        vector<glm::vec3> bases;
+        vector<PointLight> lights = makeLights(lightCount, bases);
+        cout << MODE_NAMES[mode] << ", " << lightCount << " lights, radius " << lights[0].radius << ", "
+             << pool.Size() << " threads" << endl;
+        float lastReport = 0.0f;
+        unsigned int frameCount = 0;
+        double assignMs = 0.0;
+        while (!glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            animateLights(lights, bases, currentFrame);
+            lightBuffer->Upload(lights);
+            if (mode == MODE_CLUSTERED)
+            {
+                assignLights(*clusters, lights, &pool);
+                clusters->Upload();
+                assignMs += clusters->Stats().assignMs;
+            }
+            renderFrame(mode, scene, *renderer, *clusters, *lightBuffer, lightCount, width, height, heatmap);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            frameCount++;
+            if (currentFrame - lastReport >= 1.0f)
+            {
+                cout << MODE_NAMES[mode] << ", " << lightCount << " lights: "
+                     << (currentFrame - lastReport) * 1000.0f / frameCount << " ms/frame";
+                if (mode == MODE_CLUSTERED)
+                {
+                    const LightClusterStats &stats = clusters->Stats();
+                    cout << ", assign " << assignMs / frameCount << " ms, " << stats.visible << " visible, "
+                         << stats.references << " references, max " << stats.maxPerCluster << " per cluster";
+                    if (stats.dropped)
+                        cout << ", " << stats.dropped << " dropped (GL_MAX_TEXTURE_BUFFER_SIZE " << clusters->MaxIndices << ")";
+                }
+                cout << endl;
+                lastReport = currentFrame;
+                frameCount = 0;
+                assignMs = 0.0;
+            }
+        }
+    }
+
+    delete lightBuffer;
+    delete clusters;
+    delete renderer;
+    deleteScene(scene);
+    glfwTerminate();
+    return 0;
+}
+
+glm::mat4 projectionMatrix()
+{
+    return glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, NEAR_PLANE, FAR_PLANE);
+}
+
+// 按当前的摄像机把光源分配到簇中 pool 为NULL时单线程
+void assignLights(LightClusters &clusters, const vector<PointLight> &lights, ThreadPool *pool)
+{
+    clusters.Build(lights, camera.GetViewMatrix(), projectionMatrix(), NEAR_PLANE, FAR_PLANE, pool);
+}
+
+// 着色器中不变的uniform: 纹理单元和方向光 聚光的参数 簇的划分
+void setupShaders(const Renderer &renderer, const LightClusters &clusters)
+{
+    const Shader *lit[2] = { &renderer.forward, &renderer.clustered };
+    for (int i = 0; i < 2; i++)
+    {
+        const Shader &shader = *lit[i];
+        shader.use();
+        // 光源很多 定向光调暗
+        shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+        shader.setVec3("dirLight.ambient", 0.02f, 0.02f, 0.02f);
+        shader.setVec3("dirLight.diffuse", 0.05f, 0.05f, 0.05f);
+        shader.setVec3("dirLight.specular", 0.05f, 0.05f, 0.05f);
+        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+        shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+        shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+        shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+        shader.setInt("material.diffuse", 0);
+        shader.setInt("material.specular", 1);
+        shader.setFloat("material.shininess", 32.0f);
+        shader.setInt("lights", 2);
+    }
+    renderer.clustered.use();
+    renderer.clustered.setInt("clusterGrid", 3);
+    renderer.clustered.setInt("clusterIndices", 4);
+    glUniform3ui(glGetUniformLocation(renderer.clustered.ID, "clusterCount"), clusters.X, clusters.Y, clusters.Z);
+    renderer.clustered.setFloat("sliceScale", clusters.SliceScale());
+    renderer.clustered.setFloat("sliceBias", clusters.SliceBias());
+    renderer.clustered.setFloat("near", NEAR_PLANE);
+    renderer.clustered.setFloat("far", FAR_PLANE);
+    renderer.light.use();
+    renderer.light.setInt("lights", 2);
+}
+
+static void drawScene(const Scene &scene, const Shader &shader)
+{
+    glBindVertexArray(scene.cubeVAO);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.floorDiffuse);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.boxSpecular);
+    shader.setMat4("model", scene.floor);
+    shader.setVec2("uvScale", 20.0f, 20.0f);
+    glDrawElements(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.boxDiffuse);
+    shader.setVec2("uvScale", 1.0f, 1.0f);
+    for (size_t i = 0; i < scene.boxes.size(); i++)
+    {
+        shader.setMat4("model", scene.boxes[i]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0);
+    }
+}
+
+// 分簇时 clusters 已经按这一帧的摄像机分配好并上传
+void renderFrame(Render_Mode mode, const Scene &scene, const Renderer &renderer, const LightClusters &clusters,
+                 const PointLightBuffer &lightBuffer, unsigned int lightCount, int width, int height, bool heatmap)
+{
+    glm::mat4 projection = projectionMatrix();
+    glm::mat4 view = camera.GetViewMatrix();
+    lightBuffer.Bind(2);
+    glViewport(0, 0, width, height);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(BACKGROUND.r, BACKGROUND.g, BACKGROUND.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const Shader &shader = mode == MODE_CLUSTERED ? renderer.clustered : renderer.forward;
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.setVec3("viewPos", camera.Position);
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    if (mode == MODE_CLUSTERED)
+    {
+        clusters.Bind(3, 4);
+        // 簇在屏幕上的大小随渲染的大小变化 深度的划分在 setupShaders 中设置
+        shader.setVec2("tileSize", (float)width / clusters.X, (float)height / clusters.Y);
+        shader.setBool("heatmap", heatmap);
+    }
+    else
+        shader.setInt("pointLightCount", (int)lightCount);
+    drawScene(scene, shader);
+
+    // 光源本身
+    renderer.light.use();
+    renderer.light.setMat4("projection", projection);
+    renderer.light.setMat4("view", view);
+    glBindVertexArray(scene.cubeVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0, lightCount);
+}
+
+// 40x40的地面上12x12个箱子 随机转一个角度 一部分上面再叠一个
+void makeScene(Scene &scene)
+{
+    scene.cube = MakeCube();
+    UploadMesh(scene.cube, scene.cubeVAO, scene.cubeVBO, scene.cubeEBO);
+
+    scene.boxDiffuse = loadTexture("../12_1Multiple_lights/container2.png");
+    scene.boxSpecular = loadTexture("../12_1Multiple_lights/container2_specular.png");
+    scene.floorDiffuse = loadTexture("../3_1Textures/bricks2.jpg");
+
+    scene.floor = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)), glm::vec3(40.0f, 0.2f, 40.0f));
+    srand(7);
+    for (int z = 0; z < 12; z++)
+        for (int x = 0; x < 12; x++)
+        {
+            glm::vec3 position(-16.5f + x * 3.0f, -0.4f, -16.5f + z * 3.0f);
+            float angle = (float)(rand() % 90);
+            glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+            scene.boxes.push_back(model);
+            if (rand() % 4 == 0)
+                scene.boxes.push_back(glm::rotate(glm::translate(model, glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+}
+
+void deleteScene(Scene &scene)
+{
+    unsigned int buffers[2] = { scene.cubeVBO, scene.cubeEBO };
+    unsigned int textures[3] = { scene.boxDiffuse, scene.boxSpecular, scene.floorDiffuse };
+    glDeleteVertexArrays(1, &scene.cubeVAO);
+    glDeleteBuffers(2, buffers);
+    glDeleteTextures(3, textures);
+}
+
+// 光源越多 每个越暗 照亮的范围越小 场景的总亮度大致不变
+// 与23_1相比范围的下限更小 10000个光源时每个簇中的光源仍然不多
+vector<PointLight> makeLights(unsigned int count, vector<glm::vec3> &bases)
+{
+    float scale = 1.0f / sqrtf((float)count);
+    float intensity = fminf(1.0f, 16.0f * scale);
+    float range = fmaxf(1.0f, fminf(20.0f, 80.0f * scale));
+    vector<PointLight> lights = MakePointLights(count, glm::vec3(-18.0f, -0.6f, -18.0f), glm::vec3(18.0f, 1.5f, 18.0f), range, intensity);
+    bases.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+        bases[i] = lights[i].position;
+    return lights;
+}
+
+// 每个光源绕自己的初始位置转圈 速度和方向各不相同
+void animateLights(vector<PointLight> &lights, const vector<glm::vec3> &bases, float time)
+{
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        float speed = 0.3f + (i % 7) * 0.1f;
+        float angle = time * (i % 2 ? speed : -speed) + i * 2.39996f;
+        lights[i].position = bases[i] + glm::vec3(cosf(angle), 0.0f, sinf(angle)) * 1.5f;
+    }
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
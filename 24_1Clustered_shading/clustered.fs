@@ -0,0 +1,136 @@
+// 分簇渲染: 光照与 forward.fs 相同 点光源只遍历片段所在的簇中的光源
+// 簇的划分和光源的分配见 include/light_clusters.h
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+uniform Material material;
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+
+// 每个光源3个纹素 布局见 include/point_lights.h
+uniform samplerBuffer lights;
+uniform vec3 viewPos;
+
+// 每个簇 (偏移, 个数) 偏移指向 clusterIndices 中这个簇的第一个光源
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+uniform uvec3 clusterCount;
+uniform vec2 tileSize;     // 每个簇在屏幕上的像素大小
+uniform float sliceScale;  // 深度层 = log(深度) * sliceScale - sliceBias
+uniform float sliceBias;
+uniform float near;
+uniform float far;
+uniform bool heatmap;      // 显示每个簇中光源的数量
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+
+// 深度缓冲中的非线性深度转回观察空间的距离
+float LinearDepth(float depth)
+{
+    float z = depth * 2.0 - 1.0;
+    return 2.0 * near * far / (far + near - z * (far - near));
+}
+
+// 0个光源为暗蓝色 按对数从蓝到红 255个以上为红色
+vec3 Heat(uint count)
+{
+    float t = clamp(log2(float(count) + 1.0) / 8.0, 0.0, 1.0);
+    return mix(vec3(0.0, 0.0, 1.0), vec3(1.0, 0.0, 0.0), t) * (count == 0u ? 0.3 : 1.0);
+}
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 albedo = texture(material.diffuse, TexCoords).rgb;
+    float specularMask = texture(material.specular, TexCoords).r;
+
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, albedo, specularMask);
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, albedo, specularMask);
+
+    uint slice = uint(max(log(LinearDepth(gl_FragCoord.z)) * sliceScale - sliceBias, 0.0));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / tileSize), clusterCount.xy - 1u);
+    uint cluster = tile.x + clusterCount.x * (tile.y + clusterCount.y * min(slice, clusterCount.z - 1u));
+    uvec2 range = texelFetch(clusterGrid, int(cluster)).xy;
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int index = int(texelFetch(clusterIndices, int(range.x + i)).r);
+        result += CalcPointLight(index, norm, FragPos, viewDir, albedo, specularMask);
+    }
+
+    if (heatmap)
+        result = mix(result, Heat(range.y), 0.6);
+    FragColor = vec4(result, 1.0);
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return light.ambient * albedo + light.diffuse * diff * albedo + light.specular * spec * specularMask;
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return light.ambient * albedo + (light.diffuse * diff * albedo + light.specular * spec * specularMask) * intensity;
+}
+
+// 12_1中点光源的 ambient diffuse specular 为颜色的 0.05 0.8 1.0 倍
+// 超出半径的光照小于1/256 直接跳过
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec4 positionRadius = texelFetch(lights, index * 3);
+    vec4 colorConstant = texelFetch(lights, index * 3 + 1);
+    vec4 attenuationTerms = texelFetch(lights, index * 3 + 2);
+    float distance = length(positionRadius.xyz - fragPos);
+    if (distance > positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = (positionRadius.xyz - fragPos) / distance;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float attenuation = 1.0 / (colorConstant.w + attenuationTerms.x * distance + attenuationTerms.y * (distance * distance));
+
+    vec3 color = colorConstant.rgb;
+    return (0.05 * color * albedo + 0.8 * color * diff * albedo + color * spec * specularMask) * attenuation;
+}
@@ -0,0 +1,645 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "frustum.h"
+#include "point_lights.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+const float FAR_PLANE = 100.0f;
+const glm::vec3 BACKGROUND(0.1f, 0.1f, 0.1f);
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 10.0f, 24.0f), glm::vec3(0.0f, 1.0f, 0.0f), -90.0f, -30.0f);
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+enum Cull_Mode {
+    CULL_NONE,     // 12_1的做法 每个片段遍历所有光源
+    CULL_FRUSTUM,  // 只上传与视锥体相交的光源 物体也按视锥体剔除
+    CULL_OBJECT    // 每个物体只上传照到它的光源 最多 cap 个
+};
+const char *MODE_NAMES[] = { "none", "frustum", "object" };
+
+// 每个物体带一个世界空间的包围球 用来剔除物体和光源
+struct Object {
+    glm::mat4 model;
+    glm::vec3 center;
+    float radius;
+    unsigned int diffuse;
+    glm::vec2 uvScale;
+};
+
+struct Scene {
+    MeshData cube;
+    unsigned int cubeVAO, cubeVBO, cubeEBO;
+    unsigned int boxDiffuse, boxSpecular, floorDiffuse;
+    vector<Object> objects;
+};
+
+// culled.fs 按光源数组的大小编译出的一个变体 uniform的位置提前查好 每次绘制都要设置
+struct Variant {
+    Shader *shader;
+    unsigned int size;
+    GLint pointLights;
+    GLint pointLightCount;
+    GLint model;
+    GLint uvScale;
+};
+
+struct Renderer {
+    Shader forward;
+    Shader light;
+    vector<Variant> variants;  // 从小到大
+    Renderer() : forward("./scene.vs", "./forward.fs"), light("./light.vs", "./light.fs") {}
+    ~Renderer()
+    {
+        for (size_t i = 0; i < variants.size(); i++)
+            delete variants[i].shader;
+    }
+};
+
+// 一帧中剔除的统计
+struct CullStats {
+    double cpuMs;             // 剔除光源和物体 收集每个物体的光源
+    unsigned int visibleLights;
+    unsigned int draws;
+    unsigned int lightsPerDraw;  // 所有绘制的光源个数之和
+    unsigned int capped;      // 照到的光源超过 cap 被截断的绘制
+};
+
+void makeScene(Scene &scene);
+void deleteScene(Scene &scene);
+vector<PointLight> makeLights(unsigned int count, vector<glm::vec3> &bases);
+void animateLights(vector<PointLight> &lights, const vector<glm::vec3> &bases, float time);
+void makeVariants(Renderer &renderer, unsigned int cap);
+void setupShaders(const Renderer &renderer);
+CullStats renderFrame(Cull_Mode mode, const Scene &scene, const Renderer &renderer, const vector<PointLight> &lights,
+                      PointLightBuffer &lightBuffer, PointLightBuffer &visibleBuffer, unsigned int cap, int width, int height);
+
+// 用法:
+//   ./Light_culling.o                       256个点光源 每个物体只上传照到它的光源 每秒输出帧时间和剔除的统计
+//   ./Light_culling.o --lights 1024         光源数量
+//   ./Light_culling.o --mode none           none: 不剔除 frustum: 按视锥体剔除 object: 按物体剔除(默认)
+//   ./Light_culling.o --cap 32              每次绘制最多的光源 着色器按 1 2 4 ... cap 编译几个变体
+//   ./Light_culling.o --bench --small       4到4096个光源 对比三种方式 --small 渲染1/8大小
+//   ./Light_culling.o --bench --max 1024    最多到1024个光源
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int lightCount = 256;
+    Cull_Mode mode = CULL_OBJECT;
+    unsigned int cap = 16;
+    bool bench = false;
+    bool small = false;
+    unsigned int maxLights = 4096;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+            lightCount = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (int m = 0; m < 3; m++)
+                if (strcmp(argv[i], MODE_NAMES[m]) == 0)
+                    mode = (Cull_Mode)m;
+        }
+        // 3.3保证片段着色器至少有1024个uniform分量(256个vec4) 64个光源占192个
+        else if (strcmp(argv[i], "--cap") == 0 && i + 1 < argc)
+            cap = (unsigned int)max(1, min(64, atoi(argv[++i])));
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+        else if (strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            maxLights = (unsigned int)atoi(argv[++i]);
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Light culling", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // 渲染的大小固定为窗口的初始大小 --small 时只渲染左下角的1/8
+    int width = small ? SCR_WIDTH / 8 : SCR_WIDTH;
+    int height = small ? SCR_HEIGHT / 8 : SCR_HEIGHT;
+
+    Scene scene;
+    makeScene(scene);
+    // 着色器和光源缓冲要在 glfwTerminate 之前释放 所以在堆上创建
+    Renderer *renderer = new Renderer();
+    makeVariants(*renderer, cap);
+    setupShaders(*renderer);
+    PointLightBuffer *lightBuffer = new PointLightBuffer(bench ? maxLights : lightCount);
+    PointLightBuffer *visibleBuffer = new PointLightBuffer(bench ? maxLights : lightCount);
+
+    if (bench)
+    {
+        const int frames = 5;
+        // 一帧超过这个时间后 这种方式不再测试更多的光源
+        const double slowMs = 3000.0;
+        bool slow[3] = { false, false, false };
+        cout << width << "x" << height << ", " << scene.objects.size() << " objects, cap " << cap << ", "
+             << renderer->variants.size() << " variants" << endl;
+        cout << "lights  mode      visible  cpu ms    frame ms   draws  lights/draw  capped" << endl;
+        for (unsigned int count = 4; count <= maxLights; count *= 4)
+        {
+            vector<glm::vec3> bases;
+            vector<PointLight> lights = makeLights(count, bases);
+            animateLights(lights, bases, 0.0f);
+            for (int m = 0; m < 3; m++)
+            {
+                cout.setf(ios::left);
+                cout.width(8);
+                cout << count;
+                cout.width(10);
+                cout << MODE_NAMES[m];
+                if (slow[m])
+                {
+                    cout << "skipped" << endl;
+                    continue;
+                }
+                CullStats stats;
+                double total = 0.0;
+                double cpu = 0.0;
+                for (int f = 0; f <= frames; f++)
+                {
+                    auto start = chrono::steady_clock::now();
+                    stats = renderFrame((Cull_Mode)m, scene, *renderer, lights, *lightBuffer, *visibleBuffer, cap, width, height);
+                    glFinish();
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    // 第一帧包含着色器的编译和缓冲的分配 不计入
+                    if (f > 0)
+                    {
+                        total += ms;
+                        cpu += stats.cpuMs;
+                    }
+                    if (ms > slowMs)
+                    {
+                        slow[m] = true;
+                        total = ms * frames;
+                        cpu = stats.cpuMs * frames;
+                        break;
+                    }
+                }
+                cout.width(9);
+                cout << stats.visibleLights;
+                cout.width(10);
+                cout << cpu / frames;
+                cout.width(11);
+                cout << total / frames;
+                cout.width(7);
+                cout << stats.draws;
+                cout.width(13);
+                cout << (stats.draws ? (double)stats.lightsPerDraw / stats.draws : 0.0);
+                cout << stats.capped << endl;
+            }
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window))
+                break;
+        }
+    }
+    else
+    {
+        vector<glm::vec3> bases;
+        vector<PointLight> lights = makeLights(lightCount, bases);
+        cout << MODE_NAMES[mode] << ", " << lightCount << " lights, radius " << lights[0].radius << ", cap " << cap << endl;
+        float lastReport = 0.0f;
+        unsigned int frameCount = 0;
+        while (!glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            animateLights(lights, bases, currentFrame);
+            CullStats stats = renderFrame(mode, scene, *renderer, lights, *lightBuffer, *visibleBuffer, cap, width, height);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            frameCount++;
+            if (currentFrame - lastReport >= 1.0f)
+            {
+                cout << MODE_NAMES[mode] << ", " << lightCount << " lights: "
+                     << (currentFrame - lastReport) * 1000.0f / frameCount << " ms/frame, cull " << stats.cpuMs << " ms, "
+                     << stats.visibleLights << " visible, " << stats.draws << " draws, "
+                     << (stats.draws ? (double)stats.lightsPerDraw / stats.draws : 0.0) << " lights/draw, "
+                     << stats.capped << " capped" << endl;
+                lastReport = currentFrame;
+                frameCount = 0;
+            }
+        }
+    }
+
+    delete visibleBuffer;
+    delete lightBuffer;
+    delete renderer;
+    deleteScene(scene);
+    glfwTerminate();
+    return 0;
+}
+
+// culled.fs 的变体: 光源数组大小为 1 2 4 ... 直到 cap
+// 数组越小 uniform越少 循环的上限越小 光源少的物体用小的变体
+void makeVariants(Renderer &renderer, unsigned int cap)
+{
+    for (unsigned int size = 1; ; size *= 2)
+    {
+        Variant variant;
+        variant.size = min(size, cap);
+        string defines = "#define MAX_LIGHTS " + to_string(variant.size) + "\n";
+        variant.shader = new Shader("./scene.vs", "./culled.fs", defines.c_str());
+        variant.pointLights = glGetUniformLocation(variant.shader->ID, "pointLights");
+        variant.pointLightCount = glGetUniformLocation(variant.shader->ID, "pointLightCount");
+        variant.model = glGetUniformLocation(variant.shader->ID, "model");
+        variant.uvScale = glGetUniformLocation(variant.shader->ID, "uvScale");
+        renderer.variants.push_back(variant);
+        if (variant.size == cap)
+            break;
+    }
+}
+
+// 着色器中不变的uniform: 纹理单元和方向光 聚光的参数
+void setupShaders(const Renderer &renderer)
+{
+    vector<const Shader*> lit(1, &renderer.forward);
+    for (size_t i = 0; i < renderer.variants.size(); i++)
+        lit.push_back(renderer.variants[i].shader);
+    for (size_t i = 0; i < lit.size(); i++)
+    {
+        const Shader &shader = *lit[i];
+        shader.use();
+        // 光源很多 定向光调暗
+        shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+        shader.setVec3("dirLight.ambient", 0.02f, 0.02f, 0.02f);
+        shader.setVec3("dirLight.diffuse", 0.05f, 0.05f, 0.05f);
+        shader.setVec3("dirLight.specular", 0.05f, 0.05f, 0.05f);
+        shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+        shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+        shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+        shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+        shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+        shader.setInt("material.diffuse", 0);
+        shader.setInt("material.specular", 1);
+        shader.setFloat("material.shininess", 32.0f);
+    }
+    renderer.forward.use();
+    renderer.forward.setInt("lights", 2);
+    renderer.light.use();
+    renderer.light.setInt("lights", 2);
+}
+
+// 每帧变化的uniform
+static void setFrameUniforms(const Shader &shader, const glm::mat4 &projection, const glm::mat4 &view)
+{
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    shader.setVec3("viewPos", camera.Position);
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+}
+
+static void bindDiffuse(unsigned int texture, unsigned int &bound)
+{
+    if (texture == bound)
+        return;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    bound = texture;
+}
+
+// 画一帧 返回剔除的统计
+CullStats renderFrame(Cull_Mode mode, const Scene &scene, const Renderer &renderer, const vector<PointLight> &lights,
+                      PointLightBuffer &lightBuffer, PointLightBuffer &visibleBuffer, unsigned int cap, int width, int height)
+{
+    // 每帧复用 避免反复分配
+    static vector<unsigned int> visible;
+    static vector<PointLight> visibleLights;
+    static vector<PointLight> objectLights;
+    static vector<PointLight> drawLights;
+    struct Draw {
+        unsigned int object;
+        unsigned int first;    // 在 drawLights 中的位置
+        unsigned int count;
+        unsigned int variant;
+    };
+    static vector<Draw> draws;
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+    glm::mat4 view = camera.GetViewMatrix();
+    CullStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    // CPU上的剔除
+    auto start = chrono::steady_clock::now();
+    Frustum frustum(projection * view);
+    draws.clear();
+    drawLights.clear();
+    if (mode == CULL_NONE)
+    {
+        stats.visibleLights = (unsigned int)lights.size();
+        for (unsigned int i = 0; i < scene.objects.size(); i++)
+        {
+            Draw draw = { i, 0, (unsigned int)lights.size(), 0 };
+            draws.push_back(draw);
+        }
+    }
+    else
+    {
+        CullPointLights(lights, frustum, visible);
+        stats.visibleLights = (unsigned int)visible.size();
+        if (mode == CULL_FRUSTUM)
+        {
+            visibleLights.clear();
+            for (size_t i = 0; i < visible.size(); i++)
+                visibleLights.push_back(lights[visible[i]]);
+        }
+        for (unsigned int i = 0; i < scene.objects.size(); i++)
+        {
+            const Object &object = scene.objects[i];
+            if (!frustum.IntersectsSphere(object.center, object.radius))
+                continue;
+            Draw draw = { i, 0, (unsigned int)visible.size(), 0 };
+            if (mode == CULL_OBJECT)
+            {
+                unsigned int reaching = GatherPointLights(lights, visible, object.center, object.radius, cap, objectLights);
+                stats.capped += reaching > cap ? 1 : 0;
+                draw.first = (unsigned int)drawLights.size();
+                draw.count = (unsigned int)objectLights.size();
+                drawLights.insert(drawLights.end(), objectLights.begin(), objectLights.end());
+                while (renderer.variants[draw.variant].size < draw.count)
+                    draw.variant++;
+            }
+            draws.push_back(draw);
+        }
+        // 相同变体的绘制放在一起 减少切换着色器
+        if (mode == CULL_OBJECT)
+            stable_sort(draws.begin(), draws.end(), [](const Draw &a, const Draw &b) { return a.variant < b.variant; });
+    }
+    stats.draws = (unsigned int)draws.size();
+    for (size_t i = 0; i < draws.size(); i++)
+        stats.lightsPerDraw += draws[i].count;
+    stats.cpuMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    // 光源的小立方体总是画所有光源
+    lightBuffer.Upload(lights);
+    if (mode == CULL_FRUSTUM)
+        visibleBuffer.Upload(visibleLights);
+
+    glViewport(0, 0, width, height);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(BACKGROUND.r, BACKGROUND.g, BACKGROUND.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBindVertexArray(scene.cubeVAO);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.boxSpecular);
+    unsigned int bound = 0;
+    GLsizei indexCount = (GLsizei)scene.cube.indices.size();
+
+    if (mode != CULL_OBJECT)
+    {
+        // 所有物体用同一组光源
+        (mode == CULL_NONE ? lightBuffer : visibleBuffer).Bind(2);
+        setFrameUniforms(renderer.forward, projection, view);
+        renderer.forward.setInt("pointLightCount", (int)(mode == CULL_NONE ? lights.size() : visible.size()));
+        for (size_t i = 0; i < draws.size(); i++)
+        {
+            const Object &object = scene.objects[draws[i].object];
+            bindDiffuse(object.diffuse, bound);
+            renderer.forward.setMat4("model", object.model);
+            renderer.forward.setVec2("uvScale", object.uvScale);
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+    else
+    {
+        // 每次绘制前上传照到这个物体的光源 一次 glUniform4fv
+        int current = -1;
+        for (size_t i = 0; i < draws.size(); i++)
+        {
+            const Draw &draw = draws[i];
+            const Variant &variant = renderer.variants[draw.variant];
+            if ((int)draw.variant != current)
+            {
+                setFrameUniforms(*variant.shader, projection, view);
+                current = (int)draw.variant;
+            }
+            const Object &object = scene.objects[draw.object];
+            bindDiffuse(object.diffuse, bound);
+            glUniformMatrix4fv(variant.model, 1, GL_FALSE, glm::value_ptr(object.model));
+            glUniform2fv(variant.uvScale, 1, glm::value_ptr(object.uvScale));
+            glUniform1i(variant.pointLightCount, (int)draw.count);
+            if (draw.count)
+                glUniform4fv(variant.pointLights, draw.count * POINT_LIGHT_TEXELS, &drawLights[draw.first].position.x);
+            glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        }
+    }
+
+    // 光源本身
+    lightBuffer.Bind(2);
+    renderer.light.use();
+    renderer.light.setMat4("projection", projection);
+    renderer.light.setMat4("view", view);
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, (GLsizei)lights.size());
+    return stats;
+}
+
+// 立方体的包围球: 中心为模型的原点 半径为半对角线乘以最大的缩放
+static Object makeObject(const glm::mat4 &model, unsigned int diffuse, const glm::vec2 &uvScale)
+{
+    Object object;
+    object.model = model;
+    object.center = glm::vec3(model[3]);
+    float scale = max(glm::length(glm::vec3(model[0])), max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    object.radius = 0.5f * sqrtf(3.0f) * scale;
+    object.diffuse = diffuse;
+    object.uvScale = uvScale;
+    return object;
+}
+
+// 与23_1相同的40x40的地面和12x12个箱子
+// 地面作为一个物体时所有光源都照到它 这里分成12x12块 每块只有附近的光源
+void makeScene(Scene &scene)
+{
+    scene.cube = MakeCube();
+    UploadMesh(scene.cube, scene.cubeVAO, scene.cubeVBO, scene.cubeEBO);
+
+    scene.boxDiffuse = loadTexture("../12_1Multiple_lights/container2.png");
+    scene.boxSpecular = loadTexture("../12_1Multiple_lights/container2_specular.png");
+    scene.floorDiffuse = loadTexture("../3_1Textures/bricks2.jpg");
+
+    const int tiles = 12;
+    float tile = 40.0f / tiles;
+    for (int z = 0; z < tiles; z++)
+        for (int x = 0; x < tiles; x++)
+        {
+            glm::vec3 position(-20.0f + (x + 0.5f) * tile, -1.0f, -20.0f + (z + 0.5f) * tile);
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(tile, 0.2f, tile));
+            scene.objects.push_back(makeObject(model, scene.floorDiffuse, glm::vec2(20.0f / tiles)));
+        }
+
+    srand(7);
+    for (int z = 0; z < 12; z++)
+        for (int x = 0; x < 12; x++)
+        {
+            glm::vec3 position(-16.5f + x * 3.0f, -0.4f, -16.5f + z * 3.0f);
+            float angle = (float)(rand() % 90);
+            glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+            scene.objects.push_back(makeObject(model, scene.boxDiffuse, glm::vec2(1.0f)));
+            if (rand() % 4 == 0)
+            {
+                glm::mat4 top = glm::rotate(glm::translate(model, glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                scene.objects.push_back(makeObject(top, scene.boxDiffuse, glm::vec2(1.0f)));
+            }
+        }
+}
+
+void deleteScene(Scene &scene)
+{
+    unsigned int buffers[2] = { scene.cubeVBO, scene.cubeEBO };
+    unsigned int textures[3] = { scene.boxDiffuse, scene.boxSpecular, scene.floorDiffuse };
+    glDeleteVertexArrays(1, &scene.cubeVAO);
+    glDeleteBuffers(2, buffers);
+    glDeleteTextures(3, textures);
+}
+
+// 与23_1相同 光源越多 每个越暗 照亮的范围越小 场景的总亮度大致不变
+vector<PointLight> makeLights(unsigned int count, vector<glm::vec3> &bases)
+{
+    float scale = 1.0f / sqrtf((float)count);
+    float intensity = fminf(1.0f, 16.0f * scale);
+    float range = fmaxf(2.5f, fminf(20.0f, 80.0f * scale));
+    vector<PointLight> lights = MakePointLights(count, glm::vec3(-18.0f, -0.6f, -18.0f), glm::vec3(18.0f, 1.5f, 18.0f), range, intensity);
+    bases.resize(count);
+    for (unsigned int i = 0; i < count; i++)
+        bases[i] = lights[i].position;
+    return lights;
+}
+
+// 每个光源绕自己的初始位置转圈 速度和方向各不相同
+void animateLights(vector<PointLight> &lights, const vector<glm::vec3> &bases, float time)
+{
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        float speed = 0.3f + (i % 7) * 0.1f;
+        float angle = time * (i % 2 ? speed : -speed) + i * 2.39996f;
+        lights[i].position = bases[i] + glm::vec3(cosf(angle), 0.0f, sinf(angle)) * 1.5f;
+    }
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
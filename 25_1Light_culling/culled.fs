@@ -0,0 +1,105 @@
+// object: 只有照到这个物体的点光源 每次绘制前作为uniform数组上传
+// 数组的大小 MAX_LIGHTS 在编译时由C++插入 同一份源码编译出几个变体 绘制时选能放下的最小的一个
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+};
+uniform Material material;
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+
+#ifndef MAX_LIGHTS
+#define MAX_LIGHTS 8
+#endif
+// 每个光源3个vec4 与缓冲纹理的布局相同 见 include/point_lights.h
+uniform vec4 pointLights[MAX_LIGHTS * 3];
+uniform int pointLightCount;
+uniform vec3 viewPos;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask);
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 albedo = texture(material.diffuse, TexCoords).rgb;
+    float specularMask = texture(material.specular, TexCoords).r;
+
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, albedo, specularMask);
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, albedo, specularMask);
+    for (int i = 0; i < pointLightCount; i++)
+        result += CalcPointLight(i, norm, FragPos, viewDir, albedo, specularMask);
+
+    FragColor = vec4(result, 1.0);
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return light.ambient * albedo + light.diffuse * diff * albedo + light.specular * spec * specularMask;
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return light.ambient * albedo + (light.diffuse * diff * albedo + light.specular * spec * specularMask) * intensity;
+}
+
+// 12_1中点光源的 ambient diffuse specular 为颜色的 0.05 0.8 1.0 倍
+// 超出半径的光照小于1/256 直接跳过
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 albedo, float specularMask)
+{
+    vec4 positionRadius = pointLights[index * 3];
+    vec4 colorConstant = pointLights[index * 3 + 1];
+    vec4 attenuationTerms = pointLights[index * 3 + 2];
+    float distance = length(positionRadius.xyz - fragPos);
+    if (distance > positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = (positionRadius.xyz - fragPos) / distance;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float attenuation = 1.0 / (colorConstant.w + attenuationTerms.x * distance + attenuationTerms.y * (distance * distance));
+
+    vec3 color = colorConstant.rgb;
+    return (0.05 * color * albedo + 0.8 * color * diff * albedo + color * spec * specularMask) * attenuation;
+}
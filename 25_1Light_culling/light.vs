@@ -0,0 +1,18 @@
+// 每个点光源画一个小立方体 位置和颜色从缓冲纹理读取
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform samplerBuffer lights;
+
+out vec3 LightColor;
+
+void main()
+{
+    vec4 positionRadius = texelFetch(lights, gl_InstanceID * 3);
+    vec3 color = texelFetch(lights, gl_InstanceID * 3 + 1).rgb;
+    // 光源很多时每个都很暗 灯本身按最亮的分量归一化
+    LightColor = color / max(max(color.r, color.g), max(color.b, 0.001));
+    gl_Position = projection * view * vec4(positionRadius.xyz + aPos * 0.1, 1.0);
+}
@@ -0,0 +1,528 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "gl_ext.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+enum Depth_Mode {
+    MODE_NONE,          // 12_1的做法 按数组的顺序绘制
+    MODE_SORT,          // 按观察空间的深度从近到远绘制
+    MODE_PREPASS,       // 先只画深度 再用 GL_EQUAL 画光照
+    MODE_PREPASS_SORT   // 两者都用
+};
+const char *MODE_NAMES[] = { "none", "sort", "prepass", "prepass-sort" };
+
+// 12_1的10个箱子和4个点光源 再加上 --cubes 个随机的箱子
+struct Scene {
+    MeshData cube;
+    unsigned int cubeVAO, cubeVBO, cubeEBO;
+    unsigned int diffuseMap, specularMap;
+    vector<glm::vec3> positions;
+    vector<glm::vec3> axes;
+};
+
+// 一帧的统计
+// invocations: 片段着色器的调用次数 需要管线统计查询 不支持时为0
+// samples: 通过深度测试的采样数 有提前深度测试时被挡住的片段不运行片段着色器 也就是实际着色的片段
+struct FrameStats {
+    double sortMs;
+    unsigned long long depthInvocations;
+    unsigned long long litInvocations;
+    unsigned long long depthSamples;
+    unsigned long long litSamples;
+};
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+void makeScene(Scene &scene, unsigned int extraCubes);
+void deleteScene(Scene &scene);
+void setupShader(const Shader &shader);
+FrameStats renderFrame(Depth_Mode mode, const Scene &scene, const Shader &cubeShader, const Shader &depthShader,
+                       const Shader &lightShader, float time, GLenum litDepthFunc, const unsigned int queries[4]);
+
+// 用法:
+//   ./Depth_prepass.o                          12_1的场景 每秒输出帧时间
+//   ./Depth_prepass.o --cubes 2000             再加2000个随机的箱子 顺序是随机的
+//   ./Depth_prepass.o --mode prepass           none: 按数组顺序 sort: 从近到远 prepass: 深度预渲染 prepass-sort: 两者都用
+//   ./Depth_prepass.o --lequal                 光照阶段用 GL_LEQUAL 代替 GL_EQUAL
+//   ./Depth_prepass.o --bench                  0到5000个额外的箱子 对比四种方式的帧时间和片段的统计
+//   ./Depth_prepass.o --bench --small          渲染1/8大小
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int extraCubes = 0;
+    Depth_Mode mode = MODE_NONE;
+    GLenum litDepthFunc = GL_EQUAL;
+    bool bench = false;
+    bool small = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--cubes") == 0 && i + 1 < argc)
+            extraCubes = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (int m = 0; m < 4; m++)
+                if (strcmp(argv[i], MODE_NAMES[m]) == 0)
+                    mode = (Depth_Mode)m;
+        }
+        else if (strcmp(argv[i], "--lequal") == 0)
+            litDepthFunc = GL_LEQUAL;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Depth pre-pass", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    // 管线统计查询可以直接数片段着色器的调用次数 没有时只能数通过深度测试的采样
+    cout << "pipeline statistics query: " << (glext.PipelineStatisticsQuery ? "yes" : "no") << endl;
+
+    glViewport(0, 0, small ? SCR_WIDTH / 8 : SCR_WIDTH, small ? SCR_HEIGHT / 8 : SCR_HEIGHT);
+
+    // 着色器和查询对象要在 glfwTerminate 之前释放 所以在堆上创建
+    Shader *cubeShader = new Shader("./shader.vs", "./shader.fs");
+    Shader *depthShader = new Shader("./depth.vs", "./depth.fs");
+    Shader *lightShader = new Shader("./light.vs", "./light.fs");
+    setupShader(*cubeShader);
+    // 两个阶段各一个管线统计查询和一个采样数查询
+    unsigned int queries[4];
+    glGenQueries(4, queries);
+
+    if (bench)
+    {
+        const unsigned int counts[] = { 0, 100, 1000, 5000 };
+        const int frames = 5;
+        cout << "                                          invocations (M)     samples passed (M)" << endl;
+        cout << "cubes   mode          frame ms   sort ms    depth     lighting  depth     lighting" << endl;
+        for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+        {
+            Scene scene;
+            makeScene(scene, counts[c]);
+            for (int m = 0; m < 4; m++)
+            {
+                FrameStats stats;
+                double total = 0.0;
+                double sortMs = 0.0;
+                for (int f = 0; f <= frames; f++)
+                {
+                    auto start = chrono::steady_clock::now();
+                    // 时间固定 每帧的画面相同
+                    stats = renderFrame((Depth_Mode)m, scene, *cubeShader, *depthShader, *lightShader, 1.0f, litDepthFunc, queries);
+                    glFinish();
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    // 第一帧包含着色器的编译 不计入
+                    if (f > 0)
+                    {
+                        total += ms;
+                        sortMs += stats.sortMs;
+                    }
+                }
+                cout.setf(ios::left);
+                cout.width(8);
+                cout << scene.positions.size();
+                cout.width(14);
+                cout << MODE_NAMES[m];
+                cout.width(11);
+                cout << total / frames;
+                cout.width(11);
+                cout << sortMs / frames;
+                cout.width(10);
+                cout << stats.depthInvocations / 1.0e6;
+                cout.width(10);
+                cout << stats.litInvocations / 1.0e6;
+                cout.width(10);
+                cout << stats.depthSamples / 1.0e6;
+                cout << stats.litSamples / 1.0e6 << endl;
+            }
+            deleteScene(scene);
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window))
+                break;
+        }
+    }
+    else
+    {
+        Scene scene;
+        makeScene(scene, extraCubes);
+        cout << MODE_NAMES[mode] << ", " << scene.positions.size() << " cubes" << endl;
+        float lastReport = 0.0f;
+        unsigned int frameCount = 0;
+        while (!glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            frameCount++;
+            // 读取查询结果要等这一帧画完 只在输出的那一帧查询
+            bool report = currentFrame - lastReport >= 1.0f;
+            FrameStats stats = renderFrame(mode, scene, *cubeShader, *depthShader, *lightShader, currentFrame, litDepthFunc,
+                                           report ? queries : NULL);
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            if (report)
+            {
+                cout << MODE_NAMES[mode] << ", " << scene.positions.size() << " cubes: "
+                     << (currentFrame - lastReport) * 1000.0f / frameCount << " ms/frame, invocations: depth "
+                     << stats.depthInvocations << ", lighting " << stats.litInvocations << ", samples passed: depth "
+                     << stats.depthSamples << ", lighting " << stats.litSamples << endl;
+                lastReport = currentFrame;
+                frameCount = 0;
+            }
+        }
+        deleteScene(scene);
+    }
+
+    glDeleteQueries(4, queries);
+    delete lightShader;
+    delete depthShader;
+    delete cubeShader;
+    glfwTerminate();
+    return 0;
+}
+
+// 12_1中每帧设置的光源参数 这里不变 只设置一次
+void setupShader(const Shader &shader)
+{
+    shader.use();
+    shader.setInt("material.diffuse", 0);
+    shader.setInt("material.specular", 1);
+    shader.setFloat("material.shininess", 32.0f);
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "].";
+        shader.setVec3(name + "position", pointLightPositions[i]);
+        shader.setVec3(name + "ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + "diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + "specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + "constant", 1.0f);
+        shader.setFloat(name + "linear", 0.09f);
+        shader.setFloat(name + "quadratic", 0.032f);
+    }
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+static void drawCubes(const Scene &scene, const Shader &shader, const vector<glm::mat4> &models, const vector<unsigned int> &order)
+{
+    GLint modelLocation = glGetUniformLocation(shader.ID, "model");
+    GLsizei indexCount = (GLsizei)scene.cube.indices.size();
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(models[order[i]]));
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+}
+
+// 不同类型的查询可以同时进行
+static void beginQueries(const unsigned int *queries, int first)
+{
+    if (!queries)
+        return;
+    if (glext.PipelineStatisticsQuery)
+        glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, queries[first]);
+    glBeginQuery(GL_SAMPLES_PASSED, queries[first + 1]);
+}
+
+static void endQueries(const unsigned int *queries)
+{
+    if (!queries)
+        return;
+    if (glext.PipelineStatisticsQuery)
+        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+    glEndQuery(GL_SAMPLES_PASSED);
+}
+
+static void readQueries(const unsigned int *queries, int first, unsigned long long &invocations, unsigned long long &samples)
+{
+    GLuint64 result = 0;
+    if (glext.PipelineStatisticsQuery)
+    {
+        glGetQueryObjectui64v(queries[first], GL_QUERY_RESULT, &result);
+        invocations = result;
+    }
+    glGetQueryObjectui64v(queries[first + 1], GL_QUERY_RESULT, &result);
+    samples = result;
+}
+
+// 画一帧 queries 不为NULL时统计两个阶段的片段
+FrameStats renderFrame(Depth_Mode mode, const Scene &scene, const Shader &cubeShader, const Shader &depthShader,
+                       const Shader &lightShader, float time, GLenum litDepthFunc, const unsigned int queries[4])
+{
+    static vector<glm::mat4> models;
+    static vector<unsigned int> order;
+    static vector<float> depths;
+    FrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+
+    // 与12_1相同 每个箱子绕自己的轴转
+    size_t count = scene.positions.size();
+    models.resize(count);
+    order.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), scene.positions[i]);
+        float angle = 20.0f * i + 10.0f;
+        models[i] = glm::rotate(model, time * glm::radians(angle), scene.axes[i]);
+        order[i] = (unsigned int)i;
+    }
+
+    // 从近到远: 观察空间的z越大(越接近0)越近 只看箱子的中心
+    auto start = chrono::steady_clock::now();
+    if (mode == MODE_SORT || mode == MODE_PREPASS_SORT)
+    {
+        depths.resize(count);
+        for (size_t i = 0; i < count; i++)
+            depths[i] = (view * glm::vec4(scene.positions[i], 1.0f)).z;
+        sort(order.begin(), order.end(), [](unsigned int a, unsigned int b) { return depths[a] > depths[b]; });
+    }
+    stats.sortMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glBindVertexArray(scene.cubeVAO);
+
+    bool prepass = mode == MODE_PREPASS || mode == MODE_PREPASS_SORT;
+    if (prepass)
+    {
+        // 只写深度 片段着色器是空的 不读纹理
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        depthShader.use();
+        depthShader.setMat4("projection", projection);
+        depthShader.setMat4("view", view);
+        beginQueries(queries, 0);
+        drawCubes(scene, depthShader, models, order);
+        endQueries(queries);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        // 深度已经是最终的结果 光照阶段只有最近的片段通过 不再写深度
+        glDepthMask(GL_FALSE);
+        glDepthFunc(litDepthFunc);
+    }
+
+    cubeShader.use();
+    cubeShader.setMat4("projection", projection);
+    cubeShader.setMat4("view", view);
+    cubeShader.setVec3("viewPos", camera.Position);
+    cubeShader.setVec3("spotLight.position", camera.Position);
+    cubeShader.setVec3("spotLight.direction", camera.Front);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.diffuseMap);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.specularMap);
+    beginQueries(queries, 2);
+    drawCubes(scene, cubeShader, models, order);
+    endQueries(queries);
+
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+
+    // 光源
+    lightShader.use();
+    lightShader.setMat4("projection", projection);
+    lightShader.setMat4("view", view);
+    GLsizei indexCount = (GLsizei)scene.cube.indices.size();
+    for (int i = 0; i < 4; i++)
+    {
+        glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), pointLightPositions[i]), glm::vec3(0.2f));
+        lightShader.setMat4("model", model);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+
+    if (queries)
+    {
+        if (prepass)
+            readQueries(queries, 0, stats.depthInvocations, stats.depthSamples);
+        readQueries(queries, 2, stats.litInvocations, stats.litSamples);
+    }
+    return stats;
+}
+
+// 额外的箱子随机放在摄像机前方 顺序也是随机的 与远近无关
+void makeScene(Scene &scene, unsigned int extraCubes)
+{
+    scene.cube = MakeCube();
+    UploadMesh(scene.cube, scene.cubeVAO, scene.cubeVBO, scene.cubeEBO);
+    scene.diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    scene.specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+    scene.positions.assign(cubePositions, cubePositions + 10);
+    scene.axes.assign(10, glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (unsigned int i = 0; i < extraCubes; i++)
+    {
+        float z = -2.0f - 38.0f * unit(random);
+        // 越远的范围越大 大致填满视锥体
+        float spread = 0.5f + (3.0f - z) * 0.45f;
+        scene.positions.push_back(glm::vec3((unit(random) * 2.0f - 1.0f) * spread * 1.6f, (unit(random) * 2.0f - 1.0f) * spread, z));
+        scene.axes.push_back(glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 0.1f));
+    }
+}
+
+void deleteScene(Scene &scene)
+{
+    unsigned int buffers[2] = { scene.cubeVBO, scene.cubeEBO };
+    unsigned int textures[2] = { scene.diffuseMap, scene.specularMap };
+    glDeleteVertexArrays(1, &scene.cubeVAO);
+    glDeleteBuffers(2, buffers);
+    glDeleteTextures(2, textures);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,6 @@
+// 深度预渲染只写深度 颜色写入已经用 glColorMask 关掉
+#version 330 core
+
+void main()
+{
+}
@@ -0,0 +1,551 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "mesh.h"
+#include "frustum.h"
+#include "thread_pool.h"
+#include "occlusion_culler.h"
+
+using namespace std;
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+// 站在街道的路口 沿着街道看向城市的另一头
+Camera camera(glm::vec3(192.0f, 1.7f, 336.0f), glm::vec3(0.0f, 1.0f, 0.0f), -100.0f, 0.0f);
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+enum Cull_Mode {
+    MODE_NONE,       // 画所有物体
+    MODE_FRUSTUM,    // 按包围盒剔除视锥体外的物体
+    MODE_OCCLUSION   // 再剔除被高楼挡住的物体
+};
+const char *MODE_NAMES[] = { "none", "frustum", "occlusion" };
+
+// 城市由 BLOCKS * BLOCKS 个街区组成 每个街区 BLOCK_SIZE 见方 四周是 STREET_WIDTH 宽的街道
+const unsigned int BLOCKS = 16;
+const float BLOCK_SIZE = 16.0f;
+const float STREET_WIDTH = 8.0f;
+const float BLOCK_PITCH = BLOCK_SIZE + STREET_WIDTH;
+
+// 所有物体都是缩放的立方体 包围盒就是立方体本身
+struct Object {
+    glm::mat4 model;
+    glm::vec3 minimum, maximum;
+    glm::vec2 uvScale;
+};
+
+struct Scene {
+    MeshData cube;
+    unsigned int cubeVAO, cubeVBO, cubeEBO;
+    unsigned int buildingMap, propMap, groundMap;
+    vector<Object> buildings;   // 高楼 既是遮挡物也要测试
+    vector<Object> props;       // 街道和小巷中的箱子
+    Object ground;
+};
+
+// 一帧的统计
+struct FrameStats {
+    double cullMs;             // 剔除的总时间 包括下面三项
+    double setupMs;            // 遮挡物的变换和三角形设置
+    double rasterMs;           // 光栅化
+    double testMs;             // 测试包围盒
+    unsigned int drawn;
+    unsigned int frustumCulled;
+    unsigned int occlusionCulled;
+    unsigned int occluders;
+    unsigned int triangles;
+};
+
+void makeScene(Scene &scene, unsigned int propsPerBlock);
+void deleteScene(Scene &scene);
+FrameStats renderFrame(Cull_Mode mode, const Scene &scene, const Shader &shader, OcclusionCuller &culler,
+                       ThreadPool &pool, unsigned int maxOccluders);
+void saveOcclusionBuffer(const OcclusionCuller &culler, const char *path);
+
+// 用法:
+//   ./Occlusion_culling.o                          16x16个街区 每秒输出帧时间和剔除的统计
+//   ./Occlusion_culling.o --mode frustum           none: 全画 frustum: 视锥体剔除 occlusion: 再做遮挡剔除
+//   ./Occlusion_culling.o --props 80               每个街区的箱子数 默认40
+//   ./Occlusion_culling.o --occluders 64           每帧最多光栅化的高楼 取视锥体内最近的 默认32
+//   ./Occlusion_culling.o --threads 4              光栅化和测试的线程数 默认使用全部核心 1为单线程
+//   ./Occlusion_culling.o --buffer buffer.ppm      第一帧的遮挡缓冲保存为图片
+//   ./Occlusion_culling.o --bench                  对比三种方式和不同的遮挡物数量
+//   ./Occlusion_culling.o --bench --small          渲染1/8大小
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    Cull_Mode mode = MODE_OCCLUSION;
+    unsigned int propsPerBlock = 40;
+    unsigned int maxOccluders = 32;
+    unsigned int threads = 0;
+    const char *bufferPath = NULL;
+    bool bench = false;
+    bool small = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc)
+        {
+            i++;
+            for (int m = 0; m < 3; m++)
+                if (strcmp(argv[i], MODE_NAMES[m]) == 0)
+                    mode = (Cull_Mode)m;
+        }
+        else if (strcmp(argv[i], "--props") == 0 && i + 1 < argc)
+            propsPerBlock = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--occluders") == 0 && i + 1 < argc)
+            maxOccluders = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--buffer") == 0 && i + 1 < argc)
+            bufferPath = argv[++i];
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Occlusion culling", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    glViewport(0, 0, small ? SCR_WIDTH / 8 : SCR_WIDTH, small ? SCR_HEIGHT / 8 : SCR_HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+    camera.MovementSpeed = 20.0f;
+
+    // 着色器要在 glfwTerminate 之前释放 所以在堆上创建
+    Shader *shader = new Shader("./scene.vs", "./scene.fs");
+    shader->use();
+    shader->setInt("diffuse", 0);
+    shader->setVec3("lightDirection", -0.4f, -1.0f, -0.3f);
+    ThreadPool pool(threads);
+    // 256x144 与屏幕的比例相同 每个像素对应屏幕上7.5x7.5个像素
+    OcclusionCuller culler(256, 144);
+
+    Scene scene;
+    makeScene(scene, propsPerBlock);
+    cout << scene.buildings.size() << " buildings, " << scene.props.size() << " props, "
+         << pool.Size() << " threads" << endl;
+
+    if (bench)
+    {
+        struct Run {
+            Cull_Mode mode;
+            unsigned int occluders;
+        };
+        const Run runs[] = {
+            { MODE_NONE, 0 }, { MODE_FRUSTUM, 0 },
+            { MODE_OCCLUSION, 8 }, { MODE_OCCLUSION, 16 }, { MODE_OCCLUSION, 32 },
+            { MODE_OCCLUSION, 64 }, { MODE_OCCLUSION, 128 }
+        };
+        const int frames = 5;
+        cout << "mode        occluders frame ms  cull ms   setup ms  raster ms test ms   drawn     frustum   occlusion" << endl;
+        for (unsigned int r = 0; r < sizeof(runs) / sizeof(runs[0]); r++)
+        {
+            FrameStats stats;
+            double total = 0.0, cullMs = 0.0, setupMs = 0.0, rasterMs = 0.0, testMs = 0.0;
+            for (int f = 0; f <= frames; f++)
+            {
+                auto start = chrono::steady_clock::now();
+                stats = renderFrame(runs[r].mode, scene, *shader, culler, pool, runs[r].occluders);
+                glFinish();
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                // 第一帧包含纹理的上传 不计入
+                if (f > 0)
+                {
+                    total += ms;
+                    cullMs += stats.cullMs;
+                    setupMs += stats.setupMs;
+                    rasterMs += stats.rasterMs;
+                    testMs += stats.testMs;
+                }
+            }
+            cout.setf(ios::left);
+            cout.width(12);
+            cout << MODE_NAMES[runs[r].mode];
+            cout.width(10);
+            cout << runs[r].occluders;
+            cout.width(10);
+            cout << total / frames;
+            cout.width(10);
+            cout << cullMs / frames;
+            cout.width(10);
+            cout << setupMs / frames;
+            cout.width(10);
+            cout << rasterMs / frames;
+            cout.width(10);
+            cout << testMs / frames;
+            cout.width(10);
+            cout << stats.drawn;
+            cout.width(10);
+            cout << stats.frustumCulled;
+            cout << stats.occlusionCulled << endl;
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+            if (glfwWindowShouldClose(window))
+                break;
+        }
+    }
+    else
+    {
+        float lastReport = 0.0f;
+        unsigned int frameCount = 0;
+        double cullMs = 0.0;
+        while (!glfwWindowShouldClose(window))
+        {
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+            processInput(window);
+
+            FrameStats stats = renderFrame(mode, scene, *shader, culler, pool, maxOccluders);
+            if (bufferPath && mode == MODE_OCCLUSION)
+            {
+                saveOcclusionBuffer(culler, bufferPath);
+                bufferPath = NULL;
+            }
+            frameCount++;
+            cullMs += stats.cullMs;
+
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+
+            if (currentFrame - lastReport >= 1.0f)
+            {
+                cout << MODE_NAMES[mode] << ": " << (currentFrame - lastReport) * 1000.0f / frameCount << " ms/frame, drawn "
+                     << stats.drawn << "/" << scene.buildings.size() + scene.props.size()
+                     << ", culled: frustum " << stats.frustumCulled << ", occlusion " << stats.occlusionCulled
+                     << " (" << stats.occluders << " occluders, " << stats.triangles << " triangles), cull "
+                     << cullMs / frameCount << " ms" << endl;
+                lastReport = currentFrame;
+                frameCount = 0;
+                cullMs = 0.0;
+            }
+        }
+    }
+
+    deleteScene(scene);
+    delete shader;
+    glfwTerminate();
+    return 0;
+}
+
+static void drawObject(const Scene &scene, const Shader &shader, const Object &object)
+{
+    shader.setMat4("model", object.model);
+    shader.setVec2("uvScale", object.uvScale);
+    glDrawElements(GL_TRIANGLES, (GLsizei)scene.cube.indices.size(), GL_UNSIGNED_INT, 0);
+}
+
+// 包围盒到摄像机的距离 摄像机在盒内时为0
+static float boxDistance(const Object &object, const glm::vec3 &position)
+{
+    glm::vec3 closest = glm::clamp(position, object.minimum, object.maximum);
+    return glm::length(closest - position);
+}
+
+// 画一帧 所有剔除在提交第一个绘制之前完成
+FrameStats renderFrame(Cull_Mode mode, const Scene &scene, const Shader &shader, OcclusionCuller &culler,
+                       ThreadPool &pool, unsigned int maxOccluders)
+{
+    static vector<unsigned char> visible;
+    static vector<const Object*> objects;
+    static vector<const Object*> occluders;
+    FrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 600.0f);
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 viewProjection = projection * view;
+
+    // 高楼在前 箱子在后
+    objects.clear();
+    for (size_t i = 0; i < scene.buildings.size(); i++)
+        objects.push_back(&scene.buildings[i]);
+    for (size_t i = 0; i < scene.props.size(); i++)
+        objects.push_back(&scene.props[i]);
+    unsigned int count = (unsigned int)objects.size();
+    visible.assign(count, 1);
+
+    auto start = chrono::steady_clock::now();
+    if (mode != MODE_NONE)
+    {
+        Frustum frustum(viewProjection);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            visible[i] = frustum.IntersectsBox(objects[i]->minimum, objects[i]->maximum) ? 1 : 0;
+            stats.frustumCulled += visible[i] ? 0 : 1;
+        }
+    }
+    if (mode == MODE_OCCLUSION)
+    {
+        // 遮挡物: 视锥体内最近的几栋高楼 从近到远提交
+        occluders.clear();
+        for (unsigned int i = 0; i < (unsigned int)scene.buildings.size(); i++)
+            if (visible[i])
+                occluders.push_back(objects[i]);
+        size_t used = min<size_t>(maxOccluders, occluders.size());
+        partial_sort(occluders.begin(), occluders.begin() + used, occluders.end(), [](const Object *a, const Object *b) {
+            return boxDistance(*a, camera.Position) < boxDistance(*b, camera.Position);
+        });
+        culler.Begin(viewProjection);
+        for (size_t i = 0; i < used; i++)
+            culler.AddOccluder(scene.cube, occluders[i]->model);
+        culler.Rasterize(&pool);
+
+        // 测试视锥体内的物体 每个线程测试一段 只读遮挡缓冲
+        auto testStart = chrono::steady_clock::now();
+        const unsigned int CHUNK = 256;
+        unsigned int chunks = (count + CHUNK - 1) / CHUNK;
+        pool.Run(chunks, [&](unsigned int chunk, unsigned int) {
+            unsigned int last = min(chunk * CHUNK + CHUNK, count);
+            for (unsigned int i = chunk * CHUNK; i < last; i++)
+                if (visible[i] && !culler.IsVisible(objects[i]->minimum, objects[i]->maximum))
+                    visible[i] = 2;
+        });
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (visible[i] == 2)
+            {
+                visible[i] = 0;
+                stats.occlusionCulled++;
+            }
+        }
+        stats.testMs = chrono::duration<double, milli>(chrono::steady_clock::now() - testStart).count();
+        const OcclusionStats &occlusion = culler.Stats();
+        stats.setupMs = occlusion.setupMs;
+        stats.rasterMs = occlusion.rasterMs;
+        stats.occluders = occlusion.occluders;
+        stats.triangles = occlusion.triangles;
+    }
+    stats.cullMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    glClearColor(0.6f, 0.7f, 0.8f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    shader.use();
+    shader.setMat4("projection", projection);
+    shader.setMat4("view", view);
+    glBindVertexArray(scene.cubeVAO);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindTexture(GL_TEXTURE_2D, scene.groundMap);
+    drawObject(scene, shader, scene.ground);
+    glBindTexture(GL_TEXTURE_2D, scene.buildingMap);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (i == scene.buildings.size())
+            glBindTexture(GL_TEXTURE_2D, scene.propMap);
+        if (visible[i])
+        {
+            drawObject(scene, shader, *objects[i]);
+            stats.drawn++;
+        }
+    }
+    return stats;
+}
+
+static Object makeObject(const glm::vec3 &minimum, const glm::vec3 &maximum, const glm::vec2 &uvScale)
+{
+    Object object;
+    object.minimum = minimum;
+    object.maximum = maximum;
+    object.model = glm::scale(glm::translate(glm::mat4(1.0f), (minimum + maximum) * 0.5f), maximum - minimum);
+    object.uvScale = uvScale;
+    return object;
+}
+
+// 每个街区四栋高楼 楼之间是1米宽的小巷 箱子随机放在街道和小巷中 不与高楼重叠
+void makeScene(Scene &scene, unsigned int propsPerBlock)
+{
+    scene.cube = MakeCube();
+    UploadMesh(scene.cube, scene.cubeVAO, scene.cubeVBO, scene.cubeEBO);
+    scene.buildingMap = loadTexture("../3_1Textures/bricks2.jpg");
+    scene.propMap = loadTexture("../12_1Multiple_lights/container2.png");
+    scene.groundMap = loadTexture("../3_1Textures/container.jpg");
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const float lot = (BLOCK_SIZE - 1.0f) * 0.5f;
+    for (unsigned int bz = 0; bz < BLOCKS; bz++)
+    {
+        for (unsigned int bx = 0; bx < BLOCKS; bx++)
+        {
+            glm::vec2 corner(bx * BLOCK_PITCH + STREET_WIDTH * 0.5f, bz * BLOCK_PITCH + STREET_WIDTH * 0.5f);
+            for (int j = 0; j < 2; j++)
+            {
+                for (int i = 0; i < 2; i++)
+                {
+                    float height = 6.0f + 34.0f * unit(random);
+                    glm::vec3 minimum(corner.x + i * (lot + 1.0f), 0.0f, corner.y + j * (lot + 1.0f));
+                    glm::vec3 maximum = minimum + glm::vec3(lot, height, lot);
+                    scene.buildings.push_back(makeObject(minimum, maximum, glm::vec2(lot, height) * 0.25f));
+                }
+            }
+        }
+    }
+
+    float extent = BLOCKS * BLOCK_PITCH;
+    unsigned int total = propsPerBlock * BLOCKS * BLOCKS;
+    while (scene.props.size() < total)
+    {
+        float size = 0.4f + 1.2f * unit(random);
+        glm::vec3 minimum(extent * unit(random), 0.0f, extent * unit(random));
+        glm::vec3 maximum = minimum + glm::vec3(size);
+        bool overlaps = false;
+        for (size_t b = 0; b < scene.buildings.size() && !overlaps; b++)
+        {
+            const Object &building = scene.buildings[b];
+            overlaps = maximum.x > building.minimum.x && minimum.x < building.maximum.x &&
+                       maximum.z > building.minimum.z && minimum.z < building.maximum.z;
+        }
+        if (!overlaps)
+            scene.props.push_back(makeObject(minimum, maximum, glm::vec2(1.0f)));
+    }
+
+    scene.ground = makeObject(glm::vec3(-50.0f, -0.2f, -50.0f), glm::vec3(extent + 50.0f, 0.0f, extent + 50.0f),
+                              glm::vec2((extent + 100.0f) * 0.25f));
+}
+
+void deleteScene(Scene &scene)
+{
+    unsigned int buffers[2] = { scene.cubeVBO, scene.cubeEBO };
+    unsigned int textures[3] = { scene.buildingMap, scene.propMap, scene.groundMap };
+    glDeleteVertexArrays(1, &scene.cubeVAO);
+    glDeleteBuffers(2, buffers);
+    glDeleteTextures(3, textures);
+}
+
+// 遮挡缓冲保存为PPM 越近越亮 黑色是没有遮挡物的地方
+void saveOcclusionBuffer(const OcclusionCuller &culler, const char *path)
+{
+    ofstream file(path, ios::binary);
+    if (!file)
+    {
+        cout << "ERROR::OCCLUSION::FILE_NOT_SUCCESFULLY_WRITTEN " << path << endl;
+        return;
+    }
+    file << "P6\n" << culler.Width << " " << culler.Height << "\n255\n";
+    // PPM从上到下 缓冲的第0行在下面
+    for (unsigned int y = culler.Height; y-- > 0; )
+    {
+        for (unsigned int x = 0; x < culler.Width; x++)
+        {
+            // 1/w 取平方根拉开远处的差别 距离1米为最亮
+            unsigned char value = (unsigned char)(255.0f * fminf(sqrtf(culler.Depth(x, y)), 1.0f));
+            file.put(value).put(value).put(value);
+        }
+    }
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,16 @@
+// 只有一个定向光 这一章看的是画了多少物体 不是着色
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+out vec4 FragColor;
+
+uniform sampler2D diffuse;
+uniform vec3 lightDirection;
+
+void main()
+{
+    vec3 albedo = texture(diffuse, TexCoords).rgb;
+    float diff = max(dot(normalize(Normal), -normalize(lightDirection)), 0.0);
+    FragColor = vec4(albedo * (0.3 + 0.7 * diff), 1.0);
+}
@@ -0,0 +1,562 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Camera_Class.h"
+#include "thread_pool.h"
+#include "soft_rasterizer.h"
+
+using namespace std;
+
+// 12_1的场景 不用OpenGL 在CPU上画成图片
+// 顶点着色器(shader.vs light.vs)和片段着色器(shader.fs light.fs)在下面用C++写成同样的计算
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+// 无窗口模式没有输入 与12_1的初始位置相同
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+// shader.fs 中的结构体 名字和成员都相同
+struct Material {
+    const SoftTexture *diffuse;
+    const SoftTexture *specular;
+    float shininess;
+};
+
+struct DirLight {
+    glm::vec3 direction;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+};
+
+struct PointLight {
+    glm::vec3 position;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+struct SpotLight {
+    glm::vec3 position;
+    glm::vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+};
+
+const int NR_POINT_LIGHTS = 4;
+
+// shader.fs 的uniform
+struct Uniforms {
+    Material material;
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLight;
+    glm::vec3 viewPos;
+};
+
+// varying的布局: FragPos Normal TexCoords 与 shader.vs 的输出相同
+const unsigned int VARYINGS = 8;
+
+// 场景: 12_1的10个箱子和4个光源 再加上 --cubes 个随机的箱子
+struct Scene {
+    vector<glm::vec3> positions;
+    vector<glm::vec3> axes;
+    SoftTexture diffuseMap, specularMap;
+};
+
+// 一帧的统计
+struct FrameStats {
+    double frameMs;
+    double vertexMs;
+    SoftRasterizerStats raster;
+};
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 与12_1的顶点数组相同 位置 法线 纹理坐标
+float vertices[] = {
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f
+};
+const unsigned int CUBE_VERTICES = 36;
+
+bool makeScene(Scene &scene, unsigned int extraCubes);
+void setupUniforms(Uniforms &uniforms, const Scene &scene);
+FrameStats renderFrame(SoftRasterizer &rasterizer, const Scene &scene, const Uniforms &uniforms, ThreadPool &pool, float time);
+bool loadPPM(const char *path, unsigned int &width, unsigned int &height, vector<unsigned char> &pixels);
+void compareImage(const SoftRasterizer &rasterizer, const char *path);
+
+// 用法:
+//   ./Software_rasterizer.o                            画12_1的场景 保存为 software.ppm
+//   ./Software_rasterizer.o --time 2.5                 箱子旋转的时间 默认1.16秒 与22_1回归测试中12_1的最后一帧相同
+//   ./Software_rasterizer.o --cubes 5000               再加5000个随机的箱子
+//   ./Software_rasterizer.o --threads 4                线程数 默认使用全部核心
+//   ./Software_rasterizer.o --small                    1/8大小
+//   ./Software_rasterizer.o --output out.ppm           保存的图片
+//   ./Software_rasterizer.o --compare gl.ppm           与OpenGL的截图比较
+//   ./Software_rasterizer.o --frames 10                画10帧 输出每帧的时间
+//   ./Software_rasterizer.o --bench                    1 2 4 ... 到 --threads 个线程的吞吐量
+int main(int argc, char *argv[])
+{
+    float time = 1.16f;
+    unsigned int extraCubes = 0;
+    unsigned int threads = 0;
+    unsigned int frames = 1;
+    const char *outputPath = "software.ppm";
+    const char *comparePath = NULL;
+    bool bench = false;
+    bool small = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            time = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--cubes") == 0 && i + 1 < argc)
+            extraCubes = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            comparePath = argv[++i];
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--small") == 0)
+            small = true;
+    }
+    if (threads == 0)
+        threads = max(thread::hardware_concurrency(), 1u);
+
+    Scene scene;
+    if (!makeScene(scene, extraCubes))
+        return -1;
+    Uniforms uniforms;
+    setupUniforms(uniforms, scene);
+    unsigned int width = small ? SCR_WIDTH / 8 : SCR_WIDTH;
+    unsigned int height = small ? SCR_HEIGHT / 8 : SCR_HEIGHT;
+    SoftRasterizer rasterizer(width, height, VARYINGS);
+    cout << width << "x" << height << ", " << scene.positions.size() << " cubes, "
+#if defined(SOFT_RASTERIZER_AVX2)
+         << "AVX2" << endl;
+#elif defined(SOFT_RASTERIZER_SSE)
+         << "SSE2" << endl;
+#else
+         << "scalar" << endl;
+#endif
+
+    if (bench)
+    {
+        const int benchFrames = 5;
+        cout << "threads  frame ms  vertex ms setup ms  raster ms Mpix/s    Mfrag/s   Mtri/s" << endl;
+        // 1 2 4 ... 最后是 threads
+        vector<unsigned int> counts;
+        for (unsigned int t = 1; t < threads; t *= 2)
+            counts.push_back(t);
+        counts.push_back(threads);
+        for (size_t c = 0; c < counts.size(); c++)
+        {
+            unsigned int t = counts[c];
+            ThreadPool pool(t);
+            double total = 0.0, vertexMs = 0.0, setupMs = 0.0, rasterMs = 0.0;
+            FrameStats stats;
+            for (int f = 0; f <= benchFrames; f++)
+            {
+                stats = renderFrame(rasterizer, scene, uniforms, pool, time);
+                // 第一帧分配内存 不计入
+                if (f > 0)
+                {
+                    total += stats.frameMs;
+                    vertexMs += stats.vertexMs;
+                    setupMs += stats.raster.setupMs;
+                    rasterMs += stats.raster.rasterMs;
+                }
+            }
+            double seconds = total / benchFrames / 1000.0;
+            cout.setf(ios::left);
+            cout.width(9);
+            cout << t;
+            cout.width(10);
+            cout << total / benchFrames;
+            cout.width(10);
+            cout << vertexMs / benchFrames;
+            cout.width(10);
+            cout << setupMs / benchFrames;
+            cout.width(10);
+            cout << rasterMs / benchFrames;
+            cout.width(10);
+            cout << width * height / seconds / 1.0e6;
+            cout.width(10);
+            cout << stats.raster.fragments / seconds / 1.0e6;
+            cout << stats.raster.triangles / seconds / 1.0e6 << endl;
+        }
+    }
+    else
+    {
+        ThreadPool pool(threads);
+        for (unsigned int f = 0; f < frames; f++)
+        {
+            FrameStats stats = renderFrame(rasterizer, scene, uniforms, pool, time);
+            cout << "frame " << f << ": " << stats.frameMs << " ms (vertex " << stats.vertexMs << ", setup "
+                 << stats.raster.setupMs << ", raster " << stats.raster.rasterMs << "), "
+                 << stats.raster.triangles << " triangles, " << stats.raster.fragments << " fragments, "
+                 << pool.Size() << " threads" << endl;
+        }
+    }
+
+    if (!rasterizer.SavePPM(outputPath))
+        cout << "ERROR::SOFTWARE::FILE_NOT_SUCCESFULLY_WRITTEN " << outputPath << endl;
+    if (comparePath)
+        compareImage(rasterizer, comparePath);
+    return 0;
+}
+
+// 与12_1每帧设置的uniform相同
+void setupUniforms(Uniforms &uniforms, const Scene &scene)
+{
+    uniforms.material.diffuse = &scene.diffuseMap;
+    uniforms.material.specular = &scene.specularMap;
+    uniforms.material.shininess = 32.0f;
+    uniforms.dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    uniforms.dirLight.ambient = glm::vec3(0.05f);
+    uniforms.dirLight.diffuse = glm::vec3(0.4f);
+    uniforms.dirLight.specular = glm::vec3(0.5f);
+    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+    {
+        PointLight &light = uniforms.pointLights[i];
+        light.position = pointLightPositions[i];
+        light.ambient = glm::vec3(0.05f);
+        light.diffuse = glm::vec3(0.8f);
+        light.specular = glm::vec3(1.0f);
+        light.constant = 1.0f;
+        light.linear = 0.09f;
+        light.quadratic = 0.032f;
+    }
+    uniforms.spotLight.position = camera.Position;
+    uniforms.spotLight.direction = camera.Front;
+    uniforms.spotLight.cutOff = glm::cos(glm::radians(12.5f));
+    uniforms.spotLight.outerCutOff = glm::cos(glm::radians(17.5f));
+    uniforms.spotLight.ambient = glm::vec3(0.0f);
+    uniforms.spotLight.diffuse = glm::vec3(1.0f);
+    uniforms.spotLight.specular = glm::vec3(1.0f);
+    uniforms.viewPos = camera.Position;
+}
+
+// shader.fs 的三个函数
+// GLSL中每个函数各读两次贴图 编译器会合并成一次 这里与23_1的 forward.fs 一样在 main 中读一次 作为参数传入
+glm::vec3 CalcDirLight(const DirLight &light, float shininess, const glm::vec3 &normal, const glm::vec3 &viewDir,
+                       const glm::vec3 &albedo, const glm::vec3 &specularMask)
+{
+    glm::vec3 ambient = light.ambient * albedo;
+    glm::vec3 lightDir = glm::normalize(-light.direction);
+    float diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    glm::vec3 diffuse = light.diffuse * diff * albedo;
+    glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+    float spec = powf(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    glm::vec3 specular = light.specular * spec * specularMask;
+    return ambient + diffuse + specular;
+}
+
+glm::vec3 CalcPointLight(const PointLight &light, float shininess, const glm::vec3 &normal, const glm::vec3 &fragPos,
+                         const glm::vec3 &viewDir, const glm::vec3 &albedo, const glm::vec3 &specularMask)
+{
+    glm::vec3 ambient = light.ambient * albedo;
+    glm::vec3 lightDir = glm::normalize(light.position - fragPos);
+    float diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    glm::vec3 diffuse = light.diffuse * diff * albedo;
+    glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+    float spec = powf(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    glm::vec3 specular = light.specular * spec * specularMask;
+    float distance = glm::length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+glm::vec3 CalcSpotLight(const SpotLight &light, float shininess, const glm::vec3 &normal, const glm::vec3 &fragPos,
+                        const glm::vec3 &viewDir, const glm::vec3 &albedo, const glm::vec3 &specularMask)
+{
+    glm::vec3 lightDir = glm::normalize(light.position - fragPos);
+    float theta = glm::dot(lightDir, glm::normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = glm::clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
+    glm::vec3 ambient = light.ambient * albedo;
+    float diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    glm::vec3 diffuse = light.diffuse * diff * albedo;
+    glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+    float spec = powf(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    glm::vec3 specular = light.specular * spec * specularMask;
+    diffuse *= intensity;
+    specular *= intensity;
+    return ambient + diffuse + specular;
+}
+
+// 片段着色器 draw 小于 cubeCount 的是箱子(shader.fs) 其余是光源(light.fs)
+struct FragmentShader {
+    const Uniforms *uniforms;
+    unsigned int cubeCount;
+
+    glm::vec3 operator()(unsigned int draw, const float *varyings) const
+    {
+        if (draw >= cubeCount)
+            return glm::vec3(1.0f);
+        glm::vec3 FragPos(varyings[0], varyings[1], varyings[2]);
+        glm::vec3 Normal(varyings[3], varyings[4], varyings[5]);
+        glm::vec2 TexCoords(varyings[6], varyings[7]);
+
+        const Uniforms &u = *uniforms;
+        glm::vec3 norm = glm::normalize(Normal);
+        glm::vec3 viewDir = glm::normalize(u.viewPos - FragPos);
+        glm::vec3 albedo = u.material.diffuse->Sample(TexCoords);
+        glm::vec3 specularMask = u.material.specular->Sample(TexCoords);
+        float shininess = u.material.shininess;
+        glm::vec3 result = CalcDirLight(u.dirLight, shininess, norm, viewDir, albedo, specularMask);
+        for (int i = 0; i < NR_POINT_LIGHTS; i++)
+            result += CalcPointLight(u.pointLights[i], shininess, norm, FragPos, viewDir, albedo, specularMask);
+        result += CalcSpotLight(u.spotLight, shininess, norm, FragPos, viewDir, albedo, specularMask);
+        return result;
+    }
+};
+
+// shader.vs: 一个箱子的36个顶点 写入 Triangles 中从 first 开始的12个三角形
+static void shadeCube(SoftRasterizer &rasterizer, size_t first, unsigned int draw, const glm::mat4 &model,
+                      const glm::mat4 &viewProjection)
+{
+    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+    for (unsigned int v = 0; v < CUBE_VERTICES; v++)
+    {
+        const float *p = &vertices[v * 8];
+        SoftTriangle &triangle = rasterizer.Triangles[first + v / 3];
+        SoftVertex &out = triangle.vertices[v % 3];
+        glm::vec3 FragPos = glm::vec3(model * glm::vec4(p[0], p[1], p[2], 1.0f));
+        glm::vec3 Normal = normalMatrix * glm::vec3(p[3], p[4], p[5]);
+        out.position = viewProjection * glm::vec4(FragPos, 1.0f);
+        memcpy(out.varyings, &FragPos[0], sizeof(float) * 3);
+        memcpy(out.varyings + 3, &Normal[0], sizeof(float) * 3);
+        out.varyings[6] = p[6];
+        out.varyings[7] = p[7];
+        triangle.draw = draw;
+    }
+}
+
+// light.vs: 只变换位置
+static void shadeLight(SoftRasterizer &rasterizer, size_t first, unsigned int draw, const glm::mat4 &model,
+                       const glm::mat4 &viewProjection)
+{
+    for (unsigned int v = 0; v < CUBE_VERTICES; v++)
+    {
+        const float *p = &vertices[v * 8];
+        SoftTriangle &triangle = rasterizer.Triangles[first + v / 3];
+        triangle.vertices[v % 3].position = viewProjection * model * glm::vec4(p[0], p[1], p[2], 1.0f);
+        triangle.draw = draw;
+    }
+}
+
+// 画一帧 与12_1相同 箱子在前 光源在后
+FrameStats renderFrame(SoftRasterizer &rasterizer, const Scene &scene, const Uniforms &uniforms, ThreadPool &pool, float time)
+{
+    FrameStats stats;
+    auto start = chrono::steady_clock::now();
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 viewProjection = projection * camera.GetViewMatrix();
+
+    // 顶点着色: 每个物体由一个线程处理 写入各自的12个三角形
+    unsigned int cubeCount = (unsigned int)scene.positions.size();
+    unsigned int objects = cubeCount + NR_POINT_LIGHTS;
+    const unsigned int TRIANGLES = CUBE_VERTICES / 3;
+    rasterizer.Triangles.resize((size_t)objects * TRIANGLES);
+    pool.Run(objects, [&](unsigned int i, unsigned int) {
+        if (i < cubeCount)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), scene.positions[i]);
+            float angle = 20.0f * i + 10.0f;
+            model = glm::rotate(model, time * glm::radians(angle), scene.axes[i]);
+            shadeCube(rasterizer, (size_t)i * TRIANGLES, i, model, viewProjection);
+        }
+        else
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), pointLightPositions[i - cubeCount]);
+            model = glm::scale(model, glm::vec3(0.2f));
+            shadeLight(rasterizer, (size_t)i * TRIANGLES, i, model, viewProjection);
+        }
+    });
+    stats.vertexMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    rasterizer.Clear(glm::vec3(0.1f));
+    FragmentShader shader = { &uniforms, cubeCount };
+    rasterizer.Render(shader, &pool);
+    stats.raster = rasterizer.Stats();
+    stats.frameMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+static bool loadTexture(const char *path, SoftTexture &texture)
+{
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (!data)
+    {
+        std::cout << "Failed to load texture" << std::endl;
+        return false;
+    }
+    texture = SoftTexture(data, width, height, nrChannels);
+    stbi_image_free(data);
+    return true;
+}
+
+// 额外的箱子与26_1相同 随机放在摄像机前方
+bool makeScene(Scene &scene, unsigned int extraCubes)
+{
+    if (!loadTexture("../12_1Multiple_lights/container2.png", scene.diffuseMap) ||
+        !loadTexture("../12_1Multiple_lights/container2_specular.png", scene.specularMap))
+        return false;
+
+    glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+    scene.positions.assign(cubePositions, cubePositions + 10);
+    scene.axes.assign(10, glm::vec3(1.0f, 0.3f, 0.5f));
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (unsigned int i = 0; i < extraCubes; i++)
+    {
+        float z = -2.0f - 38.0f * unit(random);
+        float spread = 0.5f + (3.0f - z) * 0.45f;
+        scene.positions.push_back(glm::vec3((unit(random) * 2.0f - 1.0f) * spread * 1.6f, (unit(random) * 2.0f - 1.0f) * spread, z));
+        scene.axes.push_back(glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + 0.1f));
+    }
+    return true;
+}
+
+// 读取 headless.h 保存的P6图片
+bool loadPPM(const char *path, unsigned int &width, unsigned int &height, vector<unsigned char> &pixels)
+{
+    ifstream file(path, ios::binary);
+    string magic;
+    unsigned int maxValue;
+    if (!(file >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255)
+        return false;
+    file.get();
+    pixels.resize((size_t)width * height * 3);
+    file.read((char*)pixels.data(), pixels.size());
+    return (bool)file;
+}
+
+// 与OpenGL的截图逐像素比较
+void compareImage(const SoftRasterizer &rasterizer, const char *path)
+{
+    unsigned int width, height;
+    vector<unsigned char> pixels;
+    if (!loadPPM(path, width, height, pixels))
+    {
+        cout << "ERROR::SOFTWARE::FILE_NOT_SUCCESFULLY_READ " << path << endl;
+        return;
+    }
+    if (width != rasterizer.Width || height != rasterizer.Height)
+    {
+        cout << "ERROR::SOFTWARE::SIZE_MISMATCH " << width << "x" << height << endl;
+        return;
+    }
+    int maxDiff = 0;
+    double sum = 0.0;
+    size_t large = 0;
+    size_t differentPixels = 0;
+    for (unsigned int y = 0; y < height; y++)
+    {
+        // PPM从上到下
+        const unsigned char *reference = &pixels[(size_t)(height - 1 - y) * width * 3];
+        for (unsigned int x = 0; x < width; x++)
+        {
+            bool different = false;
+            for (int c = 0; c < 3; c++)
+            {
+                int diff = abs((int)rasterizer.Pixel(x, y)[c] - (int)reference[x * 3 + c]);
+                maxDiff = max(maxDiff, diff);
+                sum += diff;
+                large += diff > 2 ? 1 : 0;
+                different = different || diff > 2;
+            }
+            differentPixels += different ? 1 : 0;
+        }
+    }
+    size_t components = (size_t)width * height * 3;
+    cout << "compare with " << path << ": max diff " << maxDiff << "/255, mean " << sum / components
+         << ", components > 2/255: " << 100.0 * large / components << "%, pixels > 2/255: "
+         << 100.0 * differentPixels / ((size_t)width * height) << "%" << endl;
+}
@@ -0,0 +1,482 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "thread_pool.h"
+#include "phong_simd.h"
+
+using namespace std;
+
+// 在CPU上计算12_1的多光源光照 比较标量和SIMD两个版本的速度 并与GLSL的结果比较
+
+// 无窗口模式没有输入 与12_1的初始位置相同
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+// 每个任务的片段数
+const size_t BATCH = 4096;
+
+// --verify 时GLSL计算的片段放在这个宽度的纹理中 最多 VERIFY_WIDTH * VERIFY_WIDTH 个
+const unsigned int VERIFY_WIDTH = 256;
+
+// 超过这个误差的片段算作不一致: 颜色在1以下时是绝对误差 以上时是相对误差
+const float TOLERANCE = 1.0e-4f;
+
+glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 读入后的贴图 片段的颜色取最近的像素
+struct Image {
+    vector<unsigned char> data;
+    int width, height, channels;
+};
+
+// 比较的结果
+struct Difference {
+    float maxAbsolute;
+    float maxRelative;
+    size_t failed;
+};
+
+bool loadImage(Image &image, const char *path);
+void setupUniforms(PhongUniforms &uniforms, unsigned int pointLights, mt19937 &random);
+void makeFragments(PhongFragments &fragments, size_t count, const Image &diffuse, const Image &specular, mt19937 &random);
+double shade(const PhongUniforms &uniforms, PhongFragments &fragments, ThreadPool &pool, bool simd);
+Difference compare(const vector<glm::vec3> &colors, const vector<glm::vec3> &expected);
+vector<glm::vec3> colorsOf(const PhongFragments &fragments, size_t count);
+bool shadeGLSL(const PhongUniforms &uniforms, const PhongFragments &fragments, size_t count, vector<glm::vec3> &colors);
+void printDifference(const char *name, const Difference &difference);
+
+// 用法:
+//   ./SIMD_lighting.o                          各算一次标量和SIMD版本 输出时间和两者的差别
+//   ./SIMD_lighting.o --fragments 100000       片段数 默认1048576
+//   ./SIMD_lighting.o --lights 32              点光源数 默认与12_1相同为4 多出的随机放在场景中
+//   ./SIMD_lighting.o --threads 4              线程数 默认使用全部核心
+//   ./SIMD_lighting.o --verify                 与GLSL(shader.fs)的结果比较 超过误差时返回1
+//   ./SIMD_lighting.o --verify --headless      没有显示器时用无窗口模式
+//   ./SIMD_lighting.o --bench                  1 2 4 ... 到 --threads 个线程的吞吐量
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+
+    size_t count = 1 << 20;
+    unsigned int pointLights = 4;
+    unsigned int threads = 0;
+    bool verify = false;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--fragments") == 0 && i + 1 < argc)
+            count = (size_t)max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+            pointLights = (unsigned int)max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--verify") == 0)
+            verify = true;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+    }
+    if (threads == 0)
+        threads = max(thread::hardware_concurrency(), 1u);
+
+    Image diffuse, specular;
+    if (!loadImage(diffuse, "../12_1Multiple_lights/container2.png") ||
+        !loadImage(specular, "../12_1Multiple_lights/container2_specular.png"))
+        return -1;
+
+    // 每次运行的片段和光源相同
+    mt19937 random(29);
+    PhongUniforms uniforms;
+    setupUniforms(uniforms, pointLights, random);
+    PhongFragments fragments;
+    makeFragments(fragments, count, diffuse, specular, random);
+    unsigned int lights = (unsigned int)(uniforms.dirLights.size() + uniforms.pointLights.size() + uniforms.spotLights.size());
+    cout << count << " fragments, " << lights << " lights, " << SimdName() << " (" << SIMD_WIDTH << " fragments per instruction)" << endl;
+
+    int result = 0;
+    if (bench)
+    {
+        const int benchRuns = 5;
+        cout << "threads  kernel    ms        Mfrag/s   per thread speedup" << endl;
+        // 1 2 4 ... 最后是 threads
+        vector<unsigned int> counts;
+        for (unsigned int t = 1; t < threads; t *= 2)
+            counts.push_back(t);
+        counts.push_back(threads);
+        for (size_t c = 0; c < counts.size(); c++)
+        {
+            unsigned int t = counts[c];
+            ThreadPool pool(t);
+            double referenceMs = 0.0;
+            for (int simd = 0; simd < 2; simd++)
+            {
+                double total = 0.0;
+                for (int r = 0; r <= benchRuns; r++)
+                {
+                    double ms = shade(uniforms, fragments, pool, simd != 0);
+                    // 第一次把数据读进缓存 不计入
+                    if (r > 0)
+                        total += ms;
+                }
+                double ms = total / benchRuns;
+                if (!simd)
+                    referenceMs = ms;
+                double rate = count / (ms / 1000.0) / 1.0e6;
+                cout.setf(ios::left);
+                cout.width(9);
+                cout << t;
+                cout.width(10);
+                cout << (simd ? SimdName() : "scalar");
+                cout.width(10);
+                cout << ms;
+                cout.width(10);
+                cout << rate;
+                cout.width(11);
+                cout << rate / t;
+                cout << referenceMs / ms << endl;
+            }
+        }
+    }
+    else
+    {
+        ThreadPool pool(threads);
+        double referenceMs = shade(uniforms, fragments, pool, false);
+        vector<glm::vec3> reference = colorsOf(fragments, count);
+        double simdMs = shade(uniforms, fragments, pool, true);
+        vector<glm::vec3> simd = colorsOf(fragments, count);
+        cout << "scalar " << referenceMs << " ms, " << SimdName() << " " << simdMs << " ms, "
+             << referenceMs / simdMs << "x, " << pool.Size() << " threads" << endl;
+        Difference difference = compare(simd, reference);
+        printDifference("SIMD vs scalar", difference);
+        if (difference.failed)
+            result = 1;
+
+        if (verify)
+        {
+            size_t verifyCount = min(count, (size_t)VERIFY_WIDTH * VERIFY_WIDTH);
+            vector<glm::vec3> glsl;
+            if (!shadeGLSL(uniforms, fragments, verifyCount, glsl))
+                return -1;
+            reference.resize(verifyCount);
+            simd.resize(verifyCount);
+            Difference referenceDifference = compare(reference, glsl);
+            Difference simdDifference = compare(simd, glsl);
+            cout << "GLSL: " << verifyCount << " fragments" << endl;
+            printDifference("scalar vs GLSL", referenceDifference);
+            printDifference("SIMD vs GLSL", simdDifference);
+            if (referenceDifference.failed || simdDifference.failed)
+                result = 1;
+        }
+    }
+    return result;
+}
+
+bool loadImage(Image &image, const char *path)
+{
+    unsigned char *data = stbi_load(path, &image.width, &image.height, &image.channels, 0);
+    if (!data)
+    {
+        cout << "Failed to load texture " << path << endl;
+        return false;
+    }
+    image.data.assign(data, data + (size_t)image.width * image.height * image.channels);
+    stbi_image_free(data);
+    return true;
+}
+
+static glm::vec3 sampleImage(const Image &image, glm::vec2 uv)
+{
+    int x = min((int)(uv.x * image.width), image.width - 1);
+    int y = min((int)(uv.y * image.height), image.height - 1);
+    const unsigned char *p = &image.data[((size_t)y * image.width + x) * image.channels];
+    if (image.channels < 3)
+        return glm::vec3(p[0] / 255.0f);
+    return glm::vec3(p[0], p[1], p[2]) / 255.0f;
+}
+
+// 与12_1每帧设置的uniform相同 点光源多于4个时其余的随机放在箱子周围
+void setupUniforms(PhongUniforms &uniforms, unsigned int pointLights, mt19937 &random)
+{
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    PhongDirLight dirLight;
+    dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    dirLight.ambient = glm::vec3(0.05f);
+    dirLight.diffuse = glm::vec3(0.4f);
+    dirLight.specular = glm::vec3(0.5f);
+    uniforms.dirLights.push_back(dirLight);
+
+    for (unsigned int i = 0; i < pointLights; i++)
+    {
+        PhongPointLight light;
+        if (i < 4)
+            light.position = pointLightPositions[i];
+        else
+            light.position = glm::vec3(unit(random) * 10.0f - 5.0f, unit(random) * 10.0f - 4.0f, unit(random) * -18.0f + 3.0f);
+        light.ambient = glm::vec3(0.05f);
+        light.diffuse = glm::vec3(0.8f);
+        light.specular = glm::vec3(1.0f);
+        light.constant = 1.0f;
+        light.linear = 0.09f;
+        light.quadratic = 0.032f;
+        uniforms.pointLights.push_back(light);
+    }
+
+    PhongSpotLight spotLight;
+    spotLight.position = camera.Position;
+    spotLight.direction = camera.Front;
+    spotLight.cutOff = glm::cos(glm::radians(12.5f));
+    spotLight.outerCutOff = glm::cos(glm::radians(17.5f));
+    spotLight.ambient = glm::vec3(0.0f);
+    spotLight.diffuse = glm::vec3(1.0f);
+    spotLight.specular = glm::vec3(1.0f);
+    uniforms.spotLights.push_back(spotLight);
+
+    uniforms.viewPos = camera.Position;
+    uniforms.shininess = 32.0f;
+}
+
+// 片段随机分布在12_1的10个箱子(1.16秒时的旋转)的表面上 颜色取自12_1的两张贴图
+void makeFragments(PhongFragments &fragments, size_t count, const Image &diffuse, const Image &specular, mt19937 &random)
+{
+    const float time = 1.16f;
+    glm::mat4 models[10];
+    for (int i = 0; i < 10; i++)
+    {
+        models[i] = glm::translate(glm::mat4(1.0f), cubePositions[i]);
+        models[i] = glm::rotate(models[i], time * glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+    }
+
+    uniform_int_distribution<int> cube(0, 9);
+    uniform_int_distribution<int> face(0, 5);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    fragments.Resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        int c = cube(random);
+        int f = face(random);
+        glm::vec2 uv(unit(random), unit(random));
+        // 面的法线沿 f/2 轴 f为奇数时朝负方向
+        int axis = f / 2;
+        float side = (f & 1) ? -0.5f : 0.5f;
+        glm::vec3 local, normal(0.0f);
+        local[axis] = side;
+        local[(axis + 1) % 3] = uv.x - 0.5f;
+        local[(axis + 2) % 3] = uv.y - 0.5f;
+        normal[axis] = side * 2.0f;
+
+        glm::vec3 position = glm::vec3(models[c] * glm::vec4(local, 1.0f));
+        normal = glm::mat3(glm::transpose(glm::inverse(models[c]))) * normal;
+        fragments.Set(i, position, normal, sampleImage(diffuse, uv), sampleImage(specular, uv));
+    }
+}
+
+// 所有片段分成每段 BATCH 个 交给线程池 返回毫秒数
+double shade(const PhongUniforms &uniforms, PhongFragments &fragments, ThreadPool &pool, bool simd)
+{
+    auto start = chrono::steady_clock::now();
+    unsigned int batches = (unsigned int)((fragments.Count + BATCH - 1) / BATCH);
+    pool.Run(batches, [&](unsigned int index, unsigned int) {
+        size_t first = index * BATCH;
+        size_t last = min(first + BATCH, fragments.Count);
+        if (simd)
+            ShadePhong(uniforms, fragments, first, last);
+        else
+            ShadePhongReference(uniforms, fragments, first, last);
+    });
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+vector<glm::vec3> colorsOf(const PhongFragments &fragments, size_t count)
+{
+    vector<glm::vec3> colors(count);
+    for (size_t i = 0; i < count; i++)
+        colors[i] = fragments.Color(i);
+    return colors;
+}
+
+Difference compare(const vector<glm::vec3> &colors, const vector<glm::vec3> &expected)
+{
+    Difference difference = { 0.0f, 0.0f, 0 };
+    for (size_t i = 0; i < colors.size(); i++)
+    {
+        bool failed = false;
+        for (int c = 0; c < 3; c++)
+        {
+            float error = fabsf(colors[i][c] - expected[i][c]);
+            float relative = error / max(fabsf(expected[i][c]), 1.0f);
+            difference.maxAbsolute = max(difference.maxAbsolute, error);
+            difference.maxRelative = max(difference.maxRelative, relative);
+            // NaN 也算作不一致
+            if (!(relative <= TOLERANCE))
+                failed = true;
+        }
+        if (failed)
+            difference.failed++;
+    }
+    return difference;
+}
+
+void printDifference(const char *name, const Difference &difference)
+{
+    cout << name << ": max error " << difference.maxAbsolute << " (relative " << difference.maxRelative << "), "
+         << difference.failed << " fragments over " << TOLERANCE << (difference.failed ? "  FAILED" : "  ok") << endl;
+}
+
+static unsigned int createInput(const PhongFragments &fragments, size_t count, unsigned int height,
+                                glm::vec3 (PhongFragments::*get)(size_t) const)
+{
+    vector<glm::vec3> data((size_t)VERIFY_WIDTH * height, glm::vec3(0.0f, 0.0f, 1.0f));
+    for (size_t i = 0; i < count; i++)
+        data[i] = (fragments.*get)(i);
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, VERIFY_WIDTH, height, 0, GL_RGB, GL_FLOAT, &data[0]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+// 用 verify.fs 在GPU上计算前 count 个片段 每个片段是浮点帧缓冲中的一个像素
+bool shadeGLSL(const PhongUniforms &uniforms, const PhongFragments &fragments, size_t count, vector<glm::vec3> &colors)
+{
+    unsigned int height = (unsigned int)((count + VERIFY_WIDTH - 1) / VERIFY_WIDTH);
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* window = glfwCreateWindow(VERIFY_WIDTH, height, "SIMD lighting", NULL, NULL);
+    if (window == NULL)
+    {
+        cout << "Failed to create GLFW window" << endl;
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        cout << "Failed to initialize GLAD" << endl;
+        glfwTerminate();
+        return false;
+    }
+
+    unsigned int inputs[4] = {
+        createInput(fragments, count, height, &PhongFragments::Position),
+        createInput(fragments, count, height, &PhongFragments::Normal),
+        createInput(fragments, count, height, &PhongFragments::Albedo),
+        createInput(fragments, count, height, &PhongFragments::Specular)
+    };
+    unsigned int output;
+    glGenTextures(1, &output);
+    glBindTexture(GL_TEXTURE_2D, output);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, VERIFY_WIDTH, height, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    unsigned int FBO;
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, output, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+        cout << "ERROR::SIMD_LIGHTING::FRAMEBUFFER_INCOMPLETE" << endl;
+
+    string defines = "#define NR_POINT_LIGHTS " + to_string(uniforms.pointLights.size()) + "\n";
+    Shader *shader = new Shader("./verify.vs", "./verify.fs", defines.c_str());
+    shader->use();
+    shader->setInt("fragPositions", 0);
+    shader->setInt("fragNormals", 1);
+    shader->setInt("fragAlbedos", 2);
+    shader->setInt("fragSpeculars", 3);
+    shader->setFloat("material.shininess", uniforms.shininess);
+    shader->setVec3("viewPos", uniforms.viewPos);
+
+    const PhongDirLight &dirLight = uniforms.dirLights[0];
+    shader->setVec3("dirLight.direction", dirLight.direction);
+    shader->setVec3("dirLight.ambient", dirLight.ambient);
+    shader->setVec3("dirLight.diffuse", dirLight.diffuse);
+    shader->setVec3("dirLight.specular", dirLight.specular);
+    for (size_t i = 0; i < uniforms.pointLights.size(); i++)
+    {
+        const PhongPointLight &light = uniforms.pointLights[i];
+        string name = "pointLights[" + to_string(i) + "].";
+        shader->setVec3(name + "position", light.position);
+        shader->setVec3(name + "ambient", light.ambient);
+        shader->setVec3(name + "diffuse", light.diffuse);
+        shader->setVec3(name + "specular", light.specular);
+        shader->setFloat(name + "constant", light.constant);
+        shader->setFloat(name + "linear", light.linear);
+        shader->setFloat(name + "quadratic", light.quadratic);
+    }
+    const PhongSpotLight &spotLight = uniforms.spotLights[0];
+    shader->setVec3("spotLight.position", spotLight.position);
+    shader->setVec3("spotLight.direction", spotLight.direction);
+    shader->setFloat("spotLight.cutOff", spotLight.cutOff);
+    shader->setFloat("spotLight.outerCutOff", spotLight.outerCutOff);
+    shader->setVec3("spotLight.ambient", spotLight.ambient);
+    shader->setVec3("spotLight.diffuse", spotLight.diffuse);
+    shader->setVec3("spotLight.specular", spotLight.specular);
+
+    for (int i = 0; i < 4; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, inputs[i]);
+    }
+    // 覆盖整个屏幕的三角形不需要顶点数据 但核心模式下必须绑定一个VAO
+    unsigned int VAO;
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    glViewport(0, 0, VERIFY_WIDTH, height);
+    glDisable(GL_DEPTH_TEST);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    vector<glm::vec4> pixels((size_t)VERIFY_WIDTH * height);
+    glReadPixels(0, 0, VERIFY_WIDTH, height, GL_RGBA, GL_FLOAT, &pixels[0]);
+    colors.resize(count);
+    for (size_t i = 0; i < count; i++)
+        colors[i] = glm::vec3(pixels[i]);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteTextures(4, inputs);
+    glDeleteTextures(1, &output);
+    delete shader;
+    glfwTerminate();
+    return complete;
+}
@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 #include <math.h>
 using namespace std;
@@ -37,8 +38,9 @@ const char *fragmentShaderSource = "#version 330 core\n"
     // 就可以更新它的值
     // 这次我们不去给像素传递单独的一个颜色
     // 而是让他随时间改变颜色
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
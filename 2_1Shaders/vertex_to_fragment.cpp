@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 using namespace std;
 void processInput(GLFWwindow *window);
@@ -94,8 +95,9 @@ const char *fragmentShaderSource = "#version 330 core\n"
     "   FragColor = vertexColor;\n"
     "}\n";
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -0,0 +1,588 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "instanced_renderer.h"
+#include "thread_pool.h"
+#include "transform_simd.h"
+
+using namespace std;
+
+// 成千上万个旋转的箱子 模型矩阵和法线矩阵按SoA批量计算 直接写进映射的实例缓冲
+// 与14_1逐个物体 glm::translate glm::rotate 的写法比较速度和结果
+
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+// 超过这个误差的矩阵分量算作不一致
+const float TOLERANCE = 1.0e-5f;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 所有箱子绕同一个轴旋转 与12_1相同
+const glm::vec3 ROTATION_AXIS = glm::vec3(1.0f, 0.3f, 0.5f);
+
+// 箱子的变换和动画
+// 前10个与12_1相同 之后的位置与14_1相同 每个轴的缩放在0.5到1.5之间随机
+struct Cubes {
+    TransformSoA transforms;
+    vector<float> speeds;   // 每秒旋转的弧度
+};
+
+void makeCubes(Cubes &cubes, size_t count);
+void animate(Cubes &cubes, float time, size_t first, size_t last);
+void animateParallel(ThreadPool &pool, Cubes &cubes, float time);
+glm::mat4 cubeModel(const Cubes &cubes, size_t i, float time);
+void buildGlm(const Cubes &cubes, float time, InstanceData *out, size_t first, size_t last);
+float maxError(const vector<InstanceData> &a, const vector<InstanceData> &b);
+void benchmark(unsigned int threads);
+
+// 用法:
+//   ./Batch_transforms.o                 10000个箱子 每帧批量计算矩阵写进映射的实例缓冲
+//   ./Batch_transforms.o --count 100000  箱子数 前10个与12_1相同
+//   ./Batch_transforms.o --glm           逐个箱子 glm::translate glm::rotate 再 InstancedRenderer::Add 用于对比
+//   ./Batch_transforms.o --threads 4     线程数 默认使用全部核心
+//   ./Batch_transforms.o --verify        比较SIMD与glm的矩阵 超过误差时返回1 不打开窗口
+//   ./Batch_transforms.o --bench         1000到1000000个箱子 每种写法每秒算出的矩阵数 不打开窗口
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    size_t count = 10000;
+    bool useGlm = false;
+    unsigned int threads = 0;
+    bool verify = false;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (size_t)max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--glm") == 0)
+            useGlm = true;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--verify") == 0)
+            verify = true;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+    }
+    if (threads == 0)
+        threads = max(thread::hardware_concurrency(), 1u);
+
+    if (bench)
+    {
+        benchmark(threads);
+        return 0;
+    }
+
+    if (verify)
+    {
+        // 任意时刻 三种写法的结果相同
+        Cubes cubes;
+        makeCubes(cubes, count);
+        ThreadPool pool(threads);
+        float time = 1.16f;
+        animateParallel(pool, cubes, time);
+        vector<InstanceData> glmRotate(count), glmQuat(count), simd(count);
+        buildGlm(cubes, time, glmRotate.data(), 0, count);
+        BuildInstancesReference(cubes.transforms, glmQuat.data(), 0, count);
+        BuildInstancesParallel(pool, cubes.transforms, simd.data());
+        float quatError = maxError(simd, glmQuat);
+        float rotateError = maxError(simd, glmRotate);
+        cout << count << " cubes, " << SimdName() << " (" << SIMD_WIDTH << " matrices per instruction)" << endl;
+        cout << "SIMD vs glm quaternion: max error " << quatError << (quatError > TOLERANCE ? "  FAILED" : "  ok") << endl;
+        cout << "SIMD vs glm rotate: max error " << rotateError << (rotateError > TOLERANCE ? "  FAILED" : "  ok") << endl;
+        return quatError > TOLERANCE || rotateError > TOLERANCE ? 1 : 0;
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Batch transforms", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    float vertices[] = {
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    unsigned int VAOs[2];
+    glGenVertexArrays(2, VAOs);
+    for (int i = 0; i < 2; i++)
+    {
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // 灯的VAO只需要位置
+        if (i == 0)
+        {
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+            glEnableVertexAttribArray(2);
+        }
+    }
+
+    // 实例缓冲要在 glfwTerminate 之前释放 所以在堆上创建
+    InstancedRenderer *cubeInstances = new InstancedRenderer(1024);
+    InstancedRenderer *lightInstances = new InstancedRenderer(4);
+    cubeInstances->AttachTo(VAOs[0]);
+    lightInstances->AttachTo(VAOs[1], 3, false);
+    for (int i = 0; i < 4; i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, pointLightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.2f));
+        lightInstances->Add(model);
+    }
+    lightInstances->Upload();
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+
+    Cubes cubes;
+    makeCubes(cubes, count);
+    ThreadPool pool(threads);
+    double updateTotalMs = 0.0;
+    unsigned int updateFrames = 0;
+
+    while(!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 1000.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        // 更新实例缓冲: 动画 矩阵 上传
+        auto start = chrono::steady_clock::now();
+        if (useGlm)
+        {
+            cubeInstances->Clear();
+            for (size_t i = 0; i < count; i++)
+                cubeInstances->Add(cubeModel(cubes, i, currentFrame));
+            cubeInstances->Upload();
+        }
+        else
+        {
+            animateParallel(pool, cubes, currentFrame);
+            InstanceData *instances = cubeInstances->Map((unsigned int)count);
+            if (instances)
+                BuildInstancesParallel(pool, cubes.transforms, instances);
+            cubeInstances->Unmap();
+        }
+        updateTotalMs += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        updateFrames++;
+
+        CubeShader.use();
+        setLightUniforms(CubeShader);
+        CubeShader.setMat4("projection", projection);
+        CubeShader.setMat4("view", view);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+        cubeInstances->Draw(VAOs[0], GL_TRIANGLES, 0, 36);
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        lightInstances->Draw(VAOs[1], GL_TRIANGLES, 0, 36);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    if (updateFrames)
+        cout << (useGlm ? "glm" : SimdName()) << " update: " << count << " cubes, avg " << updateTotalMs / updateFrames
+             << " ms per frame, " << pool.Size() << " threads" << endl;
+    delete cubeInstances;
+    delete lightInstances;
+    glDeleteVertexArrays(2, VAOs);
+    glDeleteBuffers(1, &VBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+void makeCubes(Cubes &cubes, size_t count)
+{
+    cubes.transforms.Resize(count);
+    cubes.speeds.resize(count);
+    float halfSize = 2.0f * cbrtf((float)count);
+    unsigned int seed = 12345u;
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 position, scale(1.0f);
+        if (i < 10)
+            position = cubePositions[i];
+        else
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                position[c] = ((seed >> 8) / 16777216.0f * 2.0f - 1.0f) * halfSize;
+            }
+            position.z -= halfSize;
+            for (int c = 0; c < 3; c++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                scale[c] = 0.5f + (seed >> 8) / 16777216.0f;
+            }
+        }
+        cubes.transforms.Set(i, position, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), scale);
+        cubes.speeds[i] = glm::radians(20.0f * (i % 10) + 10.0f);
+    }
+}
+
+// 每个箱子的四元数 绕 ROTATION_AXIS 转 time * speed 弧度
+// sin cos 没有SIMD版本 逐个计算
+void animate(Cubes &cubes, float time, size_t first, size_t last)
+{
+    glm::vec3 axis = glm::normalize(ROTATION_AXIS);
+    last = min(last, cubes.transforms.Count);
+    for (size_t i = first; i < last; i++)
+        cubes.transforms.SetRotation(i, glm::angleAxis(time * cubes.speeds[i], axis));
+}
+
+void animateParallel(ThreadPool &pool, Cubes &cubes, float time)
+{
+    unsigned int batches = (unsigned int)((cubes.transforms.Count + TRANSFORM_BATCH - 1) / TRANSFORM_BATCH);
+    pool.Run(batches, [&](unsigned int batch, unsigned int) {
+        animate(cubes, time, batch * TRANSFORM_BATCH, (batch + 1) * TRANSFORM_BATCH);
+    });
+}
+
+// 与14_1相同的逐个物体写法 再加上缩放
+glm::mat4 cubeModel(const Cubes &cubes, size_t i, float time)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, cubes.transforms.Position(i));
+    model = glm::rotate(model, time * cubes.speeds[i], ROTATION_AXIS);
+    model = glm::scale(model, cubes.transforms.Scale(i));
+    return model;
+}
+
+// 与 InstancedRenderer::Add 相同
+void buildGlm(const Cubes &cubes, float time, InstanceData *out, size_t first, size_t last)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        out[i].model = cubeModel(cubes, i, time);
+        out[i].normalMatrix = glm::inverseTranspose(glm::mat3(out[i].model));
+    }
+}
+
+// 两组矩阵所有分量的最大误差 分量大于1时(平移 缩放小于1时的法线矩阵)按相对误差
+float maxError(const vector<InstanceData> &a, const vector<InstanceData> &b)
+{
+    float error = 0.0f;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                float scale = max(1.0f, fabs(b[i].model[c][r]));
+                error = max(error, fabs(a[i].model[c][r] - b[i].model[c][r]) / scale);
+            }
+        }
+        for (int c = 0; c < 3; c++)
+        {
+            for (int r = 0; r < 3; r++)
+            {
+                float scale = max(1.0f, fabs(b[i].normalMatrix[c][r]));
+                error = max(error, fabs(a[i].normalMatrix[c][r] - b[i].normalMatrix[c][r]) / scale);
+            }
+        }
+    }
+    return error;
+}
+
+// 每种写法算出全部箱子的矩阵所用的时间 不包括上传
+//   glm rotate     14_1的写法 translate rotate scale 再 inverseTranspose
+//   glm quat       BuildInstancesReference 从四元数开始 mat4_cast
+//   SIMD           BuildInstances 一个线程
+//   SIMD+animate   先逐个箱子算四元数(sin cos) 再 BuildInstances 与 glm rotate 做的事相同
+// 线程多于1时 最后两种再用线程池测一次
+void benchmark(unsigned int threads)
+{
+    const int benchRuns = 5;
+    size_t counts[] = { 1000, 10000, 100000, 1000000 };
+    cout << SimdName() << " (" << SIMD_WIDTH << " matrices per instruction), " << threads << " threads" << endl;
+    cout << "cubes     kernel          threads  ms        Mmat/s    speedup" << endl;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        size_t count = counts[c];
+        Cubes cubes;
+        makeCubes(cubes, count);
+        vector<InstanceData> out(count);
+        ThreadPool single(1);
+        ThreadPool pool(threads);
+        double referenceMs = 0.0;
+        for (int kernel = 0; kernel < 6; kernel++)
+        {
+            if (kernel >= 4 && threads == 1)
+                break;
+            static const char *names[] = { "glm rotate", "glm quat", "SIMD", "SIMD+animate", "SIMD", "SIMD+animate" };
+            ThreadPool &used = kernel >= 4 ? pool : single;
+            double total = 0.0;
+            for (int r = 0; r <= benchRuns; r++)
+            {
+                float time = 0.1f * r;
+                auto start = chrono::steady_clock::now();
+                if (kernel == 0)
+                    buildGlm(cubes, time, out.data(), 0, count);
+                else if (kernel == 1)
+                    BuildInstancesReference(cubes.transforms, out.data(), 0, count);
+                else
+                {
+                    if (kernel == 3 || kernel == 5)
+                        animateParallel(used, cubes, time);
+                    BuildInstancesParallel(used, cubes.transforms, out.data());
+                }
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                // 第一次把数据读进缓存 不计入
+                if (r > 0)
+                    total += ms;
+            }
+            double ms = total / benchRuns;
+            if (kernel == 0)
+                referenceMs = ms;
+            cout.setf(ios::left);
+            cout.width(10);
+            cout << count;
+            cout.width(16);
+            cout << names[kernel];
+            cout.width(9);
+            cout << used.Size();
+            cout.width(10);
+            cout << ms;
+            cout.width(10);
+            cout << count / (ms / 1000.0) / 1.0e6;
+            cout << referenceMs / ms << endl;
+        }
+    }
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,671 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "instanced_renderer.h"
+#include "scene_graph.h"
+
+using namespace std;
+
+// 12_1的场景放进层级场景: 每个箱子带着绕它公转的小箱子 小箱子又带着更小的箱子 灯挂在一个节点下
+// 与逐个节点用指针和递归更新的树比较深和宽的层级 每帧1%或全部节点变化时的更新时间
+
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader, const glm::vec3 *lightPositions);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+
+glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 每个箱子的卫星数 卫星和它的小卫星到父节点中心的距离(父节点的局部坐标)
+const unsigned int SATELLITES = 3;
+const float SATELLITE_DISTANCE = 1.4f;
+const float MOON_DISTANCE = 2.0f;
+
+// 场景中的节点
+struct Scene {
+    SceneGraph graph;
+    vector<unsigned int> cubes;       // 画成箱子的节点
+    vector<unsigned int> roots;       // 12_1的10个箱子
+    vector<unsigned int> satellites;  // 绕箱子公转 每个带一个小卫星
+    unsigned int lightRig;            // 4个灯的父节点
+    unsigned int lights[4];
+};
+
+void makeScene(Scene &scene);
+void animateScene(Scene &scene, float time);
+void benchmark(unsigned int nodes);
+bool verify(unsigned int nodes);
+
+// 用法:
+//   ./Scene_graph.o                 12_1的箱子带着公转的卫星 卫星带着小卫星 退出时输出每帧重算的节点数
+//   ./Scene_graph.o --bench         深和宽的层级 每帧1%或全部节点变化 比较数组和指针树的更新时间 不打开窗口
+//   ./Scene_graph.o --nodes 1000000 --bench 的节点数 默认100000
+//   ./Scene_graph.o --verify        随机修改节点后 Update 的结果与全部重算相同 不同时返回1 不打开窗口
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    unsigned int nodes = 100000;
+    bool bench = false;
+    bool check = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+        else if (strcmp(argv[i], "--nodes") == 0 && i + 1 < argc)
+            nodes = (unsigned int)max(atoi(argv[++i]), 2);
+        else if (strcmp(argv[i], "--verify") == 0)
+            check = true;
+    }
+    if (bench)
+    {
+        benchmark(nodes);
+        return 0;
+    }
+    if (check)
+        return verify(nodes) ? 0 : 1;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Scene graph", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    float vertices[] = {
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    unsigned int VAOs[2];
+    glGenVertexArrays(2, VAOs);
+    for (int i = 0; i < 2; i++)
+    {
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        // 灯的VAO只需要位置
+        if (i == 0)
+        {
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+            glEnableVertexAttribArray(2);
+        }
+    }
+
+    // 实例缓冲要在 glfwTerminate 之前释放 所以在堆上创建
+    InstancedRenderer *cubeInstances = new InstancedRenderer(64);
+    InstancedRenderer *lightInstances = new InstancedRenderer(4);
+    cubeInstances->AttachTo(VAOs[0]);
+    lightInstances->AttachTo(VAOs[1], 3, false);
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+
+    Scene scene;
+    makeScene(scene);
+    unsigned long long updatedTotal = 0;
+    unsigned int updateFrames = 0;
+
+    while(!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        animateScene(scene, currentFrame);
+        updatedTotal += scene.graph.Update();
+        updateFrames++;
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        glm::vec3 lightPositions[4];
+        for (int i = 0; i < 4; i++)
+            lightPositions[i] = scene.graph.WorldPosition(scene.lights[i]);
+
+        CubeShader.use();
+        setLightUniforms(CubeShader, lightPositions);
+        CubeShader.setMat4("projection", projection);
+        CubeShader.setMat4("view", view);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+        cubeInstances->Clear();
+        for (size_t i = 0; i < scene.cubes.size(); i++)
+            cubeInstances->Add(scene.graph.World(scene.cubes[i]));
+        cubeInstances->Upload();
+        cubeInstances->Draw(VAOs[0], GL_TRIANGLES, 0, 36);
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        lightInstances->Clear();
+        for (int i = 0; i < 4; i++)
+            lightInstances->Add(scene.graph.World(scene.lights[i]));
+        lightInstances->Upload();
+        lightInstances->Draw(VAOs[1], GL_TRIANGLES, 0, 36);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    if (updateFrames)
+        cout << scene.graph.Size() << " nodes, avg " << (double)updatedTotal / updateFrames << " updated per frame" << endl;
+    delete cubeInstances;
+    delete lightInstances;
+    glDeleteVertexArrays(2, VAOs);
+    glDeleteBuffers(1, &VBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+void makeScene(Scene &scene)
+{
+    glm::quat identity(1.0f, 0.0f, 0.0f, 0.0f);
+    for (unsigned int i = 0; i < 10; i++)
+    {
+        unsigned int root = scene.graph.AddNode(SCENE_NO_PARENT, cubePositions[i]);
+        scene.roots.push_back(root);
+        scene.cubes.push_back(root);
+        for (unsigned int s = 0; s < SATELLITES; s++)
+        {
+            unsigned int satellite = scene.graph.AddNode(root, glm::vec3(SATELLITE_DISTANCE, 0.0f, 0.0f), identity, glm::vec3(0.3f));
+            scene.satellites.push_back(satellite);
+            scene.cubes.push_back(satellite);
+            unsigned int moon = scene.graph.AddNode(satellite, glm::vec3(MOON_DISTANCE, 0.0f, 0.0f), identity, glm::vec3(0.5f));
+            scene.cubes.push_back(moon);
+        }
+    }
+    // 灯不动 第一帧之后不再重算
+    scene.lightRig = scene.graph.AddNode(SCENE_NO_PARENT, glm::vec3(0.0f));
+    for (int i = 0; i < 4; i++)
+        scene.lights[i] = scene.graph.AddNode(scene.lightRig, pointLightPositions[i], identity, glm::vec3(0.2f));
+}
+
+// 箱子与12_1相同地旋转 卫星在箱子的局部坐标中公转和自转 小卫星跟着卫星
+void animateScene(Scene &scene, float time)
+{
+    glm::vec3 axis = glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f));
+    for (unsigned int i = 0; i < scene.roots.size(); i++)
+    {
+        float angle = 20.0f * i + 10.0f;
+        scene.graph.SetLocalRotation(scene.roots[i], glm::angleAxis(time * glm::radians(angle), axis));
+    }
+    for (unsigned int i = 0; i < scene.satellites.size(); i++)
+    {
+        unsigned int s = i % SATELLITES;
+        float orbit = time * (1.0f + 0.3f * s) + s * glm::two_pi<float>() / SATELLITES;
+        scene.graph.SetLocalPosition(scene.satellites[i], SATELLITE_DISTANCE * glm::vec3(cos(orbit), 0.0f, sin(orbit)));
+        scene.graph.SetLocalRotation(scene.satellites[i], glm::angleAxis(2.0f * time, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 对比用的指针树: 每个节点单独 new 子节点放在各自的 vector 中 递归更新
+
+struct PointerNode {
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+    glm::mat4 world;
+    bool dirty;
+    vector<PointerNode*> children;
+};
+
+// 与 SceneGraph::Update 相同的判断和计算 返回重算的节点数
+unsigned int updatePointerTree(PointerNode *node, const glm::mat4 *parentWorld, bool parentChanged)
+{
+    unsigned int count = 0;
+    bool changed = node->dirty || parentChanged;
+    if (changed)
+    {
+        glm::mat4 local = glm::translate(glm::mat4(1.0f), node->position);
+        local = local * glm::mat4_cast(node->rotation);
+        local = glm::scale(local, node->scale);
+        node->world = parentWorld ? *parentWorld * local : local;
+        node->dirty = false;
+        count++;
+    }
+    for (size_t i = 0; i < node->children.size(); i++)
+        count += updatePointerTree(node->children[i], &node->world, changed);
+    return count;
+}
+
+// 与 graph 相同的树 节点按随机的顺序分配 与运行中陆续创建和删除物体后的内存相似
+void makePointerTree(const SceneGraph &graph, vector<PointerNode*> &nodes, vector<PointerNode*> &roots)
+{
+    unsigned int size = graph.Size();
+    vector<unsigned int> order(size);
+    for (unsigned int i = 0; i < size; i++)
+        order[i] = i;
+    unsigned int seed = 31u;
+    for (unsigned int i = size - 1; i > 0; i--)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        swap(order[i], order[(seed >> 8) % (i + 1)]);
+    }
+    nodes.assign(size, NULL);
+    for (unsigned int i = 0; i < size; i++)
+        nodes[order[i]] = new PointerNode();
+    roots.clear();
+    for (unsigned int i = 0; i < size; i++)
+    {
+        PointerNode *node = nodes[i];
+        node->position = graph.LocalPosition(i);
+        node->rotation = graph.LocalRotation(i);
+        node->scale = graph.LocalScale(i);
+        node->dirty = true;
+        if (graph.Parent(i) == SCENE_NO_PARENT)
+            roots.push_back(node);
+        else
+            nodes[graph.Parent(i)]->children.push_back(node);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 测试用的层级
+
+// 深: 每条链 DEEP_CHAIN 个节点 每个节点是前一个的子节点
+// 宽: 一个根节点 其余都是它的子节点
+const unsigned int DEEP_CHAIN = 1000;
+
+void makeHierarchy(SceneGraph &graph, unsigned int nodes, bool deep)
+{
+    graph = SceneGraph();
+    graph.Reserve(nodes);
+    unsigned int seed = 49u;
+    for (unsigned int i = 0; i < nodes; i++)
+    {
+        unsigned int parent;
+        if (deep)
+            parent = i % DEEP_CHAIN == 0 ? SCENE_NO_PARENT : i - 1;
+        else
+            parent = i == 0 ? SCENE_NO_PARENT : 0;
+        glm::vec3 position;
+        for (int c = 0; c < 3; c++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            position[c] = (seed >> 8) / 16777216.0f - 0.5f;
+        }
+        graph.AddNode(parent, position);
+    }
+}
+
+// 这一帧变化的节点 percent 为100时是全部节点 其余随机选取
+void pickChanged(vector<unsigned int> &changed, unsigned int nodes, unsigned int percent, unsigned int &seed)
+{
+    changed.clear();
+    if (percent >= 100)
+    {
+        for (unsigned int i = 0; i < nodes; i++)
+            changed.push_back(i);
+        return;
+    }
+    unsigned int count = max(nodes / 100 * percent, 1u);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        changed.push_back((seed >> 8) % nodes);
+    }
+}
+
+void applyChanges(SceneGraph &graph, vector<PointerNode*> &nodes, const vector<unsigned int> &changed, int frame)
+{
+    glm::quat rotation = glm::angleAxis(0.01f * frame, glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+    for (size_t i = 0; i < changed.size(); i++)
+    {
+        graph.SetLocalRotation(changed[i], rotation);
+        if (!nodes.empty())
+        {
+            nodes[changed[i]]->rotation = rotation;
+            nodes[changed[i]]->dirty = true;
+        }
+    }
+}
+
+// 每种层级和变化比例 三种更新方式每帧的时间
+//   array      SceneGraph::Update 从第一个 dirty 的节点起顺序扫描
+//   array all  SceneGraph::UpdateAll 不看 dirty
+//   pointer    指针树递归 与 array 重算相同的节点
+void benchmark(unsigned int nodes)
+{
+    const int benchRuns = 5;
+    cout << nodes << " nodes, deep = chains of " << DEEP_CHAIN << ", wide = one root" << endl;
+    cout << "shape  changed  kernel      ms        updated   Mnodes/s" << endl;
+    for (int deep = 1; deep >= 0; deep--)
+    {
+        SceneGraph graph;
+        makeHierarchy(graph, nodes, deep != 0);
+        vector<PointerNode*> pointerNodes, roots;
+        makePointerTree(graph, pointerNodes, roots);
+        graph.UpdateAll();
+        for (unsigned int r = 0; r < roots.size(); r++)
+            updatePointerTree(roots[r], NULL, false);
+
+        unsigned int percents[] = { 1, 100 };
+        for (int p = 0; p < 2; p++)
+        {
+            for (int kernel = 0; kernel < 3; kernel++)
+            {
+                static const char *names[] = { "array", "array all", "pointer" };
+                vector<unsigned int> changed;
+                unsigned int seed = 7u;
+                double total = 0.0;
+                unsigned long long updated = 0;
+                for (int r = 0; r <= benchRuns; r++)
+                {
+                    pickChanged(changed, nodes, percents[p], seed);
+                    applyChanges(graph, pointerNodes, changed, r);
+                    unsigned int count = 0;
+                    auto start = chrono::steady_clock::now();
+                    if (kernel == 0)
+                        count = graph.Update();
+                    else if (kernel == 1)
+                    {
+                        graph.UpdateAll();
+                        count = nodes;
+                    }
+                    else
+                    {
+                        for (unsigned int i = 0; i < roots.size(); i++)
+                            count += updatePointerTree(roots[i], NULL, false);
+                    }
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    // 另外两种方式也要清掉这一帧的 dirty
+                    if (kernel != 0)
+                        graph.Update();
+                    if (kernel != 2)
+                    {
+                        for (unsigned int i = 0; i < roots.size(); i++)
+                            updatePointerTree(roots[i], NULL, false);
+                    }
+                    // 第一次把数据读进缓存 不计入
+                    if (r > 0)
+                    {
+                        total += ms;
+                        updated += count;
+                    }
+                }
+                double ms = total / benchRuns;
+                cout.setf(ios::left);
+                cout.width(7);
+                cout << (deep ? "deep" : "wide");
+                cout.width(9);
+                cout << (to_string(percents[p]) + "%");
+                cout.width(12);
+                cout << names[kernel];
+                cout.width(10);
+                cout << ms;
+                cout.width(10);
+                cout << updated / benchRuns;
+                cout << nodes / (ms / 1000.0) / 1.0e6 << endl;
+            }
+        }
+        for (size_t i = 0; i < pointerNodes.size(); i++)
+            delete pointerNodes[i];
+    }
+}
+
+// 每种层级随机修改1%的节点10帧 每帧比较 Update 与全部重算 指针树的结果
+bool verify(unsigned int nodes)
+{
+    bool ok = true;
+    for (int deep = 1; deep >= 0; deep--)
+    {
+        SceneGraph graph;
+        makeHierarchy(graph, nodes, deep != 0);
+        vector<PointerNode*> pointerNodes, roots;
+        makePointerTree(graph, pointerNodes, roots);
+        vector<unsigned int> changed;
+        unsigned int seed = 11u;
+        unsigned long long updated = 0;
+        unsigned int mismatches = 0;
+        for (int frame = 0; frame < 10; frame++)
+        {
+            if (frame > 0)
+            {
+                pickChanged(changed, nodes, 1, seed);
+                applyChanges(graph, pointerNodes, changed, frame);
+            }
+            updated += graph.Update();
+            for (unsigned int i = 0; i < roots.size(); i++)
+                updatePointerTree(roots[i], NULL, false);
+            SceneGraph full = graph;
+            full.UpdateAll();
+            for (unsigned int i = 0; i < nodes; i++)
+            {
+                if (graph.World(i) != full.World(i) || graph.World(i) != pointerNodes[i]->world)
+                    mismatches++;
+            }
+        }
+        cout << (deep ? "deep" : "wide") << ": 10 frames, " << updated << " updated, " << mismatches << " mismatches"
+             << (mismatches ? "  FAILED" : "  ok") << endl;
+        if (mismatches)
+            ok = false;
+        for (size_t i = 0; i < pointerNodes.size(); i++)
+            delete pointerNodes[i];
+    }
+    return ok;
+}
+
+// 点光源的位置取自场景中灯的节点
+void setLightUniforms(const Shader &shader, const glm::vec3 *lightPositions)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", lightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
@@ -0,0 +1,156 @@
+#version 330 core
+in vec3 Normal;
+in vec3 FragPos;
+out vec4 FragColor;
+
+struct Material {
+    sampler2D diffuse;
+    //vec3 specular;
+    sampler2D specular; // 采样镜面光贴图
+    float shininess;
+};
+
+
+// 定义一个定向光源所需的变量
+struct DirLight{
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+
+// 定义一个点光源所需的变量
+struct PointLight{
+    vec3 position;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    // 实现衰减
+    float constant;
+    float linear;
+    float quadratic;
+};
+#define NR_POINT_LIGHTS 4
+// 定义了一个点光源数量
+uniform PointLight pointLights[NR_POINT_LIGHTS];
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+
+// 定义一个聚光所需的变量
+struct SpotLight {
+    vec3 position; // 聚光的位置向量
+    vec3 direction; // 聚光的方向向量
+    float cutOff; // 切光角
+    float outerCutOff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+
+uniform Material material;
+uniform vec3 viewPos;
+
+in vec2 TexCoords;
+
+void main()
+{
+    // 属性值设置
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // 定向光照
+    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    // 四个点光源
+    for(int i = 0; i < NR_POINT_LIGHTS; i++)
+    {
+        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+    }
+    // 聚光
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);
+
+    FragColor = vec4(result, 1.0);
+}
+
+// 计算定向光源
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+{
+    // 环境光
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
+
+    // 漫反射
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+
+    // 镜面反射
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+
+    vec3 result = ambient + diffuse + specular;
+    return result;
+}
+
+// 计算点光源
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    // 环境光
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
+
+    // 漫反射
+    vec3 lightDir = normalize(light.position - fragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+
+    // 镜面反射
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    //vec3 specular = light.specular * spec * texture(material.specualr, TexCoords).rgb;
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+
+
+    
+    // 计算光源衰弱值
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    vec3 result = (ambient + diffuse + specular) * attenuation;
+    return result;
+}
+
+// 计算聚光
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // 计算光源到片段与光线方向夹角 与 切光角比较 决定是否在聚光内部
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    // 现在已有一个在聚光外为负 在内圆锥内大于1.0的强度值
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    // 使用clamp函数将第一个参数约束在0.0到1.0之间
+
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+
+
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+
+    // 不对环境光产生影响让其总有一些光
+    diffuse *= intensity;
+    specular *= intensity;
+
+    vec3 result = ambient + diffuse + specular;
+    return result;
+}
@@ -0,0 +1,839 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "shader_m.h"
+#include "Camera_Class.h"
+#include "instanced_renderer.h"
+#include "frustum.h"
+#include "point_lights.h"
+#include "bvh.h"
+
+using namespace std;
+
+// 十万个箱子放进BVH 每帧只画视锥体内的箱子 用屏幕中心(或鼠标)的射线拾取箱子 找出每个点光源照到的箱子
+// 一部分箱子每帧移动 只更新它们所在的叶子到根的包围盒
+
+void processInput(GLFWwindow *window);
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset);
+unsigned int loadTexture(const char *path);
+void setLightUniforms(const Shader &shader);
+
+const unsigned int SCR_WIDTH = 1920;
+const unsigned int SCR_HEIGHT = 1080;
+const float FAR_PLANE = 1000.0f;
+
+float deltaTime = 0.0f; // 当前帧与上一帧的时间差
+float lastFrame = 0.0f; // 上一帧的时间
+
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+bool firstMouse = true;
+float lastX = SCR_WIDTH / 2, lastY = SCR_HEIGHT / 2;
+// --cursor: 显示鼠标 用鼠标的位置拾取 不再转动摄像机
+bool cursorPick = false;
+
+glm::vec3 cubePositions[] = {
+    glm::vec3( 0.0f,  0.0f,  0.0f),
+    glm::vec3( 2.0f,  5.0f, -15.0f),
+    glm::vec3(-1.5f, -2.2f, -2.5f),
+    glm::vec3(-3.8f, -2.0f, -12.3f),
+    glm::vec3( 2.4f, -0.4f, -3.5f),
+    glm::vec3(-1.7f,  3.0f, -7.5f),
+    glm::vec3( 1.3f, -2.0f, -2.5f),
+    glm::vec3( 1.5f,  2.0f, -2.5f),
+    glm::vec3( 1.5f,  0.2f, -1.5f),
+    glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+glm::vec3 pointLightPositions[] = {
+    glm::vec3( 0.7f,  0.2f,  2.0f),
+    glm::vec3( 2.3f, -3.3f, -4.0f),
+    glm::vec3(-4.0f,  2.0f, -12.0f),
+    glm::vec3( 0.0f,  0.0f, -3.0f)
+};
+
+// 箱子不旋转 包围盒就是箱子本身 拾取的结果是准确的
+// 前10个与12_1相同 之后的位置与14_1相同 每个轴的缩放在0.5到1.5之间随机
+// moving 中的箱子绕 centers 在水平面上公转
+struct Cubes {
+    vector<glm::vec3> centers;
+    vector<glm::vec3> scales;
+    vector<BvhBox> boxes;
+    vector<unsigned int> moving;
+    vector<float> orbits;   // 公转半径
+    vector<float> speeds;   // 每秒公转的弧度
+};
+
+void makeCubes(Cubes &cubes, size_t count, float movingPercent);
+void moveCubes(Cubes &cubes, float time);
+glm::vec3 cubePosition(const Cubes &cubes, unsigned int i);
+void pickRay(const glm::mat4 &projection, const glm::mat4 &view, float x, float y, glm::vec3 &origin, glm::vec3 &direction);
+void randomRays(const glm::mat4 &projection, const glm::mat4 &view, size_t count, vector<glm::vec3> &origins, vector<glm::vec3> &directions);
+void linearFrustum(const vector<BvhBox> &boxes, const Frustum &frustum, vector<unsigned int> &result);
+unsigned int linearRaycast(const vector<BvhBox> &boxes, const glm::vec3 &origin, const glm::vec3 &direction, float maxT, float &hitT);
+void linearSphere(const vector<BvhBox> &boxes, const glm::vec3 &center, float radius, vector<unsigned int> &result);
+float lightRadius();
+bool verify(size_t count, float movingPercent);
+void benchmark(float movingPercent);
+
+// 用法:
+//   ./BVH.o                 100000个箱子 1%的箱子移动 只画视锥体内的箱子 屏幕中心的射线拾取的箱子画成白色
+//   ./BVH.o --count 1000000 箱子数 前10个与12_1相同
+//   ./BVH.o --moving 10     每帧移动的箱子的百分比 默认1
+//   ./BVH.o --cursor        显示鼠标 拾取鼠标下的箱子 摄像机不再跟随鼠标转动
+//   ./BVH.o --linear        不用BVH 每帧逐个箱子测试 用于对比
+//   ./BVH.o --verify        移动箱子10帧 每帧比较BVH与逐个测试的查询结果 不同时返回1 不打开窗口
+//   ./BVH.o --bench         10000到1000000个箱子 构建 更新 三种查询的时间 不打开窗口
+int main(int argc, char *argv[])
+{
+    HeadlessInit(argc, argv);
+    size_t count = 100000;
+    float movingPercent = 1.0f;
+    bool linear = false;
+    bool verifyOnly = false;
+    bool bench = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = (size_t)max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--moving") == 0 && i + 1 < argc)
+            movingPercent = min(max((float)atof(argv[++i]), 0.0f), 100.0f);
+        else if (strcmp(argv[i], "--cursor") == 0)
+            cursorPick = true;
+        else if (strcmp(argv[i], "--linear") == 0)
+            linear = true;
+        else if (strcmp(argv[i], "--verify") == 0)
+            verifyOnly = true;
+        else if (strcmp(argv[i], "--bench") == 0)
+            bench = true;
+    }
+
+    if (bench)
+    {
+        benchmark(movingPercent);
+        return 0;
+    }
+    if (verifyOnly)
+        return verify(count, movingPercent) ? 0 : 1;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "BVH", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, cursorPick ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glEnable(GL_DEPTH_TEST);
+
+    glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+
+    Shader CubeShader("./shader.vs", "./shader.fs");
+    Shader LightShader("./light.vs", "./light.fs");
+
+    float vertices[] = {
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f,
+
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 1.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f, 0.0f, 0.0f,
+
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f,
+
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f,
+
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f,
+        -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f,
+        -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f
+    };
+
+    unsigned int VBO;
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    // 0: 箱子  1: 灯  2: 拾取的箱子 与灯相同只需要位置
+    unsigned int VAOs[3];
+    glGenVertexArrays(3, VAOs);
+    for (int i = 0; i < 3; i++)
+    {
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        if (i == 0)
+        {
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+            glEnableVertexAttribArray(2);
+        }
+    }
+
+    // 实例缓冲要在 glfwTerminate 之前释放 所以在堆上创建
+    InstancedRenderer *cubeInstances = new InstancedRenderer(1024);
+    InstancedRenderer *lightInstances = new InstancedRenderer(4);
+    InstancedRenderer *pickInstance = new InstancedRenderer(1);
+    cubeInstances->AttachTo(VAOs[0]);
+    lightInstances->AttachTo(VAOs[1], 3, false);
+    pickInstance->AttachTo(VAOs[2], 3, false);
+    for (int i = 0; i < 4; i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, pointLightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.2f));
+        lightInstances->Add(model);
+    }
+    lightInstances->Upload();
+
+    unsigned int diffuseMap = loadTexture("../12_1Multiple_lights/container2.png");
+    unsigned int specularMap = loadTexture("../12_1Multiple_lights/container2_specular.png");
+    CubeShader.use();
+    CubeShader.setInt("material.diffuse", 0);
+    CubeShader.setInt("material.specular", 1);
+
+    Cubes cubes;
+    makeCubes(cubes, count, movingPercent);
+    Bvh bvh;
+    auto buildStart = chrono::steady_clock::now();
+    bvh.Build(cubes.boxes);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - buildStart).count();
+    // 箱子移动后节点变大 代价超过构建时的 REBUILD_RATIO 倍就重建
+    const float REBUILD_RATIO = 1.2f;
+    float builtCost = bvh.Cost();
+    cout << "bvh: " << count << " cubes, " << bvh.NodeCount() << " nodes, built in " << buildMs << " ms, SAH cost " << builtCost << endl;
+
+    float radius = lightRadius();
+    vector<unsigned int> visible, lit;
+    unsigned int picked = BVH_NONE;
+    unsigned int rebuilds = 0;
+    double refitMs = 0.0, frustumMs = 0.0, pickMs = 0.0, lightMs = 0.0;
+    double visibleTotal = 0.0, litTotal = 0.0, frustumNodes = 0.0, pickNodes = 0.0, refitNodes = 0.0;
+    unsigned int frames = 0;
+
+    while(!glfwWindowShouldClose(window))
+    {
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+        processInput(window);
+
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        // 移动的箱子 只更新它们的叶子到根
+        auto start = chrono::steady_clock::now();
+        moveCubes(cubes, currentFrame);
+        if (!linear)
+            refitNodes += bvh.Refit(cubes.boxes, cubes.moving);
+        auto refitEnd = chrono::steady_clock::now();
+        refitMs += chrono::duration<double, milli>(refitEnd - start).count();
+
+        // 视锥体内的箱子
+        Frustum frustum(projection * view);
+        visible.clear();
+        if (linear)
+            linearFrustum(cubes.boxes, frustum, visible);
+        else
+        {
+            bvh.QueryFrustum(frustum, cubes.boxes, visible);
+            frustumNodes += bvh.VisitedNodes;
+        }
+        auto frustumEnd = chrono::steady_clock::now();
+        frustumMs += chrono::duration<double, milli>(frustumEnd - refitEnd).count();
+        visibleTotal += visible.size();
+
+        // 屏幕中心或鼠标下的箱子
+        glm::vec3 origin, direction;
+        pickRay(projection, view, cursorPick ? lastX : SCR_WIDTH / 2.0f, cursorPick ? lastY : SCR_HEIGHT / 2.0f, origin, direction);
+        float hitT;
+        unsigned int hit;
+        if (linear)
+            hit = linearRaycast(cubes.boxes, origin, direction, FAR_PLANE, hitT);
+        else
+        {
+            hit = bvh.Raycast(origin, direction, cubes.boxes, FAR_PLANE, hitT);
+            pickNodes += bvh.VisitedNodes;
+        }
+        if (hit != picked)
+        {
+            if (hit == BVH_NONE)
+                cout << "picked: none" << endl;
+            else
+                cout << "picked: cube " << hit << " at distance " << hitT << endl;
+            picked = hit;
+        }
+        auto pickEnd = chrono::steady_clock::now();
+        pickMs += chrono::duration<double, milli>(pickEnd - frustumEnd).count();
+
+        // 每个点光源照到的箱子 超出半径的光照在8位的颜色中看不出来
+        for (int i = 0; i < 4; i++)
+        {
+            lit.clear();
+            if (linear)
+                linearSphere(cubes.boxes, pointLightPositions[i], radius, lit);
+            else
+                bvh.QuerySphere(pointLightPositions[i], radius, cubes.boxes, lit);
+            litTotal += lit.size();
+        }
+        lightMs += chrono::duration<double, milli>(chrono::steady_clock::now() - pickEnd).count();
+        frames++;
+
+        // 每60帧检查一次 节点太大就重建
+        if (!linear && frames % 60 == 0 && bvh.Cost() > builtCost * REBUILD_RATIO)
+        {
+            bvh.Build(cubes.boxes);
+            builtCost = bvh.Cost();
+            rebuilds++;
+        }
+
+        // 只写可见的箱子 缩放矩阵的法线矩阵是缩放的倒数
+        InstanceData *instances = cubeInstances->Map((unsigned int)visible.size());
+        for (size_t v = 0; v < visible.size(); v++)
+        {
+            unsigned int i = visible[v];
+            glm::vec3 position = cubePosition(cubes, i);
+            glm::vec3 scale = cubes.scales[i];
+            instances[v].model = glm::scale(glm::translate(glm::mat4(1.0f), position), scale);
+            instances[v].normalMatrix = glm::mat3(glm::scale(glm::mat4(1.0f), 1.0f / scale));
+        }
+        cubeInstances->Unmap();
+
+        CubeShader.use();
+        setLightUniforms(CubeShader);
+        CubeShader.setMat4("projection", projection);
+        CubeShader.setMat4("view", view);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, diffuseMap);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, specularMap);
+        cubeInstances->Draw(VAOs[0], GL_TRIANGLES, 0, 36);
+
+        LightShader.use();
+        LightShader.setMat4("projection", projection);
+        LightShader.setMat4("view", view);
+        lightInstances->Draw(VAOs[1], GL_TRIANGLES, 0, 36);
+
+        // 拾取的箱子用灯的着色器画成白色 稍微放大盖住原来的箱子
+        if (picked != BVH_NONE)
+        {
+            pickInstance->Clear();
+            pickInstance->Add(glm::scale(glm::translate(glm::mat4(1.0f), cubePosition(cubes, picked)), cubes.scales[picked] * 1.02f));
+            pickInstance->Upload();
+            pickInstance->Draw(VAOs[2], GL_TRIANGLES, 0, 36);
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    if (frames)
+    {
+        cout << (linear ? "linear" : "bvh") << ": " << count << " cubes, " << cubes.moving.size() << " moving, " << frames << " frames" << endl;
+        cout << "  move+refit " << refitMs / frames << " ms";
+        if (!linear)
+            cout << " (" << refitNodes / frames << " nodes), " << rebuilds << " rebuilds";
+        cout << endl;
+        cout << "  frustum    " << frustumMs / frames << " ms, " << visibleTotal / frames << " visible";
+        if (!linear)
+            cout << " (" << frustumNodes / frames << " nodes)";
+        cout << endl;
+        cout << "  pick       " << pickMs / frames << " ms";
+        if (!linear)
+            cout << " (" << pickNodes / frames << " nodes)";
+        cout << endl;
+        cout << "  4 lights   " << lightMs / frames << " ms, radius " << radius << ", " << litTotal / frames / 4 << " cubes per light" << endl;
+    }
+    delete cubeInstances;
+    delete lightInstances;
+    delete pickInstance;
+    glDeleteVertexArrays(3, VAOs);
+    glDeleteBuffers(1, &VBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+void makeCubes(Cubes &cubes, size_t count, float movingPercent)
+{
+    cubes.centers.resize(count);
+    cubes.scales.resize(count);
+    cubes.boxes.resize(count);
+    cubes.moving.clear();
+    cubes.orbits.clear();
+    cubes.speeds.clear();
+    float halfSize = 2.0f * cbrtf((float)count);
+    unsigned int seed = 12345u;
+    // 均匀地挑出移动的箱子 前10个不动
+    double step = movingPercent > 0.0f ? 100.0 / movingPercent : 0.0;
+    double next = 10.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 position, scale(1.0f);
+        if (i < 10)
+            position = cubePositions[i];
+        else
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                position[c] = ((seed >> 8) / 16777216.0f * 2.0f - 1.0f) * halfSize;
+            }
+            position.z -= halfSize;
+            for (int c = 0; c < 3; c++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                scale[c] = 0.5f + (seed >> 8) / 16777216.0f;
+            }
+        }
+        cubes.centers[i] = position;
+        cubes.scales[i] = scale;
+        cubes.boxes[i].minimum = position - scale * 0.5f;
+        cubes.boxes[i].maximum = position + scale * 0.5f;
+        if (step > 0.0 && i >= next)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            cubes.moving.push_back((unsigned int)i);
+            cubes.orbits.push_back(1.0f + (seed >> 8) / 16777216.0f * 2.0f);
+            cubes.speeds.push_back(glm::radians(20.0f * (i % 10) + 10.0f));
+            next += step;
+        }
+    }
+    moveCubes(cubes, 0.0f);
+}
+
+glm::vec3 cubePosition(const Cubes &cubes, unsigned int i)
+{
+    return (cubes.boxes[i].minimum + cubes.boxes[i].maximum) * 0.5f;
+}
+
+// 移动的箱子在 time 时的包围盒
+void moveCubes(Cubes &cubes, float time)
+{
+    for (size_t m = 0; m < cubes.moving.size(); m++)
+    {
+        unsigned int i = cubes.moving[m];
+        float angle = time * cubes.speeds[m];
+        glm::vec3 position = cubes.centers[i] + cubes.orbits[m] * glm::vec3(cos(angle), 0.0f, sin(angle));
+        cubes.boxes[i].minimum = position - cubes.scales[i] * 0.5f;
+        cubes.boxes[i].maximum = position + cubes.scales[i] * 0.5f;
+    }
+}
+
+// 屏幕上 (x, y) 处的射线: 近平面和远平面上的两点变换回世界空间
+void pickRay(const glm::mat4 &projection, const glm::mat4 &view, float x, float y, glm::vec3 &origin, glm::vec3 &direction)
+{
+    glm::mat4 inverse = glm::inverse(projection * view);
+    float ndcX = 2.0f * x / SCR_WIDTH - 1.0f;
+    float ndcY = 1.0f - 2.0f * y / SCR_HEIGHT; // 鼠标的y从上到下增大
+    glm::vec4 nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
+void linearFrustum(const vector<BvhBox> &boxes, const Frustum &frustum, vector<unsigned int> &result)
+{
+    for (unsigned int i = 0; i < (unsigned int)boxes.size(); i++)
+        if (frustum.IntersectsBox(boxes[i].minimum, boxes[i].maximum))
+            result.push_back(i);
+}
+
+unsigned int linearRaycast(const vector<BvhBox> &boxes, const glm::vec3 &origin, const glm::vec3 &direction, float maxT, float &hitT)
+{
+    glm::vec3 inverse = 1.0f / direction;
+    unsigned int hit = BVH_NONE;
+    hitT = maxT;
+    float t;
+    for (unsigned int i = 0; i < (unsigned int)boxes.size(); i++)
+    {
+        if (Bvh::RayBox(origin, inverse, boxes[i].minimum, boxes[i].maximum, hitT, t))
+        {
+            hitT = t;
+            hit = i;
+        }
+    }
+    return hit;
+}
+
+void linearSphere(const vector<BvhBox> &boxes, const glm::vec3 &center, float radius, vector<unsigned int> &result)
+{
+    float radius2 = radius * radius;
+    for (unsigned int i = 0; i < (unsigned int)boxes.size(); i++)
+        if (Bvh::BoxDistance2(center, boxes[i].minimum, boxes[i].maximum) <= radius2)
+            result.push_back(i);
+}
+
+// 12_1点光源的衰减 (1, 0.09, 0.032) 和漫反射 0.8 光照小于1/256的距离
+float lightRadius()
+{
+    return PointLightRadius(glm::vec3(0.8f), 1.0f, 0.09f, 0.032f);
+}
+
+// 从摄像机的位置向屏幕上随机的点发出的射线
+void randomRays(const glm::mat4 &projection, const glm::mat4 &view, size_t count, vector<glm::vec3> &origins, vector<glm::vec3> &directions)
+{
+    unsigned int seed = 777u;
+    origins.resize(count);
+    directions.resize(count);
+    for (size_t r = 0; r < count; r++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float x = (seed >> 8) / 16777216.0f * SCR_WIDTH;
+        seed = seed * 1664525u + 1013904223u;
+        float y = (seed >> 8) / 16777216.0f * SCR_HEIGHT;
+        pickRay(projection, view, x, y, origins[r], directions[r]);
+    }
+}
+
+// 移动箱子10帧 每帧比较:
+//   只更新移动的箱子与全部更新得到的节点包围盒
+//   不同方向的视锥体 随机的射线 4个点光源的球 查询的结果与逐个测试相同
+bool verify(size_t count, float movingPercent)
+{
+    Cubes cubes;
+    makeCubes(cubes, count, movingPercent);
+    Bvh bvh;
+    bvh.Build(cubes.boxes);
+    float radius = lightRadius();
+    glm::mat4 projection = glm::perspective(glm::radians(ZOOM), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+    unsigned int refitMismatches = 0, frustumMismatches = 0, rayMismatches = 0, sphereMismatches = 0;
+    size_t visibleTotal = 0, hitTotal = 0, litTotal = 0;
+    vector<unsigned int> expected, found;
+    vector<glm::vec3> origins, directions;
+    for (int frame = 0; frame < 10; frame++)
+    {
+        moveCubes(cubes, 0.1f + 0.37f * frame);
+        bvh.Refit(cubes.boxes, cubes.moving);
+        Bvh full = bvh;
+        full.Refit(cubes.boxes);
+        for (unsigned int n = 0; n < bvh.NodeCount(); n++)
+            if (bvh.Node(n).minimum != full.Node(n).minimum || bvh.Node(n).maximum != full.Node(n).maximum)
+                refitMismatches++;
+
+        // 每帧转36度
+        Camera viewer(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f), YAW + 36.0f * frame, 10.0f * (frame % 3) - 10.0f);
+        glm::mat4 view = viewer.GetViewMatrix();
+        Frustum frustum(projection * view);
+        expected.clear();
+        found.clear();
+        linearFrustum(cubes.boxes, frustum, expected);
+        bvh.QueryFrustum(frustum, cubes.boxes, found);
+        sort(found.begin(), found.end());
+        if (found != expected)
+            frustumMismatches++;
+        visibleTotal += expected.size();
+
+        // 两个箱子的交点相同时 可能拾取到其中任意一个
+        randomRays(projection, view, 100, origins, directions);
+        for (size_t r = 0; r < origins.size(); r++)
+        {
+            float expectedT, foundT;
+            unsigned int expectedHit = linearRaycast(cubes.boxes, origins[r], directions[r], FAR_PLANE, expectedT);
+            unsigned int foundHit = bvh.Raycast(origins[r], directions[r], cubes.boxes, FAR_PLANE, foundT);
+            if ((expectedHit == BVH_NONE) != (foundHit == BVH_NONE) || (expectedHit != foundHit && expectedT != foundT))
+                rayMismatches++;
+            if (expectedHit != BVH_NONE)
+                hitTotal++;
+        }
+
+        for (int i = 0; i < 4; i++)
+        {
+            expected.clear();
+            found.clear();
+            linearSphere(cubes.boxes, pointLightPositions[i], radius, expected);
+            bvh.QuerySphere(pointLightPositions[i], radius, cubes.boxes, found);
+            sort(found.begin(), found.end());
+            if (found != expected)
+                sphereMismatches++;
+            litTotal += expected.size();
+        }
+    }
+    cout << count << " cubes, " << cubes.moving.size() << " moving, " << bvh.NodeCount() << " nodes, 10 frames" << endl;
+    cout << "refit:   " << refitMismatches << " nodes differ from full refit" << (refitMismatches ? "  FAILED" : "  ok") << endl;
+    cout << "frustum: " << visibleTotal << " visible, " << frustumMismatches << " mismatches" << (frustumMismatches ? "  FAILED" : "  ok") << endl;
+    cout << "ray:     " << hitTotal << " of 1000 hit, " << rayMismatches << " mismatches" << (rayMismatches ? "  FAILED" : "  ok") << endl;
+    cout << "sphere:  " << litTotal << " lit, " << sphereMismatches << " mismatches" << (sphereMismatches ? "  FAILED" : "  ok") << endl;
+    return refitMismatches + frustumMismatches + rayMismatches + sphereMismatches == 0;
+}
+
+// 一次操作的时间 第一次把数据读进缓存 不计入 之后 benchRuns 次取平均
+template <typename Function>
+double timeMs(Function function)
+{
+    const int benchRuns = 5;
+    double total = 0.0;
+    for (int r = 0; r <= benchRuns; r++)
+    {
+        auto start = chrono::steady_clock::now();
+        function(r);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (r > 0)
+            total += ms;
+    }
+    return total / benchRuns;
+}
+
+void printRow(size_t count, const char *operation, double bvhMs, double linearMs, double result)
+{
+    cout.setf(ios::left);
+    cout.width(10);
+    cout << count;
+    cout.width(14);
+    cout << operation;
+    cout.width(11);
+    cout << bvhMs;
+    cout.width(11);
+    if (linearMs > 0.0)
+        cout << linearMs;
+    else
+        cout << "-";
+    cout.width(10);
+    if (linearMs > 0.0)
+        cout << linearMs / bvhMs;
+    else
+        cout << "-";
+    cout << result << endl;
+}
+
+// 10000到1000000个箱子:
+//   build       构建
+//   refit all   所有节点重新合并包围盒
+//   refit moved 只更新移动的箱子的叶子到根 result 为更新的节点数
+//   frustum     摄像机在 (0, 0, 3) 看向 -z 的视锥体 result 为可见的箱子数
+//   ray         屏幕上随机的点 每条射线的时间(毫秒) result 为碰到的比例
+//   sphere      4个点光源照到的箱子 每个光源的时间 result 为每个光源照到的箱子数
+// 最后比较箱子移动10秒后 只更新包围盒与重建的SAH代价
+void benchmark(float movingPercent)
+{
+    size_t counts[] = { 10000, 100000, 1000000 };
+    const size_t RAYS = 1000;
+    const size_t LINEAR_RAYS = 20;
+    float radius = lightRadius();
+    glm::mat4 projection = glm::perspective(glm::radians(ZOOM), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, FAR_PLANE);
+    glm::mat4 view = camera.GetViewMatrix();
+    Frustum frustum(projection * view);
+    vector<glm::vec3> origins, directions;
+    randomRays(projection, view, RAYS, origins, directions);
+    cout << movingPercent << "% moving, light radius " << radius << endl;
+    cout << "cubes     operation     bvh ms     linear ms  speedup   result" << endl;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        size_t count = counts[c];
+        Cubes cubes;
+        makeCubes(cubes, count, movingPercent);
+        Bvh bvh;
+        double buildMs = timeMs([&](int) { bvh.Build(cubes.boxes); });
+        printRow(count, "build", buildMs, 0.0, bvh.NodeCount());
+        printRow(count, "refit all", timeMs([&](int) { bvh.Refit(cubes.boxes); }), 0.0, bvh.NodeCount());
+        unsigned int updated = 0;
+        double refitMs = timeMs([&](int r) {
+            moveCubes(cubes, 0.1f * r);
+            updated = bvh.Refit(cubes.boxes, cubes.moving);
+        });
+        printRow(count, "refit moved", refitMs, 0.0, updated);
+
+        vector<unsigned int> result;
+        double frustumMs = timeMs([&](int) { result.clear(); bvh.QueryFrustum(frustum, cubes.boxes, result); });
+        double frustumLinearMs = timeMs([&](int) { result.clear(); linearFrustum(cubes.boxes, frustum, result); });
+        printRow(count, "frustum", frustumMs, frustumLinearMs, result.size());
+
+        unsigned int hits = 0;
+        float t;
+        double rayMs = timeMs([&](int) {
+            hits = 0;
+            for (size_t r = 0; r < RAYS; r++)
+                hits += bvh.Raycast(origins[r], directions[r], cubes.boxes, FAR_PLANE, t) != BVH_NONE;
+        }) / RAYS;
+        double rayLinearMs = timeMs([&](int) {
+            for (size_t r = 0; r < LINEAR_RAYS; r++)
+                linearRaycast(cubes.boxes, origins[r], directions[r], FAR_PLANE, t);
+        }) / LINEAR_RAYS;
+        printRow(count, "ray", rayMs, rayLinearMs, (double)hits / RAYS);
+
+        double sphereMs = timeMs([&](int) {
+            result.clear();
+            for (int i = 0; i < 4; i++)
+                bvh.QuerySphere(pointLightPositions[i], radius, cubes.boxes, result);
+        }) / 4;
+        double sphereLinearMs = timeMs([&](int) {
+            result.clear();
+            for (int i = 0; i < 4; i++)
+                linearSphere(cubes.boxes, pointLightPositions[i], radius, result);
+        }) / 4;
+        printRow(count, "sphere", sphereMs, sphereLinearMs, result.size() / 4.0);
+
+        // 移动10秒: 结构不变 只更新包围盒的代价与重新构建的代价
+        bvh.Build(cubes.boxes);
+        float builtCost = bvh.Cost();
+        for (int frame = 1; frame <= 600; frame++)
+        {
+            moveCubes(cubes, frame / 60.0f);
+            bvh.Refit(cubes.boxes, cubes.moving);
+        }
+        float refitCost = bvh.Cost();
+        bvh.Build(cubes.boxes);
+        float rebuiltCost = bvh.Cost();
+        cout << count << " SAH cost: built " << builtCost << ", refit after 10 s " << refitCost << ", rebuilt " << rebuiltCost
+             << " (" << refitCost / rebuiltCost << "x)" << endl;
+    }
+}
+
+void setLightUniforms(const Shader &shader)
+{
+    shader.setVec3("viewPos", camera.Position);
+    shader.setFloat("material.shininess", 32.0f);
+    // 定向光源
+    shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
+    shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
+    shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
+    shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
+    // 点光源
+    for (int i = 0; i < 4; i++)
+    {
+        string name = "pointLights[" + to_string(i) + "]";
+        shader.setVec3(name + ".position", pointLightPositions[i]);
+        shader.setVec3(name + ".ambient", 0.05f, 0.05f, 0.05f);
+        shader.setVec3(name + ".diffuse", 0.8f, 0.8f, 0.8f);
+        shader.setVec3(name + ".specular", 1.0f, 1.0f, 1.0f);
+        shader.setFloat(name + ".constant", 1.0f);
+        shader.setFloat(name + ".linear", 0.09f);
+        shader.setFloat(name + ".quadratic", 0.032f);
+    }
+    // 聚光
+    shader.setVec3("spotLight.position", camera.Position);
+    shader.setVec3("spotLight.direction", camera.Front);
+    shader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+    shader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+    shader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
+    shader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
+}
+
+unsigned int loadTexture(const char *path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrChannels;
+    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, 0);
+    if (data)
+    {
+        GLenum format = nrChannels == 4 ? GL_RGBA : (nrChannels == 1 ? GL_RED : GL_RGB);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+    stbi_image_free(data);
+    return textureID;
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+void processInput(GLFWwindow *window)
+{
+    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+}
+
+void mouse_callback(GLFWwindow* window, double xpos, double ypos)
+{
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // 鼠标的坐标系统中 y是从上到下增大
+    lastX = xpos;
+    lastY = ypos;
+
+    // 拾取鼠标下的箱子时 摄像机不跟随鼠标转动
+    if (!cursorPick)
+        camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+void scroll_callback(GLFWwindow* windo, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(yoffset);
+}
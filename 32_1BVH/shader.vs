@@ -0,0 +1,25 @@
+// 实例化绘制箱子
+// 模型矩阵和法线矩阵不再是uniform 而是每个实例一份的顶点属性
+// mat4 占用 location 3~6  mat3 占用 location 7~9
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in mat3 aNormalMatrix;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+    // 法线矩阵已在CPU上每个实例计算一次
+    Normal = aNormalMatrix * aNormal;
+    TexCoords = aTexCoords;
+}
@@ -6,6 +6,7 @@
 #include "../../../stb_image.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 
 #include "../../../shader_s.h"
@@ -18,8 +19,9 @@ const unsigned int SCR_HEIGHT = 600;
 
 float mixvalue = 0.2f;
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -8,6 +8,7 @@
 #include "stb_image.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -36,8 +37,9 @@ float pitch = 0.0f, yaw = -90.0f;
 bool firstMouse = true;
 float lastX = 400.0f, lastY = 300.0f;
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
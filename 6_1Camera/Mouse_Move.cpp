@@ -17,6 +17,7 @@
 #include "stb_image.h"
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "headless.h"
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -74,8 +75,9 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 float lastX = 400.0f, lastY = 300.0f;
 // 然后在鼠标的回调函数中计算当前帧与上一帧鼠标位置的偏移量
 
-int main()
+int main(int argc, char *argv[])
 {
+    HeadlessInit(argc, argv);
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -0,0 +1,514 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+
+#include "frustum.h"
+
+// 物体包围盒的层次包围体(BVH)
+//
+// 视锥体剔除 拾取 找光源照到的物体 都是对场景中的每个物体测试一次
+// BVH 把物体分成两半 每半再分成两半 每个节点存下面所有物体的包围盒 查询时整个节点在外面就跳过下面所有物体
+//
+// 构建: 表面积启发(SAH) 分桶
+//   按包围盒中心在三个轴上各分 BVH_BINS 个桶 每个桶之间是一个候选的分割位置
+//   代价 = 1 + (左边的物体数 * 左边的表面积 + 右边的物体数 * 右边的表面积) / 节点的表面积
+//   射线穿过一个盒子的概率与表面积成正比 代价是一次查询要测试的物体数的估计 不分割的代价是节点的物体数
+//   取代价最小的分割 比不分割还差且物体不多于 BVH_MAX_LEAF 时作为叶子
+// 节点放在一个数组中 两个子节点相邻 子节点总在父节点之后
+// 构建时物体按节点原地划分 每个节点(不只是叶子)下面的物体在 objects 中都是连续的一段
+// 查询时节点完全在视锥体或球内 直接复制这一段 不再往下测试
+// 构建在包围盒的副本上划分 顺序访问内存 不经过物体编号跳着读 boxes
+//
+// 物体移动后不必重建:
+//   Refit() 从数组末尾向前 每个节点重新合并子节点的包围盒
+//   Refit(boxes, moved) 只从移动的物体所在的叶子向上 包围盒不变时停止
+// 树的结构不变 物体移动得多了节点会变大 查询变慢 Cost() 与重建后的比较 差太多时重建
+
+const unsigned int BVH_NONE = 0xffffffffu;
+const unsigned int BVH_BINS = 16;
+// 物体不多于这个数时 分割比不分割还差就作为叶子
+const unsigned int BVH_MAX_LEAF = 8;
+
+struct BvhBox {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+};
+
+struct BvhNode {
+    glm::vec3 minimum;
+    unsigned int start;   // 叶子: 第一个物体在 objects 中的位置  内部节点: 左子节点 右子节点是 start + 1
+    glm::vec3 maximum;
+    unsigned int count;   // 叶子的物体数 内部节点为0
+};
+
+class Bvh
+{
+public:
+    // 查询访问的节点数 用于比较树的质量
+    unsigned int VisitedNodes;
+
+    Bvh() : VisitedNodes(0)
+    {
+    }
+
+    unsigned int NodeCount() const { return (unsigned int)nodes.size(); }
+    const BvhNode &Node(unsigned int i) const { return nodes[i]; }
+
+    // 物体的编号是它在 boxes 中的下标 之后的 Refit 和查询要传入同一个数组
+    void Build(const std::vector<BvhBox> &boxes)
+    {
+        unsigned int count = (unsigned int)boxes.size();
+        std::vector<BuildItem> items(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            items[i].box = boxes[i];
+            items[i].center = (boxes[i].minimum + boxes[i].maximum) * 0.5f;
+            items[i].object = i;
+        }
+        objects.resize(count);
+        objectLeaf.assign(count, BVH_NONE);
+        nodes.clear();
+        parents.clear();
+        subtrees.clear();
+        nodes.reserve(count > 0 ? 2 * count : 1);
+        parents.reserve(nodes.capacity());
+        subtrees.reserve(nodes.capacity());
+        BvhNode root;
+        root.minimum = root.maximum = glm::vec3(0.0f);
+        root.start = 0;
+        root.count = count;
+        nodes.push_back(root);
+        parents.push_back(BVH_NONE);
+        subtrees.push_back(BvhRange(0, count));
+        traversal.resize(2);
+        if (count == 0)
+            return;
+
+        // 待分割的节点和它的深度 不递归
+        std::vector<std::pair<unsigned int, unsigned int> > stack(1, std::make_pair(0u, 1u));
+        unsigned int depth = 1;
+        while (!stack.empty())
+        {
+            unsigned int index = stack.back().first;
+            unsigned int level = stack.back().second;
+            stack.pop_back();
+            depth = std::max(depth, level);
+            unsigned int left = Split(index, items);
+            if (left == BVH_NONE)
+            {
+                for (unsigned int i = 0; i < nodes[index].count; i++)
+                    objectLeaf[items[nodes[index].start + i].object] = index;
+                continue;
+            }
+            stack.push_back(std::make_pair(left + 1, level + 1));
+            stack.push_back(std::make_pair(left, level + 1));
+        }
+        for (unsigned int i = 0; i < count; i++)
+            objects[i] = items[i].object;
+        // 遍历时每层最多留下一个兄弟节点在栈中
+        traversal.resize(depth + 1);
+    }
+
+    // 物体都可能移动了 重新计算所有节点的包围盒
+    void Refit(const std::vector<BvhBox> &boxes)
+    {
+        for (unsigned int i = (unsigned int)nodes.size(); i-- > 0; )
+            RefitNode(i, boxes);
+    }
+
+    // 只有 moved 中的物体移动了 从它们的叶子向上更新 返回更新的节点数
+    unsigned int Refit(const std::vector<BvhBox> &boxes, const std::vector<unsigned int> &moved)
+    {
+        unsigned int updated = 0;
+        for (size_t m = 0; m < moved.size(); m++)
+        {
+            unsigned int index = objectLeaf[moved[m]];
+            while (index != BVH_NONE)
+            {
+                glm::vec3 oldMinimum = nodes[index].minimum, oldMaximum = nodes[index].maximum;
+                RefitNode(index, boxes);
+                updated++;
+                // 包围盒没有变 上面的节点也不会变
+                if (nodes[index].minimum == oldMinimum && nodes[index].maximum == oldMaximum)
+                    break;
+                index = parents[index];
+            }
+        }
+        return updated;
+    }
+
+    // SAH代价: 每个节点的表面积 * (内部节点1 叶子为物体数) / 根节点的表面积
+    float Cost() const
+    {
+        float rootArea = Area(nodes[0].minimum, nodes[0].maximum);
+        if (rootArea <= 0.0f)
+            return 0.0f;
+        float cost = 0.0f;
+        for (size_t i = 0; i < nodes.size(); i++)
+            cost += Area(nodes[i].minimum, nodes[i].maximum) * (nodes[i].count ? (float)nodes[i].count : 1.0f);
+        return cost / rootArea;
+    }
+
+    // 与视锥体相交的物体追加到 result
+    void QueryFrustum(const Frustum &frustum, const std::vector<BvhBox> &boxes, std::vector<unsigned int> &result)
+    {
+        VisitedNodes = 0;
+        if (objects.empty())
+            return;
+        unsigned int *stack = traversal.data();
+        unsigned int size = 0;
+        stack[size++] = 0;
+        while (size)
+        {
+            unsigned int index = stack[--size];
+            const BvhNode &node = nodes[index];
+            VisitedNodes++;
+            if (!frustum.IntersectsBox(node.minimum, node.maximum))
+                continue;
+            if (frustum.ContainsBox(node.minimum, node.maximum))
+            {
+                AppendSubtree(index, result);
+                continue;
+            }
+            if (node.count)
+            {
+                for (unsigned int i = 0; i < node.count; i++)
+                {
+                    unsigned int object = objects[node.start + i];
+                    if (frustum.IntersectsBox(boxes[object].minimum, boxes[object].maximum))
+                        result.push_back(object);
+                }
+                continue;
+            }
+            stack[size++] = node.start;
+            stack[size++] = node.start + 1;
+        }
+    }
+
+    // 射线 origin + t * direction (0 <= t <= maxT) 最先碰到的物体包围盒 没有时返回 BVH_NONE
+    // 先进入较近的子节点 已找到的交点比节点还近时跳过节点
+    unsigned int Raycast(const glm::vec3 &origin, const glm::vec3 &direction, const std::vector<BvhBox> &boxes,
+                         float maxT, float &hitT)
+    {
+        VisitedNodes = 0;
+        unsigned int hit = BVH_NONE;
+        hitT = maxT;
+        if (objects.empty())
+            return hit;
+        // 方向的分量为0时得到无穷大 比较的结果仍然正确
+        glm::vec3 inverse = 1.0f / direction;
+        unsigned int *stack = traversal.data();
+        unsigned int size = 0;
+        float t;
+        if (!RayBox(origin, inverse, nodes[0].minimum, nodes[0].maximum, hitT, t))
+            return hit;
+        stack[size++] = 0;
+        while (size)
+        {
+            const BvhNode &node = nodes[stack[--size]];
+            VisitedNodes++;
+            // 入栈后找到了更近的交点
+            if (!RayBox(origin, inverse, node.minimum, node.maximum, hitT, t))
+                continue;
+            if (node.count)
+            {
+                for (unsigned int i = 0; i < node.count; i++)
+                {
+                    unsigned int object = objects[node.start + i];
+                    if (RayBox(origin, inverse, boxes[object].minimum, boxes[object].maximum, hitT, t))
+                    {
+                        hitT = t;
+                        hit = object;
+                    }
+                }
+                continue;
+            }
+            float tLeft, tRight;
+            const BvhNode &left = nodes[node.start];
+            const BvhNode &right = nodes[node.start + 1];
+            bool hitLeft = RayBox(origin, inverse, left.minimum, left.maximum, hitT, tLeft);
+            bool hitRight = RayBox(origin, inverse, right.minimum, right.maximum, hitT, tRight);
+            // 较近的最后入栈 先出栈
+            if (hitLeft && hitRight)
+            {
+                bool leftFirst = tLeft <= tRight;
+                stack[size++] = leftFirst ? node.start + 1 : node.start;
+                stack[size++] = leftFirst ? node.start : node.start + 1;
+            }
+            else if (hitLeft)
+                stack[size++] = node.start;
+            else if (hitRight)
+                stack[size++] = node.start + 1;
+        }
+        return hit;
+    }
+
+    // 包围盒与球相交的物体追加到 result
+    void QuerySphere(const glm::vec3 &center, float radius, const std::vector<BvhBox> &boxes, std::vector<unsigned int> &result)
+    {
+        VisitedNodes = 0;
+        if (objects.empty())
+            return;
+        float radius2 = radius * radius;
+        unsigned int *stack = traversal.data();
+        unsigned int size = 0;
+        stack[size++] = 0;
+        while (size)
+        {
+            unsigned int index = stack[--size];
+            const BvhNode &node = nodes[index];
+            VisitedNodes++;
+            if (BoxDistance2(center, node.minimum, node.maximum) > radius2)
+                continue;
+            if (BoxFarDistance2(center, node.minimum, node.maximum) <= radius2)
+            {
+                AppendSubtree(index, result);
+                continue;
+            }
+            if (node.count)
+            {
+                for (unsigned int i = 0; i < node.count; i++)
+                {
+                    unsigned int object = objects[node.start + i];
+                    if (BoxDistance2(center, boxes[object].minimum, boxes[object].maximum) <= radius2)
+                        result.push_back(object);
+                }
+                continue;
+            }
+            stack[size++] = node.start;
+            stack[size++] = node.start + 1;
+        }
+    }
+
+    // 线性扫描的射线与包围盒测试 Raycast 和对比用的线性扫描共用
+    static bool RayBox(const glm::vec3 &origin, const glm::vec3 &inverse, const glm::vec3 &minimum, const glm::vec3 &maximum,
+                       float maxT, float &t)
+    {
+        glm::vec3 t0 = (minimum - origin) * inverse;
+        glm::vec3 t1 = (maximum - origin) * inverse;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+        t = enter;
+        return enter <= exit;
+    }
+
+    // 点到包围盒的距离的平方 在盒内时为0
+    static float BoxDistance2(const glm::vec3 &point, const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        glm::vec3 d = glm::max(glm::max(minimum - point, point - maximum), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    // 点到包围盒最远的角的距离的平方 不大于半径的平方时整个盒子在球内
+    static float BoxFarDistance2(const glm::vec3 &point, const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        glm::vec3 d = glm::max(point - minimum, maximum - point);
+        return glm::dot(d, d);
+    }
+
+private:
+    // 构建时的包围盒副本 与物体编号一起划分
+    struct BuildItem {
+        BvhBox box;
+        glm::vec3 center;
+        unsigned int object;
+    };
+
+    // 节点下面的物体在 objects 中的位置
+    struct BvhRange {
+        unsigned int first;
+        unsigned int count;
+        BvhRange(unsigned int first, unsigned int count) : first(first), count(count) {}
+    };
+
+    std::vector<BvhNode> nodes;
+    std::vector<unsigned int> parents;
+    std::vector<BvhRange> subtrees;
+    std::vector<unsigned int> objects;     // 按叶子排列的物体编号
+    std::vector<unsigned int> objectLeaf;  // 每个物体所在的叶子
+    std::vector<unsigned int> traversal;   // 查询的栈 大小为树的深度 + 1
+
+    static float Area(const glm::vec3 &minimum, const glm::vec3 &maximum)
+    {
+        glm::vec3 d = glm::max(maximum - minimum, glm::vec3(0.0f));
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    void ComputeLeafBounds(unsigned int index, const std::vector<BvhBox> &boxes)
+    {
+        BvhNode &node = nodes[index];
+        node.minimum = glm::vec3(FLT_MAX);
+        node.maximum = glm::vec3(-FLT_MAX);
+        for (unsigned int i = 0; i < node.count; i++)
+        {
+            const BvhBox &box = boxes[objects[node.start + i]];
+            node.minimum = glm::min(node.minimum, box.minimum);
+            node.maximum = glm::max(node.maximum, box.maximum);
+        }
+    }
+
+    void AppendSubtree(unsigned int index, std::vector<unsigned int> &result) const
+    {
+        const BvhRange &range = subtrees[index];
+        result.insert(result.end(), objects.begin() + range.first, objects.begin() + range.first + range.count);
+    }
+
+    void RefitNode(unsigned int index, const std::vector<BvhBox> &boxes)
+    {
+        BvhNode &node = nodes[index];
+        if (node.count)
+        {
+            ComputeLeafBounds(index, boxes);
+            return;
+        }
+        const BvhNode &left = nodes[node.start];
+        const BvhNode &right = nodes[node.start + 1];
+        node.minimum = glm::min(left.minimum, right.minimum);
+        node.maximum = glm::max(left.maximum, right.maximum);
+    }
+
+    // 计算节点 index 的包围盒 再按SAH分割 返回左子节点 不分割时返回 BVH_NONE
+    unsigned int Split(unsigned int index, std::vector<BuildItem> &items)
+    {
+        unsigned int start = nodes[index].start;
+        unsigned int count = nodes[index].count;
+        BuildItem *first = &items[start];
+
+        glm::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+        glm::vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            minimum = glm::min(minimum, first[i].box.minimum);
+            maximum = glm::max(maximum, first[i].box.maximum);
+            centerMin = glm::min(centerMin, first[i].center);
+            centerMax = glm::max(centerMax, first[i].center);
+        }
+        nodes[index].minimum = minimum;
+        nodes[index].maximum = maximum;
+        if (count <= 1)
+            return BVH_NONE;
+
+        // 三个轴的桶在一次遍历中填满 物体少的节点用少一些的桶 节点很多时每个节点的固定开销不能大
+        unsigned int binCount = std::min(BVH_BINS, std::max(count, 4u));
+        struct Bin {
+            glm::vec3 minimum, maximum;
+            unsigned int count;
+        };
+        Bin bins[3][BVH_BINS];
+        glm::vec3 scale;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = centerMax[axis] - centerMin[axis];
+            scale[axis] = extent > 0.0f ? binCount / extent : 0.0f;
+            for (unsigned int b = 0; b < binCount; b++)
+            {
+                bins[axis][b].minimum = glm::vec3(FLT_MAX);
+                bins[axis][b].maximum = glm::vec3(-FLT_MAX);
+                bins[axis][b].count = 0;
+            }
+        }
+        for (unsigned int i = 0; i < count; i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                Bin &bin = bins[axis][BinIndex(first[i].center[axis], centerMin[axis], scale[axis], binCount)];
+                bin.minimum = glm::min(bin.minimum, first[i].box.minimum);
+                bin.maximum = glm::max(bin.maximum, first[i].box.maximum);
+                bin.count++;
+            }
+        }
+
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        unsigned int bestBin = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (scale[axis] == 0.0f)
+                continue;
+            // 从右向左累计 再从左向右扫描每个分割位置
+            float rightArea[BVH_BINS];
+            unsigned int rightCount[BVH_BINS];
+            glm::vec3 boundsMin(FLT_MAX), boundsMax(-FLT_MAX);
+            unsigned int n = 0;
+            for (unsigned int b = binCount - 1; b > 0; b--)
+            {
+                boundsMin = glm::min(boundsMin, bins[axis][b].minimum);
+                boundsMax = glm::max(boundsMax, bins[axis][b].maximum);
+                n += bins[axis][b].count;
+                rightArea[b] = n ? Area(boundsMin, boundsMax) : 0.0f;
+                rightCount[b] = n;
+            }
+            boundsMin = glm::vec3(FLT_MAX);
+            boundsMax = glm::vec3(-FLT_MAX);
+            n = 0;
+            for (unsigned int b = 0; b + 1 < binCount; b++)
+            {
+                boundsMin = glm::min(boundsMin, bins[axis][b].minimum);
+                boundsMax = glm::max(boundsMax, bins[axis][b].maximum);
+                n += bins[axis][b].count;
+                if (n == 0 || rightCount[b + 1] == 0)
+                    continue;
+                float cost = n * Area(boundsMin, boundsMax) + rightCount[b + 1] * rightArea[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        float area = Area(minimum, maximum);
+        unsigned int middle;
+        if (bestAxis < 0)
+        {
+            // 所有中心重合 不分割 物体太多时按个数对半分
+            if (count <= BVH_MAX_LEAF)
+                return BVH_NONE;
+            middle = start + count / 2;
+        }
+        else
+        {
+            float splitCost = 1.0f + (area > 0.0f ? bestCost / area : 0.0f);
+            if (splitCost >= (float)count && count <= BVH_MAX_LEAF)
+                return BVH_NONE;
+            float axisMin = centerMin[bestAxis], axisScale = scale[bestAxis];
+            BuildItem *split = std::partition(first, first + count, [&](const BuildItem &item) {
+                return BinIndex(item.center[bestAxis], axisMin, axisScale, binCount) <= bestBin;
+            });
+            middle = start + (unsigned int)(split - first);
+        }
+
+        unsigned int left = (unsigned int)nodes.size();
+        BvhNode child;
+        child.minimum = child.maximum = glm::vec3(0.0f);
+        child.start = start;
+        child.count = middle - start;
+        nodes.push_back(child);
+        child.start = middle;
+        child.count = start + count - middle;
+        nodes.push_back(child);
+        parents.push_back(index);
+        parents.push_back(index);
+        subtrees.push_back(BvhRange(start, middle - start));
+        subtrees.push_back(BvhRange(middle, start + count - middle));
+        nodes[index].start = left;
+        nodes[index].count = 0;
+        return left;
+    }
+
+    static unsigned int BinIndex(float center, float axisMin, float scale, unsigned int binCount)
+    {
+        return std::min((unsigned int)((center - axisMin) * scale), binCount - 1);
+    }
+};
+
+#endif
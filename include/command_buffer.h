@@ -0,0 +1,343 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "shader_m.h"
+#include "render_queue.h"
+
+// 命令缓冲
+//
+// OpenGL的上下文只属于一个线程 所有 gl* 调用都必须在这个线程上
+// 但是剔除 计算矩阵 决定绘制什么 这些工作不需要上下文
+// 工作线程把要做的事情写成与API无关的命令 每个线程写自己的命令缓冲 互不干扰
+// 最后主线程按顺序回放 转换成GL调用
+//
+// 命令只引用资源的编号(着色器 材质 VAO) 不包含GL对象名 换成别的图形API只需要另写一个回放器
+
+// 线性分配器: 只能向后分配 一次性全部释放
+// 每帧 Reset 一次 内存块保留下来 下一帧不需要再向系统申请
+class LinearAllocator
+{
+public:
+    LinearAllocator(size_t blockSize = 1 << 20) : blockSize(blockSize), current(0), offset(0), used(0)
+    {
+    }
+
+    ~LinearAllocator()
+    {
+        for (size_t i = 0; i < blocks.size(); i++)
+            delete[] blocks[i].data;
+    }
+
+    // alignment 必须是2的幂且不超过16 (new 返回的内存按16字节对齐)
+    void *Allocate(size_t size, size_t alignment = 16)
+    {
+        while (true)
+        {
+            if (current < blocks.size())
+            {
+                Block &block = blocks[current];
+                size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+                if (aligned + size <= block.size)
+                {
+                    offset = aligned + size;
+                    used += size;
+                    return block.data + aligned;
+                }
+                // 当前块放不下 换到下一块
+                current++;
+                offset = 0;
+                continue;
+            }
+            Block block;
+            block.size = size > blockSize ? size : blockSize;
+            block.data = new char[block.size];
+            blocks.push_back(block);
+        }
+    }
+
+    template <typename T>
+    T *Allocate()
+    {
+        return (T*)Allocate(sizeof(T), alignof(T) < 16 ? alignof(T) : 16);
+    }
+
+    void Reset()
+    {
+        current = 0;
+        offset = 0;
+        used = 0;
+    }
+
+    size_t Used() const
+    {
+        return used;
+    }
+
+    size_t Reserved() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < blocks.size(); i++)
+            total += blocks[i].size;
+        return total;
+    }
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t blockSize;
+    size_t current;
+    size_t offset;
+    size_t used;
+
+    LinearAllocator(const LinearAllocator&);
+    LinearAllocator &operator=(const LinearAllocator&);
+};
+
+enum Command_Type {
+    CMD_BIND_PROGRAM,
+    CMD_BIND_MATERIAL,
+    CMD_BIND_VERTEX_ARRAY,
+    CMD_SET_TRANSFORM,
+    CMD_DRAW_INDEXED,
+    CMD_DRAW_ARRAYS
+};
+
+// 每个绘制的uniform数据 写在线性分配器中
+struct TransformData {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+};
+
+// 每条命令大小固定 参数的含义取决于类型
+//   BIND_PROGRAM / BIND_MATERIAL / BIND_VERTEX_ARRAY: a 为资源编号
+//   SET_TRANSFORM: data 指向 TransformData
+//   DRAW_INDEXED: a 为索引个数 b 为第一个索引的位置
+//   DRAW_ARRAYS: a 为顶点个数 b 为第一个顶点
+struct Command {
+    uint32_t type;
+    uint32_t a;
+    uint32_t b;
+    const void *data;
+};
+
+// 一个线程写入的命令序列
+// 只在自己的范围内跳过重复的状态 每个缓冲开头的状态由回放器再过滤一次
+class CommandBuffer
+{
+public:
+    // uniform数据所在的分配器 与命令缓冲属于同一个线程
+    LinearAllocator Uniforms;
+
+    CommandBuffer() : program(~0u), material(~0u), vertexArray(~0u), draws(0)
+    {
+    }
+
+    void Reset()
+    {
+        commands.clear();
+        Uniforms.Reset();
+        program = material = vertexArray = ~0u;
+        draws = 0;
+    }
+
+    void BindProgram(unsigned int id)
+    {
+        if (id == program)
+            return;
+        program = id;
+        // 回放器换着色器时会清掉材质 这里也要清掉 否则下一次同样的材质会被跳过
+        material = ~0u;
+        Push(CMD_BIND_PROGRAM, id, 0, NULL);
+    }
+
+    void BindMaterial(unsigned int id)
+    {
+        if (id == material)
+            return;
+        material = id;
+        Push(CMD_BIND_MATERIAL, id, 0, NULL);
+    }
+
+    void BindVertexArray(unsigned int id)
+    {
+        if (id == vertexArray)
+            return;
+        vertexArray = id;
+        Push(CMD_BIND_VERTEX_ARRAY, id, 0, NULL);
+    }
+
+    // 法线矩阵在这里(工作线程上)计算 顶点着色器中不再需要 inverse
+    void SetTransform(const glm::mat4 &model)
+    {
+        TransformData *data = Uniforms.Allocate<TransformData>();
+        data->model = model;
+        data->normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        Push(CMD_SET_TRANSFORM, 0, 0, data);
+    }
+
+    void DrawIndexed(unsigned int count, unsigned int firstIndex)
+    {
+        Push(CMD_DRAW_INDEXED, count, firstIndex, NULL);
+        draws++;
+    }
+
+    void DrawArrays(unsigned int count, unsigned int firstVertex)
+    {
+        Push(CMD_DRAW_ARRAYS, count, firstVertex, NULL);
+        draws++;
+    }
+
+    const std::vector<Command> &Commands() const
+    {
+        return commands;
+    }
+
+    unsigned int Draws() const
+    {
+        return draws;
+    }
+
+private:
+    std::vector<Command> commands;
+    unsigned int program;
+    unsigned int material;
+    unsigned int vertexArray;
+    unsigned int draws;
+
+    void Push(uint32_t type, uint32_t a, uint32_t b, const void *data)
+    {
+        Command command;
+        command.type = type;
+        command.a = a;
+        command.b = b;
+        command.data = data;
+        commands.push_back(command);
+    }
+};
+
+// 把命令转换成OpenGL调用 只能在拥有上下文的线程上使用
+// 材质使用渲染队列(render_queue.h)中的 RenderMaterial
+class GLCommandReplayer
+{
+public:
+    unsigned int RegisterProgram(const Shader *shader)
+    {
+        Program program;
+        program.shader = shader;
+        program.modelLocation = glGetUniformLocation(shader->ID, "model");
+        program.normalMatrixLocation = glGetUniformLocation(shader->ID, "normalMatrix");
+        program.shininessLocation = glGetUniformLocation(shader->ID, "material.shininess");
+        programs.push_back(program);
+        return (unsigned int)programs.size() - 1;
+    }
+
+    unsigned int RegisterMaterial(const RenderMaterial &material)
+    {
+        materials.push_back(material);
+        return (unsigned int)materials.size() - 1;
+    }
+
+    unsigned int RegisterVertexArray(unsigned int VAO)
+    {
+        vertexArrays.push_back(VAO);
+        return (unsigned int)vertexArrays.size() - 1;
+    }
+
+    // 每帧回放前调用 之后的第一次绑定一定会执行
+    void Begin()
+    {
+        program = material = vertexArray = ~0u;
+        for (unsigned int i = 0; i < RENDER_QUEUE_MAX_TEXTURES; i++)
+            textures[i] = ~0u;
+    }
+
+    void Replay(const CommandBuffer &buffer)
+    {
+        const std::vector<Command> &commands = buffer.Commands();
+        for (size_t i = 0; i < commands.size(); i++)
+        {
+            const Command &command = commands[i];
+            switch (command.type)
+            {
+            case CMD_BIND_PROGRAM:
+                if (command.a != program)
+                {
+                    program = command.a;
+                    programs[program].shader->use();
+                    // 换了着色器 反光度要重新设置
+                    material = ~0u;
+                }
+                break;
+            case CMD_BIND_MATERIAL:
+                if (command.a != material)
+                {
+                    material = command.a;
+                    const RenderMaterial &m = materials[material];
+                    for (unsigned int t = 0; t < m.textureCount; t++)
+                    {
+                        if (textures[t] != m.textures[t])
+                        {
+                            glActiveTexture(GL_TEXTURE0 + t);
+                            glBindTexture(GL_TEXTURE_2D, m.textures[t]);
+                            textures[t] = m.textures[t];
+                        }
+                    }
+                    if (programs[program].shininessLocation >= 0)
+                        glUniform1f(programs[program].shininessLocation, m.shininess);
+                }
+                break;
+            case CMD_BIND_VERTEX_ARRAY:
+                if (command.a != vertexArray)
+                {
+                    vertexArray = command.a;
+                    glBindVertexArray(vertexArrays[vertexArray]);
+                }
+                break;
+            case CMD_SET_TRANSFORM:
+            {
+                const TransformData *data = (const TransformData*)command.data;
+                const Program &p = programs[program];
+                glUniformMatrix4fv(p.modelLocation, 1, GL_FALSE, &data->model[0][0]);
+                if (p.normalMatrixLocation >= 0)
+                    glUniformMatrix3fv(p.normalMatrixLocation, 1, GL_FALSE, &data->normalMatrix[0][0]);
+                break;
+            }
+            case CMD_DRAW_INDEXED:
+                glDrawElements(GL_TRIANGLES, (GLsizei)command.a, GL_UNSIGNED_INT, (void*)((size_t)command.b * sizeof(unsigned int)));
+                break;
+            case CMD_DRAW_ARRAYS:
+                glDrawArrays(GL_TRIANGLES, (GLint)command.b, (GLsizei)command.a);
+                break;
+            }
+        }
+    }
+
+private:
+    struct Program {
+        const Shader *shader;
+        int modelLocation;
+        int normalMatrixLocation;
+        int shininessLocation;
+    };
+
+    std::vector<Program> programs;
+    std::vector<RenderMaterial> materials;
+    std::vector<unsigned int> vertexArrays;
+    unsigned int program;
+    unsigned int material;
+    unsigned int vertexArray;
+    unsigned int textures[RENDER_QUEUE_MAX_TEXTURES];
+};
+
+#endif
@@ -0,0 +1,296 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include "shader_m.h"
+
+// 动态分辨率
+//
+// 场景先画到一个离屏的帧缓冲(FBO) 再放大到窗口 FBO按窗口的大小创建 每帧只用左下角 Scale 倍的区域
+// 改变分辨率只改视口和裁剪区域 不需要重新创建纹理
+// 每帧的GPU时间用 GL_TIME_ELAPSED 查询 从 BeginFrame 到交换缓冲之后的 EndFrame
+// (llvmpipe 到交换缓冲时才光栅化 只包住场景的绘制量不到时间)
+// 查询结果要过几帧才可用 与 profiler.h 一样按帧分成 LATENCY 组 不可用时不等待
+//
+// ResolutionController 根据GPU时间与目标时间的误差调整缩放 是一个PID控制器:
+//   误差 e = (GPU时间 - 目标) / 目标 为正表示太慢 限制在 ±1 以内
+//   u = Kp e + Ki 累计的e + Kd (e - 上一次的e)
+//   像素数乘以 1 - u 缩放乘以 sqrt(1 - u) GPU时间大致与像素数成正比
+// 防止来回振荡(滞回):
+//   - GPU时间先做指数平滑 软件渲染每帧的时间相差10%以上
+//   - 误差在 ±Deadband 以内不调整 累计的误差慢慢衰减
+//   - 缩放的变化小于 MinStep 不调整
+//   - 只用在当前缩放下画出的帧 调整之前提交的帧的结果到达时丢弃
+//
+// 放大用 upscale.fs 定义 SHARPEN 时在双线性之后按局部对比度锐化(类似AMD的CAS) 边缘处锐化少 不会出现振铃
+
+struct ResolutionSettings {
+    double TargetMs = 1000.0 / 60.0;
+    float MinScale = 0.5f;
+    float MaxScale = 1.0f;
+    float Kp = 0.6f;
+    float Ki = 0.1f;
+    float Kd = 0.2f;
+    float Deadband = 0.1f;
+    float MinStep = 0.02f;
+    float Smoothing = 0.3f;      // GPU时间的指数平滑 每帧向新值移动的比例 1为不平滑
+};
+
+// 每次用GPU时间做出的决定
+struct ResolutionDecision {
+    unsigned int frame;      // 测量的帧
+    double gpuMs;            // 这一帧的GPU时间
+    double filteredMs;       // 平滑后的GPU时间
+    float error;             // (filteredMs - 目标) / 目标
+    float oldScale;
+    float newScale;
+};
+
+class ResolutionController
+{
+public:
+    ResolutionSettings Settings;
+
+    ResolutionController(const ResolutionSettings &settings) : Settings(settings), scale(settings.MaxScale), integral(0.0f), lastError(0.0f), filteredMs(0.0)
+    {
+    }
+
+    // 用一帧的GPU时间更新缩放
+    ResolutionDecision Update(unsigned int frame, double gpuMs)
+    {
+        ResolutionDecision decision;
+        decision.frame = frame;
+        decision.gpuMs = gpuMs;
+        filteredMs = filteredMs > 0.0 ? filteredMs + Settings.Smoothing * (gpuMs - filteredMs) : gpuMs;
+        decision.filteredMs = filteredMs;
+        decision.error = (float)((filteredMs - Settings.TargetMs) / Settings.TargetMs);
+        decision.oldScale = scale;
+        decision.newScale = scale;
+
+        // 偶尔的卡顿(比如编译着色器)不应让缩放一下子降到最低 误差最多按 ±1 计算
+        float error = std::min(std::max(decision.error, -1.0f), 1.0f);
+        float derivative = error - lastError;
+        lastError = error;
+        if (fabsf(error) < Settings.Deadband)
+        {
+            integral *= 0.9f;
+            return decision;
+        }
+        // 在边界上时不再累计 否则离开边界要等很久(积分饱和)
+        bool saturated = (error > 0.0f && scale <= Settings.MinScale) || (error < 0.0f && scale >= Settings.MaxScale);
+        if (!saturated)
+            integral = std::min(std::max(integral + error, -2.0f), 2.0f);
+
+        float u = Settings.Kp * error + Settings.Ki * integral + Settings.Kd * derivative;
+        float area = std::min(std::max(1.0f - u, 0.5f), 1.5f);
+        float next = std::min(std::max(scale * sqrtf(area), Settings.MinScale), Settings.MaxScale);
+        if (fabsf(next - scale) < Settings.MinStep && next != Settings.MinScale && next != Settings.MaxScale)
+            return decision;
+        scale = next;
+        decision.newScale = scale;
+        // 新的分辨率重新开始平滑
+        filteredMs = 0.0;
+        return decision;
+    }
+
+    float Scale() const
+    {
+        return scale;
+    }
+
+private:
+    float scale;
+    float integral;
+    float lastError;
+    double filteredMs;
+};
+
+class DynamicResolution
+{
+public:
+    static const unsigned int LATENCY = 4;
+    // 保留的决定的个数上限
+    static const size_t MAX_DECISIONS = 1 << 20;
+
+    ResolutionController Controller;
+
+    // width height 是窗口的大小 sharpen 为真时放大后锐化
+    DynamicResolution(unsigned int width, unsigned int height, const ResolutionSettings &settings, bool sharpen,
+                      const char *vertexPath, const char *fragmentPath)
+        : Controller(settings), width(width), height(height), frame(0), scaledWidth(width), scaledHeight(height), lastGpuMs(0.0), droppedFrames(0)
+    {
+        glGenTextures(1, &colorTexture);
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenRenderbuffers(1, &depthStencil);
+        glBindRenderbuffer(GL_RENDERBUFFER, depthStencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthStencil);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::DYNAMIC_RESOLUTION::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // 覆盖整个屏幕的三角形不需要顶点数据 但核心模式下必须绑定一个VAO
+        glGenVertexArrays(1, &VAO);
+        upscale = new Shader(vertexPath, fragmentPath, sharpen ? "#define SHARPEN\n" : NULL);
+        upscale->use();
+        upscale->setInt("scene", 0);
+        upscale->setVec2("texelSize", glm::vec2(1.0f / width, 1.0f / height));
+        upscale->setVec2("outputSize", glm::vec2((float)width, (float)height));
+
+        for (unsigned int i = 0; i < LATENCY; i++)
+        {
+            glGenQueries(1, &slots[i].query);
+            slots[i].pending = false;
+        }
+    }
+
+    ~DynamicResolution()
+    {
+        for (unsigned int i = 0; i < LATENCY; i++)
+            glDeleteQueries(1, &slots[i].query);
+        glDeleteFramebuffers(1, &FBO);
+        glDeleteTextures(1, &colorTexture);
+        glDeleteRenderbuffers(1, &depthStencil);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteProgram(upscale->ID);
+        delete upscale;
+    }
+
+    // 开始计时 绑定场景的FBO 视口设为当前的分辨率
+    void BeginFrame()
+    {
+        frame++;
+        Slot &slot = slots[frame % LATENCY];
+        // 这组查询还没有结果就丢弃 不等待GPU
+        Resolve(slot);
+        if (slot.pending)
+            droppedFrames++;
+        slot.pending = false;
+
+        scaledWidth = std::max(1u, (unsigned int)lroundf(width * Controller.Scale()));
+        scaledHeight = std::max(1u, (unsigned int)lroundf(height * Controller.Scale()));
+        slot.frame = frame;
+        slot.scale = Controller.Scale();
+        glBeginQuery(GL_TIME_ELAPSED, slot.query);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, scaledWidth, scaledHeight);
+        // glClear 不受视口限制 用裁剪测试只清除用到的区域
+        glScissor(0, 0, scaledWidth, scaledHeight);
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    // 把场景放大到默认的帧缓冲 在交换缓冲之前调用
+    void Upscale()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, width, height);
+        glDisable(GL_SCISSOR_TEST);
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
+        upscale->use();
+        upscale->setVec2("uvScale", glm::vec2((float)scaledWidth / width, (float)scaledHeight / height));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, colorTexture);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+    }
+
+    // 结束计时 在交换缓冲之后调用 读取已经可用的旧帧 更新缩放
+    void EndFrame()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        slots[frame % LATENCY].pending = true;
+        // 从最旧的一帧开始
+        for (unsigned int i = 1; i <= LATENCY; i++)
+            Resolve(slots[(frame + i) % LATENCY]);
+    }
+
+    float Scale() const { return Controller.Scale(); }
+    unsigned int ScaledWidth() const { return scaledWidth; }
+    unsigned int ScaledHeight() const { return scaledHeight; }
+    // 最近一个可用的GPU时间
+    double GpuMs() const { return lastGpuMs; }
+    // 查询组被重用时结果还不可用 丢弃的帧数
+    unsigned int DroppedFrames() const { return droppedFrames; }
+    // 所有缩放的决定 按帧的顺序
+    const std::vector<ResolutionDecision> &Decisions() const { return decisions; }
+
+    bool WriteLog(const char *path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::DYNAMIC_RESOLUTION::FILE_NOT_WRITTEN " << path << std::endl;
+            return false;
+        }
+        file << "frame,gpu_ms,filtered_ms,error,old_scale,new_scale\n";
+        for (size_t i = 0; i < decisions.size(); i++)
+        {
+            const ResolutionDecision &d = decisions[i];
+            file << d.frame << "," << d.gpuMs << "," << d.filteredMs << "," << d.error << "," << d.oldScale << "," << d.newScale << "\n";
+        }
+        return true;
+    }
+
+private:
+    struct Slot {
+        GLuint query;
+        unsigned int frame;
+        float scale;
+        bool pending;
+    };
+
+    unsigned int width, height;
+    unsigned int frame;
+    unsigned int scaledWidth, scaledHeight;
+    double lastGpuMs;
+    unsigned int droppedFrames;
+    GLuint FBO, colorTexture, depthStencil, VAO;
+    Shader *upscale;
+    Slot slots[LATENCY];
+    std::vector<ResolutionDecision> decisions;
+
+    DynamicResolution(const DynamicResolution&);
+    DynamicResolution &operator=(const DynamicResolution&);
+
+    void Resolve(Slot &slot)
+    {
+        if (!slot.pending)
+            return;
+        GLuint available = 0;
+        glGetQueryObjectuiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed);
+        slot.pending = false;
+        lastGpuMs = (double)elapsed / 1e6;
+        // 第一帧包括着色器的编译 调整之前提交的帧不代表当前分辨率的时间
+        if (slot.frame == 1 || slot.scale != Controller.Scale())
+            return;
+        ResolutionDecision decision = Controller.Update(slot.frame, lastGpuMs);
+        if (decisions.size() < MAX_DECISIONS)
+            decisions.push_back(decision);
+    }
+};
+
+#endif
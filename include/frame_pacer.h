@@ -0,0 +1,273 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+// 帧率限制和帧间隔的平滑
+//
+// deltaTime 直接取 glfwGetTime() 的差 关掉垂直同步时帧间隔忽长忽短 画面跟着抖动
+// FramePacer 在每帧交换缓冲之后等到这一帧的截止时间 截止时间每帧前进一个周期 1 / TargetFps
+// 放在交换之后: 驱动可能在交换时才真正画完(llvmpipe就是这样) 等待时这一帧已经完成
+//
+// 等待分两步(hybrid):
+//   1. sleep_for 到截止时间之前 margin 毫秒 线程让出CPU
+//   2. 剩下的时间自旋 每次检查时钟 准确但占满一个核心
+// 操作系统的睡眠常常晚醒 晚多少与调度器有关 margin 取测得的晚醒时间:
+//   平均值 + 4倍平均偏差 与TCP估计重传超时的方法相同 大多数睡眠都在截止时间之前醒来
+// Mode 也可以只睡眠(晚醒的时间都算进帧间隔)或只自旋 用来比较
+//
+// 错过截止时间超过一个周期时不追赶 从现在重新开始
+// 间隔超过1.5个周期的帧算作掉帧 错过的周期数(间隔四舍五入到周期的倍数减1)计入 droppedFrames
+//
+// SmoothDelta 是给动画用的帧间隔: 先限制在4个周期以内 再做指数平滑
+// 平滑后的值与实际间隔的差累计起来 慢慢补回 动画的总时间不会偏离真实时间
+//
+// 相邻两次 Wait 返回的间隔进入直方图 每格 0.25 0.5 1 2 ... 毫秒 至少覆盖0到4个周期 不限制帧率时每格0.5毫秒
+// 不保存每一帧的间隔 运行多久内存都不变: 平均值和标准差由累计的和与平方和得到
+// p50 p99 从直方图得到 在格子内按线性插值 误差不超过一格 落在最后一格(超出范围)时取最大值
+
+enum PacingMode {
+    PACING_HYBRID,
+    PACING_SLEEP,
+    PACING_SPIN
+};
+
+struct FramePacerStats {
+    unsigned int frames;
+    unsigned int droppedFrames;   // 错过的周期数
+    double minMs, avgMs, p50Ms, p99Ms, maxMs;
+    double jitterMs;              // 帧间隔的标准差
+    double onTimePercent;         // 间隔与周期相差不到 ON_TIME_MS 的帧的比例
+    double spinMs;                // 平均每帧自旋的时间
+    double marginMs;              // 当前的睡眠余量
+};
+
+class FramePacer
+{
+public:
+    static const unsigned int HISTOGRAM_BINS = 200;
+    static constexpr double ON_TIME_MS = 0.5;
+
+    double TargetFps;     // 0 表示不限制 只统计
+    PacingMode Mode;
+    float Smoothing;      // SmoothDelta 每帧向新值移动的比例
+
+    FramePacer(double targetFps = 60.0, PacingMode mode = PACING_HYBRID)
+        : TargetFps(targetFps), Mode(mode), Smoothing(0.1f), started(false), oversleepMs(0.5), oversleepDeviationMs(0.25),
+          smoothDelta(0.0f), residual(0.0f)
+    {
+        Reset();
+    }
+
+    // 交换缓冲的间隔 0 关闭垂直同步 1 每次刷新交换一次
+    // 打开垂直同步时 TargetFps 设为0 由垂直同步决定节奏 这里只统计
+    void SetSwapInterval(int interval)
+    {
+        glfwSwapInterval(interval);
+    }
+
+    // 在交换缓冲之后调用 等到这一帧的截止时间 返回与上次返回的间隔(秒)
+    double Wait()
+    {
+        Clock::time_point now = Clock::now();
+        if (!started)
+        {
+            started = true;
+            deadline = now;
+            last = now;
+            return 0.0;
+        }
+        if (TargetFps > 0.0)
+        {
+            Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / TargetFps));
+            deadline += period;
+            if (now > deadline + period)
+            {
+                // 已经晚了不止一个周期 不追赶
+                deadline = now;
+            }
+            WaitUntil(deadline);
+        }
+        now = Clock::now();
+        double seconds = std::chrono::duration<double>(now - last).count();
+        last = now;
+        Record(seconds * 1000.0);
+        return seconds;
+    }
+
+    // 长时间不画(按需渲染等待事件)之后调用 下一次 Wait 重新开始计时 等待的时间不算掉帧
+    void Restart()
+    {
+        started = false;
+    }
+
+    // 给动画用的平滑的帧间隔 rawSeconds 是 Wait 返回的值或 glfwGetTime() 的差
+    float SmoothDelta(float rawSeconds)
+    {
+        float limit = TargetFps > 0.0 ? 4.0f / (float)TargetFps : 0.25f;
+        float delta = std::min(std::max(rawSeconds, 0.0f), limit);
+        if (smoothDelta <= 0.0f)
+            smoothDelta = delta;
+        smoothDelta += Smoothing * (delta - smoothDelta);
+        // 平滑丢掉的时间慢慢补回
+        residual += delta - smoothDelta;
+        float correction = residual * Smoothing;
+        residual -= correction;
+        return std::max(smoothDelta + correction, 0.0f);
+    }
+
+    FramePacerStats Stats() const
+    {
+        FramePacerStats stats = {};
+        stats.frames = frames;
+        stats.droppedFrames = droppedFrames;
+        stats.marginMs = MarginMs();
+        if (!frames)
+            return stats;
+        stats.onTimePercent = 100.0 * onTimeFrames / frames;
+        stats.minMs = minMs;
+        stats.maxMs = maxMs;
+        stats.avgMs = sumMs / frames;
+        stats.p50Ms = Percentile(frames / 2);
+        stats.p99Ms = Percentile(std::min(frames - 1, (frames * 99 + 99) / 100 - 1));
+        stats.jitterMs = sqrt(std::max(squaresMs / frames - stats.avgMs * stats.avgMs, 0.0));
+        stats.spinMs = spinTotalMs / frames;
+        return stats;
+    }
+
+    // 统计和直方图 直方图只输出有帧的格子
+    void Print(std::ostream &out) const
+    {
+        FramePacerStats stats = Stats();
+        out << stats.frames << " frames, " << stats.droppedFrames << " dropped, interval min " << stats.minMs << " avg "
+            << stats.avgMs << " p50 " << stats.p50Ms << " p99 " << stats.p99Ms << " max " << stats.maxMs << " ms, jitter "
+            << stats.jitterMs << " ms, on time " << stats.onTimePercent << "%, spin " << stats.spinMs << " ms/frame, margin "
+            << stats.marginMs << " ms" << std::endl;
+        unsigned int peak = *std::max_element(histogram, histogram + HISTOGRAM_BINS + 1);
+        for (unsigned int i = 0; i <= HISTOGRAM_BINS; i++)
+        {
+            if (!histogram[i])
+                continue;
+            out.width(8);
+            if (i < HISTOGRAM_BINS)
+                out << std::right << i * binMs;
+            else
+                out << std::right << ">";
+            out << " ms ";
+            out.width(6);
+            out << histogram[i] << " " << std::string((histogram[i] * 40 + peak - 1) / peak, '#') << std::endl;
+        }
+        out << std::left;
+    }
+
+    void Reset()
+    {
+        frames = 0;
+        onTimeFrames = 0;
+        sumMs = 0.0;
+        squaresMs = 0.0;
+        minMs = 0.0;
+        maxMs = 0.0;
+        for (unsigned int i = 0; i <= HISTOGRAM_BINS; i++)
+            histogram[i] = 0;
+        droppedFrames = 0;
+        spinTotalMs = 0.0;
+        binMs = TargetFps > 0.0 ? 0.25 : 0.5;
+        while (TargetFps > 0.0 && binMs * HISTOGRAM_BINS < 4000.0 / TargetFps)
+            binMs *= 2.0;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    bool started;
+    Clock::time_point deadline;
+    Clock::time_point last;
+    double oversleepMs;
+    double oversleepDeviationMs;
+    float smoothDelta;
+    float residual;
+    unsigned int frames;
+    unsigned int onTimeFrames;
+    double sumMs, squaresMs, minMs, maxMs;
+    unsigned int histogram[HISTOGRAM_BINS + 1];  // 最后一格是超出范围的
+    unsigned int droppedFrames;
+    double spinTotalMs;
+    double binMs;
+
+    double MarginMs() const
+    {
+        return std::min(std::max(oversleepMs + 4.0 * oversleepDeviationMs, 0.1), 4.0);
+    }
+
+    void WaitUntil(Clock::time_point target)
+    {
+        Clock::time_point now = Clock::now();
+        if (Mode != PACING_SPIN)
+        {
+            double remainingMs = std::chrono::duration<double, std::milli>(target - now).count();
+            double sleepMs = Mode == PACING_SLEEP ? remainingMs : remainingMs - MarginMs();
+            if (sleepMs > 0.0)
+            {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sleepMs));
+                Clock::time_point woke = Clock::now();
+                // 晚醒的时间 更新平均值和平均偏差
+                double late = std::chrono::duration<double, std::milli>(woke - now).count() - sleepMs;
+                oversleepDeviationMs += 0.25 * (fabs(late - oversleepMs) - oversleepDeviationMs);
+                oversleepMs += 0.125 * (late - oversleepMs);
+                now = woke;
+            }
+            if (Mode == PACING_SLEEP)
+                return;
+        }
+        Clock::time_point spinStart = now;
+        while (now < target)
+            now = Clock::now();
+        spinTotalMs += std::chrono::duration<double, std::milli>(now - spinStart).count();
+    }
+
+    // 从小到大第 rank 个间隔(从0开始)所在的格子 按它在格子中的位置插值
+    double Percentile(unsigned int rank) const
+    {
+        unsigned int before = 0;
+        for (unsigned int i = 0; i < HISTOGRAM_BINS; i++)
+        {
+            if (rank < before + histogram[i])
+            {
+                double ms = (i + (rank - before + 0.5) / histogram[i]) * binMs;
+                return std::min(std::max(ms, minMs), maxMs);
+            }
+            before += histogram[i];
+        }
+        return maxMs;
+    }
+
+    void Record(double ms)
+    {
+        minMs = frames ? std::min(minMs, ms) : ms;
+        maxMs = frames ? std::max(maxMs, ms) : ms;
+        frames++;
+        sumMs += ms;
+        squaresMs += ms * ms;
+        if (TargetFps > 0.0 && fabs(ms - 1000.0 / TargetFps) < ON_TIME_MS)
+            onTimeFrames++;
+        if (TargetFps > 0.0)
+        {
+            double periods = ms * TargetFps / 1000.0;
+            if (periods > 1.5)
+                droppedFrames += (unsigned int)(periods + 0.5) - 1;
+        }
+        unsigned int bin = (unsigned int)(ms / binMs);
+        histogram[std::min(bin, HISTOGRAM_BINS)]++;
+    }
+};
+
+#endif
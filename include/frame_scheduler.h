@@ -0,0 +1,247 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "headless.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glm/glm.hpp>
+
+#include "Camera_Class.h"
+
+// 按需渲染
+//
+// 章节的循环每一轮都画一帧 画面没有变化时也一样 CPU和GPU一直满载
+// FrameScheduler 记录画面变化的原因 没有原因时不画 在 glfwWaitEvents 中阻塞到有事件或定时的重绘
+//
+// 变化的来源:
+//   - 输入: 回调函数(窗口大小 按键)调用 Invalidate
+//   - 摄像机: 每轮调用 TrackCamera 位置 方向或视野与上次画的不同时重绘
+//   - 动画: 有动画时 SetAnimating(true) 每轮都画
+//   - 定时: RedrawAt 在指定的时间醒来重绘一次
+//
+// 每轮:
+//   处理输入 更新摄像机和动画
+//   if (!scheduler.ShouldRender()) { scheduler.Wait(); continue; }
+//   画一帧
+//
+// Enabled 为假时 ShouldRender 总是返回真 与原来的循环相同
+// 等待用 glfwWaitEventsTimeout(GLFW 3.2) 可能提前醒来 醒来后重新检查 附带的头文件是3.0 见 headless.h
+//
+// WakeupTimer 在指定的时间用 glfwPostEmptyEvent 唤醒 Wait 但不要求重绘
+
+enum RedrawReason {
+    REDRAW_FIRST = 1,         // 第一帧
+    REDRAW_INPUT = 2,         // Invalidate
+    REDRAW_CAMERA = 4,        // 摄像机变了
+    REDRAW_ANIMATION = 8,     // 有动画
+    REDRAW_SCHEDULED = 16,    // RedrawAt 的时间到了
+    REDRAW_ALWAYS = 32,       // Enabled 为假
+    REDRAW_REASONS = 6
+};
+
+inline const char *RedrawReasonName(unsigned int index)
+{
+    static const char *names[REDRAW_REASONS] = { "first", "input", "camera", "animation", "scheduled", "always" };
+    return index < REDRAW_REASONS ? names[index] : "";
+}
+
+struct FrameSchedulerStats {
+    double seconds;                            // 统计的时长
+    unsigned int wakeups;                      // 从等待中醒来的次数
+    unsigned int frames;                       // 画出的帧数
+    unsigned int reasonFrames[REDRAW_REASONS]; // 每种原因触发的帧数 一帧可以有几种原因
+
+    double WakeupsPerMinute() const { return seconds > 0.0 ? wakeups * 60.0 / seconds : 0.0; }
+    double FramesPerMinute() const { return seconds > 0.0 ? frames * 60.0 / seconds : 0.0; }
+};
+
+class FrameScheduler
+{
+public:
+    bool Enabled;
+
+    FrameScheduler(bool enabled = true) : Enabled(enabled), pending(REDRAW_FIRST), animating(false), redrawAt(-1.0), lastReasons(0)
+    {
+        origin = std::chrono::steady_clock::now();
+        cameraPosition = glm::vec3(NAN);
+        cameraFront = glm::vec3(NAN);
+        cameraZoom = NAN;
+        ResetStats();
+    }
+
+    // 从调度器创建起的秒数 RedrawAt 使用这个时间
+    double Now() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    void Invalidate(unsigned int reason = REDRAW_INPUT)
+    {
+        pending |= reason;
+    }
+
+    void SetAnimating(bool value)
+    {
+        animating = value;
+    }
+
+    // 在 Now() 为 time 时重绘 只保留最早的一个
+    void RedrawAt(double time)
+    {
+        if (redrawAt < 0.0 || time < redrawAt)
+            redrawAt = time;
+    }
+
+    void TrackCamera(const Camera &camera)
+    {
+        if (camera.Position != cameraPosition || camera.Front != cameraFront || camera.Zoom != cameraZoom)
+        {
+            pending |= REDRAW_CAMERA;
+            cameraPosition = camera.Position;
+            cameraFront = camera.Front;
+            cameraZoom = camera.Zoom;
+        }
+    }
+
+    // 这一轮是否要画 为真时计入统计 清除已经处理的原因
+    bool ShouldRender()
+    {
+        unsigned int reasons = pending;
+        if (!Enabled)
+            reasons |= REDRAW_ALWAYS;
+        if (animating)
+            reasons |= REDRAW_ANIMATION;
+        if (redrawAt >= 0.0 && Now() >= redrawAt)
+        {
+            reasons |= REDRAW_SCHEDULED;
+            redrawAt = -1.0;
+        }
+        lastReasons = reasons;
+        if (!reasons)
+            return false;
+        pending = 0;
+        stats.frames++;
+        for (unsigned int i = 0; i < REDRAW_REASONS; i++)
+        {
+            if (reasons & (1u << i))
+                stats.reasonFrames[i]++;
+        }
+        return true;
+    }
+
+    // 最近一次 ShouldRender 的原因 0 表示没有画
+    unsigned int LastReasons() const
+    {
+        return lastReasons;
+    }
+
+    // 阻塞到有事件或到了 RedrawAt 的时间 返回等待的秒数
+    double Wait()
+    {
+        double start = Now();
+        if (redrawAt < 0.0)
+            glfwWaitEvents();
+        else if (redrawAt > start)
+            glfwWaitEventsTimeout(redrawAt - start);
+        stats.wakeups++;
+        return Now() - start;
+    }
+
+    // 从上次 ResetStats 到现在的统计
+    FrameSchedulerStats Stats() const
+    {
+        FrameSchedulerStats result = stats;
+        result.seconds = Now() - statsStart;
+        return result;
+    }
+
+    void ResetStats()
+    {
+        stats.seconds = 0.0;
+        stats.wakeups = 0;
+        stats.frames = 0;
+        for (unsigned int i = 0; i < REDRAW_REASONS; i++)
+            stats.reasonFrames[i] = 0;
+        statsStart = Now();
+    }
+
+private:
+    std::chrono::steady_clock::time_point origin;
+    unsigned int pending;
+    bool animating;
+    double redrawAt;
+    unsigned int lastReasons;
+    glm::vec3 cameraPosition;
+    glm::vec3 cameraFront;
+    float cameraZoom;
+    FrameSchedulerStats stats;
+    double statsStart;
+};
+
+// 在另一个线程中等到指定的时间 用 glfwPostEmptyEvent 唤醒主线程的 Wait
+// 与 RedrawAt 不同 调度器不知道这个时间 醒来后没有原因就继续等待 用于在空闲时结束一段测量之类的事
+class WakeupTimer
+{
+public:
+    WakeupTimer() : armed(false), stop(false)
+    {
+        thread = std::thread(&WakeupTimer::Run, this);
+    }
+
+    ~WakeupTimer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        changed.notify_one();
+        thread.join();
+    }
+
+    // 在 scheduler.Now() 为 time 时唤醒一次 替换还没到的时间
+    void WakeAt(const FrameScheduler &scheduler, double time)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wakeAt = std::chrono::steady_clock::now() +
+                 std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time - scheduler.Now()));
+        if (!armed)
+            HeadlessExpectEmptyEvent();
+        armed = true;
+        changed.notify_one();
+    }
+
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::chrono::steady_clock::time_point wakeAt;
+    bool armed;
+    bool stop;
+
+    WakeupTimer(const WakeupTimer&);
+    WakeupTimer &operator=(const WakeupTimer&);
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stop)
+        {
+            if (!armed)
+                changed.wait(lock);
+            else if (changed.wait_until(lock, wakeAt) == std::cv_status::timeout && armed && std::chrono::steady_clock::now() >= wakeAt)
+            {
+                armed = false;
+                glfwPostEmptyEvent();
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// 视锥体的6个平面 从 projection * view 矩阵中直接提取(Gribb/Hartmann)
+// 平面为 (n, d) 满足 n·p + d >= 0 的点在平面内侧 n 已经归一化 所以 n·p + d 就是有符号的距离
+struct Frustum {
+    glm::vec4 planes[6];
+
+    Frustum()
+    {
+    }
+
+    Frustum(const glm::mat4 &viewProjection)
+    {
+        // glm 的矩阵按列存储 m[c][r] 第 r 行为 (m[0][r], m[1][r], m[2][r], m[3][r])
+        glm::vec4 rows[4];
+        for (int r = 0; r < 4; r++)
+            rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+        planes[0] = rows[3] + rows[0]; // 左
+        planes[1] = rows[3] - rows[0]; // 右
+        planes[2] = rows[3] + rows[1]; // 下
+        planes[3] = rows[3] - rows[1]; // 上
+        planes[4] = rows[3] + rows[2]; // 近
+        planes[5] = rows[3] - rows[2]; // 远
+        for (int i = 0; i < 6; i++)
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+
+    // 球与视锥体相交或在内部(保守: 有少量在外面的球也会返回真)
+    bool IntersectsSphere(const glm::vec3 &center, float radius) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // 轴对齐包围盒: 只需检查每个平面法线方向上最远的那个角
+    bool IntersectsBox(const glm::vec3 &minimum, const glm::vec3 &maximum) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            glm::vec3 n(planes[i]);
+            glm::vec3 p(n.x >= 0.0f ? maximum.x : minimum.x,
+                        n.y >= 0.0f ? maximum.y : minimum.y,
+                        n.z >= 0.0f ? maximum.z : minimum.z);
+            if (glm::dot(n, p) + planes[i].w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    // 包围盒完全在视锥体内: 每个平面法线方向上最近的那个角也在内侧
+    bool ContainsBox(const glm::vec3 &minimum, const glm::vec3 &maximum) const
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            glm::vec3 n(planes[i]);
+            glm::vec3 p(n.x >= 0.0f ? minimum.x : maximum.x,
+                        n.y >= 0.0f ? minimum.y : maximum.y,
+                        n.z >= 0.0f ? minimum.z : maximum.z);
+            if (glm::dot(n, p) + planes[i].w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// glad.c 只生成了 OpenGL 3.3 core 的函数
+// 这里手动加载 3.3 之后才加入核心的函数 驱动不支持时对应指针为NULL
+// 使用前先检查 GLExt 中的标志
+
+#ifndef APIENTRYP
+#define APIENTRYP APIENTRY *
+#endif
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_CLIENT_STORAGE_BIT
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+
+typedef void (APIENTRYP PFNMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+typedef void (APIENTRYP PFNBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef void (APIENTRYP PFNTEXBUFFERRANGEPROC)(GLenum target, GLenum internalformat, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+// glMultiDrawElementsIndirect 读取的命令格式 由GL规定 不能改变成员顺序
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+struct GLExt {
+    int Major = 3;
+    int Minor = 3;
+    // GL 4.3 或 GL_ARB_multi_draw_indirect
+    bool MultiDrawIndirect = false;
+    // GL 4.4 或 GL_ARB_buffer_storage
+    bool BufferStorage = false;
+    // GL_ARB_shader_draw_parameters 着色器中可以读取 gl_DrawIDARB
+    // 4.6 的核心功能叫 gl_DrawID 要 #version 460 着色器是430加扩展写的 所以只看扩展
+    bool ShaderDrawParameters = false;
+    // GL 4.3 或 GL_ARB_texture_buffer_range
+    bool TextureBufferRange = false;
+    // GL 4.6 或 GL_ARB_pipeline_statistics_query 用 glBeginQuery 统计着色器的调用次数
+    bool PipelineStatisticsQuery = false;
+
+    PFNMULTIDRAWELEMENTSINDIRECTPROC MultiDrawElementsIndirect = NULL;
+    PFNBUFFERSTORAGEPROC BufferStorageFn = NULL;
+    PFNTEXBUFFERRANGEPROC TexBufferRange = NULL;
+};
+
+inline GLExt glext;
+
+inline bool HasGLExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline bool GLVersionAtLeast(int major, int minor)
+{
+    return glext.Major > major || (glext.Major == major && glext.Minor >= minor);
+}
+
+// 在 gladLoadGLLoader 之后调用 传入同一个加载函数
+inline void LoadGLExtensions(GLADloadproc load)
+{
+    glGetIntegerv(GL_MAJOR_VERSION, &glext.Major);
+    glGetIntegerv(GL_MINOR_VERSION, &glext.Minor);
+
+    glext.MultiDrawElementsIndirect = (PFNMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+    glext.BufferStorageFn = (PFNBUFFERSTORAGEPROC)load("glBufferStorage");
+    glext.TexBufferRange = (PFNTEXBUFFERRANGEPROC)load("glTexBufferRange");
+
+    // 有些驱动即使不支持也会返回非NULL的指针 所以还要检查版本或扩展
+    glext.MultiDrawIndirect = glext.MultiDrawElementsIndirect &&
+        (GLVersionAtLeast(4, 3) || HasGLExtension("GL_ARB_multi_draw_indirect"));
+    glext.BufferStorage = glext.BufferStorageFn &&
+        (GLVersionAtLeast(4, 4) || HasGLExtension("GL_ARB_buffer_storage"));
+    glext.TextureBufferRange = glext.TexBufferRange &&
+        (GLVersionAtLeast(4, 3) || HasGLExtension("GL_ARB_texture_buffer_range"));
+    glext.ShaderDrawParameters = HasGLExtension("GL_ARB_shader_draw_parameters");
+    glext.PipelineStatisticsQuery = GLVersionAtLeast(4, 6) || HasGLExtension("GL_ARB_pipeline_statistics_query");
+}
+
+#endif
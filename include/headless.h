@@ -0,0 +1,504 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+// 不需要X11的头文件(它会定义 None Status 等宏)
+#ifndef EGL_NO_X11
+#define EGL_NO_X11
+#endif
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// 无窗口(headless)模式
+//
+// 章节都用 glfwCreateWindow 创建窗口 在没有显示器和GPU的构建机 测试机上无法运行
+// 加上 --headless 后 用 EGL 的 surfaceless 上下文(Mesa llvmpipe 软件渲染)代替窗口
+// 渲染到一个与窗口同样大小的帧缓冲对象(FBO) 绘制固定的帧数后退出
+//
+//   --headless             使用无窗口模式
+//   --frames N             绘制的帧数 默认60
+//   --screenshot out.ppm   最后一帧保存为PPM图片
+//   --timestep 0.016       每帧前进的时间 glfwGetTime 返回 帧号 * timestep 每次运行的画面相同
+//
+// 章节的代码不需要改动 只要在 glfw3.h 之后包含这个头文件 并在 main 的开头调用 HeadlessInit(argc, argv)
+// 头文件末尾把章节用到的 glfw 函数重定向到这里的同名包装函数:
+// 没有 --headless 时包装函数直接调用GLFW 有时由EGL实现 窗口指针只是一个占位的值
+//
+// 链接时需要加上 -lEGL
+//
+// 附带的 glfw3.h 是3.0 没有 glfwPostEmptyEvent(3.1) 和 glfwWaitEventsTimeout(3.2) 这里自己声明
+// 不做睡眠加轮询的代替 链接的GLFW库低于3.2时直接链接失败
+#if GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR < 2
+extern "C" {
+GLFWAPI void glfwPostEmptyEvent(void);
+GLFWAPI void glfwWaitEventsTimeout(double timeout);
+}
+#endif
+
+struct HeadlessState {
+    bool Enabled = false;
+    unsigned int Frames = 60;
+    unsigned int Frame = 0;
+    const char *Screenshot = NULL;
+    double TimeStep = 1.0 / 60.0;
+
+    int Width = 0;
+    int Height = 0;
+    int Major = 1;
+    int Minor = 0;
+    bool CoreProfile = false;
+    bool ShouldClose = false;
+
+    EGLDisplay Display = EGL_NO_DISPLAY;
+    EGLContext Context = EGL_NO_CONTEXT;
+    GLuint Framebuffer = 0;
+    GLuint Renderbuffers[2] = { 0, 0 };
+
+    std::vector<double> FrameMs;
+    std::chrono::steady_clock::time_point FrameStart;
+
+    // 无窗口模式没有输入 只有 glfwPostEmptyEvent 能唤醒等待
+    std::mutex EventMutex;
+    std::condition_variable EventPosted;
+    unsigned int ExpectedEvents = 0;  // 其他线程答应之后会发出的空事件
+    unsigned int PostedEvents = 0;
+};
+
+inline HeadlessState headless;
+
+// 从参数中取出无窗口模式的参数 剩下的参数留给章节自己解析
+inline void HeadlessInit(int &argc, char *argv[])
+{
+    int kept = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless.Enabled = true;
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            headless.Frames = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc)
+            headless.Screenshot = argv[++i];
+        else if (strcmp(argv[i], "--timestep") == 0 && i + 1 < argc)
+            headless.TimeStep = atof(argv[++i]);
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    argv[argc] = NULL;
+}
+
+// FBO相关的函数不经过glad 章节加载glad之前就要创建FBO
+namespace headless_gl {
+    typedef void (APIENTRYP GenFn)(GLsizei, GLuint*);
+    typedef void (APIENTRYP DeleteFn)(GLsizei, const GLuint*);
+    typedef void (APIENTRYP BindFn)(GLenum, GLuint);
+    typedef void (APIENTRYP StorageFn)(GLenum, GLenum, GLsizei, GLsizei);
+    typedef void (APIENTRYP AttachFn)(GLenum, GLenum, GLenum, GLuint);
+    typedef GLenum (APIENTRYP StatusFn)(GLenum);
+    typedef void (APIENTRYP ReadPixelsFn)(GLint, GLint, GLsizei, GLsizei, GLenum, GLenum, void*);
+    typedef void (APIENTRYP VoidFn)(void);
+    typedef void (APIENTRYP PixelStoreFn)(GLenum, GLint);
+    typedef void (APIENTRYP ViewportFn)(GLint, GLint, GLsizei, GLsizei);
+
+    inline void *Load(const char *name)
+    {
+        return (void*)eglGetProcAddress(name);
+    }
+}
+
+inline bool HeadlessCreateFramebuffer()
+{
+    using namespace headless_gl;
+    GenFn genFramebuffers = (GenFn)Load("glGenFramebuffers");
+    GenFn genRenderbuffers = (GenFn)Load("glGenRenderbuffers");
+    BindFn bindFramebuffer = (BindFn)Load("glBindFramebuffer");
+    BindFn bindRenderbuffer = (BindFn)Load("glBindRenderbuffer");
+    StorageFn renderbufferStorage = (StorageFn)Load("glRenderbufferStorage");
+    AttachFn framebufferRenderbuffer = (AttachFn)Load("glFramebufferRenderbuffer");
+    StatusFn checkFramebufferStatus = (StatusFn)Load("glCheckFramebufferStatus");
+    ViewportFn viewport = (ViewportFn)Load("glViewport");
+    if (!genFramebuffers || !genRenderbuffers || !bindFramebuffer || !bindRenderbuffer ||
+        !renderbufferStorage || !framebufferRenderbuffer || !checkFramebufferStatus || !viewport)
+    {
+        std::cout << "ERROR::HEADLESS::FRAMEBUFFER_FUNCTIONS_NOT_FOUND" << std::endl;
+        return false;
+    }
+
+    // 颜色 RGBA8 深度24位 模板8位 与默认窗口的帧缓冲一致
+    genFramebuffers(1, &headless.Framebuffer);
+    genRenderbuffers(2, headless.Renderbuffers);
+    bindRenderbuffer(GL_RENDERBUFFER, headless.Renderbuffers[0]);
+    renderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, headless.Width, headless.Height);
+    bindRenderbuffer(GL_RENDERBUFFER, headless.Renderbuffers[1]);
+    renderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, headless.Width, headless.Height);
+    bindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // 章节中不会再绑定其他帧缓冲 这个FBO一直保持绑定 相当于窗口的默认帧缓冲
+    bindFramebuffer(GL_FRAMEBUFFER, headless.Framebuffer);
+    framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, headless.Renderbuffers[0]);
+    framebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, headless.Renderbuffers[1]);
+    if (checkFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        return false;
+    }
+    viewport(0, 0, headless.Width, headless.Height);
+    return true;
+}
+
+// 读取FBO的颜色 保存为二进制PPM(P6) OpenGL的第一行在底部 写入时上下翻转
+inline bool HeadlessSaveScreenshot(const char *path)
+{
+    using namespace headless_gl;
+    ReadPixelsFn readPixels = (ReadPixelsFn)Load("glReadPixels");
+    PixelStoreFn pixelStore = (PixelStoreFn)Load("glPixelStorei");
+    BindFn bindFramebuffer = (BindFn)Load("glBindFramebuffer");
+    // 章节可能绑定了自己的帧缓冲 截图总是读取代替窗口的FBO
+    bindFramebuffer(GL_READ_FRAMEBUFFER, headless.Framebuffer);
+    std::vector<unsigned char> pixels((size_t)headless.Width * headless.Height * 3);
+    pixelStore(GL_PACK_ALIGNMENT, 1);
+    readPixels(0, 0, headless.Width, headless.Height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        std::cout << "ERROR::HEADLESS::SCREENSHOT_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", headless.Width, headless.Height);
+    size_t row = (size_t)headless.Width * 3;
+    for (int y = headless.Height - 1; y >= 0; y--)
+        fwrite(pixels.data() + y * row, 1, row, file);
+    fclose(file);
+    return true;
+}
+
+// 以下是GLFW函数的包装 参数和返回值与GLFW相同
+
+inline int HeadlessGlfwInit()
+{
+    if (!headless.Enabled)
+        return glfwInit();
+    // 优先使用Mesa的surfaceless平台 不需要任何显示服务
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+    {
+        std::cout << "ERROR::HEADLESS::EGL_INITIALIZATION_FAILED" << std::endl;
+        return GL_FALSE;
+    }
+    headless.Display = display;
+    return GL_TRUE;
+}
+
+inline void HeadlessWindowHint(int hint, int value)
+{
+    if (!headless.Enabled)
+    {
+        glfwWindowHint(hint, value);
+        return;
+    }
+    if (hint == GLFW_CONTEXT_VERSION_MAJOR)
+        headless.Major = value;
+    else if (hint == GLFW_CONTEXT_VERSION_MINOR)
+        headless.Minor = value;
+    else if (hint == GLFW_OPENGL_PROFILE)
+        headless.CoreProfile = value == GLFW_OPENGL_CORE_PROFILE;
+}
+
+// 无窗口模式下返回的窗口指针只用来与NULL比较 不能传给真正的GLFW函数
+inline GLFWwindow *HeadlessCreateWindow(int width, int height, const char *title, GLFWmonitor *monitor, GLFWwindow *share)
+{
+    if (!headless.Enabled)
+        return glfwCreateWindow(width, height, title, monitor, share);
+    // 像GLFW一样 请求的版本不支持时返回NULL 章节可以降低版本再试
+    if (headless.Context != EGL_NO_CONTEXT || !eglBindAPI(EGL_OPENGL_API))
+        return NULL;
+    EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config;
+    EGLint count = 0;
+    if (!eglChooseConfig(headless.Display, configAttributes, &config, 1, &count) || count == 0)
+        return NULL;
+    EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, headless.Major,
+        EGL_CONTEXT_MINOR_VERSION, headless.Minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,
+        headless.CoreProfile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(headless.Display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT)
+        return NULL;
+    headless.Context = context;
+    headless.Width = width;
+    headless.Height = height;
+    return (GLFWwindow*)&headless;
+}
+
+inline void HeadlessMakeContextCurrent(GLFWwindow *window)
+{
+    if (!headless.Enabled)
+    {
+        glfwMakeContextCurrent(window);
+        return;
+    }
+    // 需要 EGL_KHR_surfaceless_context: 不绑定任何surface 所有绘制都进入FBO
+    if (!eglMakeCurrent(headless.Display, EGL_NO_SURFACE, EGL_NO_SURFACE, headless.Context) || !HeadlessCreateFramebuffer())
+    {
+        std::cout << "ERROR::HEADLESS::MAKE_CURRENT_FAILED" << std::endl;
+        exit(-1);
+    }
+    headless.FrameStart = std::chrono::steady_clock::now();
+}
+
+inline GLFWglproc HeadlessGetProcAddress(const char *name)
+{
+    if (!headless.Enabled)
+        return glfwGetProcAddress(name);
+    return (GLFWglproc)eglGetProcAddress(name);
+}
+
+inline int HeadlessWindowShouldClose(GLFWwindow *window)
+{
+    if (!headless.Enabled)
+        return glfwWindowShouldClose(window);
+    return headless.ShouldClose || headless.Frame >= headless.Frames;
+}
+
+inline void HeadlessSetWindowShouldClose(GLFWwindow *window, int value)
+{
+    if (!headless.Enabled)
+    {
+        glfwSetWindowShouldClose(window, value);
+        return;
+    }
+    headless.ShouldClose = value != 0;
+}
+
+// 一帧结束: 等待渲染完成后计时 最后一帧保存截图
+inline void HeadlessSwapBuffers(GLFWwindow *window)
+{
+    if (!headless.Enabled)
+    {
+        glfwSwapBuffers(window);
+        return;
+    }
+    headless_gl::VoidFn finish = (headless_gl::VoidFn)headless_gl::Load("glFinish");
+    finish();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - headless.FrameStart).count();
+    headless.FrameMs.push_back(ms);
+    std::cout << "frame " << headless.Frame << ": " << ms << " ms" << std::endl;
+    headless.FrameStart = now;
+    headless.Frame++;
+    if (headless.Frame == headless.Frames && headless.Screenshot)
+        HeadlessSaveScreenshot(headless.Screenshot);
+}
+
+inline void HeadlessPollEvents()
+{
+    if (!headless.Enabled)
+        glfwPollEvents();
+}
+
+// 其他线程在之后一定会调用 glfwPostEmptyEvent 时先调用这个 无窗口模式的 glfwWaitEvents 才会等它
+// 有窗口时什么也不做
+inline void HeadlessExpectEmptyEvent()
+{
+    if (!headless.Enabled)
+        return;
+    std::lock_guard<std::mutex> lock(headless.EventMutex);
+    headless.ExpectedEvents++;
+}
+
+// 可以在任意线程调用
+inline void HeadlessPostEmptyEvent()
+{
+    if (!headless.Enabled)
+    {
+        glfwPostEmptyEvent();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(headless.EventMutex);
+    if (headless.ExpectedEvents)
+        headless.ExpectedEvents--;
+    headless.PostedEvents++;
+    headless.EventPosted.notify_all();
+}
+
+// 无窗口模式没有输入 没有线程答应发出空事件时 无限等待永远不会返回 直接结束运行
+inline void HeadlessWaitEvents()
+{
+    if (!headless.Enabled)
+    {
+        glfwWaitEvents();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(headless.EventMutex);
+    if (!headless.ExpectedEvents && !headless.PostedEvents)
+    {
+        headless.ShouldClose = true;
+        return;
+    }
+    headless.EventPosted.wait(lock, [] { return headless.PostedEvents > 0; });
+    // 与GLFW相同 等待期间的几个空事件只唤醒一次
+    headless.PostedEvents = 0;
+}
+
+// 调用者要像GLFW的文档要求的那样 醒来后重新检查是否需要绘制
+// 无窗口模式没有输入 等到超时或者有空事件
+inline void HeadlessWaitEventsTimeout(double timeout)
+{
+    if (!headless.Enabled)
+    {
+        glfwWaitEventsTimeout(timeout);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(headless.EventMutex);
+    headless.EventPosted.wait_for(lock, std::chrono::duration<double>(timeout), [] { return headless.PostedEvents > 0; });
+    headless.PostedEvents = 0;
+}
+
+// 无窗口模式没有垂直同步
+inline void HeadlessSwapInterval(int interval)
+{
+    if (!headless.Enabled)
+        glfwSwapInterval(interval);
+}
+
+// 无窗口模式下时间只由帧号决定
+inline double HeadlessGetTime()
+{
+    if (!headless.Enabled)
+        return glfwGetTime();
+    return headless.Frame * headless.TimeStep;
+}
+
+inline int HeadlessGetKey(GLFWwindow *window, int key)
+{
+    if (!headless.Enabled)
+        return glfwGetKey(window, key);
+    return GLFW_RELEASE;
+}
+
+inline void HeadlessSetInputMode(GLFWwindow *window, int mode, int value)
+{
+    if (!headless.Enabled)
+        glfwSetInputMode(window, mode, value);
+}
+
+inline GLFWframebuffersizefun HeadlessSetFramebufferSizeCallback(GLFWwindow *window, GLFWframebuffersizefun callback)
+{
+    if (!headless.Enabled)
+        return glfwSetFramebufferSizeCallback(window, callback);
+    return NULL;
+}
+
+inline GLFWcursorposfun HeadlessSetCursorPosCallback(GLFWwindow *window, GLFWcursorposfun callback)
+{
+    if (!headless.Enabled)
+        return glfwSetCursorPosCallback(window, callback);
+    return NULL;
+}
+
+inline GLFWscrollfun HeadlessSetScrollCallback(GLFWwindow *window, GLFWscrollfun callback)
+{
+    if (!headless.Enabled)
+        return glfwSetScrollCallback(window, callback);
+    return NULL;
+}
+
+inline GLFWkeyfun HeadlessSetKeyCallback(GLFWwindow *window, GLFWkeyfun callback)
+{
+    if (!headless.Enabled)
+        return glfwSetKeyCallback(window, callback);
+    return NULL;
+}
+
+// 输出帧时间的统计 释放FBO和上下文
+inline void HeadlessTerminate()
+{
+    if (!headless.Enabled)
+    {
+        glfwTerminate();
+        return;
+    }
+    if (!headless.FrameMs.empty())
+    {
+        double total = 0.0, minimum = headless.FrameMs[0], maximum = headless.FrameMs[0];
+        for (size_t i = 0; i < headless.FrameMs.size(); i++)
+        {
+            total += headless.FrameMs[i];
+            minimum = headless.FrameMs[i] < minimum ? headless.FrameMs[i] : minimum;
+            maximum = headless.FrameMs[i] > maximum ? headless.FrameMs[i] : maximum;
+        }
+        std::cout << headless.FrameMs.size() << " frames, avg " << total / headless.FrameMs.size()
+                  << " ms, min " << minimum << " ms, max " << maximum << " ms" << std::endl;
+    }
+    if (headless.Context != EGL_NO_CONTEXT)
+    {
+        if (headless.Framebuffer)
+        {
+            headless_gl::DeleteFn deleteFramebuffers = (headless_gl::DeleteFn)headless_gl::Load("glDeleteFramebuffers");
+            headless_gl::DeleteFn deleteRenderbuffers = (headless_gl::DeleteFn)headless_gl::Load("glDeleteRenderbuffers");
+            deleteFramebuffers(1, &headless.Framebuffer);
+            deleteRenderbuffers(2, headless.Renderbuffers);
+        }
+        eglMakeCurrent(headless.Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(headless.Display, headless.Context);
+        headless.Context = EGL_NO_CONTEXT;
+    }
+    if (headless.Display != EGL_NO_DISPLAY)
+        eglTerminate(headless.Display);
+    headless.Display = EGL_NO_DISPLAY;
+}
+
+// 章节中绑定0(窗口的帧缓冲)时 换成代替窗口的FBO
+// 这个函数在下面的宏之前定义 里面调用的还是glad的 glBindFramebuffer
+inline void HeadlessBindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    glBindFramebuffer(target, framebuffer == 0 && headless.Enabled ? headless.Framebuffer : framebuffer);
+}
+
+// 章节中的 glfw 调用从这里开始都指向上面的包装函数
+#define glfwInit HeadlessGlfwInit
+#define glfwWindowHint HeadlessWindowHint
+#define glfwCreateWindow HeadlessCreateWindow
+#define glfwMakeContextCurrent HeadlessMakeContextCurrent
+#define glfwGetProcAddress HeadlessGetProcAddress
+#define glfwWindowShouldClose HeadlessWindowShouldClose
+#define glfwSetWindowShouldClose HeadlessSetWindowShouldClose
+#define glfwSwapBuffers HeadlessSwapBuffers
+#define glfwSwapInterval HeadlessSwapInterval
+#define glfwPollEvents HeadlessPollEvents
+#define glfwWaitEvents HeadlessWaitEvents
+#define glfwWaitEventsTimeout HeadlessWaitEventsTimeout
+#define glfwPostEmptyEvent HeadlessPostEmptyEvent
+#define glfwGetTime HeadlessGetTime
+#define glfwGetKey HeadlessGetKey
+#define glfwSetInputMode HeadlessSetInputMode
+#define glfwSetFramebufferSizeCallback HeadlessSetFramebufferSizeCallback
+#define glfwSetCursorPosCallback HeadlessSetCursorPosCallback
+#define glfwSetScrollCallback HeadlessSetScrollCallback
+#define glfwSetKeyCallback HeadlessSetKeyCallback
+#define glfwTerminate HeadlessTerminate
+#undef glBindFramebuffer
+#define glBindFramebuffer HeadlessBindFramebuffer
+
+#endif
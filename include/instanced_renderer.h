@@ -0,0 +1,137 @@
+#ifndef INSTANCED_RENDERER_H
+#define INSTANCED_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <vector>
+#include <cstddef>
+
+// 实例化渲染
+// 章节中每个立方体都要 setMat4("model") 再调用一次 glDrawArrays
+// 这里把所有共享同一网格和材质的物体的模型矩阵与法线矩阵写进一个实例缓冲
+// 再用一次 glDrawArraysInstanced 画完
+
+// 每个实例的数据 顶点着色器中占用 model: 4个location  normalMatrix: 3个location
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+};
+
+class InstancedRenderer
+{
+public:
+    unsigned int InstanceVBO;
+    // 实例缓冲当前能容纳的实例个数 至少为1 不够时翻倍
+    unsigned int Capacity;
+    std::vector<InstanceData> Instances;
+
+    InstancedRenderer(unsigned int capacity = 1024) : Capacity(capacity > 0 ? capacity : 1), drawCount(0)
+    {
+        glGenBuffers(1, &InstanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, Capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        Instances.reserve(Capacity);
+    }
+
+    ~InstancedRenderer()
+    {
+        glDeleteBuffers(1, &InstanceVBO);
+    }
+
+    // 把实例缓冲挂到一个已经设置好顶点属性的VAO上
+    // firstLocation 起的4个location是模型矩阵 withNormalMatrix 时紧接着3个location是法线矩阵
+    // glVertexAttribDivisor(location, 1) 表示每个实例而不是每个顶点前进一次
+    void AttachTo(unsigned int VAO, unsigned int firstLocation = 3, bool withNormalMatrix = true) const
+    {
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            glVertexAttribPointer(firstLocation + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offsetof(InstanceData, model) + sizeof(glm::vec4) * i));
+            glEnableVertexAttribArray(firstLocation + i);
+            glVertexAttribDivisor(firstLocation + i, 1);
+        }
+        if (withNormalMatrix)
+        {
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                glVertexAttribPointer(firstLocation + 4 + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                      (void*)(offsetof(InstanceData, normalMatrix) + sizeof(glm::vec3) * i));
+                glEnableVertexAttribArray(firstLocation + 4 + i);
+                glVertexAttribDivisor(firstLocation + 4 + i, 1);
+            }
+        }
+        glBindVertexArray(0);
+    }
+
+    void Clear()
+    {
+        Instances.clear();
+    }
+
+    // 法线矩阵在CPU上每个实例算一次 而不是在顶点着色器里每个顶点算一次 inverse
+    void Add(const glm::mat4 &model)
+    {
+        InstanceData data;
+        data.model = model;
+        data.normalMatrix = glm::inverseTranspose(glm::mat3(model));
+        Instances.push_back(data);
+    }
+
+    // 每帧把实例数据传到GPU
+    // 先用 glBufferData(NULL) 丢弃旧的存储(orphaning) 驱动可以另分配一块内存
+    // 不必等待上一帧还在使用这块缓冲的绘制完成
+    void Upload()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        if (Instances.size() > Capacity)
+        {
+            while (Capacity < Instances.size())
+                Capacity *= 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, Capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, Instances.size() * sizeof(InstanceData), Instances.data());
+        drawCount = (unsigned int)Instances.size();
+    }
+
+    // 不经过 Instances 直接写实例缓冲 返回 count 个实例的指针 写完后调用 Unmap
+    // GL_MAP_INVALIDATE_BUFFER_BIT 与 Upload 中的 orphaning 作用相同 不等待上一帧
+    // 返回的指针可以交给其他线程写 但 Map 和 Unmap 要在GL上下文所在的线程调用
+    InstanceData *Map(unsigned int count)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        if (count > Capacity)
+        {
+            while (Capacity < count)
+                Capacity *= 2;
+            glBufferData(GL_ARRAY_BUFFER, Capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        }
+        drawCount = count;
+        if (count == 0)
+            return NULL;
+        return (InstanceData*)glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData),
+                                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    void Unmap()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, InstanceVBO);
+        if (drawCount)
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+
+    // VAO需要先用 AttachTo 挂上实例缓冲 画最近一次 Upload 或 Map 的实例数
+    void Draw(unsigned int VAO, GLenum mode, GLint first, GLsizei count) const
+    {
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(mode, first, count, (GLsizei)drawCount);
+    }
+
+private:
+    unsigned int drawCount;
+};
+
+#endif
@@ -0,0 +1,403 @@
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIGHT_CLUSTERS_SSE 1
+#endif
+
+#include "point_lights.h"
+#include "thread_pool.h"
+
+// 分簇光照(clustered shading)
+//
+// 把视锥体按屏幕分成 X * Y 个格子 按深度分成 Z 层 每一块叫一个簇(cluster)
+// 每帧在CPU上算出每个光源的球与哪些簇相交 片段着色器根据自己的像素位置和深度找到所在的簇
+// 只遍历这个簇中的光源 代价从 片段数 * 光源数 降到 片段数 * 簇中的光源数
+//
+// 深度按指数划分: 第k层为 near * (far/near)^(k/Z) 到 near * (far/near)^((k+1)/Z)
+// 每一块簇的长宽高比例大致相同 近处的簇小 远处的簇大
+//
+// 每帧的步骤:
+//   1. 每个光源变换到观察空间 算出它覆盖的簇的范围(SSE一次处理4个光源)
+//   2. 按深度层分桶 每层由一个线程处理 对范围内的每个簇做球与包围盒的相交测试
+//      每个簇只被处理它所在层的线程写入 不需要加锁
+//   3. 前缀和得到每个簇在索引表中的偏移 合并成一个索引表
+//
+// 结果放进两个缓冲纹理:
+//   grid:    每个簇一个 RG32UI (在索引表中的偏移, 光源个数)
+//   indices: R32UI 光源的编号 对应 PointLightBuffer 中的光源
+//
+// 缓冲纹理最多 GL_MAX_TEXTURE_BUFFER_SIZE 个texel GL只保证65536
+// 索引表超过时限制每个簇的光源个数 光源多的簇丢掉编号靠后的光源 光源少的簇不受影响
+// 丢掉的个数记在 LightClusterStats::dropped 中
+
+struct LightClusterStats {
+    double assignMs;          // CPU上分配光源的时间
+    unsigned int visible;     // 与视锥体相交的光源
+    unsigned int references;  // 索引表的长度 所有簇中光源个数的和
+    unsigned int dropped;     // 超过 MaxIndices 没有放进索引表的光源编号
+    unsigned int maxPerCluster;
+    unsigned int nonEmpty;    // 至少有一个光源的簇
+};
+
+class LightClusters
+{
+public:
+    unsigned int X, Y, Z;
+    std::vector<unsigned int> Grid;     // 每个簇两个数: 偏移 个数
+    std::vector<unsigned int> Indices;
+    unsigned int GridBuffer, GridTexture;
+    unsigned int IndexBuffer, IndexTexture;
+    unsigned int MaxIndices;            // GL_MAX_TEXTURE_BUFFER_SIZE
+
+    LightClusters(unsigned int x = 16, unsigned int y = 9, unsigned int z = 24)
+        : X(x), Y(y), Z(z), cachedProjection(0.0f), cachedNear(0.0f), cachedFar(0.0f)
+    {
+        Grid.resize(X * Y * Z * 2);
+        clusterLights.resize(X * Y * Z);
+        sliceLights.resize(Z);
+        memset(&stats, 0, sizeof(stats));
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        MaxIndices = (unsigned int)std::max(maxTexels, 1);
+        CreateTexture(GridBuffer, GridTexture, GL_RG32UI);
+        CreateTexture(IndexBuffer, IndexTexture, GL_R32UI);
+    }
+
+    ~LightClusters()
+    {
+        glDeleteTextures(1, &GridTexture);
+        glDeleteTextures(1, &IndexTexture);
+        glDeleteBuffers(1, &GridBuffer);
+        glDeleteBuffers(1, &IndexBuffer);
+    }
+
+    // projection 为对称的透视投影 pool 为NULL时在当前线程完成
+    void Build(const std::vector<PointLight> &lights, const glm::mat4 &view, const glm::mat4 &projection,
+               float near, float far, ThreadPool *pool)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (projection != cachedProjection || near != cachedNear || far != cachedFar)
+            BuildClusterBounds(projection, near, far);
+
+        // 1. 每个光源覆盖的簇的范围
+        bounds.resize(lights.size());
+        unsigned int count = (unsigned int)lights.size();
+        unsigned int chunks = (count + CHUNK - 1) / CHUNK;
+        auto computeChunk = [&](unsigned int chunk, unsigned int) {
+            unsigned int first = chunk * CHUNK;
+            unsigned int last = std::min(first + CHUNK, count);
+            ComputeBounds(lights, view, projection, first, last);
+        };
+        if (pool)
+            pool->Run(chunks, computeChunk);
+        else
+            for (unsigned int c = 0; c < chunks; c++)
+                computeChunk(c, 0);
+
+        // 2. 按深度层分桶
+        for (unsigned int k = 0; k < Z; k++)
+            sliceLights[k].clear();
+        stats.visible = 0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const LightBounds &b = bounds[i];
+            if (!b.visible)
+                continue;
+            stats.visible++;
+            for (int k = b.z0; k <= b.z1; k++)
+                sliceLights[k].push_back(i);
+        }
+        auto assignSlice = [&](unsigned int k, unsigned int) {
+            AssignSlice(k);
+        };
+        if (pool)
+            pool->Run(Z, assignSlice);
+        else
+            for (unsigned int k = 0; k < Z; k++)
+                assignSlice(k, 0);
+
+        // 3. 合并成一个索引表 超过 MaxIndices 时每个簇最多放 limit 个
+        unsigned int limit = ClusterLimit();
+        Indices.clear();
+        stats.maxPerCluster = 0;
+        stats.nonEmpty = 0;
+        stats.dropped = 0;
+        for (unsigned int c = 0; c < X * Y * Z; c++)
+        {
+            const std::vector<unsigned int> &list = clusterLights[c];
+            unsigned int size = std::min((unsigned int)list.size(), limit);
+            Grid[c * 2] = (unsigned int)Indices.size();
+            Grid[c * 2 + 1] = size;
+            Indices.insert(Indices.end(), list.begin(), list.begin() + size);
+            stats.maxPerCluster = std::max(stats.maxPerCluster, size);
+            stats.nonEmpty += list.empty() ? 0 : 1;
+            stats.dropped += (unsigned int)list.size() - size;
+        }
+        stats.references = (unsigned int)Indices.size();
+        stats.assignMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 每帧丢弃旧的存储后上传
+    void Upload()
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, GridBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, Grid.size() * sizeof(unsigned int), Grid.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, IndexBuffer);
+        // 空的缓冲纹理不能读取 至少保留一个元素
+        size_t size = std::max<size_t>(Indices.size(), 1) * sizeof(unsigned int);
+        glBufferData(GL_TEXTURE_BUFFER, size, NULL, GL_STREAM_DRAW);
+        if (!Indices.empty())
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, Indices.size() * sizeof(unsigned int), Indices.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // 着色器中都是 usamplerBuffer
+    void Bind(unsigned int gridUnit, unsigned int indexUnit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + gridUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, GridTexture);
+        glActiveTexture(GL_TEXTURE0 + indexUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, IndexTexture);
+    }
+
+    // 着色器用 floor(log(depth) * SliceScale() - SliceBias()) 计算深度层 与 Slice 相同
+    float SliceScale() const
+    {
+        return Z / logf(cachedFar / cachedNear);
+    }
+
+    float SliceBias() const
+    {
+        return Z * logf(cachedNear) / logf(cachedFar / cachedNear);
+    }
+
+    const LightClusterStats &Stats() const
+    {
+        return stats;
+    }
+
+private:
+    static const unsigned int CHUNK = 256;
+
+    struct LightBounds {
+        glm::vec3 center;  // 观察空间
+        float radius;
+        int x0, x1, y0, y1, z0, z1;
+        bool visible;
+    };
+
+    struct Box {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+    };
+
+    std::vector<LightBounds> bounds;
+    std::vector<Box> clusterBounds;
+    std::vector<std::vector<unsigned int> > sliceLights;
+    std::vector<std::vector<unsigned int> > clusterLights;
+    std::vector<unsigned int> sizes;    // ClusterLimit 排序用
+    glm::mat4 cachedProjection;
+    float cachedNear, cachedFar;
+    float scaleX, scaleY;
+    LightClusterStats stats;
+
+    LightClusters(const LightClusters&);
+    LightClusters &operator=(const LightClusters&);
+
+    static void CreateTexture(unsigned int &buffer, unsigned int &texture, GLenum format)
+    {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 8, NULL, GL_STREAM_DRAW);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // 索引表放得下时不限制 否则找最大的 limit 使 sum(min(簇中的光源个数, limit)) <= MaxIndices
+    // 按光源个数从少到多 放得下的簇全部放进去 剩下的簇平分剩下的空间
+    unsigned int ClusterLimit()
+    {
+        unsigned int clusters = X * Y * Z;
+        size_t total = 0;
+        for (unsigned int c = 0; c < clusters; c++)
+            total += clusterLights[c].size();
+        if (total <= MaxIndices)
+            return ~0u;
+        sizes.resize(clusters);
+        for (unsigned int c = 0; c < clusters; c++)
+            sizes[c] = (unsigned int)clusterLights[c].size();
+        std::sort(sizes.begin(), sizes.end());
+        size_t remaining = MaxIndices;
+        for (unsigned int c = 0; c < clusters; c++)
+        {
+            size_t rest = clusters - c;
+            if ((size_t)sizes[c] * rest > remaining)
+                return (unsigned int)(remaining / rest);
+            remaining -= sizes[c];
+        }
+        return ~0u;
+    }
+
+    float SliceDepth(unsigned int k) const
+    {
+        return cachedNear * powf(cachedFar / cachedNear, (float)k / Z);
+    }
+
+    int Slice(float depth) const
+    {
+        int k = (int)floorf(logf(depth) * SliceScale() - SliceBias());
+        return std::max(0, std::min((int)Z - 1, k));
+    }
+
+    // 投影不变时簇的包围盒也不变 只在投影改变时重新计算
+    // 观察空间中 x = ndc.x * depth / projection[0][0]
+    void BuildClusterBounds(const glm::mat4 &projection, float near, float far)
+    {
+        cachedProjection = projection;
+        cachedNear = near;
+        cachedFar = far;
+        scaleX = projection[0][0];
+        scaleY = projection[1][1];
+        clusterBounds.resize(X * Y * Z);
+        for (unsigned int k = 0; k < Z; k++)
+        {
+            float d0 = SliceDepth(k), d1 = SliceDepth(k + 1);
+            for (unsigned int y = 0; y < Y; y++)
+                for (unsigned int x = 0; x < X; x++)
+                {
+                    float nx0 = -1.0f + 2.0f * x / X, nx1 = -1.0f + 2.0f * (x + 1) / X;
+                    float ny0 = -1.0f + 2.0f * y / Y, ny1 = -1.0f + 2.0f * (y + 1) / Y;
+                    Box &box = clusterBounds[(k * Y + y) * X + x];
+                    box.minimum = glm::vec3(std::min(nx0 * d0, nx0 * d1) / scaleX, std::min(ny0 * d0, ny0 * d1) / scaleY, -d1);
+                    box.maximum = glm::vec3(std::max(nx1 * d0, nx1 * d1) / scaleX, std::max(ny1 * d0, ny1 * d1) / scaleY, -d0);
+                }
+        }
+    }
+
+    // 球在屏幕上的范围: 球的包围盒在最近和最远的深度处投影 取并集 是保守的
+    void FinishBounds(LightBounds &b, float xmin, float xmax, float ymin, float ymax, float d0, float d1) const
+    {
+        b.visible = d1 >= cachedNear && d0 <= cachedFar && xmax >= -1.0f && xmin <= 1.0f && ymax >= -1.0f && ymin <= 1.0f;
+        if (!b.visible)
+            return;
+        b.x0 = std::max(0, (int)floorf((xmin + 1.0f) * 0.5f * X));
+        b.x1 = std::min((int)X - 1, (int)floorf((xmax + 1.0f) * 0.5f * X));
+        b.y0 = std::max(0, (int)floorf((ymin + 1.0f) * 0.5f * Y));
+        b.y1 = std::min((int)Y - 1, (int)floorf((ymax + 1.0f) * 0.5f * Y));
+        b.z0 = Slice(std::max(d0, cachedNear));
+        b.z1 = Slice(std::min(d1, cachedFar));
+    }
+
+    void ComputeBounds(const std::vector<PointLight> &lights, const glm::mat4 &view, const glm::mat4 &projection,
+                       unsigned int first, unsigned int last)
+    {
+        unsigned int i = first;
+#ifdef LIGHT_CLUSTERS_SSE
+        // 4个光源一组 结构体数组转成每个分量一个寄存器(SoA)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 nearPlane = _mm_set1_ps(cachedNear);
+        const __m128 sx = _mm_set1_ps(scaleX), sy = _mm_set1_ps(scaleY);
+        for (; i + 4 <= last; i += 4)
+        {
+            const PointLight *l = &lights[i];
+            __m128 px = _mm_set_ps(l[3].position.x, l[2].position.x, l[1].position.x, l[0].position.x);
+            __m128 py = _mm_set_ps(l[3].position.y, l[2].position.y, l[1].position.y, l[0].position.y);
+            __m128 pz = _mm_set_ps(l[3].position.z, l[2].position.z, l[1].position.z, l[0].position.z);
+            __m128 r = _mm_set_ps(l[3].radius, l[2].radius, l[1].radius, l[0].radius);
+            // 观察矩阵 view[列][行]
+            __m128 vx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(view[0][0])), _mm_mul_ps(py, _mm_set1_ps(view[1][0]))),
+                                   _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(view[2][0])), _mm_set1_ps(view[3][0])));
+            __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(view[0][1])), _mm_mul_ps(py, _mm_set1_ps(view[1][1]))),
+                                   _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(view[2][1])), _mm_set1_ps(view[3][1])));
+            __m128 vz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(view[0][2])), _mm_mul_ps(py, _mm_set1_ps(view[1][2]))),
+                                   _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(view[2][2])), _mm_set1_ps(view[3][2])));
+            __m128 depth = _mm_sub_ps(zero, vz);
+            __m128 d0 = _mm_sub_ps(depth, r);
+            __m128 d1 = _mm_add_ps(depth, r);
+            // 投影时深度不能小于近平面
+            __m128 n0 = _mm_max_ps(d0, nearPlane);
+            __m128 n1 = _mm_max_ps(d1, nearPlane);
+            __m128 inv0 = _mm_div_ps(_mm_set1_ps(1.0f), n0);
+            __m128 inv1 = _mm_div_ps(_mm_set1_ps(1.0f), n1);
+            __m128 left = _mm_mul_ps(_mm_sub_ps(vx, r), sx), right = _mm_mul_ps(_mm_add_ps(vx, r), sx);
+            __m128 bottom = _mm_mul_ps(_mm_sub_ps(vy, r), sy), top = _mm_mul_ps(_mm_add_ps(vy, r), sy);
+            __m128 xmin = _mm_min_ps(_mm_mul_ps(left, inv0), _mm_mul_ps(left, inv1));
+            __m128 xmax = _mm_max_ps(_mm_mul_ps(right, inv0), _mm_mul_ps(right, inv1));
+            __m128 ymin = _mm_min_ps(_mm_mul_ps(bottom, inv0), _mm_mul_ps(bottom, inv1));
+            __m128 ymax = _mm_max_ps(_mm_mul_ps(top, inv0), _mm_mul_ps(top, inv1));
+
+            alignas(16) float out[10][4];
+            _mm_store_ps(out[0], vx);
+            _mm_store_ps(out[1], vy);
+            _mm_store_ps(out[2], vz);
+            _mm_store_ps(out[3], r);
+            _mm_store_ps(out[4], xmin);
+            _mm_store_ps(out[5], xmax);
+            _mm_store_ps(out[6], ymin);
+            _mm_store_ps(out[7], ymax);
+            _mm_store_ps(out[8], d0);
+            _mm_store_ps(out[9], d1);
+            for (int j = 0; j < 4; j++)
+            {
+                LightBounds &b = bounds[i + j];
+                b.center = glm::vec3(out[0][j], out[1][j], out[2][j]);
+                b.radius = out[3][j];
+                FinishBounds(b, out[4][j], out[5][j], out[6][j], out[7][j], out[8][j], out[9][j]);
+            }
+        }
+#endif
+        // 剩下的不足4个(或者没有SSE时全部)逐个计算
+        for (; i < last; i++)
+        {
+            LightBounds &b = bounds[i];
+            b.center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+            b.radius = lights[i].radius;
+            float d0 = -b.center.z - b.radius, d1 = -b.center.z + b.radius;
+            float inv0 = 1.0f / std::max(d0, cachedNear), inv1 = 1.0f / std::max(d1, cachedNear);
+            float left = (b.center.x - b.radius) * scaleX, right = (b.center.x + b.radius) * scaleX;
+            float bottom = (b.center.y - b.radius) * scaleY, top = (b.center.y + b.radius) * scaleY;
+            FinishBounds(b, std::min(left * inv0, left * inv1), std::max(right * inv0, right * inv1),
+                         std::min(bottom * inv0, bottom * inv1), std::max(top * inv0, top * inv1), d0, d1);
+        }
+        (void)projection;
+    }
+
+    // 第k层: 范围内的每个簇做球与包围盒的相交测试
+    void AssignSlice(unsigned int k)
+    {
+        for (unsigned int c = k * X * Y; c < (k + 1) * X * Y; c++)
+            clusterLights[c].clear();
+        const std::vector<unsigned int> &lights = sliceLights[k];
+        for (size_t n = 0; n < lights.size(); n++)
+        {
+            const LightBounds &b = bounds[lights[n]];
+            float radius2 = b.radius * b.radius;
+            for (int y = b.y0; y <= b.y1; y++)
+                for (int x = b.x0; x <= b.x1; x++)
+                {
+                    unsigned int c = (k * Y + y) * X + x;
+                    const Box &box = clusterBounds[c];
+                    glm::vec3 closest = glm::clamp(b.center, box.minimum, box.maximum);
+                    glm::vec3 offset = closest - b.center;
+                    if (glm::dot(offset, offset) <= radius2)
+                        clusterLights[c].push_back(lights[n]);
+                }
+        }
+    }
+};
+
+#endif
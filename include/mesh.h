@@ -0,0 +1,237 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <vector>
+#include <cmath>
+
+// 带索引的网格数据
+// 顶点布局与章节中的 float vertices[] 相同: 位置(3) 法线(3) 纹理坐标(2) 每个顶点8个float
+struct MeshData {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    unsigned int VertexCount() const
+    {
+        return (unsigned int)(vertices.size() / 8);
+    }
+
+    void AddVertex(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &texCoords)
+    {
+        vertices.push_back(position.x);
+        vertices.push_back(position.y);
+        vertices.push_back(position.z);
+        vertices.push_back(normal.x);
+        vertices.push_back(normal.y);
+        vertices.push_back(normal.z);
+        vertices.push_back(texCoords.x);
+        vertices.push_back(texCoords.y);
+    }
+};
+
+// 把顶点和索引上传到新的VAO/VBO/EBO 顶点属性与章节相同
+// vertexFloats 是float的个数 每个顶点8个
+inline void UploadMesh(const float *vertices, size_t vertexFloats, const unsigned int *indices, size_t indexCount,
+                       unsigned int &VAO, unsigned int &VBO, unsigned int &EBO)
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexFloats * sizeof(float), vertices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+}
+
+inline void UploadMesh(const MeshData &mesh, unsigned int &VAO, unsigned int &VBO, unsigned int &EBO)
+{
+    UploadMesh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), VAO, VBO, EBO);
+}
+
+// 以下生成几种基本形状 尺寸都在 [-0.5, 0.5] 内 与章节中的立方体一致
+
+// 立方体 每个面4个顶点 共24个顶点 36个索引
+inline MeshData MakeCube()
+{
+    MeshData mesh;
+    glm::vec3 normals[] = {
+        glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3( 0.0f,  0.0f,  1.0f),
+        glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 1.0f,  0.0f,  0.0f),
+        glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f,  1.0f,  0.0f)
+    };
+    for (int f = 0; f < 6; f++)
+    {
+        glm::vec3 n = normals[f];
+        // 面上的两个切线方向
+        glm::vec3 u = glm::abs(n.y) > 0.5f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), n);
+        glm::vec3 v = glm::cross(n, u);
+        unsigned int base = mesh.VertexCount();
+        glm::vec2 corners[] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+        for (int c = 0; c < 4; c++)
+        {
+            glm::vec3 p = 0.5f * n + (corners[c].x - 0.5f) * u + (corners[c].y - 0.5f) * v;
+            mesh.AddVertex(p, n, corners[c]);
+        }
+        unsigned int quad[] = { 0, 1, 2, 2, 3, 0 };
+        for (int i = 0; i < 6; i++)
+            mesh.indices.push_back(base + quad[i]);
+    }
+    return mesh;
+}
+
+// 经纬度球 stacks * slices 个四边形
+inline MeshData MakeSphere(unsigned int slices = 32, unsigned int stacks = 16)
+{
+    MeshData mesh;
+    for (unsigned int y = 0; y <= stacks; y++)
+    {
+        float v = (float)y / stacks;
+        float phi = v * glm::pi<float>();
+        for (unsigned int x = 0; x <= slices; x++)
+        {
+            float u = (float)x / slices;
+            float theta = u * 2.0f * glm::pi<float>();
+            glm::vec3 n(cosf(theta) * sinf(phi), cosf(phi), sinf(theta) * sinf(phi));
+            mesh.AddVertex(0.5f * n, n, glm::vec2(u, 1.0f - v));
+        }
+    }
+    for (unsigned int y = 0; y < stacks; y++)
+    {
+        for (unsigned int x = 0; x < slices; x++)
+        {
+            unsigned int a = y * (slices + 1) + x;
+            unsigned int b = a + slices + 1;
+            mesh.indices.push_back(a);
+            mesh.indices.push_back(a + 1);
+            mesh.indices.push_back(b);
+            mesh.indices.push_back(b);
+            mesh.indices.push_back(a + 1);
+            mesh.indices.push_back(b + 1);
+        }
+    }
+    return mesh;
+}
+
+// 圆柱 侧面加上下两个盖子
+inline MeshData MakeCylinder(unsigned int slices = 32)
+{
+    MeshData mesh;
+    for (unsigned int x = 0; x <= slices; x++)
+    {
+        float u = (float)x / slices;
+        float theta = u * 2.0f * glm::pi<float>();
+        glm::vec3 n(cosf(theta), 0.0f, sinf(theta));
+        mesh.AddVertex(glm::vec3(0.5f * n.x, -0.5f, 0.5f * n.z), n, glm::vec2(u, 0.0f));
+        mesh.AddVertex(glm::vec3(0.5f * n.x,  0.5f, 0.5f * n.z), n, glm::vec2(u, 1.0f));
+    }
+    for (unsigned int x = 0; x < slices; x++)
+    {
+        unsigned int a = x * 2;
+        mesh.indices.push_back(a);
+        mesh.indices.push_back(a + 1);
+        mesh.indices.push_back(a + 2);
+        mesh.indices.push_back(a + 2);
+        mesh.indices.push_back(a + 1);
+        mesh.indices.push_back(a + 3);
+    }
+    for (int side = 0; side < 2; side++)
+    {
+        float y = side == 0 ? -0.5f : 0.5f;
+        glm::vec3 n(0.0f, side == 0 ? -1.0f : 1.0f, 0.0f);
+        unsigned int center = mesh.VertexCount();
+        mesh.AddVertex(glm::vec3(0.0f, y, 0.0f), n, glm::vec2(0.5f, 0.5f));
+        for (unsigned int x = 0; x <= slices; x++)
+        {
+            float theta = (float)x / slices * 2.0f * glm::pi<float>();
+            mesh.AddVertex(glm::vec3(0.5f * cosf(theta), y, 0.5f * sinf(theta)), n,
+                           glm::vec2(0.5f + 0.5f * cosf(theta), 0.5f + 0.5f * sinf(theta)));
+        }
+        for (unsigned int x = 0; x < slices; x++)
+        {
+            mesh.indices.push_back(center);
+            // 保证两个盖子都是逆时针环绕
+            mesh.indices.push_back(center + 1 + (side == 0 ? x : x + 1));
+            mesh.indices.push_back(center + 1 + (side == 0 ? x + 1 : x));
+        }
+    }
+    return mesh;
+}
+
+// 圆环 major为环的半径 minor为管的半径
+inline MeshData MakeTorus(unsigned int rings = 32, unsigned int sides = 16, float major = 0.35f, float minor = 0.15f)
+{
+    MeshData mesh;
+    for (unsigned int i = 0; i <= rings; i++)
+    {
+        float u = (float)i / rings;
+        float theta = u * 2.0f * glm::pi<float>();
+        glm::vec3 center(major * cosf(theta), 0.0f, major * sinf(theta));
+        for (unsigned int j = 0; j <= sides; j++)
+        {
+            float v = (float)j / sides;
+            float phi = v * 2.0f * glm::pi<float>();
+            glm::vec3 n(cosf(phi) * cosf(theta), sinf(phi), cosf(phi) * sinf(theta));
+            mesh.AddVertex(center + minor * n, n, glm::vec2(u, v));
+        }
+    }
+    for (unsigned int i = 0; i < rings; i++)
+    {
+        for (unsigned int j = 0; j < sides; j++)
+        {
+            unsigned int a = i * (sides + 1) + j;
+            unsigned int b = a + sides + 1;
+            mesh.indices.push_back(a);
+            mesh.indices.push_back(a + 1);
+            mesh.indices.push_back(b);
+            mesh.indices.push_back(b);
+            mesh.indices.push_back(a + 1);
+            mesh.indices.push_back(b + 1);
+        }
+    }
+    return mesh;
+}
+
+// 四棱锥
+inline MeshData MakePyramid()
+{
+    MeshData mesh;
+    glm::vec3 apex(0.0f, 0.5f, 0.0f);
+    glm::vec3 base[] = {
+        glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3( 0.5f, -0.5f, -0.5f),
+        glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(-0.5f, -0.5f,  0.5f)
+    };
+    for (int i = 0; i < 4; i++)
+    {
+        glm::vec3 a = base[i], b = base[(i + 1) % 4];
+        glm::vec3 n = glm::normalize(glm::cross(a - b, apex - b));
+        unsigned int first = mesh.VertexCount();
+        mesh.AddVertex(b, n, glm::vec2(0.0f, 0.0f));
+        mesh.AddVertex(a, n, glm::vec2(1.0f, 0.0f));
+        mesh.AddVertex(apex, n, glm::vec2(0.5f, 1.0f));
+        mesh.indices.push_back(first);
+        mesh.indices.push_back(first + 1);
+        mesh.indices.push_back(first + 2);
+    }
+    unsigned int first = mesh.VertexCount();
+    for (int i = 0; i < 4; i++)
+        mesh.AddVertex(base[i], glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(base[i].x + 0.5f, base[i].z + 0.5f));
+    unsigned int quad[] = { 0, 1, 2, 2, 3, 0 };
+    for (int i = 0; i < 6; i++)
+        mesh.indices.push_back(first + quad[i]);
+    return mesh;
+}
+
+#endif
@@ -0,0 +1,317 @@
+#ifndef MESH_BATCHER_H
+#define MESH_BATCHER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#include "gl_ext.h"
+#include "mesh.h"
+#include "shader_m.h"
+
+// 多重间接绘制(Multi-draw indirect)
+// 所有网格的顶点和索引放进同一个大VBO和EBO 共用一个VAO
+// 每次绘制只是一条 DrawElementsIndirectCommand 记录 写进间接缓冲
+// 整个pass用一次 glMultiDrawElementsIndirect 提交
+// 每次绘制的数据(模型矩阵 法线矩阵)放在缓冲纹理里 着色器用 gl_DrawID 取出
+//
+// 间接缓冲和绘制数据缓冲是持久映射的(GL_MAP_PERSISTENT_BIT) 只映射一次
+// 分成 FRAMES 份轮流使用 每份用一个fence保护 CPU不会改写GPU还在读的部分
+//
+// 缓冲纹理的大小受 GL_MAX_TEXTURE_BUFFER_SIZE 限制 GL只保证65536个texel(约9362次绘制)
+// 超过时每份绘制数据分成几个缓冲纹理 Submit 分几次提交 每次的 gl_DrawID 从0开始
+//
+// 驱动不支持时(低于GL 4.3/4.4 又没有对应扩展) 退回到逐个 glDrawElementsBaseVertex
+// 这时着色器用 uniform int drawID 代替 gl_DrawID
+
+struct MeshRange {
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLint baseVertex;
+};
+
+class MeshBatcher
+{
+public:
+    static const unsigned int FRAMES = 3;
+    // 每次绘制占用的缓冲纹理texel数 RGBA32F
+    // 0~3: 模型矩阵的四列  4~6: 法线矩阵的三列
+    static const unsigned int DRAW_DATA_TEXELS = 7;
+
+    unsigned int VAO, VBO, EBO;
+    unsigned int IndirectBuffer;
+    // 第 frame 份的第 batch 个缓冲纹理在 frame * Batches + batch
+    std::vector<unsigned int> DrawDataBuffers;
+    std::vector<unsigned int> DrawDataTextures;
+    unsigned int MaxDraws;
+    // 一个缓冲纹理能放下的绘制数 和每帧需要的缓冲纹理数
+    unsigned int DrawsPerBatch;
+    unsigned int Batches;
+    std::vector<MeshRange> Meshes;
+    // 是否使用 glMultiDrawElementsIndirect 与持久映射
+    bool UseMultiDraw;
+    bool Persistent;
+
+    MeshBatcher(unsigned int maxDraws) : MaxDraws(maxDraws), frame(0), drawCount(0)
+    {
+        UseMultiDraw = glext.MultiDrawIndirect && glext.ShaderDrawParameters;
+        Persistent = glext.BufferStorage;
+        for (unsigned int i = 0; i < FRAMES; i++)
+            fences[i] = 0;
+        if (MaxDraws == 0)
+            MaxDraws = 1;
+
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        DrawsPerBatch = std::max(1u, std::min(MaxDraws, (unsigned int)maxTexels / DRAW_DATA_TEXELS));
+        Batches = (MaxDraws + DrawsPerBatch - 1) / DrawsPerBatch;
+        if (Batches > 1)
+            std::cout << "MeshBatcher: " << MaxDraws << " draws need " << (size_t)MaxDraws * DRAW_DATA_TEXELS
+                      << " texels, GL_MAX_TEXTURE_BUFFER_SIZE is " << maxTexels << ", submitting in " << Batches << " batches" << std::endl;
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glGenBuffers(1, &IndirectBuffer);
+        DrawDataBuffers.resize(FRAMES * Batches);
+        DrawDataTextures.resize(FRAMES * Batches);
+        mappedData.assign(FRAMES * Batches, NULL);
+        glGenBuffers((GLsizei)DrawDataBuffers.size(), DrawDataBuffers.data());
+        glGenTextures((GLsizei)DrawDataTextures.size(), DrawDataTextures.data());
+
+        GLsizeiptr commandBytes = (GLsizeiptr)FRAMES * MaxDraws * sizeof(DrawElementsIndirectCommand);
+        GLsizeiptr dataBytes = (GLsizeiptr)DrawsPerBatch * DRAW_DATA_TEXELS * sizeof(glm::vec4);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        if (UseMultiDraw)
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+            if (Persistent)
+            {
+                glext.BufferStorageFn(GL_DRAW_INDIRECT_BUFFER, commandBytes, NULL, flags);
+                mappedCommands = (DrawElementsIndirectCommand*)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, commandBytes, flags);
+            }
+            else
+            {
+                glBufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, NULL, GL_STREAM_DRAW);
+            }
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        }
+        if (!Persistent || !UseMultiDraw)
+            stagingCommands.resize((size_t)MaxDraws);
+
+        for (unsigned int i = 0; i < DrawDataBuffers.size(); i++)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, DrawDataBuffers[i]);
+            if (Persistent)
+            {
+                glext.BufferStorageFn(GL_TEXTURE_BUFFER, dataBytes, NULL, flags);
+                mappedData[i] = (glm::vec4*)glMapBufferRange(GL_TEXTURE_BUFFER, 0, dataBytes, flags);
+            }
+            else
+            {
+                glBufferData(GL_TEXTURE_BUFFER, dataBytes, NULL, GL_STREAM_DRAW);
+            }
+            glBindTexture(GL_TEXTURE_BUFFER, DrawDataTextures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, DrawDataBuffers[i]);
+        }
+        if (!Persistent)
+            stagingData.resize((size_t)MaxDraws * DRAW_DATA_TEXELS);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~MeshBatcher()
+    {
+        for (unsigned int i = 0; i < FRAMES; i++)
+        {
+            if (fences[i])
+                glDeleteSync(fences[i]);
+        }
+        if (Persistent)
+        {
+            if (UseMultiDraw)
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+                glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+            }
+            for (unsigned int i = 0; i < DrawDataBuffers.size(); i++)
+            {
+                glBindBuffer(GL_TEXTURE_BUFFER, DrawDataBuffers[i]);
+                glUnmapBuffer(GL_TEXTURE_BUFFER);
+            }
+        }
+        glDeleteTextures((GLsizei)DrawDataTextures.size(), DrawDataTextures.data());
+        glDeleteBuffers((GLsizei)DrawDataBuffers.size(), DrawDataBuffers.data());
+        glDeleteBuffers(1, &IndirectBuffer);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+
+    // 把网格追加到大缓冲中 返回网格编号 所有网格加完后调用 Build
+    unsigned int AddMesh(const MeshData &mesh)
+    {
+        MeshRange range;
+        range.firstIndex = (GLuint)indices.size();
+        range.indexCount = (GLuint)mesh.indices.size();
+        range.baseVertex = (GLint)(vertices.size() / 8);
+        vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+        indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+        Meshes.push_back(range);
+        return (unsigned int)Meshes.size() - 1;
+    }
+
+    // 上传大VBO和EBO 设置与章节相同的顶点属性
+    void Build()
+    {
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 3));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(sizeof(float) * 6));
+        glEnableVertexAttribArray(2);
+        glBindVertexArray(0);
+
+        vertices.clear();
+        vertices.shrink_to_fit();
+        indices.clear();
+        indices.shrink_to_fit();
+    }
+
+    // 开始新的一帧 等待这一份缓冲上一次的绘制完成
+    void Begin()
+    {
+        frame = (frame + 1) % FRAMES;
+        drawCount = 0;
+        if (fences[frame])
+        {
+            GLenum result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            glDeleteSync(fences[frame]);
+            fences[frame] = 0;
+        }
+    }
+
+    // 记录一次绘制 超过 MaxDraws 的部分被丢弃
+    void Draw(unsigned int mesh, const glm::mat4 &model)
+    {
+        if (drawCount >= MaxDraws)
+            return;
+        const MeshRange &range = Meshes[mesh];
+        DrawElementsIndirectCommand *command = currentCommands() + drawCount;
+        command->count = range.indexCount;
+        command->instanceCount = 1;
+        command->firstIndex = range.firstIndex;
+        command->baseVertex = range.baseVertex;
+        command->baseInstance = 0;
+
+        glm::vec4 *data = currentData(drawCount);
+        glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(model));
+        data[0] = model[0];
+        data[1] = model[1];
+        data[2] = model[2];
+        data[3] = model[3];
+        data[4] = glm::vec4(normalMatrix[0], 0.0f);
+        data[5] = glm::vec4(normalMatrix[1], 0.0f);
+        data[6] = glm::vec4(normalMatrix[2], 0.0f);
+        drawCount++;
+    }
+
+    // 提交本帧记录的所有绘制 绘制数据分成几个缓冲纹理时分几次提交
+    // shader 需要有 uniform samplerBuffer drawData 退回时还需要 uniform int drawID
+    void Submit(const Shader &shader, int textureUnit = 2)
+    {
+        glBindVertexArray(VAO);
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        shader.setInt("drawData", textureUnit);
+        GLintptr commandOffset = (GLintptr)frame * MaxDraws * sizeof(DrawElementsIndirectCommand);
+        if (UseMultiDraw)
+        {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IndirectBuffer);
+            if (!Persistent)
+                glBufferSubData(GL_DRAW_INDIRECT_BUFFER, commandOffset, (GLsizeiptr)drawCount * sizeof(DrawElementsIndirectCommand), stagingCommands.data());
+        }
+        GLint location = UseMultiDraw ? -1 : glGetUniformLocation(shader.ID, "drawID");
+        for (unsigned int first = 0, batch = 0; first < drawCount; first += DrawsPerBatch, batch++)
+        {
+            unsigned int count = std::min(DrawsPerBatch, drawCount - first);
+            unsigned int index = frame * Batches + batch;
+            if (!Persistent)
+            {
+                glBindBuffer(GL_TEXTURE_BUFFER, DrawDataBuffers[index]);
+                glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)count * DRAW_DATA_TEXELS * sizeof(glm::vec4),
+                                stagingData.data() + (size_t)first * DRAW_DATA_TEXELS);
+                glBindBuffer(GL_TEXTURE_BUFFER, 0);
+            }
+            glBindTexture(GL_TEXTURE_BUFFER, DrawDataTextures[index]);
+
+            if (UseMultiDraw)
+            {
+                GLintptr offset = commandOffset + (GLintptr)first * sizeof(DrawElementsIndirectCommand);
+                glext.MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)offset, (GLsizei)count, 0);
+            }
+            else
+            {
+                for (unsigned int i = 0; i < count; i++)
+                {
+                    const DrawElementsIndirectCommand &command = stagingCommands[first + i];
+                    glUniform1i(location, (GLint)i);
+                    glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                             (void*)(command.firstIndex * sizeof(unsigned int)), command.baseVertex);
+                }
+            }
+        }
+        if (UseMultiDraw)
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        // 同一帧多次 Submit 时 新的fence已经包含了前面的绘制 旧的直接删除
+        if (fences[frame])
+            glDeleteSync(fences[frame]);
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    unsigned int DrawCount() const
+    {
+        return drawCount;
+    }
+
+private:
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    unsigned int frame;
+    unsigned int drawCount;
+    GLsync fences[FRAMES];
+    DrawElementsIndirectCommand *mappedCommands = NULL;
+    std::vector<glm::vec4*> mappedData;
+    std::vector<DrawElementsIndirectCommand> stagingCommands;
+    std::vector<glm::vec4> stagingData;
+
+    DrawElementsIndirectCommand *currentCommands()
+    {
+        if (UseMultiDraw && Persistent)
+            return mappedCommands + (size_t)frame * MaxDraws;
+        return stagingCommands.data();
+    }
+
+    // 第 draw 次绘制的数据写在哪里
+    glm::vec4 *currentData(unsigned int draw)
+    {
+        if (Persistent)
+            return mappedData[frame * Batches + draw / DrawsPerBatch] + (size_t)(draw % DrawsPerBatch) * DRAW_DATA_TEXELS;
+        return stagingData.data() + (size_t)draw * DRAW_DATA_TEXELS;
+    }
+};
+
+#endif
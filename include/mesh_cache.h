@@ -0,0 +1,306 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include <sys/stat.h>
+
+#include "mesh.h"
+#include "model_loader.h"
+
+// 二进制网格缓存
+// 文件中的顶点已经是章节使用的布局(位置 法线 纹理坐标 每个顶点32字节) 索引是32位无符号整数
+// 读取时 mmap 整个文件 直接把映射的指针交给 glBufferData 不对顶点做任何处理
+//
+// 文件结构(小端序):
+//   MeshCacheHeader
+//   MeshCacheLod[lodCount]   每一级细节在索引缓冲中的范围
+//   顶点数据 vertexCount * 32 字节
+//   索引数据 indexCount * 4 字节
+// 每一段都按64字节对齐
+
+const char MESH_CACHE_MAGIC[8] = { 'L', 'O', 'G', 'L', 'M', 'E', 'S', 'H' };
+// 格式有变化时增加版本号 旧的缓存会被拒绝 重新从模型文件生成
+// 2: MeshCacheLod 中存放几何误差 而不是切换距离
+const uint32_t MESH_CACHE_VERSION = 2;
+const uint32_t MESH_CACHE_VERTEX_STRIDE = 8 * sizeof(float);
+const uint64_t MESH_CACHE_ALIGNMENT = 64;
+
+// 一级细节: 使用索引缓冲中 [firstIndex, firstIndex + indexCount) 的三角形
+// error 是这一级与原始网格的最大偏差(模型空间的长度) 第0级为0
+// 切换距离还取决于视野和屏幕大小 在运行时由误差算出
+struct MeshCacheLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+    uint32_t reserved;
+};
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t lodOffset;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+};
+
+static_assert(sizeof(MeshCacheLod) == 16, "MeshCacheLod must be 16 bytes");
+static_assert(sizeof(MeshCacheHeader) == 88, "MeshCacheHeader must be 88 bytes");
+
+inline uint64_t AlignMeshCacheOffset(uint64_t offset)
+{
+    return (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+// 写入缓存 lods 为空时只有一级 即整个网格
+// 先写到临时文件再重命名 读取的一方不会看到写了一半的文件
+inline bool WriteMeshCache(const char *path, const MeshData &mesh, const std::vector<MeshCacheLod> &lods = std::vector<MeshCacheLod>())
+{
+    std::vector<MeshCacheLod> levels = lods;
+    if (levels.empty())
+    {
+        MeshCacheLod lod = { 0, (uint32_t)mesh.indices.size(), 0.0f, 0 };
+        levels.push_back(lod);
+    }
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        if ((uint64_t)levels[i].firstIndex + levels[i].indexCount > mesh.indices.size())
+        {
+            std::cout << "ERROR::MESH_CACHE::LOD_OUT_OF_RANGE" << std::endl;
+            return false;
+        }
+    }
+
+    MeshCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.headerSize = sizeof(MeshCacheHeader);
+    header.vertexStride = MESH_CACHE_VERTEX_STRIDE;
+    header.vertexCount = mesh.VertexCount();
+    header.indexCount = (uint32_t)mesh.indices.size();
+    header.lodCount = (uint32_t)levels.size();
+    glm::vec3 minimum(0.0f), maximum(0.0f);
+    for (unsigned int i = 0; i < header.vertexCount; i++)
+    {
+        glm::vec3 p(mesh.vertices[i * 8], mesh.vertices[i * 8 + 1], mesh.vertices[i * 8 + 2]);
+        minimum = i == 0 ? p : glm::min(minimum, p);
+        maximum = i == 0 ? p : glm::max(maximum, p);
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        header.boundsMin[k] = minimum[k];
+        header.boundsMax[k] = maximum[k];
+    }
+    header.lodOffset = AlignMeshCacheOffset(sizeof(MeshCacheHeader));
+    header.vertexOffset = AlignMeshCacheOffset(header.lodOffset + levels.size() * sizeof(MeshCacheLod));
+    header.indexOffset = AlignMeshCacheOffset(header.vertexOffset + (uint64_t)header.vertexCount * MESH_CACHE_VERTEX_STRIDE);
+    header.fileSize = header.indexOffset + (uint64_t)header.indexCount * sizeof(uint32_t);
+
+    std::string temporary = std::string(path) + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (file == NULL)
+    {
+        std::cout << "ERROR::MESH_CACHE::FILE_NOT_SUCCESFULLY_WRITTEN " << path << std::endl;
+        return false;
+    }
+    const char zeros[MESH_CACHE_ALIGNMENT] = { 0 };
+    uint64_t written = 0;
+    bool ok = true;
+    // 补零到 offset 再写入一段数据
+    auto writeAt = [&](uint64_t offset, const void *data, size_t size) {
+        if (offset > written)
+            ok = ok && fwrite(zeros, 1, (size_t)(offset - written), file) == offset - written;
+        if (size)
+            ok = ok && fwrite(data, 1, size, file) == size;
+        written = offset + size;
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.lodOffset, levels.data(), levels.size() * sizeof(MeshCacheLod));
+    writeAt(header.vertexOffset, mesh.vertices.data(), (size_t)header.vertexCount * MESH_CACHE_VERTEX_STRIDE);
+    writeAt(header.indexOffset, mesh.indices.data(), (size_t)header.indexCount * sizeof(uint32_t));
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), path) != 0)
+    {
+        remove(temporary.c_str());
+        std::cout << "ERROR::MESH_CACHE::FILE_NOT_SUCCESFULLY_WRITTEN " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// 只读打开缓存文件 所有指针都指向映射的内存 对象销毁后失效
+class MeshCache
+{
+public:
+    MeshCache(const char *path) : file(path), header(NULL)
+    {
+        if (!file.IsOpen())
+        {
+            std::cout << "ERROR::MESH_CACHE::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+            return;
+        }
+        if (file.Size < sizeof(MeshCacheHeader))
+        {
+            std::cout << "ERROR::MESH_CACHE::FILE_TOO_SMALL " << path << std::endl;
+            return;
+        }
+        const MeshCacheHeader *h = (const MeshCacheHeader*)file.Data;
+        if (memcmp(h->magic, MESH_CACHE_MAGIC, sizeof(h->magic)) != 0)
+        {
+            std::cout << "ERROR::MESH_CACHE::NOT_A_MESH_CACHE " << path << std::endl;
+            return;
+        }
+        if (h->version != MESH_CACHE_VERSION || h->headerSize != sizeof(MeshCacheHeader) || h->vertexStride != MESH_CACHE_VERTEX_STRIDE)
+        {
+            std::cout << "ERROR::MESH_CACHE::VERSION_MISMATCH " << path << " (version " << h->version << ")" << std::endl;
+            return;
+        }
+        // 文件可能被截断或者损坏 每一段都要在文件范围内
+        if (h->fileSize != file.Size ||
+            h->lodOffset + (uint64_t)h->lodCount * sizeof(MeshCacheLod) > file.Size ||
+            h->vertexOffset + (uint64_t)h->vertexCount * MESH_CACHE_VERTEX_STRIDE > file.Size ||
+            h->indexOffset + (uint64_t)h->indexCount * sizeof(uint32_t) > file.Size ||
+            h->lodCount == 0)
+        {
+            std::cout << "ERROR::MESH_CACHE::FILE_CORRUPTED " << path << std::endl;
+            return;
+        }
+        const MeshCacheLod *lods = (const MeshCacheLod*)(file.Data + h->lodOffset);
+        for (uint32_t i = 0; i < h->lodCount; i++)
+        {
+            if ((uint64_t)lods[i].firstIndex + lods[i].indexCount > h->indexCount)
+            {
+                std::cout << "ERROR::MESH_CACHE::FILE_CORRUPTED " << path << std::endl;
+                return;
+            }
+        }
+        // 损坏的索引会让GPU读到顶点缓冲之外 检查一遍 比上传本身快得多
+        const uint32_t *indices = (const uint32_t*)(file.Data + h->indexOffset);
+        for (uint32_t i = 0; i < h->indexCount; i++)
+        {
+            if (indices[i] >= h->vertexCount)
+            {
+                std::cout << "ERROR::MESH_CACHE::INDEX_OUT_OF_RANGE " << path << " (index " << i << ")" << std::endl;
+                return;
+            }
+        }
+        header = h;
+    }
+
+    bool IsValid() const
+    {
+        return header != NULL;
+    }
+
+    unsigned int VertexCount() const
+    {
+        return header->vertexCount;
+    }
+
+    unsigned int IndexCount() const
+    {
+        return header->indexCount;
+    }
+
+    unsigned int LodCount() const
+    {
+        return header->lodCount;
+    }
+
+    const MeshCacheLod &Lod(unsigned int level) const
+    {
+        return ((const MeshCacheLod*)(file.Data + header->lodOffset))[level];
+    }
+
+    const float *Vertices() const
+    {
+        return (const float*)(file.Data + header->vertexOffset);
+    }
+
+    const unsigned int *Indices() const
+    {
+        return (const unsigned int*)(file.Data + header->indexOffset);
+    }
+
+    glm::vec3 BoundsMin() const
+    {
+        return glm::vec3(header->boundsMin[0], header->boundsMin[1], header->boundsMin[2]);
+    }
+
+    glm::vec3 BoundsMax() const
+    {
+        return glm::vec3(header->boundsMax[0], header->boundsMax[1], header->boundsMax[2]);
+    }
+
+    size_t SizeInBytes() const
+    {
+        return file.Size;
+    }
+
+    // 映射的内存直接作为 glBufferData 的数据源
+    void Upload(unsigned int &VAO, unsigned int &VBO, unsigned int &EBO) const
+    {
+        UploadMesh(Vertices(), (size_t)header->vertexCount * 8, Indices(), header->indexCount, VAO, VBO, EBO);
+    }
+
+    // 需要在CPU上处理网格时复制一份
+    MeshData ToMeshData() const
+    {
+        MeshData mesh;
+        mesh.vertices.assign(Vertices(), Vertices() + (size_t)header->vertexCount * 8);
+        mesh.indices.assign(Indices(), Indices() + header->indexCount);
+        return mesh;
+    }
+
+private:
+    MappedFile file;
+    const MeshCacheHeader *header;
+};
+
+// 缓存不存在 比模型文件旧 或者文件头不是当前的格式(旧版本 损坏)时需要重新生成
+// 文件头之后的内容由 MeshCache 检查 打不开时章节再重新生成一次
+inline bool MeshCacheIsStale(const char *cachePath, const char *sourcePath)
+{
+    struct stat cacheStat, sourceStat;
+    if (stat(cachePath, &cacheStat) != 0)
+        return true;
+    MeshCacheHeader header;
+    FILE *file = fopen(cachePath, "rb");
+    if (file == NULL)
+        return true;
+    bool complete = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+    if (!complete || memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION ||
+        header.headerSize != sizeof(MeshCacheHeader) || header.vertexStride != MESH_CACHE_VERTEX_STRIDE)
+        return true;
+    if (stat(sourcePath, &sourceStat) != 0)
+        return false;
+    return cacheStat.st_mtime < sourceStat.st_mtime;
+}
+
+// 导入模型文件并写成缓存
+inline bool ConvertToMeshCache(const char *sourcePath, const char *cachePath, unsigned int threads = 0)
+{
+    MeshData mesh;
+    if (!LoadModel(sourcePath, mesh, threads))
+        return false;
+    return WriteMeshCache(cachePath, mesh);
+}
+
+#endif
@@ -0,0 +1,505 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cfloat>
+#include <cmath>
+
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "Camera_Class.h"
+
+// 二次误差度量(QEM)网格简化
+//
+// 每个顶点记录一个二次型 Q 它是与这个顶点相邻的所有三角形所在平面的距离平方和
+// 把边 (a, b) 的 a 合并到 b 之后 新顶点到这些平面的距离平方和就是 (Qa + Qb)(pb)
+// 每次选代价最小的边合并 直到三角形数量达到目标
+//
+// 这里只做"半边合并": a 直接移到 b 的位置 不计算新的最优位置
+// 这样简化后的顶点都是原来的顶点 所有细节级别可以共用同一个顶点缓冲 只是索引不同
+
+// 对称4x4矩阵 只存上三角的10个数
+struct Quadric {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    Quadric()
+    {
+        memset(this, 0, sizeof(Quadric));
+    }
+
+    // 平面 n·p + d = 0 (n为单位向量) 乘以权重
+    static Quadric FromPlane(const glm::dvec3 &n, double d, double weight)
+    {
+        Quadric q;
+        q.a2 = n.x * n.x * weight; q.ab = n.x * n.y * weight; q.ac = n.x * n.z * weight; q.ad = n.x * d * weight;
+        q.b2 = n.y * n.y * weight; q.bc = n.y * n.z * weight; q.bd = n.y * d * weight;
+        q.c2 = n.z * n.z * weight; q.cd = n.z * d * weight;
+        q.d2 = d * d * weight;
+        return q;
+    }
+
+    void Add(const Quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+    }
+
+    // 点到所有平面的距离平方和
+    double Evaluate(const glm::dvec3 &p) const
+    {
+        double e = a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x
+                 + b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y
+                 + c2 * p.z * p.z + 2.0 * cd * p.z
+                 + d2;
+        return e > 0.0 ? e : 0.0;
+    }
+};
+
+class MeshSimplifier
+{
+public:
+    // 边界和纹理接缝上的边额外加一个垂直于三角形的平面 权重越大越不容易被移动
+    double BorderWeight;
+
+    MeshSimplifier(const MeshData &mesh) : BorderWeight(10.0), source(mesh), maxCost(0.0)
+    {
+        unsigned int vertexCount = mesh.VertexCount();
+        // 位置相同的顶点(法线或纹理坐标不同 比如立方体的棱和纹理接缝)归为一组 简化在组上进行
+        std::unordered_map<uint64_t, std::vector<unsigned int> > buckets;
+        group.assign(vertexCount, 0);
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            glm::vec3 p = Position(v);
+            uint32_t bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            uint64_t hash = ((uint64_t)bits[0] * 73856093u) ^ ((uint64_t)bits[1] * 19349663u << 16) ^ ((uint64_t)bits[2] * 83492791u << 32);
+            std::vector<unsigned int> &bucket = buckets[hash];
+            unsigned int found = ~0u;
+            for (size_t i = 0; i < bucket.size(); i++)
+            {
+                if (Position(groupVertices[bucket[i]][0]) == p)
+                {
+                    found = bucket[i];
+                    break;
+                }
+            }
+            if (found == ~0u)
+            {
+                found = (unsigned int)groupVertices.size();
+                groupVertices.push_back(std::vector<unsigned int>());
+                groupPosition.push_back(glm::dvec3(p));
+                bucket.push_back(found);
+            }
+            groupVertices[found].push_back(v);
+            group[v] = found;
+        }
+        unsigned int groupCount = (unsigned int)groupVertices.size();
+        quadrics.assign(groupCount, Quadric());
+        groupTriangles.assign(groupCount, std::vector<unsigned int>());
+        version.assign(groupCount, 0);
+        removed.assign(groupCount, 0);
+
+        unsigned int triangleCount = (unsigned int)(mesh.indices.size() / 3);
+        corners.resize(triangleCount * 3);
+        triangleGroups.resize(triangleCount * 3);
+        alive.assign(triangleCount, 1);
+        liveTriangles = 0;
+        // 原始顶点索引下只被一个三角形使用的边是边界或者接缝
+        std::unordered_map<uint64_t, int> edgeUse;
+        edgeUse.reserve(mesh.indices.size());
+        for (unsigned int t = 0; t < triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                corners[t * 3 + k] = mesh.indices[t * 3 + k];
+                triangleGroups[t * 3 + k] = group[mesh.indices[t * 3 + k]];
+            }
+            unsigned int g0 = triangleGroups[t * 3], g1 = triangleGroups[t * 3 + 1], g2 = triangleGroups[t * 3 + 2];
+            // 原本就退化的三角形直接丢弃
+            if (g0 == g1 || g1 == g2 || g0 == g2)
+            {
+                alive[t] = 0;
+                continue;
+            }
+            liveTriangles++;
+            glm::dvec3 normal = glm::cross(groupPosition[g1] - groupPosition[g0], groupPosition[g2] - groupPosition[g0]);
+            double length = glm::length(normal);
+            if (length > 0.0)
+            {
+                normal /= length;
+                Quadric q = Quadric::FromPlane(normal, -glm::dot(normal, groupPosition[g0]), 1.0);
+                for (int k = 0; k < 3; k++)
+                    quadrics[triangleGroups[t * 3 + k]].Add(q);
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                groupTriangles[triangleGroups[t * 3 + k]].push_back(t);
+                unsigned int u = corners[t * 3 + k], v = corners[t * 3 + (k + 1) % 3];
+                edgeUse[EdgeKey(u, v)]++;
+            }
+        }
+        for (unsigned int t = 0; t < triangleCount; t++)
+        {
+            if (!alive[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int u = corners[t * 3 + k], v = corners[t * 3 + (k + 1) % 3];
+                if (edgeUse[EdgeKey(u, v)] != 1)
+                    continue;
+                // 过这条边且垂直于三角形的平面 阻止边界点沿着垂直于边界的方向移动
+                glm::dvec3 pu = groupPosition[group[u]], pv = groupPosition[group[v]];
+                glm::dvec3 pw = groupPosition[triangleGroups[t * 3 + (k + 2) % 3]];
+                glm::dvec3 faceNormal = glm::cross(pv - pu, pw - pu);
+                glm::dvec3 edgeNormal = glm::cross(faceNormal, pv - pu);
+                double length = glm::length(edgeNormal);
+                if (length <= 0.0)
+                    continue;
+                edgeNormal /= length;
+                Quadric q = Quadric::FromPlane(edgeNormal, -glm::dot(edgeNormal, pu), BorderWeight);
+                quadrics[group[u]].Add(q);
+                quadrics[group[v]].Add(q);
+            }
+        }
+
+        // 所有不同的边放进最小堆
+        std::vector<uint64_t> edges;
+        edges.reserve(liveTriangles * 3);
+        for (unsigned int t = 0; t < triangleCount; t++)
+        {
+            if (!alive[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+                edges.push_back(EdgeKey(triangleGroups[t * 3 + k], triangleGroups[t * 3 + (k + 1) % 3]));
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        for (size_t i = 0; i < edges.size(); i++)
+            PushEdge((unsigned int)(edges[i] >> 32), (unsigned int)(edges[i] & 0xffffffffu));
+    }
+
+    unsigned int TriangleCount() const
+    {
+        return liveTriangles;
+    }
+
+    // 到目前为止最大的合并误差 是一个距离(模型空间)
+    // 每个点到原来的平面距离平方和的平方根 不小于到任何一个平面的距离
+    float Error() const
+    {
+        return (float)std::sqrt(maxCost);
+    }
+
+    // 一直合并到三角形数不超过 targetTriangles
+    // 或者下一次合并的误差超过 maxError 或者没有可以合并的边
+    void SimplifyTo(unsigned int targetTriangles, float maxError = FLT_MAX)
+    {
+        double maxAllowed = (double)maxError * (double)maxError;
+        while (liveTriangles > targetTriangles && !heap.empty())
+        {
+            Collapse top = heap.top();
+            if (removed[top.from] || removed[top.to] || version[top.from] != top.fromVersion || version[top.to] != top.toVersion)
+            {
+                heap.pop();
+                continue;
+            }
+            if (top.cost > maxAllowed)
+                break;
+            heap.pop();
+            if (!IsValid(top.from, top.to))
+                continue;
+            maxCost = std::max(maxCost, top.cost);
+            Apply(top.from, top.to);
+        }
+    }
+
+    // 当前网格的索引 使用原始网格的顶点编号
+    std::vector<unsigned int> Indices() const
+    {
+        std::vector<unsigned int> indices;
+        indices.reserve(liveTriangles * 3);
+        for (size_t t = 0; t < alive.size(); t++)
+        {
+            if (!alive[t])
+                continue;
+            indices.push_back(corners[t * 3]);
+            indices.push_back(corners[t * 3 + 1]);
+            indices.push_back(corners[t * 3 + 2]);
+        }
+        return indices;
+    }
+
+private:
+    struct Collapse {
+        double cost;
+        unsigned int from, to;
+        unsigned int fromVersion, toVersion;
+
+        bool operator>(const Collapse &other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    const MeshData &source;
+    std::vector<unsigned int> group;
+    std::vector<std::vector<unsigned int> > groupVertices;
+    std::vector<glm::dvec3> groupPosition;
+    std::vector<Quadric> quadrics;
+    std::vector<std::vector<unsigned int> > groupTriangles;
+    std::vector<unsigned int> version;
+    std::vector<char> removed;
+    // 每个三角形三个角的原始顶点编号 以及当前所在的组
+    std::vector<unsigned int> corners;
+    std::vector<unsigned int> triangleGroups;
+    std::vector<char> alive;
+    unsigned int liveTriangles;
+    double maxCost;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > heap;
+
+    static uint64_t EdgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    glm::vec3 Position(unsigned int v) const
+    {
+        return glm::vec3(source.vertices[v * 8], source.vertices[v * 8 + 1], source.vertices[v * 8 + 2]);
+    }
+
+    // 边的两个方向 选误差小的一个
+    void PushEdge(unsigned int a, unsigned int b)
+    {
+        Quadric q = quadrics[a];
+        q.Add(quadrics[b]);
+        double toB = q.Evaluate(groupPosition[b]);
+        double toA = q.Evaluate(groupPosition[a]);
+        Collapse c;
+        c.cost = toB <= toA ? toB : toA;
+        c.from = toB <= toA ? a : b;
+        c.to = toB <= toA ? b : a;
+        c.fromVersion = version[c.from];
+        c.toVersion = version[c.to];
+        heap.push(c);
+    }
+
+    // a 移到 b 之后 与 a 相邻的三角形不能翻转或者退化
+    bool IsValid(unsigned int a, unsigned int b) const
+    {
+        const std::vector<unsigned int> &triangles = groupTriangles[a];
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            unsigned int t = triangles[i];
+            if (!alive[t])
+                continue;
+            const unsigned int *g = &triangleGroups[t * 3];
+            if (g[0] == b || g[1] == b || g[2] == b)
+                continue;
+            glm::dvec3 p[3], moved[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = groupPosition[g[k]];
+                moved[k] = g[k] == a ? groupPosition[b] : p[k];
+            }
+            glm::dvec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::dvec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            double afterLength = glm::length(after), beforeLength = glm::length(before);
+            if (afterLength <= 1e-12 * (beforeLength + 1e-30))
+                return false;
+            if (glm::dot(before, after) < 0.2 * beforeLength * afterLength)
+                return false;
+        }
+        return true;
+    }
+
+    // 组 b 中与顶点 v 的法线和纹理坐标最接近的顶点
+    unsigned int MatchVertex(unsigned int v, unsigned int b) const
+    {
+        const std::vector<unsigned int> &candidates = groupVertices[b];
+        const float *attributes = &source.vertices[v * 8 + 3];
+        unsigned int best = candidates[0];
+        float bestDistance = FLT_MAX;
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            const float *other = &source.vertices[candidates[i] * 8 + 3];
+            float distance = 0.0f;
+            for (int k = 0; k < 5; k++)
+                distance += (attributes[k] - other[k]) * (attributes[k] - other[k]);
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = candidates[i];
+            }
+        }
+        return best;
+    }
+
+    void Apply(unsigned int a, unsigned int b)
+    {
+        std::vector<unsigned int> &fromTriangles = groupTriangles[a];
+        std::vector<unsigned int> &toTriangles = groupTriangles[b];
+        for (size_t i = 0; i < fromTriangles.size(); i++)
+        {
+            unsigned int t = fromTriangles[i];
+            if (!alive[t])
+                continue;
+            unsigned int *g = &triangleGroups[t * 3];
+            if (g[0] == b || g[1] == b || g[2] == b)
+            {
+                // 包含这条边的三角形消失
+                alive[t] = 0;
+                liveTriangles--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                if (g[k] == a)
+                {
+                    g[k] = b;
+                    corners[t * 3 + k] = MatchVertex(corners[t * 3 + k], b);
+                }
+            }
+            toTriangles.push_back(t);
+        }
+        std::vector<unsigned int>().swap(fromTriangles);
+        quadrics[b].Add(quadrics[a]);
+        removed[a] = 1;
+        version[b]++;
+
+        // 去掉已经消失的三角形 然后用新的二次型重新计算 b 周围所有边的代价
+        size_t live = 0;
+        std::vector<unsigned int> neighbors;
+        for (size_t i = 0; i < toTriangles.size(); i++)
+        {
+            unsigned int t = toTriangles[i];
+            if (!alive[t])
+                continue;
+            toTriangles[live++] = t;
+            for (int k = 0; k < 3; k++)
+            {
+                if (triangleGroups[t * 3 + k] != b)
+                    neighbors.push_back(triangleGroups[t * 3 + k]);
+            }
+        }
+        toTriangles.resize(live);
+        std::sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        for (size_t i = 0; i < neighbors.size(); i++)
+            PushEdge(b, neighbors[i]);
+    }
+};
+
+// 生成细节级别链: 每一级的三角形数约为上一级的 ratio 倍
+// 所有级别的索引依次追加到 mesh.indices 之后 lods 记录每一级的范围和误差 第0级是原始网格
+// 三角形数少于 minTriangles 或者无法继续简化时停止
+inline std::vector<MeshCacheLod> GenerateLods(MeshData &mesh, unsigned int maxLevels = 6, float ratio = 0.5f, unsigned int minTriangles = 32)
+{
+    std::vector<MeshCacheLod> lods;
+    MeshCacheLod base = { 0, (uint32_t)mesh.indices.size(), 0.0f, 0 };
+    lods.push_back(base);
+
+    MeshData original;
+    original.vertices.swap(mesh.vertices);
+    original.indices = mesh.indices;
+    {
+        // 一次简化过程 三角形数降到每一级的目标时记录下当前的索引
+        MeshSimplifier simplifier(original);
+        unsigned int previous = simplifier.TriangleCount();
+        while (lods.size() < maxLevels)
+        {
+            unsigned int target = (unsigned int)(previous * ratio);
+            if (target < minTriangles)
+                break;
+            simplifier.SimplifyTo(target);
+            unsigned int count = simplifier.TriangleCount();
+            // 卡住了(剩下的边合并都会导致翻转)
+            if (count > previous * (ratio + 1.0f) * 0.5f)
+                break;
+            std::vector<unsigned int> indices = simplifier.Indices();
+            MeshCacheLod lod = { (uint32_t)mesh.indices.size(), (uint32_t)indices.size(), simplifier.Error(), 0 };
+            mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+            lods.push_back(lod);
+            previous = count;
+        }
+    }
+    mesh.vertices.swap(original.vertices);
+    return lods;
+}
+
+// 每个物体每帧选择细节级别
+//
+// 模型空间的误差 e 在距离 d 处投影到屏幕上的像素数为
+//     e * scale * (屏幕高度 / (2 * tan(fov / 2))) / d
+// 选择投影误差不超过 PixelError 的最粗的一级
+//
+// 物体正好在切换距离附近时 相机的微小移动会让级别来回跳动(闪烁)
+// Hysteresis 为滞后比例: 只有距离越过切换距离的 (1 ± Hysteresis) 倍才改变级别
+class LodSelector
+{
+public:
+    float PixelError;
+    float Hysteresis;
+
+    LodSelector(const std::vector<MeshCacheLod> &lods, float pixelError = 1.0f, float hysteresis = 0.15f)
+        : PixelError(pixelError), Hysteresis(hysteresis), levels(lods), pixelsPerUnit(1.0f)
+    {
+    }
+
+    // 视野(Camera::Zoom)或窗口大小改变后都会影响投影误差 每帧调用一次
+    void Update(const Camera &camera, float screenHeight)
+    {
+        pixelsPerUnit = screenHeight / (2.0f * std::tan(glm::radians(camera.Zoom) * 0.5f));
+    }
+
+    unsigned int LevelCount() const
+    {
+        return (unsigned int)levels.size();
+    }
+
+    const MeshCacheLod &Level(unsigned int level) const
+    {
+        return levels[level];
+    }
+
+    // 不考虑滞后 distance 是相机到物体包围球表面的距离
+    unsigned int Select(float distance, float scale) const
+    {
+        distance = std::max(distance, 1e-4f);
+        unsigned int level = 0;
+        for (unsigned int i = 1; i < levels.size(); i++)
+        {
+            if (levels[i].error * scale * pixelsPerUnit / distance > PixelError)
+                break;
+            level = i;
+        }
+        return level;
+    }
+
+    // current 是这个物体上一帧的级别
+    unsigned int Select(float distance, float scale, unsigned int current) const
+    {
+        // 距离缩小一点仍然可以用的级别 与 距离放大一点才能用的级别 之间不切换
+        unsigned int finest = Select(distance / (1.0f + Hysteresis), scale);
+        unsigned int coarsest = Select(distance * (1.0f + Hysteresis), scale);
+        if (current < finest)
+            return finest;
+        if (current > coarsest)
+            return coarsest;
+        return current;
+    }
+
+private:
+    std::vector<MeshCacheLod> levels;
+    float pixelsPerUnit;
+};
+
+#endif
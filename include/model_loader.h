@@ -0,0 +1,951 @@
+#ifndef MODEL_LOADER_H
+#define MODEL_LOADER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <cmath>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mesh.h"
+
+// 模型导入
+// 文件用 mmap 映射到内存 不经过 iostream 也不整份复制
+// 文本按行边界切成若干块 每个线程解析一块 最后再合并
+// 浮点数和整数用手写的解析函数 比 strtof / sscanf 快得多
+// 支持 OBJ 和 PLY(ascii 与 binary_little_endian) 结果是章节顶点布局的 MeshData
+// 可以直接交给 UploadMesh 生成VAO/VBO/EBO
+
+// 只读映射一个文件
+class MappedFile
+{
+public:
+    const char *Data;
+    size_t Size;
+
+    MappedFile(const char *path) : Data(NULL), Size(0), fd(-1)
+    {
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+            return;
+        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            return;
+        // 顺序读取 让内核提前预读
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        Data = (const char*)p;
+        Size = (size_t)st.st_size;
+    }
+
+    ~MappedFile()
+    {
+        if (Data)
+            munmap((void*)Data, Size);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool IsOpen() const
+    {
+        return Data != NULL;
+    }
+
+private:
+    int fd;
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+};
+
+// ==================== 数字解析 ====================
+
+inline bool IsDigit(char c)
+{
+    return (unsigned char)(c - '0') < 10;
+}
+
+inline const char *SkipSpaces(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+        p++;
+    return p;
+}
+
+inline const char *SkipLine(const char *p, const char *end)
+{
+    const char *n = (const char*)memchr(p, '\n', end - p);
+    return n ? n + 1 : end;
+}
+
+inline double PowerOf10(int e)
+{
+    // 1e0 ~ 1e22 都能被double精确表示 用它们做乘除结果是正确舍入的
+    static const double exact[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if (e <= 22)
+        return exact[e];
+    return std::pow(10.0, e);
+}
+
+// 解析一个十进制浮点数 格式为 [+-]digits[.digits][(e|E)[+-]digits]
+// 最多保留19位有效数字 对于模型文件已经远超float的精度
+inline const char *ParseFloat(const char *p, const char *end, float &out)
+{
+    p = SkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    while (p < end && IsDigit(*p))
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            if (mantissa)
+                digits++;
+        }
+        else
+        {
+            exponent++;
+        }
+        p++;
+    }
+    if (p < end && *p == '.')
+    {
+        p++;
+        while (p < end && IsDigit(*p))
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                if (mantissa)
+                    digits++;
+                exponent--;
+            }
+            p++;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        int e = 0;
+        while (p < end && IsDigit(*p))
+        {
+            if (e < 10000)
+                e = e * 10 + (*p - '0');
+            p++;
+        }
+        exponent += negativeExponent ? -e : e;
+    }
+    double value = (double)mantissa;
+    if (exponent > 0)
+        value *= PowerOf10(exponent);
+    else if (exponent < 0)
+        value /= PowerOf10(-exponent);
+    out = (float)(negative ? -value : value);
+    return p;
+}
+
+inline const char *ParseInt(const char *p, const char *end, int &out)
+{
+    p = SkipSpaces(p, end);
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    int value = 0;
+    while (p < end && IsDigit(*p))
+    {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    out = negative ? -value : value;
+    return p;
+}
+
+// ==================== 并行工具 ====================
+
+inline unsigned int LoaderThreadCount(unsigned int requested)
+{
+    if (requested)
+        return requested;
+    unsigned int n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// 把 [begin, end) 切成 count 块 每块的起点都挪到下一行的开头
+inline std::vector<const char*> SplitOnLines(const char *begin, const char *end, unsigned int count)
+{
+    std::vector<const char*> bounds;
+    bounds.push_back(begin);
+    size_t size = end - begin;
+    for (unsigned int i = 1; i < count; i++)
+    {
+        const char *p = begin + size * i / count;
+        if (p < bounds.back())
+            p = bounds.back();
+        if (p > begin && p < end && p[-1] != '\n')
+            p = SkipLine(p, end);
+        bounds.push_back(p);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+template <typename Function>
+void ParallelFor(unsigned int count, Function function)
+{
+    if (count == 1)
+    {
+        function(0u);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < count; i++)
+        threads.push_back(std::thread(function, i));
+    for (unsigned int i = 0; i < count; i++)
+        threads[i].join();
+}
+
+// 没有法线时按面积加权累加面法线
+inline void ComputeNormals(MeshData &mesh)
+{
+    unsigned int vertexCount = mesh.VertexCount();
+    std::vector<glm::vec3> normals(vertexCount, glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        unsigned int a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+        glm::vec3 pa(mesh.vertices[a * 8], mesh.vertices[a * 8 + 1], mesh.vertices[a * 8 + 2]);
+        glm::vec3 pb(mesh.vertices[b * 8], mesh.vertices[b * 8 + 1], mesh.vertices[b * 8 + 2]);
+        glm::vec3 pc(mesh.vertices[c * 8], mesh.vertices[c * 8 + 1], mesh.vertices[c * 8 + 2]);
+        glm::vec3 n = glm::cross(pb - pa, pc - pa);
+        normals[a] += n;
+        normals[b] += n;
+        normals[c] += n;
+    }
+    for (unsigned int i = 0; i < vertexCount; i++)
+    {
+        float length = glm::length(normals[i]);
+        glm::vec3 n = length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        mesh.vertices[i * 8 + 3] = n.x;
+        mesh.vertices[i * 8 + 4] = n.y;
+        mesh.vertices[i * 8 + 5] = n.z;
+    }
+}
+
+// ==================== OBJ ====================
+
+// 面的一个角 v/vt/vn 都是从0开始的索引 没有时为 OBJ_MISSING
+// OBJ允许负数索引(相对于当前已读到的顶点数) 这取决于前面所有块的顶点数
+// 所以先记下块内的相对值 合并时再加上前面块的数量
+const int OBJ_MISSING = INT_MIN;
+
+struct ObjCorner {
+    int v, vt, vn;
+};
+
+struct ObjChunk {
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners;
+    // 每个角的三个分量是否为相对索引 bit0: v  bit1: vt  bit2: vn
+    std::vector<unsigned char> relative;
+};
+
+inline const char *ParseObjCorner(const char *p, const char *end, const ObjChunk &chunk, ObjCorner &corner, unsigned char &relative)
+{
+    int counts[3] = {
+        (int)(chunk.positions.size() / 3),
+        (int)(chunk.texCoords.size() / 2),
+        (int)(chunk.normals.size() / 3)
+    };
+    int values[3] = { OBJ_MISSING, OBJ_MISSING, OBJ_MISSING };
+    relative = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        if (k > 0)
+        {
+            if (p >= end || *p != '/')
+                break;
+            p++;
+        }
+        if (p < end && (IsDigit(*p) || *p == '-'))
+        {
+            int index;
+            p = ParseInt(p, end, index);
+            if (index < 0)
+            {
+                values[k] = counts[k] + index;
+                relative |= (unsigned char)(1 << k);
+            }
+            else
+            {
+                values[k] = index - 1;
+            }
+        }
+    }
+    corner.v = values[0];
+    corner.vt = values[1];
+    corner.vn = values[2];
+    return p;
+}
+
+inline void ParseObjChunk(const char *p, const char *end, ObjChunk &chunk)
+{
+    std::vector<ObjCorner> face;
+    std::vector<unsigned char> faceRelative;
+    while (p < end)
+    {
+        p = SkipSpaces(p, end);
+        if (p >= end)
+            break;
+        if (p[0] == 'v' && p + 1 < end && (p[1] == ' ' || p[1] == '\t'))
+        {
+            float x, y, z;
+            p = ParseFloat(p + 2, end, x);
+            p = ParseFloat(p, end, y);
+            p = ParseFloat(p, end, z);
+            chunk.positions.push_back(x);
+            chunk.positions.push_back(y);
+            chunk.positions.push_back(z);
+        }
+        else if (p[0] == 'v' && p + 2 < end && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            float x, y, z;
+            p = ParseFloat(p + 3, end, x);
+            p = ParseFloat(p, end, y);
+            p = ParseFloat(p, end, z);
+            chunk.normals.push_back(x);
+            chunk.normals.push_back(y);
+            chunk.normals.push_back(z);
+        }
+        else if (p[0] == 'v' && p + 2 < end && p[1] == 't' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            float u, v;
+            p = ParseFloat(p + 3, end, u);
+            p = ParseFloat(p, end, v);
+            chunk.texCoords.push_back(u);
+            chunk.texCoords.push_back(v);
+        }
+        else if (p[0] == 'f' && p + 1 < end && (p[1] == ' ' || p[1] == '\t'))
+        {
+            face.clear();
+            faceRelative.clear();
+            p += 2;
+            while (true)
+            {
+                p = SkipSpaces(p, end);
+                if (p >= end || *p == '\n' || *p == '#')
+                    break;
+                ObjCorner corner;
+                unsigned char relative;
+                const char *next = ParseObjCorner(p, end, chunk, corner, relative);
+                if (next == p)
+                    break;
+                p = next;
+                face.push_back(corner);
+                faceRelative.push_back(relative);
+            }
+            // 多边形按扇形拆成三角形
+            for (size_t i = 2; i < face.size(); i++)
+            {
+                size_t fan[3] = { 0, i - 1, i };
+                for (int k = 0; k < 3; k++)
+                {
+                    chunk.corners.push_back(face[fan[k]]);
+                    chunk.relative.push_back(faceRelative[fan[k]]);
+                }
+            }
+        }
+        // 其余的行(注释 o g s usemtl mtllib 等)忽略
+        p = SkipLine(p, end);
+    }
+}
+
+struct ObjCornerHash {
+    size_t operator()(const ObjCorner &c) const
+    {
+        uint64_t h = (uint64_t)(uint32_t)c.v * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)(uint32_t)c.vt * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= (uint64_t)(uint32_t)c.vn * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+struct ObjCornerEqual {
+    bool operator()(const ObjCorner &a, const ObjCorner &b) const
+    {
+        return a.v == b.v && a.vt == b.vt && a.vn == b.vn;
+    }
+};
+
+inline bool LoadObj(const char *data, size_t size, MeshData &mesh, unsigned int threads)
+{
+    unsigned int chunkCount = LoaderThreadCount(threads);
+    // 文件太小时不值得开线程
+    if (size < (size_t)chunkCount * 65536)
+        chunkCount = (unsigned int)(size / 65536) + 1;
+    std::vector<const char*> bounds = SplitOnLines(data, data + size, chunkCount);
+    std::vector<ObjChunk> chunks(chunkCount);
+    ParallelFor(chunkCount, [&](unsigned int i) {
+        ParseObjChunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // 每块之前的 v/vt/vn 数量 用于把相对索引变成绝对索引
+    std::vector<int> positionBase(chunkCount), texCoordBase(chunkCount), normalBase(chunkCount);
+    std::vector<size_t> cornerBase(chunkCount);
+    int positionCount = 0, texCoordCount = 0, normalCount = 0;
+    size_t cornerCount = 0;
+    for (unsigned int i = 0; i < chunkCount; i++)
+    {
+        positionBase[i] = positionCount;
+        texCoordBase[i] = texCoordCount;
+        normalBase[i] = normalCount;
+        cornerBase[i] = cornerCount;
+        positionCount += (int)(chunks[i].positions.size() / 3);
+        texCoordCount += (int)(chunks[i].texCoords.size() / 2);
+        normalCount += (int)(chunks[i].normals.size() / 3);
+        cornerCount += chunks[i].corners.size();
+    }
+    if (positionCount == 0 || cornerCount == 0)
+    {
+        std::cout << "ERROR::MODEL::OBJ_HAS_NO_GEOMETRY" << std::endl;
+        return false;
+    }
+
+    std::vector<float> positions((size_t)positionCount * 3), texCoords((size_t)texCoordCount * 2), normals((size_t)normalCount * 3);
+    std::vector<ObjCorner> corners(cornerCount);
+    // 检查是否每个角的 v vt vn 都相同(或缺失) 这时可以直接用位置索引作为顶点索引
+    std::vector<char> sameIndices(chunkCount, 1), allNormals(chunkCount, 1), allTexCoords(chunkCount, 1), valid(chunkCount, 1);
+    ParallelFor(chunkCount, [&](unsigned int i) {
+        ObjChunk &chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + (size_t)positionBase[i] * 3);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + (size_t)texCoordBase[i] * 2);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + (size_t)normalBase[i] * 3);
+        for (size_t c = 0; c < chunk.corners.size(); c++)
+        {
+            ObjCorner corner = chunk.corners[c];
+            unsigned char relative = chunk.relative[c];
+            if (relative & 1)
+                corner.v += positionBase[i];
+            if ((relative & 2) && corner.vt != OBJ_MISSING)
+                corner.vt += texCoordBase[i];
+            if ((relative & 4) && corner.vn != OBJ_MISSING)
+                corner.vn += normalBase[i];
+            if (corner.v < 0 || corner.v >= positionCount ||
+                (corner.vt != OBJ_MISSING && (corner.vt < 0 || corner.vt >= texCoordCount)) ||
+                (corner.vn != OBJ_MISSING && (corner.vn < 0 || corner.vn >= normalCount)))
+                valid[i] = 0;
+            if ((corner.vt != OBJ_MISSING && corner.vt != corner.v) || (corner.vn != OBJ_MISSING && corner.vn != corner.v))
+                sameIndices[i] = 0;
+            if (corner.vn == OBJ_MISSING)
+                allNormals[i] = 0;
+            if (corner.vt == OBJ_MISSING)
+                allTexCoords[i] = 0;
+            corners[cornerBase[i] + c] = corner;
+        }
+        // 解析的中间结果已经复制完 尽早释放以降低峰值内存
+        ObjChunk().positions.swap(chunk.positions);
+        ObjChunk().texCoords.swap(chunk.texCoords);
+        ObjChunk().normals.swap(chunk.normals);
+        ObjChunk().corners.swap(chunk.corners);
+        ObjChunk().relative.swap(chunk.relative);
+    });
+    bool useSameIndices = true, hasNormals = true, hasTexCoords = true;
+    for (unsigned int i = 0; i < chunkCount; i++)
+    {
+        if (!valid[i])
+        {
+            std::cout << "ERROR::MODEL::OBJ_INDEX_OUT_OF_RANGE" << std::endl;
+            return false;
+        }
+        useSameIndices = useSameIndices && sameIndices[i];
+        hasNormals = hasNormals && allNormals[i];
+        hasTexCoords = hasTexCoords && allTexCoords[i];
+    }
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    if (useSameIndices)
+    {
+        // 快速路径: 顶点就是位置数组 索引直接使用
+        mesh.vertices.resize((size_t)positionCount * 8);
+        mesh.indices.resize(cornerCount);
+        ParallelFor(chunkCount, [&](unsigned int t) {
+            size_t vBegin = (size_t)positionCount * t / chunkCount, vEnd = (size_t)positionCount * (t + 1) / chunkCount;
+            for (size_t v = vBegin; v < vEnd; v++)
+            {
+                float *out = &mesh.vertices[v * 8];
+                out[0] = positions[v * 3];
+                out[1] = positions[v * 3 + 1];
+                out[2] = positions[v * 3 + 2];
+                out[3] = hasNormals && v < (size_t)normalCount ? normals[v * 3] : 0.0f;
+                out[4] = hasNormals && v < (size_t)normalCount ? normals[v * 3 + 1] : 0.0f;
+                out[5] = hasNormals && v < (size_t)normalCount ? normals[v * 3 + 2] : 0.0f;
+                out[6] = hasTexCoords && v < (size_t)texCoordCount ? texCoords[v * 2] : 0.0f;
+                out[7] = hasTexCoords && v < (size_t)texCoordCount ? texCoords[v * 2 + 1] : 0.0f;
+            }
+            size_t cBegin = cornerCount * t / chunkCount, cEnd = cornerCount * (t + 1) / chunkCount;
+            for (size_t c = cBegin; c < cEnd; c++)
+                mesh.indices[c] = (unsigned int)corners[c].v;
+        });
+    }
+    else
+    {
+        // v vt vn 的组合各不相同 需要去重后生成顶点
+        std::unordered_map<ObjCorner, unsigned int, ObjCornerHash, ObjCornerEqual> unique;
+        unique.reserve(cornerCount / 2);
+        mesh.indices.reserve(cornerCount);
+        for (size_t c = 0; c < cornerCount; c++)
+        {
+            const ObjCorner &corner = corners[c];
+            std::pair<std::unordered_map<ObjCorner, unsigned int, ObjCornerHash, ObjCornerEqual>::iterator, bool> result =
+                unique.insert(std::make_pair(corner, mesh.VertexCount()));
+            if (result.second)
+            {
+                glm::vec3 position(positions[corner.v * 3], positions[corner.v * 3 + 1], positions[corner.v * 3 + 2]);
+                glm::vec3 normal(0.0f);
+                glm::vec2 uv(0.0f);
+                if (corner.vn != OBJ_MISSING)
+                    normal = glm::vec3(normals[corner.vn * 3], normals[corner.vn * 3 + 1], normals[corner.vn * 3 + 2]);
+                if (corner.vt != OBJ_MISSING)
+                    uv = glm::vec2(texCoords[corner.vt * 2], texCoords[corner.vt * 2 + 1]);
+                mesh.AddVertex(position, normal, uv);
+            }
+            mesh.indices.push_back(result.first->second);
+        }
+    }
+    if (!hasNormals)
+        ComputeNormals(mesh);
+    return true;
+}
+
+// ==================== PLY ====================
+
+enum Ply_Type {
+    PLY_NONE, PLY_CHAR, PLY_UCHAR, PLY_SHORT, PLY_USHORT, PLY_INT, PLY_UINT, PLY_FLOAT, PLY_DOUBLE
+};
+
+inline Ply_Type PlyTypeFromName(const std::string &name)
+{
+    if (name == "char" || name == "int8") return PLY_CHAR;
+    if (name == "uchar" || name == "uint8") return PLY_UCHAR;
+    if (name == "short" || name == "int16") return PLY_SHORT;
+    if (name == "ushort" || name == "uint16") return PLY_USHORT;
+    if (name == "int" || name == "int32") return PLY_INT;
+    if (name == "uint" || name == "uint32") return PLY_UINT;
+    if (name == "float" || name == "float32") return PLY_FLOAT;
+    if (name == "double" || name == "float64") return PLY_DOUBLE;
+    return PLY_NONE;
+}
+
+inline size_t PlyTypeSize(Ply_Type type)
+{
+    switch (type)
+    {
+    case PLY_CHAR: case PLY_UCHAR: return 1;
+    case PLY_SHORT: case PLY_USHORT: return 2;
+    case PLY_INT: case PLY_UINT: case PLY_FLOAT: return 4;
+    case PLY_DOUBLE: return 8;
+    default: return 0;
+    }
+}
+
+// 小端序二进制读取 x86与ARM都是小端 直接memcpy
+inline double PlyReadBinary(const char *p, Ply_Type type)
+{
+    switch (type)
+    {
+    case PLY_CHAR: return (double)*(const int8_t*)p;
+    case PLY_UCHAR: return (double)*(const uint8_t*)p;
+    case PLY_SHORT: { int16_t v; memcpy(&v, p, 2); return v; }
+    case PLY_USHORT: { uint16_t v; memcpy(&v, p, 2); return v; }
+    case PLY_INT: { int32_t v; memcpy(&v, p, 4); return v; }
+    case PLY_UINT: { uint32_t v; memcpy(&v, p, 4); return v; }
+    case PLY_FLOAT: { float v; memcpy(&v, p, 4); return v; }
+    case PLY_DOUBLE: { double v; memcpy(&v, p, 8); return v; }
+    default: return 0.0;
+    }
+}
+
+struct PlyProperty {
+    std::string name;
+    Ply_Type type;
+    // 列表属性 countType 为长度的类型
+    Ply_Type countType;
+};
+
+struct PlyElement {
+    std::string name;
+    size_t count;
+    std::vector<PlyProperty> properties;
+};
+
+// 顶点属性在8个float中的位置 -1 表示不需要
+inline int PlyVertexSlot(const std::string &name)
+{
+    if (name == "x") return 0;
+    if (name == "y") return 1;
+    if (name == "z") return 2;
+    if (name == "nx") return 3;
+    if (name == "ny") return 4;
+    if (name == "nz") return 5;
+    if (name == "u" || name == "s" || name == "texture_u" || name == "texture_s") return 6;
+    if (name == "v" || name == "t" || name == "texture_v" || name == "texture_t") return 7;
+    return -1;
+}
+
+// 按行读取ascii的PLY 每个线程负责一段连续的行
+inline bool LoadPlyAscii(const char *p, const char *end, const std::vector<PlyElement> &elements, MeshData &mesh, unsigned int threads, bool &hasNormals)
+{
+    unsigned int chunkCount = LoaderThreadCount(threads);
+    for (size_t e = 0; e < elements.size(); e++)
+    {
+        const PlyElement &element = elements[e];
+        // 找到这个元素所有行的结束位置 memchr 很快 串行即可
+        const char *begin = p;
+        for (size_t i = 0; i < element.count && p < end; i++)
+            p = SkipLine(p, end);
+        const char *elementEnd = p;
+
+        unsigned int parts = (elementEnd - begin) < (ptrdiff_t)chunkCount * 65536 ? 1 : chunkCount;
+        std::vector<const char*> bounds = SplitOnLines(begin, elementEnd, parts);
+
+        if (element.name == "vertex")
+        {
+            std::vector<int> slots;
+            for (size_t k = 0; k < element.properties.size(); k++)
+            {
+                slots.push_back(PlyVertexSlot(element.properties[k].name));
+                if (slots.back() == 3)
+                    hasNormals = true;
+            }
+            // 先数出每块的行数 得到每块第一个顶点的编号
+            std::vector<size_t> lineCounts(parts, 0);
+            ParallelFor(parts, [&](unsigned int t) {
+                for (const char *q = bounds[t]; q < bounds[t + 1]; q = SkipLine(q, bounds[t + 1]))
+                    lineCounts[t]++;
+            });
+            std::vector<size_t> firstLine(parts, 0);
+            for (unsigned int t = 1; t < parts; t++)
+                firstLine[t] = firstLine[t - 1] + lineCounts[t - 1];
+            mesh.vertices.assign(element.count * 8, 0.0f);
+            ParallelFor(parts, [&](unsigned int t) {
+                size_t v = firstLine[t];
+                for (const char *q = bounds[t]; q < bounds[t + 1] && v < element.count; v++)
+                {
+                    float *out = &mesh.vertices[v * 8];
+                    for (size_t k = 0; k < slots.size(); k++)
+                    {
+                        float value;
+                        q = ParseFloat(q, bounds[t + 1], value);
+                        if (slots[k] >= 0)
+                            out[slots[k]] = value;
+                    }
+                    q = SkipLine(q, bounds[t + 1]);
+                }
+            });
+        }
+        else if (element.name == "face")
+        {
+            std::vector<std::vector<unsigned int> > local(parts);
+            ParallelFor(parts, [&](unsigned int t) {
+                std::vector<unsigned int> &out = local[t];
+                std::vector<int> polygon;
+                for (const char *q = bounds[t]; q < bounds[t + 1]; q = SkipLine(q, bounds[t + 1]))
+                {
+                    for (size_t k = 0; k < element.properties.size(); k++)
+                    {
+                        if (element.properties[k].countType == PLY_NONE)
+                        {
+                            float ignored;
+                            q = ParseFloat(q, bounds[t + 1], ignored);
+                            continue;
+                        }
+                        int count;
+                        q = ParseInt(q, bounds[t + 1], count);
+                        polygon.resize(count > 0 ? count : 0);
+                        for (int i = 0; i < count; i++)
+                            q = ParseInt(q, bounds[t + 1], polygon[i]);
+                        if (element.properties[k].name != "vertex_indices" && element.properties[k].name != "vertex_index")
+                            continue;
+                        for (int i = 2; i < count; i++)
+                        {
+                            out.push_back((unsigned int)polygon[0]);
+                            out.push_back((unsigned int)polygon[i - 1]);
+                            out.push_back((unsigned int)polygon[i]);
+                        }
+                    }
+                }
+            });
+            size_t total = 0;
+            for (unsigned int t = 0; t < parts; t++)
+                total += local[t].size();
+            mesh.indices.reserve(total);
+            for (unsigned int t = 0; t < parts; t++)
+            {
+                mesh.indices.insert(mesh.indices.end(), local[t].begin(), local[t].end());
+                std::vector<unsigned int>().swap(local[t]);
+            }
+        }
+    }
+    return true;
+}
+
+inline bool LoadPlyBinary(const char *p, const char *end, const std::vector<PlyElement> &elements, MeshData &mesh, unsigned int threads, bool &hasNormals)
+{
+    unsigned int chunkCount = LoaderThreadCount(threads);
+    for (size_t e = 0; e < elements.size(); e++)
+    {
+        const PlyElement &element = elements[e];
+        bool fixedSize = true;
+        size_t stride = 0;
+        for (size_t k = 0; k < element.properties.size(); k++)
+        {
+            if (element.properties[k].countType != PLY_NONE)
+                fixedSize = false;
+            stride += PlyTypeSize(element.properties[k].type);
+        }
+
+        if (element.name == "vertex" && fixedSize)
+        {
+            if ((size_t)(end - p) < stride * element.count)
+            {
+                std::cout << "ERROR::MODEL::PLY_TRUNCATED" << std::endl;
+                return false;
+            }
+            std::vector<int> slots;
+            std::vector<size_t> offsets;
+            size_t offset = 0;
+            for (size_t k = 0; k < element.properties.size(); k++)
+            {
+                slots.push_back(PlyVertexSlot(element.properties[k].name));
+                offsets.push_back(offset);
+                offset += PlyTypeSize(element.properties[k].type);
+                if (slots.back() == 3)
+                    hasNormals = true;
+            }
+            mesh.vertices.assign(element.count * 8, 0.0f);
+            // 每个顶点的大小固定 直接按编号均分给各个线程
+            const char *base = p;
+            ParallelFor(element.count < 65536 ? 1 : chunkCount, [&](unsigned int t) {
+                unsigned int parts = element.count < 65536 ? 1 : chunkCount;
+                size_t vBegin = element.count * t / parts, vEnd = element.count * (t + 1) / parts;
+                for (size_t v = vBegin; v < vEnd; v++)
+                {
+                    const char *q = base + v * stride;
+                    float *out = &mesh.vertices[v * 8];
+                    for (size_t k = 0; k < slots.size(); k++)
+                    {
+                        if (slots[k] >= 0)
+                            out[slots[k]] = (float)PlyReadBinary(q + offsets[k], element.properties[k].type);
+                    }
+                }
+            });
+            p += stride * element.count;
+            continue;
+        }
+
+        // 带列表的元素(面)每一项长度不同 只能顺序扫描
+        bool isFace = element.name == "face";
+        for (size_t i = 0; i < element.count; i++)
+        {
+            for (size_t k = 0; k < element.properties.size(); k++)
+            {
+                const PlyProperty &property = element.properties[k];
+                if (property.countType == PLY_NONE)
+                {
+                    p += PlyTypeSize(property.type);
+                    continue;
+                }
+                size_t countSize = PlyTypeSize(property.countType);
+                size_t itemSize = PlyTypeSize(property.type);
+                if (p + countSize > end)
+                {
+                    std::cout << "ERROR::MODEL::PLY_TRUNCATED" << std::endl;
+                    return false;
+                }
+                size_t count = (size_t)PlyReadBinary(p, property.countType);
+                p += countSize;
+                if (p + count * itemSize > end)
+                {
+                    std::cout << "ERROR::MODEL::PLY_TRUNCATED" << std::endl;
+                    return false;
+                }
+                if (isFace && (property.name == "vertex_indices" || property.name == "vertex_index"))
+                {
+                    unsigned int first = (unsigned int)PlyReadBinary(p, property.type);
+                    unsigned int previous = count > 1 ? (unsigned int)PlyReadBinary(p + itemSize, property.type) : 0;
+                    for (size_t j = 2; j < count; j++)
+                    {
+                        unsigned int current = (unsigned int)PlyReadBinary(p + j * itemSize, property.type);
+                        mesh.indices.push_back(first);
+                        mesh.indices.push_back(previous);
+                        mesh.indices.push_back(current);
+                        previous = current;
+                    }
+                }
+                p += count * itemSize;
+            }
+        }
+    }
+    return true;
+}
+
+inline bool LoadPly(const char *data, size_t size, MeshData &mesh, unsigned int threads)
+{
+    const char *end = data + size;
+    const char *p = data;
+    if (size < 4 || strncmp(p, "ply", 3) != 0)
+    {
+        std::cout << "ERROR::MODEL::NOT_A_PLY_FILE" << std::endl;
+        return false;
+    }
+    std::vector<PlyElement> elements;
+    bool binary = false;
+    bool headerDone = false;
+    // 文件头是几十行文本 用std::string解析即可
+    while (p < end && !headerDone)
+    {
+        const char *lineEnd = SkipLine(p, end);
+        std::string line(p, lineEnd);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+            line.pop_back();
+        p = lineEnd;
+
+        std::vector<std::string> words;
+        size_t start = 0;
+        while (start < line.size())
+        {
+            size_t stop = line.find(' ', start);
+            if (stop == std::string::npos)
+                stop = line.size();
+            if (stop > start)
+                words.push_back(line.substr(start, stop - start));
+            start = stop + 1;
+        }
+        if (words.empty())
+            continue;
+        if (words[0] == "format" && words.size() > 1)
+        {
+            if (words[1] == "binary_little_endian")
+                binary = true;
+            else if (words[1] != "ascii")
+            {
+                std::cout << "ERROR::MODEL::PLY_FORMAT_NOT_SUPPORTED " << words[1] << std::endl;
+                return false;
+            }
+        }
+        else if (words[0] == "element" && words.size() > 2)
+        {
+            PlyElement element;
+            element.name = words[1];
+            element.count = (size_t)strtoull(words[2].c_str(), NULL, 10);
+            elements.push_back(element);
+        }
+        else if (words[0] == "property" && !elements.empty())
+        {
+            PlyProperty property;
+            if (words.size() > 4 && words[1] == "list")
+            {
+                property.countType = PlyTypeFromName(words[2]);
+                property.type = PlyTypeFromName(words[3]);
+                property.name = words[4];
+            }
+            else if (words.size() > 2)
+            {
+                property.countType = PLY_NONE;
+                property.type = PlyTypeFromName(words[1]);
+                property.name = words[2];
+            }
+            else
+                continue;
+            if (property.type == PLY_NONE)
+            {
+                std::cout << "ERROR::MODEL::PLY_UNKNOWN_TYPE " << line << std::endl;
+                return false;
+            }
+            elements.back().properties.push_back(property);
+        }
+        else if (words[0] == "end_header")
+            headerDone = true;
+    }
+    if (!headerDone)
+    {
+        std::cout << "ERROR::MODEL::PLY_HEADER_INCOMPLETE" << std::endl;
+        return false;
+    }
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    bool hasNormals = false;
+    bool ok = binary ? LoadPlyBinary(p, end, elements, mesh, threads, hasNormals)
+                     : LoadPlyAscii(p, end, elements, mesh, threads, hasNormals);
+    if (!ok)
+        return false;
+    unsigned int vertexCount = mesh.VertexCount();
+    for (size_t i = 0; i < mesh.indices.size(); i++)
+    {
+        if (mesh.indices[i] >= vertexCount)
+        {
+            std::cout << "ERROR::MODEL::PLY_INDEX_OUT_OF_RANGE" << std::endl;
+            return false;
+        }
+    }
+    if (!hasNormals)
+        ComputeNormals(mesh);
+    return true;
+}
+
+// 根据扩展名选择格式 threads 为0时使用全部核心
+inline bool LoadModel(const char *path, MeshData &mesh, unsigned int threads = 0)
+{
+    MappedFile file(path);
+    if (!file.IsOpen())
+    {
+        std::cout << "ERROR::MODEL::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+        return false;
+    }
+    std::string name(path);
+    std::string extension = name.substr(name.find_last_of('.') + 1);
+    for (size_t i = 0; i < extension.size(); i++)
+        extension[i] = (char)tolower(extension[i]);
+    if (extension == "obj")
+        return LoadObj(file.Data, file.Size, mesh, threads);
+    if (extension == "ply")
+        return LoadPly(file.Data, file.Size, mesh, threads);
+    std::cout << "ERROR::MODEL::FORMAT_NOT_SUPPORTED " << extension << std::endl;
+    return false;
+}
+
+#endif
@@ -0,0 +1,388 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OCCLUSION_CULLER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE 1
+#endif
+
+#include "mesh.h"
+#include "thread_pool.h"
+
+// CPU上的遮挡剔除 做法来自 masked occlusion culling(Andersson等 2015)
+//
+// 把少量大的遮挡物(occluder)光栅化到一张低分辨率的深度缓冲 绘制之前用它测试每个物体屏幕上的包围矩形
+// 矩形内的每一处都在遮挡物后面就不用画
+//
+// 深度缓冲分成 32x8 像素的块(tile) 不保存每个像素的深度 每块只有:
+//   zMin[0]: 参考层 整块中所有像素的遮挡物都至少这么近
+//   zMin[1]: 工作层 mask 中的像素至少这么近
+//   mask:    工作层覆盖的像素 8行 每行32位
+// 一个三角形光栅化到一块时得到覆盖的位和它在这块中最远的深度 并入工作层
+// 工作层盖满整块时成为新的参考层 所以每块只占40字节 整个缓冲都在缓存里
+//
+// 深度用 1/w 在屏幕空间是线性的 越大越近 清空时为0(无穷远)
+// 所有的近似都偏向"看得见": 三角形的深度取块中最远的 丢掉工作层只会损失信息 不会错误地剔除
+//
+// 每帧的步骤:
+//   1. Begin 清空
+//   2. AddOccluder 把遮挡物的三角形变换到屏幕 裁剪近平面 剔除背面 算出边函数和深度平面
+//   3. Rasterize 每一行块由一个线程处理 按提交的顺序光栅化与这一行相交的三角形 块之间不需要加锁
+//   4. IsVisible 测试包围盒 只读 可以在多个线程中同时调用
+//
+// 一行32个像素的覆盖 编译时打开AVX2(-mavx2)时一次算8个像素 否则用SSE2一次4个 都没有时逐个计算
+
+struct OcclusionStats {
+    double setupMs;           // 变换和三角形设置
+    double rasterMs;          // 光栅化
+    unsigned int occluders;
+    unsigned int triangles;   // 裁剪和背面剔除之后
+    unsigned int fullTiles;   // 参考层不是无穷远的块
+};
+
+class OcclusionCuller
+{
+public:
+    static const unsigned int TILE_WIDTH = 32;
+    static const unsigned int TILE_HEIGHT = 8;
+
+    unsigned int Width, Height;
+
+    // 宽和高分别是32和8的倍数
+    OcclusionCuller(unsigned int width = 256, unsigned int height = 144)
+        : Width(width), Height(height)
+    {
+        tilesX = Width / TILE_WIDTH;
+        tilesY = Height / TILE_HEIGHT;
+        tiles.resize(tilesX * tilesY);
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void Begin(const glm::mat4 &viewProjection)
+    {
+        this->viewProjection = viewProjection;
+        triangles.clear();
+        for (size_t i = 0; i < tiles.size(); i++)
+        {
+            tiles[i].zMin[0] = 0.0f;
+            tiles[i].zMin[1] = 0.0f;
+            memset(tiles[i].mask, 0, sizeof(tiles[i].mask));
+        }
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // 遮挡物必须是封闭的网格 正面逆时针 背面不光栅化
+    // 按从近到远的顺序提交效果最好 近处的三角形先填满参考层 远处的直接跳过
+    void AddOccluder(const MeshData &mesh, const glm::mat4 &model)
+    {
+        auto start = std::chrono::steady_clock::now();
+        glm::mat4 mvp = viewProjection * model;
+        unsigned int vertexCount = mesh.VertexCount();
+        clip.resize(vertexCount);
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const float *p = &mesh.vertices[i * 8];
+            clip[i] = mvp * glm::vec4(p[0], p[1], p[2], 1.0f);
+        }
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+            AddTriangle(clip[mesh.indices[i]], clip[mesh.indices[i + 1]], clip[mesh.indices[i + 2]]);
+        stats.occluders++;
+        stats.setupMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // pool 为NULL时在当前线程完成
+    void Rasterize(ThreadPool *pool)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto rasterizeRow = [&](unsigned int ty, unsigned int) {
+            RasterizeRow(ty);
+        };
+        if (pool)
+            pool->Run(tilesY, rasterizeRow);
+        else
+            for (unsigned int ty = 0; ty < tilesY; ty++)
+                rasterizeRow(ty, 0);
+        stats.triangles = (unsigned int)triangles.size();
+        stats.fullTiles = 0;
+        for (size_t i = 0; i < tiles.size(); i++)
+            stats.fullTiles += tiles[i].zMin[0] > 0.0f ? 1 : 0;
+        stats.rasterMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 世界空间的轴对齐包围盒 可能看得见时返回真
+    bool IsVisible(const glm::vec3 &minimum, const glm::vec3 &maximum) const
+    {
+        float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+        float minW = INFINITY;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec3 corner(c & 1 ? maximum.x : minimum.x, c & 2 ? maximum.y : minimum.y, c & 4 ? maximum.z : minimum.z);
+            glm::vec4 p = viewProjection * glm::vec4(corner, 1.0f);
+            // 有一个角在近平面前面 包围盒挡住了摄像机 一定看得见
+            if (p.z < -p.w)
+                return true;
+            minX = fminf(minX, p.x / p.w);
+            maxX = fmaxf(maxX, p.x / p.w);
+            minY = fminf(minY, p.y / p.w);
+            maxY = fmaxf(maxY, p.y / p.w);
+            minW = fminf(minW, p.w);
+        }
+        // 矩形接触到的像素
+        int x0 = (int)floorf(fmaxf((minX * 0.5f + 0.5f) * Width, 0.0f));
+        int x1 = (int)ceilf(fminf((maxX * 0.5f + 0.5f) * Width, (float)Width)) - 1;
+        int y0 = (int)floorf(fmaxf((minY * 0.5f + 0.5f) * Height, 0.0f));
+        int y1 = (int)ceilf(fminf((maxY * 0.5f + 0.5f) * Height, (float)Height)) - 1;
+        if (x0 > x1 || y0 > y1)
+            return false;
+        // 包围盒上最近的点
+        float zMax = 1.0f / minW;
+
+        for (int ty = y0 / (int)TILE_HEIGHT; ty <= y1 / (int)TILE_HEIGHT; ty++)
+        {
+            for (int tx = x0 / (int)TILE_WIDTH; tx <= x1 / (int)TILE_WIDTH; tx++)
+            {
+                const Tile &tile = tiles[ty * tilesX + tx];
+                if (zMax < tile.zMin[0])
+                    continue;
+                if (zMax >= tile.zMin[1])
+                    return true;
+                // 只在工作层后面 矩形在这一块中的像素必须都在 mask 中
+                int left = std::max(x0 - tx * (int)TILE_WIDTH, 0);
+                int right = std::min(x1 - tx * (int)TILE_WIDTH, (int)TILE_WIDTH - 1);
+                unsigned int columns = (right - left == 31 ? 0xFFFFFFFFu : ((1u << (right - left + 1)) - 1u)) << left;
+                int bottom = std::max(y0 - ty * (int)TILE_HEIGHT, 0);
+                int top = std::min(y1 - ty * (int)TILE_HEIGHT, (int)TILE_HEIGHT - 1);
+                for (int row = bottom; row <= top; row++)
+                    if ((tile.mask[row] & columns) != columns)
+                        return true;
+            }
+        }
+        return false;
+    }
+
+    // 像素 (x, y) 处遮挡物的 1/w 保守的值 0为没有遮挡物 用来显示缓冲的内容
+    float Depth(unsigned int x, unsigned int y) const
+    {
+        const Tile &tile = tiles[(y / TILE_HEIGHT) * tilesX + x / TILE_WIDTH];
+        bool working = (tile.mask[y % TILE_HEIGHT] >> (x % TILE_WIDTH)) & 1u;
+        return working ? fmaxf(tile.zMin[0], tile.zMin[1]) : tile.zMin[0];
+    }
+
+    const OcclusionStats &Stats() const
+    {
+        return stats;
+    }
+
+private:
+    struct Tile {
+        float zMin[2];
+        unsigned int mask[TILE_HEIGHT];
+    };
+
+    // 屏幕空间的三角形 像素坐标 y向上
+    // 边 i 从顶点 i 到 i+1: E(x, y) = a[i] * (x - vx[i]) + b[i] * (y - vy[i]) 三条边都大于0的像素中心在三角形内
+    // 相对顶点计算 裁剪后的顶点离屏幕很远时也不会损失精度
+    struct Triangle {
+        float vx[3], vy[3];
+        float a[3], b[3];
+        float z0, dzdx, dzdy;   // 深度平面 相对顶点0
+        float zMin;             // 三个顶点中最远的
+        int tx0, tx1, ty0, ty1; // 覆盖的块
+    };
+
+    unsigned int tilesX, tilesY;
+    std::vector<Tile> tiles;
+    std::vector<Triangle> triangles;
+    std::vector<glm::vec4> clip;
+    glm::mat4 viewProjection;
+    OcclusionStats stats;
+
+    // 在裁剪空间中按近平面 z >= -w 裁剪 一个三角形最多变成两个
+    void AddTriangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c)
+    {
+        const glm::vec4 *input[3] = { &a, &b, &c };
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const glm::vec4 &p = *input[i];
+            const glm::vec4 &q = *input[(i + 1) % 3];
+            float dp = p.z + p.w;
+            float dq = q.z + q.w;
+            if (dp >= 0.0f)
+                polygon[count++] = p;
+            if ((dp >= 0.0f) != (dq >= 0.0f))
+                polygon[count++] = p + (q - p) * (dp / (dp - dq));
+        }
+        for (int i = 2; i < count; i++)
+            SetupTriangle(polygon[0], polygon[i - 1], polygon[i]);
+    }
+
+    void SetupTriangle(const glm::vec4 &p0, const glm::vec4 &p1, const glm::vec4 &p2)
+    {
+        const glm::vec4 *p[3] = { &p0, &p1, &p2 };
+        Triangle t;
+        float z[3];
+        for (int i = 0; i < 3; i++)
+        {
+            // 在近平面上的点 w 等于近平面的距离 不会是0
+            float invW = 1.0f / p[i]->w;
+            t.vx[i] = (p[i]->x * invW * 0.5f + 0.5f) * Width;
+            t.vy[i] = (p[i]->y * invW * 0.5f + 0.5f) * Height;
+            z[i] = invW;
+        }
+        float e1x = t.vx[1] - t.vx[0], e1y = t.vy[1] - t.vy[0];
+        float e2x = t.vx[2] - t.vx[0], e2y = t.vy[2] - t.vy[0];
+        float area = e1x * e2y - e2x * e1y;
+        // 背面和退化的三角形
+        if (!(area > 0.0f))
+            return;
+
+        float minX = fminf(fminf(t.vx[0], t.vx[1]), t.vx[2]);
+        float maxX = fmaxf(fmaxf(t.vx[0], t.vx[1]), t.vx[2]);
+        float minY = fminf(fminf(t.vy[0], t.vy[1]), t.vy[2]);
+        float maxY = fmaxf(fmaxf(t.vy[0], t.vy[1]), t.vy[2]);
+        if (maxX <= 0.0f || maxY <= 0.0f || minX >= Width || minY >= Height)
+            return;
+        t.tx0 = (int)fmaxf(minX, 0.0f) / TILE_WIDTH;
+        t.tx1 = (int)fminf(maxX, Width - 1.0f) / TILE_WIDTH;
+        t.ty0 = (int)fmaxf(minY, 0.0f) / TILE_HEIGHT;
+        t.ty1 = (int)fminf(maxY, Height - 1.0f) / TILE_HEIGHT;
+
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3;
+            t.a[i] = t.vy[i] - t.vy[j];
+            t.b[i] = t.vx[j] - t.vx[i];
+        }
+        t.z0 = z[0];
+        t.dzdx = ((z[1] - z[0]) * e2y - (z[2] - z[0]) * e1y) / area;
+        t.dzdy = ((z[2] - z[0]) * e1x - (z[1] - z[0]) * e2x) / area;
+        t.zMin = fminf(fminf(z[0], z[1]), z[2]);
+        triangles.push_back(t);
+    }
+
+    void RasterizeRow(unsigned int ty)
+    {
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            const Triangle &t = triangles[i];
+            if ((int)ty < t.ty0 || (int)ty > t.ty1)
+                continue;
+            for (int tx = t.tx0; tx <= t.tx1; tx++)
+                RasterizeTile(t, tx, ty);
+        }
+    }
+
+    void RasterizeTile(const Triangle &t, unsigned int tx, unsigned int ty)
+    {
+        Tile &tile = tiles[ty * tilesX + tx];
+        // 块中像素中心的范围内 深度平面最远(最小)的地方 不会比最远的顶点更远
+        float left = tx * TILE_WIDTH + 0.5f, right = left + TILE_WIDTH - 1.0f;
+        float bottom = ty * TILE_HEIGHT + 0.5f, top = bottom + TILE_HEIGHT - 1.0f;
+        float zTri = t.z0 + t.dzdx * ((t.dzdx > 0.0f ? left : right) - t.vx[0])
+                          + t.dzdy * ((t.dzdy > 0.0f ? bottom : top) - t.vy[0]);
+        zTri = fmaxf(zTri, t.zMin);
+        // 不比参考层近 对这一块没有帮助
+        if (zTri <= tile.zMin[0])
+            return;
+
+        unsigned int coverage[TILE_HEIGHT];
+        unsigned int any = 0;
+        for (unsigned int row = 0; row < TILE_HEIGHT; row++)
+        {
+            coverage[row] = CoverRow(t, left, bottom + row);
+            any |= coverage[row];
+        }
+        if (!any)
+            return;
+        Merge(tile, coverage, zTri);
+    }
+
+    // 并入工作层
+    static void Merge(Tile &tile, const unsigned int coverage[TILE_HEIGHT], float zTri)
+    {
+        bool empty = true;
+        for (unsigned int row = 0; row < TILE_HEIGHT; row++)
+            empty = empty && tile.mask[row] == 0;
+        // 三角形比工作层近得多(距离超过工作层到参考层的距离)时丢掉工作层 从这个三角形重新开始
+        // 否则远近差很多的三角形合在一起 工作层的深度被拉到最远的那个
+        if (empty || zTri - tile.zMin[1] > tile.zMin[1] - tile.zMin[0])
+        {
+            tile.zMin[1] = zTri;
+            memcpy(tile.mask, coverage, sizeof(tile.mask));
+        }
+        else
+        {
+            tile.zMin[1] = fminf(tile.zMin[1], zTri);
+            for (unsigned int row = 0; row < TILE_HEIGHT; row++)
+                tile.mask[row] |= coverage[row];
+        }
+        unsigned int full = 0xFFFFFFFFu;
+        for (unsigned int row = 0; row < TILE_HEIGHT; row++)
+            full &= tile.mask[row];
+        if (full == 0xFFFFFFFFu)
+        {
+            tile.zMin[0] = fmaxf(tile.zMin[0], tile.zMin[1]);
+            tile.zMin[1] = 0.0f;
+            memset(tile.mask, 0, sizeof(tile.mask));
+        }
+    }
+
+    // 一行32个像素中心的覆盖 第 i 位为 x + i
+    static unsigned int CoverRow(const Triangle &t, float x, float y)
+    {
+        unsigned int bits = 0;
+#if defined(OCCLUSION_CULLER_AVX2)
+        const __m256 offsets = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        for (unsigned int group = 0; group < TILE_WIDTH; group += 8)
+        {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int e = 0; e < 3; e++)
+            {
+                __m256 dx = _mm256_add_ps(_mm256_set1_ps(x + group - t.vx[e]), offsets);
+                __m256 edge = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.a[e]), dx), _mm256_set1_ps(t.b[e] * (y - t.vy[e])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(edge, zero, _CMP_GT_OQ));
+            }
+            bits |= (unsigned int)_mm256_movemask_ps(inside) << group;
+        }
+#elif defined(OCCLUSION_CULLER_SSE)
+        const __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 zero = _mm_setzero_ps();
+        for (unsigned int group = 0; group < TILE_WIDTH; group += 4)
+        {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int e = 0; e < 3; e++)
+            {
+                __m128 dx = _mm_add_ps(_mm_set1_ps(x + group - t.vx[e]), offsets);
+                __m128 edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.a[e]), dx), _mm_set1_ps(t.b[e] * (y - t.vy[e])));
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(edge, zero));
+            }
+            bits |= (unsigned int)_mm_movemask_ps(inside) << group;
+        }
+#else
+        for (unsigned int i = 0; i < TILE_WIDTH; i++)
+        {
+            bool inside = true;
+            for (int e = 0; e < 3; e++)
+                inside = inside && t.a[e] * (x + i - t.vx[e]) + t.b[e] * (y - t.vy[e]) > 0.0f;
+            bits |= (inside ? 1u : 0u) << i;
+        }
+#endif
+        return bits;
+    }
+};
+
+#endif
@@ -0,0 +1,339 @@
+#ifndef PHONG_SIMD_H
+#define PHONG_SIMD_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+#include "simd.h"
+
+// CPU上的多光源Phong光照 与12_1的 shader.fs 的 CalcDirLight CalcPointLight CalcSpotLight 相同
+// 用于烘焙光照 验证GPU的结果 和没有GPU时的后备路径
+//
+// 片段按SoA存放: 位置 法线 颜色的每个分量各是一个数组
+// 同一个光源一次照亮相邻的几个片段 每个分量正好装进一个SIMD寄存器 不需要重排
+//   -mavx512f  一次16个片段
+//   -mavx2     一次8个片段
+//   默认       SSE2一次4个 都没有时逐个计算
+//
+// ShadePhongReference 是逐个片段的标量版本 与GLSL逐行对应 用来检查 ShadePhong
+// 贴图不在这里采样 片段自带漫反射贴图和镜面光贴图的颜色(与28_1一样每个片段读一次)
+
+struct PhongDirLight {
+    glm::vec3 direction;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+};
+
+struct PhongPointLight {
+    glm::vec3 position;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+struct PhongSpotLight {
+    glm::vec3 position;
+    glm::vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    glm::vec3 ambient;
+    glm::vec3 diffuse;
+    glm::vec3 specular;
+};
+
+// shader.fs 中除了贴图以外的uniform 光源的数量不限
+struct PhongUniforms {
+    std::vector<PhongDirLight> dirLights;
+    std::vector<PhongPointLight> pointLights;
+    std::vector<PhongSpotLight> spotLights;
+    glm::vec3 viewPos;
+    float shininess;
+};
+
+// 片段的输入和输出 每个分量一个数组
+struct PhongFragments {
+    std::vector<float> posX, posY, posZ;              // FragPos
+    std::vector<float> normalX, normalY, normalZ;     // Normal 不需要归一化
+    std::vector<float> albedoR, albedoG, albedoB;     // 漫反射贴图的颜色
+    std::vector<float> specularR, specularG, specularB; // 镜面光贴图的颜色
+    std::vector<float> colorR, colorG, colorB;        // 输出 FragColor.rgb
+    size_t Count = 0;
+
+    // 补齐的片段法线为 (0,0,1) 位置在原点 算出的颜色不用
+    void Resize(size_t count)
+    {
+        Count = count;
+        size_t padded = (count + SIMD_BLOCK - 1) / SIMD_BLOCK * SIMD_BLOCK;
+        std::vector<float> *arrays[] = { &posX, &posY, &posZ, &normalX, &normalY, &normalZ,
+                                         &albedoR, &albedoG, &albedoB, &specularR, &specularG, &specularB,
+                                         &colorR, &colorG, &colorB };
+        for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+            arrays[i]->assign(padded, 0.0f);
+        normalZ.assign(padded, 1.0f);
+    }
+
+    size_t Padded() const
+    {
+        return posX.size();
+    }
+
+    void Set(size_t i, const glm::vec3 &position, const glm::vec3 &normal, const glm::vec3 &albedo, const glm::vec3 &specular)
+    {
+        posX[i] = position.x; posY[i] = position.y; posZ[i] = position.z;
+        normalX[i] = normal.x; normalY[i] = normal.y; normalZ[i] = normal.z;
+        albedoR[i] = albedo.r; albedoG[i] = albedo.g; albedoB[i] = albedo.b;
+        specularR[i] = specular.r; specularG[i] = specular.g; specularB[i] = specular.b;
+    }
+
+    glm::vec3 Position(size_t i) const { return glm::vec3(posX[i], posY[i], posZ[i]); }
+    glm::vec3 Normal(size_t i) const { return glm::vec3(normalX[i], normalY[i], normalZ[i]); }
+    glm::vec3 Albedo(size_t i) const { return glm::vec3(albedoR[i], albedoG[i], albedoB[i]); }
+    glm::vec3 Specular(size_t i) const { return glm::vec3(specularR[i], specularG[i], specularB[i]); }
+    glm::vec3 Color(size_t i) const { return glm::vec3(colorR[i], colorG[i], colorB[i]); }
+};
+
+// ---------------------------------------------------------------------------
+// 标量版本 与 shader.fs 逐行对应
+
+inline glm::vec3 PhongCalcDirLight(const PhongDirLight &light, const glm::vec3 &normal, const glm::vec3 &viewDir,
+                                   const glm::vec3 &albedo, const glm::vec3 &specularMask, float shininess)
+{
+    glm::vec3 ambient = light.ambient * albedo;
+
+    glm::vec3 lightDir = glm::normalize(-light.direction);
+    float diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    glm::vec3 diffuse = light.diffuse * diff * albedo;
+
+    glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+    float spec = powf(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    glm::vec3 specular = light.specular * spec * specularMask;
+
+    return ambient + diffuse + specular;
+}
+
+inline glm::vec3 PhongCalcPointLight(const PhongPointLight &light, const glm::vec3 &normal, const glm::vec3 &fragPos,
+                                     const glm::vec3 &viewDir, const glm::vec3 &albedo, const glm::vec3 &specularMask, float shininess)
+{
+    glm::vec3 ambient = light.ambient * albedo;
+
+    glm::vec3 lightDir = glm::normalize(light.position - fragPos);
+    float diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    glm::vec3 diffuse = light.diffuse * diff * albedo;
+
+    glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+    float spec = powf(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    glm::vec3 specular = light.specular * spec * specularMask;
+
+    float distance = glm::length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+inline glm::vec3 PhongCalcSpotLight(const PhongSpotLight &light, const glm::vec3 &normal, const glm::vec3 &fragPos,
+                                    const glm::vec3 &viewDir, const glm::vec3 &albedo, const glm::vec3 &specularMask, float shininess)
+{
+    glm::vec3 lightDir = glm::normalize(light.position - fragPos);
+    float theta = glm::dot(lightDir, glm::normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = glm::clamp((theta - light.outerCutOff) / epsilon, 0.0f, 1.0f);
+
+    glm::vec3 ambient = light.ambient * albedo;
+
+    float diff = glm::max(glm::dot(normal, lightDir), 0.0f);
+    glm::vec3 diffuse = light.diffuse * diff * albedo;
+
+    glm::vec3 reflectDir = glm::reflect(-lightDir, normal);
+    float spec = powf(glm::max(glm::dot(viewDir, reflectDir), 0.0f), shininess);
+    glm::vec3 specular = light.specular * spec * specularMask;
+
+    diffuse *= intensity;
+    specular *= intensity;
+
+    return ambient + diffuse + specular;
+}
+
+// 逐个计算 [first, last) 的片段
+inline void ShadePhongReference(const PhongUniforms &uniforms, PhongFragments &fragments, size_t first, size_t last)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        glm::vec3 fragPos = fragments.Position(i);
+        glm::vec3 norm = glm::normalize(fragments.Normal(i));
+        glm::vec3 viewDir = glm::normalize(uniforms.viewPos - fragPos);
+        glm::vec3 albedo = fragments.Albedo(i);
+        glm::vec3 specularMask = fragments.Specular(i);
+
+        glm::vec3 result(0.0f);
+        for (size_t l = 0; l < uniforms.dirLights.size(); l++)
+            result += PhongCalcDirLight(uniforms.dirLights[l], norm, viewDir, albedo, specularMask, uniforms.shininess);
+        for (size_t l = 0; l < uniforms.pointLights.size(); l++)
+            result += PhongCalcPointLight(uniforms.pointLights[l], norm, fragPos, viewDir, albedo, specularMask, uniforms.shininess);
+        for (size_t l = 0; l < uniforms.spotLights.size(); l++)
+            result += PhongCalcSpotLight(uniforms.spotLights[l], norm, fragPos, viewDir, albedo, specularMask, uniforms.shininess);
+
+        fragments.colorR[i] = result.r;
+        fragments.colorG[i] = result.g;
+        fragments.colorB[i] = result.b;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SIMD版本 SimdFloat 的封装见 simd.h
+
+// pow(x, shininess) 指数是非负整数时(章节中都是32或64)用反复平方 32次方只要6次乘法
+// 否则逐个分量调用 powf
+inline SimdFloat PhongPow(SimdFloat x, float exponent)
+{
+    int n = (int)exponent;
+    if ((float)n == exponent && n >= 0 && n <= 4096)
+    {
+        SimdFloat result = SimdSet(1.0f);
+        for (; n; n >>= 1)
+        {
+            if (n & 1)
+                result = result * x;
+            if (n > 1)
+                x = x * x;
+        }
+        return result;
+    }
+    float lanes[SIMD_WIDTH];
+    SimdStore(lanes, x);
+    for (size_t i = 0; i < SIMD_WIDTH; i++)
+        lanes[i] = powf(lanes[i], exponent);
+    return SimdLoad(lanes);
+}
+
+// 计算 [first, last) 的片段 first 和 last 是 SIMD_BLOCK 的倍数 或 last 等于 Count
+// 与 ShadePhongReference 的区别只在浮点运算的顺序:
+//   - 定向光的 normalize(-direction) 和聚光的 1/epsilon 对所有片段相同 在循环外算一次
+//   - reflect(-L, N) 与 V 的点积展开成 2 dot(N,L) dot(N,V) - dot(L,V) 不需要算出反射向量
+//   - 点光源的 normalize 和 length 共用一次开方
+inline void ShadePhong(const PhongUniforms &uniforms, PhongFragments &fragments, size_t first, size_t last)
+{
+    if (last >= fragments.Count)
+        last = fragments.Padded();
+
+    std::vector<glm::vec3> dirLightDirs(uniforms.dirLights.size());
+    for (size_t l = 0; l < uniforms.dirLights.size(); l++)
+        dirLightDirs[l] = glm::normalize(-uniforms.dirLights[l].direction);
+    std::vector<glm::vec3> spotLightDirs(uniforms.spotLights.size());
+    std::vector<float> spotLightScales(uniforms.spotLights.size());
+    for (size_t l = 0; l < uniforms.spotLights.size(); l++)
+    {
+        spotLightDirs[l] = glm::normalize(-uniforms.spotLights[l].direction);
+        spotLightScales[l] = 1.0f / (uniforms.spotLights[l].cutOff - uniforms.spotLights[l].outerCutOff);
+    }
+
+    const SimdFloat zero = SimdSet(0.0f);
+    const SimdFloat one = SimdSet(1.0f);
+    const SimdFloat two = SimdSet(2.0f);
+
+    for (size_t i = first; i < last; i += SIMD_WIDTH)
+    {
+        SimdFloat px = SimdLoad(&fragments.posX[i]);
+        SimdFloat py = SimdLoad(&fragments.posY[i]);
+        SimdFloat pz = SimdLoad(&fragments.posZ[i]);
+
+        SimdFloat nx = SimdLoad(&fragments.normalX[i]);
+        SimdFloat ny = SimdLoad(&fragments.normalY[i]);
+        SimdFloat nz = SimdLoad(&fragments.normalZ[i]);
+        SimdFloat invLength = one / SimdSqrt(nx * nx + ny * ny + nz * nz);
+        nx = nx * invLength; ny = ny * invLength; nz = nz * invLength;
+
+        SimdFloat vx = SimdSet(uniforms.viewPos.x) - px;
+        SimdFloat vy = SimdSet(uniforms.viewPos.y) - py;
+        SimdFloat vz = SimdSet(uniforms.viewPos.z) - pz;
+        invLength = one / SimdSqrt(vx * vx + vy * vy + vz * vz);
+        vx = vx * invLength; vy = vy * invLength; vz = vz * invLength;
+        SimdFloat nDotV = nx * vx + ny * vy + nz * vz;
+
+        SimdFloat albedoR = SimdLoad(&fragments.albedoR[i]);
+        SimdFloat albedoG = SimdLoad(&fragments.albedoG[i]);
+        SimdFloat albedoB = SimdLoad(&fragments.albedoB[i]);
+        SimdFloat specularR = SimdLoad(&fragments.specularR[i]);
+        SimdFloat specularG = SimdLoad(&fragments.specularG[i]);
+        SimdFloat specularB = SimdLoad(&fragments.specularB[i]);
+
+        SimdFloat r = zero, g = zero, b = zero;
+
+        for (size_t l = 0; l < uniforms.dirLights.size(); l++)
+        {
+            const PhongDirLight &light = uniforms.dirLights[l];
+            SimdFloat lx = SimdSet(dirLightDirs[l].x), ly = SimdSet(dirLightDirs[l].y), lz = SimdSet(dirLightDirs[l].z);
+            SimdFloat nDotL = nx * lx + ny * ly + nz * lz;
+            SimdFloat diff = SimdMax(nDotL, zero);
+            SimdFloat lDotV = lx * vx + ly * vy + lz * vz;
+            SimdFloat spec = PhongPow(SimdMax(two * nDotL * nDotV - lDotV, zero), uniforms.shininess);
+
+            r = r + (SimdSet(light.ambient.r) + SimdSet(light.diffuse.r) * diff) * albedoR + SimdSet(light.specular.r) * spec * specularR;
+            g = g + (SimdSet(light.ambient.g) + SimdSet(light.diffuse.g) * diff) * albedoG + SimdSet(light.specular.g) * spec * specularG;
+            b = b + (SimdSet(light.ambient.b) + SimdSet(light.diffuse.b) * diff) * albedoB + SimdSet(light.specular.b) * spec * specularB;
+        }
+
+        for (size_t l = 0; l < uniforms.pointLights.size(); l++)
+        {
+            const PhongPointLight &light = uniforms.pointLights[l];
+            SimdFloat lx = SimdSet(light.position.x) - px;
+            SimdFloat ly = SimdSet(light.position.y) - py;
+            SimdFloat lz = SimdSet(light.position.z) - pz;
+            SimdFloat distance = SimdSqrt(lx * lx + ly * ly + lz * lz);
+            invLength = one / distance;
+            lx = lx * invLength; ly = ly * invLength; lz = lz * invLength;
+
+            SimdFloat nDotL = nx * lx + ny * ly + nz * lz;
+            SimdFloat diff = SimdMax(nDotL, zero);
+            SimdFloat lDotV = lx * vx + ly * vy + lz * vz;
+            SimdFloat spec = PhongPow(SimdMax(two * nDotL * nDotV - lDotV, zero), uniforms.shininess);
+            SimdFloat attenuation = one / (SimdSet(light.constant) + SimdSet(light.linear) * distance + SimdSet(light.quadratic) * (distance * distance));
+
+            r = r + ((SimdSet(light.ambient.r) + SimdSet(light.diffuse.r) * diff) * albedoR + SimdSet(light.specular.r) * spec * specularR) * attenuation;
+            g = g + ((SimdSet(light.ambient.g) + SimdSet(light.diffuse.g) * diff) * albedoG + SimdSet(light.specular.g) * spec * specularG) * attenuation;
+            b = b + ((SimdSet(light.ambient.b) + SimdSet(light.diffuse.b) * diff) * albedoB + SimdSet(light.specular.b) * spec * specularB) * attenuation;
+        }
+
+        for (size_t l = 0; l < uniforms.spotLights.size(); l++)
+        {
+            const PhongSpotLight &light = uniforms.spotLights[l];
+            SimdFloat lx = SimdSet(light.position.x) - px;
+            SimdFloat ly = SimdSet(light.position.y) - py;
+            SimdFloat lz = SimdSet(light.position.z) - pz;
+            invLength = one / SimdSqrt(lx * lx + ly * ly + lz * lz);
+            lx = lx * invLength; ly = ly * invLength; lz = lz * invLength;
+
+            SimdFloat theta = lx * SimdSet(spotLightDirs[l].x) + ly * SimdSet(spotLightDirs[l].y) + lz * SimdSet(spotLightDirs[l].z);
+            SimdFloat intensity = SimdMin(SimdMax((theta - SimdSet(light.outerCutOff)) * SimdSet(spotLightScales[l]), zero), one);
+
+            SimdFloat nDotL = nx * lx + ny * ly + nz * lz;
+            SimdFloat diff = SimdMax(nDotL, zero) * intensity;
+            SimdFloat lDotV = lx * vx + ly * vy + lz * vz;
+            SimdFloat spec = PhongPow(SimdMax(two * nDotL * nDotV - lDotV, zero), uniforms.shininess) * intensity;
+
+            r = r + (SimdSet(light.ambient.r) + SimdSet(light.diffuse.r) * diff) * albedoR + SimdSet(light.specular.r) * spec * specularR;
+            g = g + (SimdSet(light.ambient.g) + SimdSet(light.diffuse.g) * diff) * albedoG + SimdSet(light.specular.g) * spec * specularG;
+            b = b + (SimdSet(light.ambient.b) + SimdSet(light.diffuse.b) * diff) * albedoB + SimdSet(light.specular.b) * spec * specularB;
+        }
+
+        SimdStore(&fragments.colorR[i], r);
+        SimdStore(&fragments.colorG[i], g);
+        SimdStore(&fragments.colorB[i], b);
+    }
+#if defined(SIMD_AVX512) || defined(SIMD_AVX2)
+    // 调用者可能接着运行不带VEX前缀的SSE代码 见28_1
+    _mm256_zeroupper();
+#endif
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef POINT_LIGHTS_H
+#define POINT_LIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include "frustum.h"
+
+// 大量点光源的数据
+//
+// 12_1的点光源在着色器中是 uniform PointLight pointLights[NR_POINT_LIGHTS] 数量在编译时固定
+// uniform数组最多只能放几百个光源 这里把光源放进缓冲纹理(GL_TEXTURE_BUFFER) 着色器用 texelFetch 读取
+// 数量只受显存限制 3.3就支持
+//
+// 12_1中点光源的 ambient diffuse specular 分别是颜色的 0.05 0.8 1.0 倍 这里只保存颜色
+
+// 每个光源占3个 RGBA32F 的纹素:
+//   0: position.xyz radius
+//   1: color.rgb    constant
+//   2: linear quadratic 0 0
+const unsigned int POINT_LIGHT_TEXELS = 3;
+
+struct PointLight {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding[2];
+};
+
+// 衰减 1/(constant + linear*d + quadratic*d^2) 乘以颜色最亮的分量 小于 threshold 的距离
+// 默认阈值1/256 超出半径的光照在8位的颜色中已经看不出来 着色器在半径外直接跳过这个光源
+inline float PointLightRadius(const glm::vec3 &color, float constant, float linear, float quadratic, float threshold = 1.0f / 256.0f)
+{
+    float brightest = fmaxf(fmaxf(color.r, color.g), color.b);
+    // 解 quadratic*d^2 + linear*d + constant - brightest/threshold = 0
+    float c = constant - brightest / threshold;
+    if (c >= 0.0f)
+        return 0.0f;
+    if (quadratic <= 0.0f)
+        return linear > 0.0f ? -c / linear : INFINITY;
+    return (-linear + sqrtf(linear * linear - 4.0f * quadratic * c)) / (2.0f * quadratic);
+}
+
+inline void UpdatePointLightRadius(PointLight &light, float threshold = 1.0f / 256.0f)
+{
+    light.radius = PointLightRadius(light.color, light.constant, light.linear, light.quadratic, threshold);
+}
+
+// 按照常用的衰减表 覆盖 range 距离的光源 linear = 4.5 / range  quadratic = 75 / range^2
+// 比如 range 为50时是 0.09 0.0300 与12_1的 0.09 0.032 相近
+inline void SetPointLightRange(PointLight &light, float range)
+{
+    light.constant = 1.0f;
+    light.linear = 4.5f / range;
+    light.quadratic = 75.0f / (range * range);
+    UpdatePointLightRadius(light);
+}
+
+// 距离光源 distance 处光照的强度(颜色最亮的分量乘以衰减) 用来比较哪个光源对一个物体更重要
+inline float PointLightIntensity(const PointLight &light, float distance)
+{
+    float brightest = fmaxf(fmaxf(light.color.r, light.color.g), light.color.b);
+    return brightest / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+}
+
+// 半径与视锥体相交的光源编号放进 visible
+inline void CullPointLights(const std::vector<PointLight> &lights, const Frustum &frustum, std::vector<unsigned int> &visible)
+{
+    visible.clear();
+    for (unsigned int i = 0; i < (unsigned int)lights.size(); i++)
+        if (frustum.IntersectsSphere(lights[i].position, lights[i].radius))
+            visible.push_back(i);
+}
+
+// 照到一个物体的光源: candidates 中半径与物体的包围球相交的光源复制到 out
+// 超过 limit 个时只保留在物体上最亮的 limit 个 返回截断之前的个数
+inline unsigned int GatherPointLights(const std::vector<PointLight> &lights, const std::vector<unsigned int> &candidates,
+                                      const glm::vec3 &center, float radius, unsigned int limit, std::vector<PointLight> &out)
+{
+    out.clear();
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        const PointLight &light = lights[candidates[i]];
+        glm::vec3 offset = light.position - center;
+        float reach = light.radius + radius;
+        if (glm::dot(offset, offset) <= reach * reach)
+            out.push_back(light);
+    }
+    unsigned int count = (unsigned int)out.size();
+    if (count > limit)
+    {
+        // 按光源到包围球表面的距离估计亮度
+        std::partial_sort(out.begin(), out.begin() + limit, out.end(), [&](const PointLight &a, const PointLight &b) {
+            float da = fmaxf(0.0f, glm::length(a.position - center) - radius);
+            float db = fmaxf(0.0f, glm::length(b.position - center) - radius);
+            return PointLightIntensity(a, da) > PointLightIntensity(b, db);
+        });
+        out.resize(limit);
+    }
+    return count;
+}
+
+// 在 [boundsMin, boundsMax] 中随机放置 count 个光源 颜色随机 最亮的分量为 intensity
+inline std::vector<PointLight> MakePointLights(unsigned int count, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                                               float range, float intensity, unsigned int seed = 1)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<PointLight> lights(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        PointLight &light = lights[i];
+        light.position = boundsMin + (boundsMax - boundsMin) * glm::vec3(unit(random), unit(random), unit(random));
+        // 饱和度较高的颜色
+        glm::vec3 color = glm::mix(glm::vec3(unit(random), unit(random), unit(random)), glm::vec3(1.0f), 0.2f);
+        light.color = color / fmaxf(fmaxf(color.r, color.g), color.b) * intensity;
+        light.padding[0] = light.padding[1] = 0.0f;
+        SetPointLightRange(light, range);
+    }
+    return lights;
+}
+
+// 保存所有光源的缓冲纹理 每帧用 Upload 更新
+class PointLightBuffer
+{
+public:
+    unsigned int Buffer;
+    unsigned int Texture;
+    unsigned int Capacity;
+
+    PointLightBuffer(unsigned int capacity) : Capacity(capacity)
+    {
+        glGenBuffers(1, &Buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, Buffer);
+        glBufferData(GL_TEXTURE_BUFFER, Capacity * sizeof(PointLight), NULL, GL_STREAM_DRAW);
+        glGenTextures(1, &Texture);
+        glBindTexture(GL_TEXTURE_BUFFER, Texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, Buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~PointLightBuffer()
+    {
+        glDeleteTextures(1, &Texture);
+        glDeleteBuffers(1, &Buffer);
+    }
+
+    // 光源数量超过容量时重新分配 每帧都先丢弃旧的存储(orphaning)
+    void Upload(const std::vector<PointLight> &lights)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, Buffer);
+        if (lights.size() > Capacity)
+            Capacity = (unsigned int)lights.size();
+        glBufferData(GL_TEXTURE_BUFFER, Capacity * sizeof(PointLight), NULL, GL_STREAM_DRAW);
+        if (!lights.empty())
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, lights.size() * sizeof(PointLight), lights.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // 绑定到纹理单元 unit 着色器中是 samplerBuffer
+    void Bind(unsigned int unit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, Texture);
+    }
+
+private:
+    PointLightBuffer(const PointLightBuffer&);
+    PointLightBuffer &operator=(const PointLightBuffer&);
+};
+
+#endif
@@ -0,0 +1,422 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+
+// CPU/GPU 帧分析器
+//
+// CPU区间用 steady_clock 计时 作用域结束时立即得到结果
+// GPU区间在开始和结束处各插入一个 glQueryCounter(GL_TIMESTAMP) 两个时间戳的差就是GPU执行这段命令的时间
+// GL_TIME_ELAPSED 查询不能嵌套 时间戳可以 所以层次结构的GPU区间都用时间戳
+//
+// 查询结果要等GPU执行完才有 立即读取会让CPU等待GPU
+// 查询对象按帧分成 LATENCY 组轮流使用 每帧开始时只读取已经可用(GL_QUERY_RESULT_AVAILABLE)的旧帧
+// 一组查询再次被使用时结果仍不可用 就丢弃这一帧的GPU数据 而不是等待
+//
+// 每帧每个区间的耗时(同名区间累加)进入滚动的历史 可以得到 min/avg/p99
+// 所有区间可以导出为 Chrome 的 trace_event JSON 用 chrome://tracing 或 Perfetto 打开
+
+struct ProfileEvent {
+    const char *name;
+    unsigned int depth;
+    double startMs;        // 相对于分析器创建的时间
+    double durationMs;
+    bool gpu;
+    unsigned int frame;
+};
+
+struct ProfileStats {
+    double minMs;
+    double avgMs;
+    double p99Ms;
+    unsigned int samples;
+};
+
+class Profiler
+{
+public:
+    // 查询结果最多延迟的帧数
+    static const unsigned int LATENCY = 4;
+
+    // 为假时所有调用直接返回
+    bool Enabled;
+
+    // history: 统计使用的最近帧数  maxEvents: 为导出保留的区间个数上限
+    Profiler(unsigned int history = 240, size_t maxEvents = 1 << 20)
+        : Enabled(true), history(history), maxEvents(maxEvents), frame(0), inFrame(false), droppedFrames(0)
+    {
+        origin = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < LATENCY; i++)
+        {
+            slots[i].frame = 0;
+            slots[i].used = 0;
+            slots[i].pending = false;
+        }
+    }
+
+    ~Profiler()
+    {
+        for (unsigned int i = 0; i < LATENCY; i++)
+        {
+            if (!slots[i].queries.empty())
+                glDeleteQueries((GLsizei)slots[i].queries.size(), slots[i].queries.data());
+        }
+    }
+
+    void BeginFrame()
+    {
+        if (!Enabled)
+            return;
+        frame++;
+        inFrame = true;
+        // 先收集所有已经可用的旧帧 然后才重用这一帧的查询组
+        for (unsigned int i = 1; i < LATENCY; i++)
+            Resolve(slots[(frame + i) % LATENCY], false);
+        Slot &slot = slots[frame % LATENCY];
+        Resolve(slot, true);
+        slot.frame = frame;
+        slot.used = 0;
+        slot.scopes.clear();
+        // 同一时刻的CPU时间和GPU时间 用于把GPU区间放到CPU的时间轴上
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        slot.gpuBase = (uint64_t)gpuNow;
+        slot.cpuBaseMs = NowMs();
+        cpuTotals.clear();
+        BeginCPU("frame");
+        BeginGPU("frame");
+    }
+
+    void EndFrame()
+    {
+        if (!Enabled || !inFrame)
+            return;
+        while (!gpuStack.empty())
+            EndGPU();
+        while (!cpuStack.empty())
+            EndCPU();
+        Slot &slot = slots[frame % LATENCY];
+        slot.pending = !slot.scopes.empty();
+        for (std::map<std::string, double>::iterator it = cpuTotals.begin(); it != cpuTotals.end(); ++it)
+            AddSample(cpuSeries, it->first, it->second);
+        inFrame = false;
+    }
+
+    // name 只保存指针 必须是字符串常量
+    void BeginCPU(const char *name)
+    {
+        if (!Enabled)
+            return;
+        OpenScope scope;
+        scope.name = name;
+        scope.startMs = NowMs();
+        cpuStack.push_back(scope);
+    }
+
+    void EndCPU()
+    {
+        if (!Enabled || cpuStack.empty())
+            return;
+        OpenScope scope = cpuStack.back();
+        cpuStack.pop_back();
+        double duration = NowMs() - scope.startMs;
+        ProfileEvent event;
+        event.name = scope.name;
+        event.depth = (unsigned int)cpuStack.size();
+        event.startMs = scope.startMs;
+        event.durationMs = duration;
+        event.gpu = false;
+        event.frame = frame;
+        Record(event);
+        cpuTotals[scope.name] += duration;
+    }
+
+    void BeginGPU(const char *name)
+    {
+        if (!Enabled || !inFrame)
+            return;
+        Slot &slot = slots[frame % LATENCY];
+        PendingScope scope;
+        scope.name = name;
+        scope.depth = (unsigned int)gpuStack.size();
+        scope.begin = NextQuery(slot);
+        scope.end = ~0u;
+        glQueryCounter(slot.queries[scope.begin], GL_TIMESTAMP);
+        gpuStack.push_back((unsigned int)slot.scopes.size());
+        slot.scopes.push_back(scope);
+    }
+
+    void EndGPU()
+    {
+        if (!Enabled || !inFrame || gpuStack.empty())
+            return;
+        Slot &slot = slots[frame % LATENCY];
+        PendingScope &scope = slot.scopes[gpuStack.back()];
+        gpuStack.pop_back();
+        scope.end = NextQuery(slot);
+        glQueryCounter(slot.queries[scope.end], GL_TIMESTAMP);
+    }
+
+    // name 区间最近若干帧的统计 没有数据时 samples 为0
+    ProfileStats Stats(const std::string &name, bool gpu) const
+    {
+        ProfileStats stats = { 0.0, 0.0, 0.0, 0 };
+        const std::map<std::string, Series> &series = gpu ? gpuSeries : cpuSeries;
+        std::map<std::string, Series>::const_iterator it = series.find(name);
+        if (it == series.end() || it->second.values.empty())
+            return stats;
+        std::vector<double> values = it->second.values;
+        stats.samples = (unsigned int)values.size();
+        stats.minMs = *std::min_element(values.begin(), values.end());
+        double sum = 0.0;
+        for (size_t i = 0; i < values.size(); i++)
+            sum += values[i];
+        stats.avgMs = sum / values.size();
+        size_t rank = (values.size() * 99 + 99) / 100 - 1;
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        stats.p99Ms = values[rank];
+        return stats;
+    }
+
+    // 输出所有区间的统计 按名字排序
+    void Print(std::ostream &out) const
+    {
+        out << "scope              where  min ms     avg ms     p99 ms     frames" << std::endl;
+        PrintSeries(out, cpuSeries, false);
+        PrintSeries(out, gpuSeries, true);
+        if (droppedFrames)
+            out << droppedFrames << " frames of GPU timings dropped (results not ready after " << LATENCY << " frames)" << std::endl;
+    }
+
+    // Chrome trace_event 格式 CPU区间在线程1 GPU区间在线程2
+    bool WriteTrace(const char *path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::PROFILER::FILE_NOT_WRITTEN " << path << std::endl;
+            return false;
+        }
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+        file.precision(3);
+        file << std::fixed;
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            const ProfileEvent &event = events[i];
+            file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+                 << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (event.gpu ? 2 : 1)
+                 << ",\"ts\":" << event.startMs * 1000.0 << ",\"dur\":" << event.durationMs * 1000.0
+                 << ",\"args\":{\"frame\":" << event.frame << "}}";
+        }
+        file << "\n]}\n";
+        return true;
+    }
+
+    const std::vector<ProfileEvent> &Events() const
+    {
+        return events;
+    }
+
+    unsigned int Frame() const
+    {
+        return frame;
+    }
+
+private:
+    struct OpenScope {
+        const char *name;
+        double startMs;
+    };
+
+    struct PendingScope {
+        const char *name;
+        unsigned int depth;
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    // 一帧的查询组
+    struct Slot {
+        std::vector<GLuint> queries;
+        unsigned int used;
+        std::vector<PendingScope> scopes;
+        unsigned int frame;
+        uint64_t gpuBase;
+        double cpuBaseMs;
+        bool pending;
+    };
+
+    // 滚动的历史 写满后覆盖最旧的值
+    struct Series {
+        std::vector<double> values;
+        size_t next;
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    unsigned int history;
+    size_t maxEvents;
+    unsigned int frame;
+    bool inFrame;
+    unsigned int droppedFrames;
+    Slot slots[LATENCY];
+    std::vector<OpenScope> cpuStack;
+    std::vector<unsigned int> gpuStack;
+    std::map<std::string, double> cpuTotals;
+    std::map<std::string, Series> cpuSeries;
+    std::map<std::string, Series> gpuSeries;
+    std::vector<ProfileEvent> events;
+
+    Profiler(const Profiler&);
+    Profiler &operator=(const Profiler&);
+
+    double NowMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    unsigned int NextQuery(Slot &slot)
+    {
+        if (slot.used == slot.queries.size())
+        {
+            GLuint query;
+            glGenQueries(1, &query);
+            slot.queries.push_back(query);
+        }
+        return slot.used++;
+    }
+
+    void Record(const ProfileEvent &event)
+    {
+        if (events.size() < maxEvents)
+            events.push_back(event);
+    }
+
+    void AddSample(std::map<std::string, Series> &series, const std::string &name, double value)
+    {
+        Series &s = series[name];
+        if (s.values.size() < history)
+        {
+            s.values.push_back(value);
+            s.next = s.values.size() % history;
+        }
+        else
+        {
+            s.values[s.next] = value;
+            s.next = (s.next + 1) % history;
+        }
+    }
+
+    // 读取一帧的GPU时间戳 force 为真表示这组查询马上要被重用 不可用就丢弃
+    void Resolve(Slot &slot, bool force)
+    {
+        if (!slot.pending)
+            return;
+        // 查询按提交顺序完成 最后一个可用时前面的都可用
+        GLuint available = 0;
+        glGetQueryObjectuiv(slot.queries[slot.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            if (force)
+            {
+                slot.pending = false;
+                droppedFrames++;
+            }
+            return;
+        }
+        std::map<std::string, double> totals;
+        for (size_t i = 0; i < slot.scopes.size(); i++)
+        {
+            const PendingScope &scope = slot.scopes[i];
+            // 没有配对的 EndGPU
+            if (scope.end == ~0u)
+                continue;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(slot.queries[scope.begin], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(slot.queries[scope.end], GL_QUERY_RESULT, &end);
+            ProfileEvent event;
+            event.name = scope.name;
+            event.depth = scope.depth;
+            event.startMs = slot.cpuBaseMs + ((double)(int64_t)(begin - slot.gpuBase)) / 1e6;
+            event.durationMs = (double)(end - begin) / 1e6;
+            event.gpu = true;
+            event.frame = slot.frame;
+            Record(event);
+            totals[scope.name] += event.durationMs;
+        }
+        for (std::map<std::string, double>::iterator it = totals.begin(); it != totals.end(); ++it)
+            AddSample(gpuSeries, it->first, it->second);
+        slot.pending = false;
+    }
+
+    void PrintSeries(std::ostream &out, const std::map<std::string, Series> &series, bool gpu) const
+    {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision(3);
+        out << std::fixed;
+        for (std::map<std::string, Series>::const_iterator it = series.begin(); it != series.end(); ++it)
+        {
+            ProfileStats stats = Stats(it->first, gpu);
+            out.width(18);
+            out << std::left << it->first << " ";
+            out.width(6);
+            out << (gpu ? "GPU" : "CPU") << " ";
+            out.width(10);
+            out << stats.minMs << " ";
+            out.width(10);
+            out << stats.avgMs << " ";
+            out.width(10);
+            out << stats.p99Ms << " ";
+            out << stats.samples << std::endl;
+        }
+        out.flags(flags);
+        out.precision(precision);
+    }
+};
+
+// 作用域结束时自动结束的区间
+class CPUScope
+{
+public:
+    CPUScope(Profiler &profiler, const char *name) : profiler(profiler)
+    {
+        profiler.BeginCPU(name);
+    }
+
+    ~CPUScope()
+    {
+        profiler.EndCPU();
+    }
+
+private:
+    Profiler &profiler;
+};
+
+class GPUScope
+{
+public:
+    GPUScope(Profiler &profiler, const char *name) : profiler(profiler)
+    {
+        profiler.BeginGPU(name);
+    }
+
+    ~GPUScope()
+    {
+        profiler.EndGPU();
+    }
+
+private:
+    Profiler &profiler;
+};
+
+#endif
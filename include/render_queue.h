@@ -0,0 +1,289 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+#include "shader_m.h"
+
+// 渲染队列
+//
+// 章节中的渲染循环按代码的书写顺序切换着色器 绑定纹理和VAO 每个物体都重新设置一遍
+// 这里先把一帧所有的绘制记录下来 每个绘制对应一个64位的排序键
+// 排序后相同状态的绘制挨在一起 回放时只在状态变化的地方调用 glUseProgram glBindTexture glBindVertexArray
+//
+// 不透明物体的排序键 高位到低位:
+//   pass(4) | program(8) | material(12) | VAO(12) | depth(28)
+// 先按pass分开 pass内状态相同的放在一起 最后按深度从近到远(减少被遮挡片段的着色)
+// 半透明物体必须从远到近绘制 所以深度放在状态之前 并且取反:
+//   pass(4) | ~depth(28) | program(8) | material(12) | VAO(12)
+
+enum Render_Pass {
+    PASS_OPAQUE = 0,
+    PASS_LIGHTS = 1,
+    PASS_TRANSPARENT = 2
+};
+
+const unsigned int RENDER_QUEUE_MAX_PROGRAMS = 1u << 8;
+const unsigned int RENDER_QUEUE_MAX_MATERIALS = 1u << 12;
+const unsigned int RENDER_QUEUE_MAX_VAOS = 1u << 12;
+const unsigned int RENDER_QUEUE_DEPTH_BITS = 28;
+const unsigned int RENDER_QUEUE_MAX_TEXTURES = 4;
+
+// 材质: 依次绑定到纹理单元 0, 1, ... 的纹理 以及反光度
+struct RenderMaterial {
+    unsigned int textures[RENDER_QUEUE_MAX_TEXTURES];
+    unsigned int textureCount;
+    float shininess;
+};
+
+// 一次绘制的参数
+// indexed 为真时 first 是EBO中第一个索引的位置 否则是第一个顶点
+struct DrawCommand {
+    glm::mat4 model;
+    GLenum mode;
+    GLsizei count;
+    unsigned int first;
+    bool indexed;
+};
+
+// 每帧的统计
+struct RenderQueueStats {
+    unsigned int draws;
+    unsigned int programChanges;
+    unsigned int materialChanges;
+    unsigned int textureChanges;
+    unsigned int vaoChanges;
+    double sortMs;
+};
+
+class RenderQueue
+{
+public:
+    // 为假时按提交顺序回放 仍然跳过重复的状态设置 用于对比
+    bool Sort;
+
+    RenderQueue() : Sort(true), frame(0)
+    {
+        memset(&stats, 0, sizeof(stats));
+        // 材质0表示不绑定任何纹理(比如光源)
+        RenderMaterial none;
+        memset(&none, 0, sizeof(none));
+        materials.push_back(none);
+    }
+
+    // 着色器在一帧中第一次被使用时调用 setup 设置每帧不变的uniform(投影 观察矩阵 光源等)
+    unsigned int RegisterProgram(const Shader *shader, std::function<void(const Shader&)> setup)
+    {
+        Program program;
+        program.shader = shader;
+        program.setup = setup;
+        program.modelLocation = glGetUniformLocation(shader->ID, "model");
+        program.shininessLocation = glGetUniformLocation(shader->ID, "material.shininess");
+        program.frame = 0;
+        programs.push_back(program);
+        return (unsigned int)programs.size() - 1;
+    }
+
+    unsigned int RegisterMaterial(const RenderMaterial &material)
+    {
+        materials.push_back(material);
+        return (unsigned int)materials.size() - 1;
+    }
+
+    unsigned int RegisterVAO(unsigned int VAO)
+    {
+        vaos.push_back(VAO);
+        return (unsigned int)vaos.size() - 1;
+    }
+
+    // depth 为物体到相机的距离除以远平面 范围 [0, 1]
+    static uint64_t MakeKey(unsigned int pass, unsigned int program, unsigned int material, unsigned int vao, float depth)
+    {
+        const uint64_t depthMask = (1ull << RENDER_QUEUE_DEPTH_BITS) - 1;
+        depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+        uint64_t d = (uint64_t)(depth * (float)depthMask) & depthMask;
+        uint64_t state = ((uint64_t)program << 24) | ((uint64_t)material << 12) | (uint64_t)vao;
+        if (pass >= PASS_TRANSPARENT)
+            return ((uint64_t)pass << 60) | ((depthMask - d) << 32) | state;
+        return ((uint64_t)pass << 60) | (state << RENDER_QUEUE_DEPTH_BITS) | d;
+    }
+
+    void Clear()
+    {
+        entries.clear();
+        commands.clear();
+    }
+
+    void Submit(unsigned int pass, unsigned int program, unsigned int material, unsigned int vao, float depth, const DrawCommand &command)
+    {
+        Entry entry;
+        entry.key = MakeKey(pass, program, material, vao, depth);
+        entry.index = (unsigned int)commands.size();
+        entries.push_back(entry);
+        Command c;
+        c.draw = command;
+        c.program = program;
+        c.material = material;
+        c.vao = vao;
+        commands.push_back(c);
+    }
+
+    unsigned int Size() const
+    {
+        return (unsigned int)entries.size();
+    }
+
+    // 排序 回放 然后清空队列
+    void Flush()
+    {
+        memset(&stats, 0, sizeof(stats));
+        frame++;
+        if (Sort)
+        {
+            auto start = std::chrono::steady_clock::now();
+            RadixSort();
+            stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        // 当前的状态 ~0u 表示未知 每帧开始时都重新绑定一次
+        unsigned int currentProgram = ~0u, currentMaterial = ~0u, currentVAO = ~0u;
+        unsigned int boundTextures[RENDER_QUEUE_MAX_TEXTURES];
+        for (unsigned int i = 0; i < RENDER_QUEUE_MAX_TEXTURES; i++)
+            boundTextures[i] = ~0u;
+        for (size_t i = 0; i < entries.size(); i++)
+        {
+            const Command &c = commands[entries[i].index];
+            Program &program = programs[c.program];
+            bool programChanged = c.program != currentProgram;
+            if (programChanged)
+            {
+                program.shader->use();
+                if (program.frame != frame)
+                {
+                    program.setup(*program.shader);
+                    program.frame = frame;
+                }
+                currentProgram = c.program;
+                stats.programChanges++;
+            }
+            // 反光度是着色器的uniform 换了着色器也要重新设置
+            if (c.material != currentMaterial || programChanged)
+            {
+                const RenderMaterial &material = materials[c.material];
+                for (unsigned int t = 0; t < material.textureCount; t++)
+                {
+                    if (boundTextures[t] != material.textures[t])
+                    {
+                        glActiveTexture(GL_TEXTURE0 + t);
+                        glBindTexture(GL_TEXTURE_2D, material.textures[t]);
+                        boundTextures[t] = material.textures[t];
+                        stats.textureChanges++;
+                    }
+                }
+                if (program.shininessLocation >= 0 && c.material != 0)
+                    glUniform1f(program.shininessLocation, material.shininess);
+                if (c.material != currentMaterial)
+                    stats.materialChanges++;
+                currentMaterial = c.material;
+            }
+            if (c.vao != currentVAO)
+            {
+                glBindVertexArray(vaos[c.vao]);
+                currentVAO = c.vao;
+                stats.vaoChanges++;
+            }
+            glUniformMatrix4fv(program.modelLocation, 1, GL_FALSE, &c.draw.model[0][0]);
+            if (c.draw.indexed)
+                glDrawElements(c.draw.mode, c.draw.count, GL_UNSIGNED_INT, (void*)(c.draw.first * sizeof(unsigned int)));
+            else
+                glDrawArrays(c.draw.mode, (GLint)c.draw.first, c.draw.count);
+            stats.draws++;
+        }
+        Clear();
+    }
+
+    const RenderQueueStats &Stats() const
+    {
+        return stats;
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        unsigned int index;
+    };
+
+    struct Command {
+        DrawCommand draw;
+        unsigned int program;
+        unsigned int material;
+        unsigned int vao;
+    };
+
+    struct Program {
+        const Shader *shader;
+        std::function<void(const Shader&)> setup;
+        int modelLocation;
+        int shininessLocation;
+        unsigned int frame;
+    };
+
+    std::vector<Program> programs;
+    std::vector<RenderMaterial> materials;
+    std::vector<unsigned int> vaos;
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;
+    std::vector<Command> commands;
+    RenderQueueStats stats;
+    unsigned int frame;
+
+    // 低位优先的基数排序 每次处理8位 共8趟
+    // 所有键在某一字节上都相同时(比如pass只有一两种) 这一趟直接跳过
+    // 排序是稳定的 键相同的绘制保持提交顺序
+    void RadixSort()
+    {
+        size_t n = entries.size();
+        if (n < 2)
+            return;
+        scratch.resize(n);
+        size_t counts[8][256];
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < n; i++)
+        {
+            uint64_t key = entries[i].key;
+            for (int b = 0; b < 8; b++)
+                counts[b][(key >> (b * 8)) & 0xff]++;
+        }
+        Entry *from = entries.data();
+        Entry *to = scratch.data();
+        for (int b = 0; b < 8; b++)
+        {
+            size_t *count = counts[b];
+            if (count[(from[0].key >> (b * 8)) & 0xff] == n)
+                continue;
+            size_t offset = 0;
+            for (int d = 0; d < 256; d++)
+            {
+                size_t c = count[d];
+                count[d] = offset;
+                offset += c;
+            }
+            for (size_t i = 0; i < n; i++)
+                to[count[(from[i].key >> (b * 8)) & 0xff]++] = from[i];
+            Entry *swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from != entries.data())
+            memcpy(entries.data(), from, n * sizeof(Entry));
+    }
+};
+
+#endif
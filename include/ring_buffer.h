@@ -0,0 +1,234 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstddef>
+
+#include "gl_ext.h"
+
+// 环形缓冲: 每帧变化的数据(uniform 顶点 实例数据)都从这里分配
+//
+// glBufferSubData 改写GPU可能还在读的缓冲时 驱动要么等待GPU(隐式同步) 要么另外复制一份
+// 这里用一个缓冲分成 REGIONS 份 每帧轮流写其中一份
+// 每份在提交绘制后插入一个fence 下一次写这份之前等待它 GPU用完之前CPU不会改写
+// CPU最多领先GPU REGIONS - 1 帧 正常情况下fence早已完成 等待不会发生
+//
+// 支持 GL 4.4 / GL_ARB_buffer_storage 时缓冲只映射一次(GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+// 写入的数据不需要解除映射就对GPU可见
+// 否则每帧用 GL_MAP_UNSYNCHRONIZED_BIT 映射自己的那一份 同步仍然由fence保证
+//
+// 每帧的用法:
+//   ring.Begin();                               等待这一份的fence
+//   RingAllocation a = ring.Allocate(size);     写入 a.Data
+//   ring.Flush();                               绘制之前调用 退回路径在这里解除映射
+//   ... 绘制 使用 a.Offset ...
+//   ring.End();                                 插入fence
+
+struct RingAllocation {
+    void *Data;          // 写入的地址 分配失败时为NULL
+    GLintptr Offset;     // 在缓冲中的偏移 用于 glBindBufferRange glVertexAttribPointer 等
+    GLsizeiptr Size;
+};
+
+// 累计的统计 ResetStats 清零
+struct RingBufferStats {
+    unsigned int frames;
+    unsigned int stalls;      // Begin 时fence还没有完成的次数
+    double stallMs;           // 等待fence的总时间
+    size_t bytes;             // 分配出去的字节数
+    unsigned int overflows;   // 一帧的数据超过 RegionSize 而分配失败的次数
+};
+
+class RingBuffer
+{
+public:
+    static const unsigned int REGIONS = 3;
+
+    unsigned int ID;
+    GLenum Target;
+    // 每一份的大小 整个缓冲为 REGIONS * RegionSize
+    GLsizeiptr RegionSize;
+    bool Persistent;
+
+    // target 决定创建时绑定的目标 以及uniform缓冲的偏移对齐
+    // 数据可以用于任何目标 比如同一个缓冲同时放uniform和实例数据
+    RingBuffer(GLenum target, GLsizeiptr regionSize) : Target(target), RegionSize(regionSize), region(0), offset(0), mapped(NULL)
+    {
+        Persistent = glext.BufferStorage;
+        for (unsigned int i = 0; i < REGIONS; i++)
+            fences[i] = 0;
+        memset(&stats, 0, sizeof(stats));
+
+        // uniform缓冲绑定的偏移必须是 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 的倍数
+        GLint uniformAlignment = 16;
+        if (target == GL_UNIFORM_BUFFER)
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        minAlignment = uniformAlignment > 16 ? (GLsizeiptr)uniformAlignment : 16;
+        RegionSize = (RegionSize + minAlignment - 1) / minAlignment * minAlignment;
+
+        glGenBuffers(1, &ID);
+        glBindBuffer(Target, ID);
+        GLsizeiptr total = RegionSize * REGIONS;
+        if (Persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glext.BufferStorageFn(Target, total, NULL, flags);
+            mapped = (char*)glMapBufferRange(Target, 0, total, flags);
+            if (mapped == NULL)
+                std::cout << "ERROR::RING_BUFFER::MAP_FAILED" << std::endl;
+        }
+        else
+        {
+            glBufferData(Target, total, NULL, GL_STREAM_DRAW);
+        }
+        glBindBuffer(Target, 0);
+        // 第一帧 Begin 时前进到第0份
+        region = REGIONS - 1;
+        frameMapped = false;
+    }
+
+    ~RingBuffer()
+    {
+        for (unsigned int i = 0; i < REGIONS; i++)
+        {
+            if (fences[i])
+                glDeleteSync(fences[i]);
+        }
+        if ((Persistent && mapped) || frameMapped)
+        {
+            glBindBuffer(Target, ID);
+            glUnmapBuffer(Target);
+            glBindBuffer(Target, 0);
+        }
+        glDeleteBuffers(1, &ID);
+    }
+
+    // 开始新的一帧 切换到下一份并等待GPU用完它
+    void Begin()
+    {
+        region = (region + 1) % REGIONS;
+        offset = 0;
+        stats.frames++;
+        if (fences[region])
+        {
+            GLenum result = glClientWaitSync(fences[region], 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                auto start = std::chrono::steady_clock::now();
+                while (result == GL_TIMEOUT_EXPIRED)
+                    result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                stats.stalls++;
+                stats.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        if (!Persistent)
+        {
+            // fence已经保证GPU不再读这一份 不需要驱动再同步
+            glBindBuffer(Target, ID);
+            mapped = (char*)glMapBufferRange(Target, RegionOffset(), RegionSize,
+                                             GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            glBindBuffer(Target, 0);
+            frameMapped = mapped != NULL;
+        }
+    }
+
+    // 在当前这一份中分配 空间不够时 Data 为NULL
+    // alignment 为2的幂 uniform缓冲至少按 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 对齐
+    RingAllocation Allocate(GLsizeiptr size, GLsizeiptr alignment = 16)
+    {
+        RingAllocation allocation;
+        allocation.Data = NULL;
+        allocation.Offset = 0;
+        allocation.Size = size;
+        if (alignment < minAlignment)
+            alignment = minAlignment;
+        GLsizeiptr aligned = (offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + size > RegionSize || mapped == NULL)
+        {
+            stats.overflows++;
+            return allocation;
+        }
+        offset = aligned + size;
+        allocation.Offset = RegionOffset() + aligned;
+        // 持久映射的地址对应整个缓冲 退回路径只映射了这一份
+        allocation.Data = Persistent ? mapped + allocation.Offset : mapped + aligned;
+        stats.bytes += (size_t)size;
+        return allocation;
+    }
+
+    // 分配并复制
+    RingAllocation Write(const void *data, GLsizeiptr size, GLsizeiptr alignment = 16)
+    {
+        RingAllocation allocation = Allocate(size, alignment);
+        if (allocation.Data)
+            memcpy(allocation.Data, data, (size_t)size);
+        return allocation;
+    }
+
+    // 绘制之前调用 持久映射时什么都不做
+    void Flush()
+    {
+        if (!Persistent && frameMapped)
+        {
+            glBindBuffer(Target, ID);
+            glUnmapBuffer(Target);
+            glBindBuffer(Target, 0);
+            frameMapped = false;
+            mapped = NULL;
+        }
+    }
+
+    // 使用这一帧数据的绘制都提交之后调用
+    void End()
+    {
+        Flush();
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // 把一块分配绑定到uniform块的绑定点上
+    void BindRange(GLuint index, const RingAllocation &allocation) const
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, index, ID, allocation.Offset, allocation.Size);
+    }
+
+    // 当前这一份已经用掉的字节数
+    GLsizeiptr Used() const
+    {
+        return offset;
+    }
+
+    const RingBufferStats &Stats() const
+    {
+        return stats;
+    }
+
+    void ResetStats()
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+private:
+    unsigned int region;
+    GLsizeiptr offset;
+    GLsizeiptr minAlignment;
+    char *mapped;
+    bool frameMapped;
+    GLsync fences[REGIONS];
+    RingBufferStats stats;
+
+    GLintptr RegionOffset() const
+    {
+        return (GLintptr)region * RegionSize;
+    }
+
+    RingBuffer(const RingBuffer&);
+    RingBuffer &operator=(const RingBuffer&);
+};
+
+#endif
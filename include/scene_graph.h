@@ -0,0 +1,154 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+// 层级场景
+//
+// 章节中的场景是平的数组(cubePositions pointLightPositions) 没有父子关系
+// SceneGraph 的节点放在连续的数组中 父节点总是排在子节点之前:
+//   AddNode 只能挂到已有的节点下 新节点追加在数组末尾 顺序自然满足
+// 每个节点存局部的平移 旋转 缩放 世界矩阵 = 父节点的世界矩阵 * T * R * S
+//
+// 改了局部变换的节点标记为 dirty Update 从第一个 dirty 的节点起顺序扫一遍数组:
+//   节点自己 dirty 或父节点这一次重算过 就重算 并记下这一次的编号
+// 父节点在前 扫到子节点时父节点已经是新的 变化沿着数组向下传播 只有变化的子树重算
+// 没有递归和指针 只有两个数组按下标访问 第一个 dirty 之前的节点都不用看
+
+const unsigned int SCENE_NO_PARENT = 0xffffffffu;
+
+class SceneGraph
+{
+public:
+    SceneGraph() : firstDirty(SCENE_NO_PARENT), generation(0)
+    {
+    }
+
+    void Reserve(unsigned int count)
+    {
+        parent.reserve(count);
+        localPosition.reserve(count);
+        localRotation.reserve(count);
+        localScale.reserve(count);
+        world.reserve(count);
+        dirty.reserve(count);
+        updated.reserve(count);
+    }
+
+    // parent 为 SCENE_NO_PARENT 或已有的节点 返回新节点的编号
+    unsigned int AddNode(unsigned int parentIndex, const glm::vec3 &position, const glm::quat &rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                         const glm::vec3 &scale = glm::vec3(1.0f))
+    {
+        unsigned int index = Size();
+        parent.push_back(parentIndex < index ? parentIndex : SCENE_NO_PARENT);
+        localPosition.push_back(position);
+        localRotation.push_back(rotation);
+        localScale.push_back(scale);
+        world.push_back(glm::mat4(1.0f));
+        dirty.push_back(0);
+        updated.push_back(0);
+        MarkDirty(index);
+        return index;
+    }
+
+    unsigned int Size() const
+    {
+        return (unsigned int)parent.size();
+    }
+
+    unsigned int Parent(unsigned int i) const { return parent[i]; }
+    const glm::vec3 &LocalPosition(unsigned int i) const { return localPosition[i]; }
+    const glm::quat &LocalRotation(unsigned int i) const { return localRotation[i]; }
+    const glm::vec3 &LocalScale(unsigned int i) const { return localScale[i]; }
+
+    void SetLocalPosition(unsigned int i, const glm::vec3 &position)
+    {
+        localPosition[i] = position;
+        MarkDirty(i);
+    }
+
+    void SetLocalRotation(unsigned int i, const glm::quat &rotation)
+    {
+        localRotation[i] = rotation;
+        MarkDirty(i);
+    }
+
+    void SetLocalScale(unsigned int i, const glm::vec3 &scale)
+    {
+        localScale[i] = scale;
+        MarkDirty(i);
+    }
+
+    // 上一次 Update 之后的世界矩阵
+    const glm::mat4 &World(unsigned int i) const { return world[i]; }
+    glm::vec3 WorldPosition(unsigned int i) const { return glm::vec3(world[i][3]); }
+
+    // 局部变换的矩阵 T * R * S
+    glm::mat4 Local(unsigned int i) const
+    {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), localPosition[i]);
+        model = model * glm::mat4_cast(localRotation[i]);
+        return glm::scale(model, localScale[i]);
+    }
+
+    // 重算变化的节点的世界矩阵 返回重算的节点数
+    unsigned int Update()
+    {
+        if (firstDirty == SCENE_NO_PARENT)
+            return 0;
+        generation++;
+        unsigned int count = 0;
+        unsigned int size = Size();
+        for (unsigned int i = firstDirty; i < size; i++)
+        {
+            unsigned int p = parent[i];
+            bool parentChanged = p != SCENE_NO_PARENT && updated[p] == generation;
+            if (!dirty[i] && !parentChanged)
+                continue;
+            world[i] = p == SCENE_NO_PARENT ? Local(i) : world[p] * Local(i);
+            dirty[i] = 0;
+            updated[i] = generation;
+            count++;
+        }
+        firstDirty = SCENE_NO_PARENT;
+        return count;
+    }
+
+    // 不看 dirty 全部重算 用于对比和检查
+    void UpdateAll()
+    {
+        unsigned int size = Size();
+        for (unsigned int i = 0; i < size; i++)
+        {
+            unsigned int p = parent[i];
+            world[i] = p == SCENE_NO_PARENT ? Local(i) : world[p] * Local(i);
+            dirty[i] = 0;
+        }
+        firstDirty = SCENE_NO_PARENT;
+    }
+
+private:
+    std::vector<unsigned int> parent;
+    std::vector<glm::vec3> localPosition;
+    std::vector<glm::quat> localRotation;
+    std::vector<glm::vec3> localScale;
+    std::vector<glm::mat4> world;
+    std::vector<unsigned char> dirty;
+    // 最近一次重算时 Update 的编号 子节点用它判断父节点这一次是否变了
+    std::vector<unsigned int> updated;
+    unsigned int firstDirty;
+    unsigned int generation;
+
+    void MarkDirty(unsigned int i)
+    {
+        dirty[i] = 1;
+        if (firstDirty == SCENE_NO_PARENT || i < firstDirty)
+            firstDirty = i;
+    }
+};
+
+#endif
@@ -14,7 +14,9 @@ class Shader
 public:
     unsigned int ID;
 
-    Shader(const char* vertexPath, const char* fragmentPath)
+    // defines 不为NULL时插在两个着色器的 #version 这一行之后 比如 "#define MAX_LIGHTS 8\n"
+    // 同一份源码可以编译出几个变体
+    Shader(const char* vertexPath, const char* fragmentPath, const char* defines = NULL)
     {
         std::string vertexCode;
         std::string fragmentCode;
@@ -42,6 +44,11 @@ public:
         {
             std::cout << "ERROR:SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
+        if (defines)
+        {
+            vertexCode.insert(vertexCode.find('\n', vertexCode.find("#version")) + 1, defines);
+            fragmentCode.insert(fragmentCode.find('\n', fragmentCode.find("#version")) + 1, defines);
+        }
         const char* vShaderCode = vertexCode.c_str();
         const char* fShaderCode = fragmentCode.c_str();
 
@@ -0,0 +1,87 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define SIMD_AVX512 1
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_SSE 1
+#endif
+
+// 一个SIMD寄存器的float的简单封装 phong_simd.h 的光照和 transform_simd.h 的矩阵共用
+//
+// SimdFloat 是一个寄存器的 SIMD_WIDTH 个float 只有加减乘除 最小最大和开方 每种指令集写一遍
+//   -mavx512f  16个
+//   -mavx2     8个
+//   默认       SSE2 4个 都没有时是一个float
+// 用到AVX的函数结束前调用 _mm256_zeroupper 之后的SSE代码不会因为高位不干净而变慢
+
+// SoA数组的长度补齐到 SIMD_BLOCK 的倍数 任何宽度都不需要处理剩下的几个元素
+const size_t SIMD_BLOCK = 16;
+
+#if defined(SIMD_AVX512)
+const size_t SIMD_WIDTH = 16;
+struct SimdFloat { __m512 v; };
+inline SimdFloat SimdSet(float x) { return { _mm512_set1_ps(x) }; }
+inline SimdFloat SimdLoad(const float *p) { return { _mm512_loadu_ps(p) }; }
+inline void SimdStore(float *p, SimdFloat a) { _mm512_storeu_ps(p, a.v); }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm512_add_ps(a.v, b.v) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm512_sub_ps(a.v, b.v) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm512_mul_ps(a.v, b.v) }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm512_div_ps(a.v, b.v) }; }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return { _mm512_min_ps(a.v, b.v) }; }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return { _mm512_max_ps(a.v, b.v) }; }
+inline SimdFloat SimdSqrt(SimdFloat a) { return { _mm512_sqrt_ps(a.v) }; }
+inline const char *SimdName() { return "AVX-512"; }
+#elif defined(SIMD_AVX2)
+const size_t SIMD_WIDTH = 8;
+struct SimdFloat { __m256 v; };
+inline SimdFloat SimdSet(float x) { return { _mm256_set1_ps(x) }; }
+inline SimdFloat SimdLoad(const float *p) { return { _mm256_loadu_ps(p) }; }
+inline void SimdStore(float *p, SimdFloat a) { _mm256_storeu_ps(p, a.v); }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline SimdFloat SimdSqrt(SimdFloat a) { return { _mm256_sqrt_ps(a.v) }; }
+inline const char *SimdName() { return "AVX2"; }
+#elif defined(SIMD_SSE)
+const size_t SIMD_WIDTH = 4;
+struct SimdFloat { __m128 v; };
+inline SimdFloat SimdSet(float x) { return { _mm_set1_ps(x) }; }
+inline SimdFloat SimdLoad(const float *p) { return { _mm_loadu_ps(p) }; }
+inline void SimdStore(float *p, SimdFloat a) { _mm_storeu_ps(p, a.v); }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm_add_ps(a.v, b.v) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm_div_ps(a.v, b.v) }; }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return { _mm_min_ps(a.v, b.v) }; }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return { _mm_max_ps(a.v, b.v) }; }
+inline SimdFloat SimdSqrt(SimdFloat a) { return { _mm_sqrt_ps(a.v) }; }
+inline const char *SimdName() { return "SSE2"; }
+#else
+const size_t SIMD_WIDTH = 1;
+struct SimdFloat { float v; };
+inline SimdFloat SimdSet(float x) { return { x }; }
+inline SimdFloat SimdLoad(const float *p) { return { *p }; }
+inline void SimdStore(float *p, SimdFloat a) { *p = a.v; }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { a.v + b.v }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { a.v - b.v }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { a.v * b.v }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { a.v / b.v }; }
+inline SimdFloat SimdMin(SimdFloat a, SimdFloat b) { return { a.v < b.v ? a.v : b.v }; }
+inline SimdFloat SimdMax(SimdFloat a, SimdFloat b) { return { a.v > b.v ? a.v : b.v }; }
+inline SimdFloat SimdSqrt(SimdFloat a) { return { sqrtf(a.v) }; }
+inline const char *SimdName() { return "scalar"; }
+#endif
+
+#endif
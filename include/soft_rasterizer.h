@@ -0,0 +1,487 @@
+#ifndef SOFT_RASTERIZER_H
+#define SOFT_RASTERIZER_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SOFT_RASTERIZER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SOFT_RASTERIZER_SSE 1
+#endif
+
+#include "thread_pool.h"
+
+// CPU上的软件光栅化
+//
+// 没有GPU的构建机只有llvmpipe 它把整个OpenGL管线放在CPU上 看不出时间花在哪里
+// 这里只实现章节用到的部分: 三角形 裁剪 深度测试(GL_LESS) 透视校正的插值 不混合
+// 顶点着色器和片段着色器由章节用C++写 见 28_1
+//
+// 每帧的步骤:
+//   1. 章节把顶点着色器的输出(裁剪空间的位置和varying)放进 Triangles 可以在多个线程中填写不同的三角形
+//   2. Render 把三角形分成每段 CHUNK 个 每段由一个线程裁剪 设置边函数 分到覆盖的块(tile 64x64像素)
+//   3. 每一块由一个线程光栅化 按提交的顺序遍历各段分到这一块的三角形
+//      块之间没有共享的像素 深度缓冲和颜色缓冲都不需要加锁 结果与线程数无关
+//
+// 一行像素的边函数和深度测试 编译时打开AVX2(-mavx2)时一次算8个像素 否则用SSE2一次4个
+// 通过深度测试的像素再逐个插值varying 调用片段着色器
+//
+// 坐标与OpenGL相同: 像素中心在 +0.5 第0行在下面 边上的像素按左上规则只属于一个三角形
+
+const unsigned int SOFT_MAX_VARYINGS = 8;
+
+struct SoftVertex {
+    glm::vec4 position;                   // gl_Position
+    float varyings[SOFT_MAX_VARYINGS];
+};
+
+struct SoftTriangle {
+    SoftVertex vertices[3];
+    unsigned int draw;                    // 传给片段着色器 区分不同的物体和材质
+};
+
+struct SoftRasterizerStats {
+    double setupMs;                       // 裁剪 三角形设置和分块
+    double rasterMs;                      // 光栅化和片段着色
+    unsigned int triangles;               // 提交的三角形
+    unsigned int setupTriangles;          // 裁剪和剔除之后
+    unsigned long long fragments;         // 通过深度测试 运行了片段着色器的像素
+};
+
+// 贴图 与 GL_LINEAR 和 GL_REPEAT 相同 不用mipmap
+// 数据的第一行是 t = 0 与 glTexImage2D 相同
+class SoftTexture
+{
+public:
+    int Width, Height;
+
+    SoftTexture() : Width(0), Height(0)
+    {
+    }
+
+    // channels 为 1 3 4 只用前三个分量 与12_1上传为 GL_RGB 相同
+    SoftTexture(const unsigned char *data, int width, int height, int channels) : Width(width), Height(height)
+    {
+        texels.resize((size_t)width * height);
+        for (size_t i = 0; i < texels.size(); i++)
+        {
+            const unsigned char *p = data + i * channels;
+            texels[i] = channels >= 3 ? glm::vec3(p[0], p[1], p[2]) / 255.0f : glm::vec3(p[0] / 255.0f, 0.0f, 0.0f);
+        }
+    }
+
+    glm::vec3 Sample(const glm::vec2 &uv) const
+    {
+        float u = uv.x * Width - 0.5f;
+        float v = uv.y * Height - 0.5f;
+        float fu = floorf(u), fv = floorf(v);
+        float s = u - fu, t = v - fv;
+        int x0 = Wrap((int)fu, Width), x1 = Wrap((int)fu + 1, Width);
+        int y0 = Wrap((int)fv, Height), y1 = Wrap((int)fv + 1, Height);
+        glm::vec3 bottom = glm::mix(texels[y0 * Width + x0], texels[y0 * Width + x1], s);
+        glm::vec3 top = glm::mix(texels[y1 * Width + x0], texels[y1 * Width + x1], s);
+        return glm::mix(bottom, top, t);
+    }
+
+private:
+    std::vector<glm::vec3> texels;
+
+    static int Wrap(int i, int size)
+    {
+        i %= size;
+        return i < 0 ? i + size : i;
+    }
+};
+
+class SoftRasterizer
+{
+public:
+    static const unsigned int TILE_SIZE = 64;
+    static const unsigned int CHUNK = 1024;
+
+    unsigned int Width, Height;
+    unsigned int Varyings;                 // 每个顶点用到的varying个数
+    bool CullBackFaces;                    // 与 glEnable(GL_CULL_FACE) 相同 默认两面都画
+    std::vector<SoftTriangle> Triangles;
+
+    SoftRasterizer(unsigned int width, unsigned int height, unsigned int varyings)
+        : Width(width), Height(height), Varyings(varyings), CullBackFaces(false)
+    {
+        tilesX = (Width + TILE_SIZE - 1) / TILE_SIZE;
+        tilesY = (Height + TILE_SIZE - 1) / TILE_SIZE;
+        // 每行补齐到块的宽度 一次读写一段像素时不会越过这一行
+        stride = tilesX * TILE_SIZE;
+        depth.resize((size_t)stride * Height);
+        color.resize((size_t)stride * Height * 3);
+        tileFragments.resize(tilesX * tilesY);
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void Clear(const glm::vec3 &clearColor)
+    {
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        unsigned char rgb[3];
+        for (int c = 0; c < 3; c++)
+            rgb[c] = ToUnorm8(clearColor[c]);
+        for (size_t i = 0; i < color.size(); i += 3)
+            memcpy(&color[i], rgb, 3);
+    }
+
+    // shader(draw, varyings) 返回片段的颜色 与 FragColor.rgb 相同 由多个线程同时调用
+    // pool 为NULL时在当前线程完成
+    template<class FragmentShader>
+    void Render(const FragmentShader &shader, ThreadPool *pool)
+    {
+        memset(&stats, 0, sizeof(stats));
+        stats.triangles = (unsigned int)Triangles.size();
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned int chunks = (stats.triangles + CHUNK - 1) / CHUNK;
+        if (chunkSetup.size() < chunks)
+        {
+            chunkSetup.resize(chunks);
+            chunkBins.resize(chunks);
+        }
+        auto setupChunk = [&](unsigned int chunk, unsigned int) {
+            SetupChunk(chunk);
+        };
+        if (pool)
+            pool->Run(chunks, setupChunk);
+        else
+            for (unsigned int c = 0; c < chunks; c++)
+                setupChunk(c, 0);
+        for (unsigned int c = 0; c < chunks; c++)
+            stats.setupTriangles += (unsigned int)chunkSetup[c].size();
+        auto rasterStart = std::chrono::steady_clock::now();
+        stats.setupMs = std::chrono::duration<double, std::milli>(rasterStart - start).count();
+
+        unsigned int tiles = tilesX * tilesY;
+        auto rasterizeTile = [&](unsigned int tile, unsigned int) {
+            tileFragments[tile] = 0;
+            for (unsigned int c = 0; c < chunks; c++)
+            {
+                const std::vector<unsigned int> &bin = chunkBins[c][tile];
+                for (size_t i = 0; i < bin.size(); i++)
+                    RasterizeTriangle(chunkSetup[c][bin[i]], tile, shader);
+            }
+        };
+        if (pool)
+            pool->Run(tiles, rasterizeTile);
+        else
+            for (unsigned int t = 0; t < tiles; t++)
+                rasterizeTile(t, 0);
+        for (unsigned int t = 0; t < tiles; t++)
+            stats.fragments += tileFragments[t];
+        stats.rasterMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - rasterStart).count();
+    }
+
+    // 像素 (x, y) 的颜色 第0行在下面
+    const unsigned char *Pixel(unsigned int x, unsigned int y) const
+    {
+        return &color[((size_t)y * stride + x) * 3];
+    }
+
+    // 与 headless.h 的截图相同 PPM从上到下
+    bool SavePPM(const char *path) const
+    {
+        FILE *file = fopen(path, "wb");
+        if (!file)
+            return false;
+        fprintf(file, "P6\n%u %u\n255\n", Width, Height);
+        for (unsigned int y = Height; y-- > 0; )
+            fwrite(Pixel(0, y), 1, (size_t)Width * 3, file);
+        fclose(file);
+        return true;
+    }
+
+    const SoftRasterizerStats &Stats() const
+    {
+        return stats;
+    }
+
+private:
+#if defined(SOFT_RASTERIZER_AVX2)
+    static const unsigned int LANES = 8;
+#else
+    static const unsigned int LANES = 4;
+#endif
+
+    // 屏幕空间的三角形 逆时针 像素坐标
+    // 边 i 从顶点 i 到 i+1: E(x, y) = a[i] * (x - x[i]) + b[i] * (y - y[i])
+    // 三条边的和是两倍的面积 E[i] / area 就是对面顶点 (i+2)%3 的重心坐标
+    struct Setup {
+        float x[3], y[3];
+        float a[3], b[3];
+        bool topLeft[3];
+        float invArea;
+        float z[3];                               // 窗口空间的深度 0到1 在屏幕空间线性插值
+        float invW[3];
+        float varyings[3][SOFT_MAX_VARYINGS];     // 已经除以w 透视校正时线性插值
+        int minX, maxX, minY, maxY;               // 覆盖的像素中心
+        unsigned int draw;
+    };
+
+    unsigned int tilesX, tilesY, stride;
+    std::vector<float> depth;
+    std::vector<unsigned char> color;
+    std::vector<std::vector<Setup> > chunkSetup;
+    std::vector<std::vector<std::vector<unsigned int> > > chunkBins;   // [段][块] 三角形在段中的编号
+    std::vector<unsigned long long> tileFragments;
+    SoftRasterizerStats stats;
+
+    static unsigned char ToUnorm8(float value)
+    {
+        return (unsigned char)(fminf(fmaxf(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    void SetupChunk(unsigned int chunk)
+    {
+        std::vector<Setup> &setup = chunkSetup[chunk];
+        std::vector<std::vector<unsigned int> > &bins = chunkBins[chunk];
+        setup.clear();
+        bins.resize(tilesX * tilesY);
+        for (size_t i = 0; i < bins.size(); i++)
+            bins[i].clear();
+        size_t first = (size_t)chunk * CHUNK;
+        size_t last = std::min(first + CHUNK, Triangles.size());
+        for (size_t i = first; i < last; i++)
+            ClipTriangle(Triangles[i], setup, bins);
+    }
+
+    // 按近平面 z >= -w 和远平面 z <= w 裁剪 x y 超出屏幕的部分由边函数处理
+    void ClipTriangle(const SoftTriangle &triangle, std::vector<Setup> &setup, std::vector<std::vector<unsigned int> > &bins)
+    {
+        SoftVertex polygon[2][5];
+        int count = 3;
+        bool inside = true;
+        for (int i = 0; i < 3; i++)
+        {
+            polygon[0][i] = triangle.vertices[i];
+            const glm::vec4 &p = triangle.vertices[i].position;
+            inside = inside && p.z >= -p.w && p.z <= p.w;
+        }
+        int current = 0;
+        if (!inside)
+        {
+            for (int plane = 0; plane < 2 && count >= 3; plane++)
+            {
+                const SoftVertex *in = polygon[current];
+                SoftVertex *out = polygon[1 - current];
+                int outCount = 0;
+                for (int i = 0; i < count; i++)
+                {
+                    const SoftVertex &p = in[i];
+                    const SoftVertex &q = in[(i + 1) % count];
+                    float dp = plane == 0 ? p.position.z + p.position.w : p.position.w - p.position.z;
+                    float dq = plane == 0 ? q.position.z + q.position.w : q.position.w - q.position.z;
+                    if (dp >= 0.0f)
+                        out[outCount++] = p;
+                    if ((dp >= 0.0f) != (dq >= 0.0f))
+                    {
+                        float t = dp / (dp - dq);
+                        SoftVertex &v = out[outCount++];
+                        v.position = p.position + (q.position - p.position) * t;
+                        for (unsigned int k = 0; k < Varyings; k++)
+                            v.varyings[k] = p.varyings[k] + (q.varyings[k] - p.varyings[k]) * t;
+                    }
+                }
+                count = outCount;
+                current = 1 - current;
+            }
+        }
+        for (int i = 2; i < count; i++)
+            SetupTriangle(polygon[current][0], polygon[current][i - 1], polygon[current][i], triangle.draw, setup, bins);
+    }
+
+    void SetupTriangle(const SoftVertex &v0, const SoftVertex &v1, const SoftVertex &v2, unsigned int draw,
+                       std::vector<Setup> &setup, std::vector<std::vector<unsigned int> > &bins)
+    {
+        const SoftVertex *v[3] = { &v0, &v1, &v2 };
+        Setup t;
+        for (int i = 0; i < 3; i++)
+        {
+            float invW = 1.0f / v[i]->position.w;
+            t.x[i] = (v[i]->position.x * invW * 0.5f + 0.5f) * Width;
+            t.y[i] = (v[i]->position.y * invW * 0.5f + 0.5f) * Height;
+            t.z[i] = v[i]->position.z * invW * 0.5f + 0.5f;
+            t.invW[i] = invW;
+        }
+        float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.x[2] - t.x[0]) * (t.y[1] - t.y[0]);
+        if (area == 0.0f || !(area == area))
+            return;
+        if (area < 0.0f)
+        {
+            if (CullBackFaces)
+                return;
+            // 背面换成逆时针 边函数仍然在内部为正
+            std::swap(v[1], v[2]);
+            std::swap(t.x[1], t.x[2]);
+            std::swap(t.y[1], t.y[2]);
+            std::swap(t.z[1], t.z[2]);
+            std::swap(t.invW[1], t.invW[2]);
+            area = -area;
+        }
+        t.invArea = 1.0f / area;
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3;
+            t.a[i] = t.y[i] - t.y[j];
+            t.b[i] = t.x[j] - t.x[i];
+            // y向上的逆时针三角形 向下的边是左边 向左的水平边是上边
+            t.topLeft[i] = t.a[i] > 0.0f || (t.a[i] == 0.0f && t.b[i] < 0.0f);
+            for (unsigned int k = 0; k < Varyings; k++)
+                t.varyings[i][k] = v[i]->varyings[k] * t.invW[i];
+        }
+
+        // 像素中心 i + 0.5 在 [min, max] 内的像素
+        float minX = fminf(fminf(t.x[0], t.x[1]), t.x[2]);
+        float maxX = fmaxf(fmaxf(t.x[0], t.x[1]), t.x[2]);
+        float minY = fminf(fminf(t.y[0], t.y[1]), t.y[2]);
+        float maxY = fmaxf(fmaxf(t.y[0], t.y[1]), t.y[2]);
+        t.minX = (int)ceilf(fmaxf(minX - 0.5f, 0.0f));
+        t.maxX = (int)floorf(fminf(maxX - 0.5f, Width - 1.0f));
+        t.minY = (int)ceilf(fmaxf(minY - 0.5f, 0.0f));
+        t.maxY = (int)floorf(fminf(maxY - 0.5f, Height - 1.0f));
+        if (t.minX > t.maxX || t.minY > t.maxY)
+            return;
+        t.draw = draw;
+
+        unsigned int index = (unsigned int)setup.size();
+        setup.push_back(t);
+        for (int ty = t.minY / (int)TILE_SIZE; ty <= t.maxY / (int)TILE_SIZE; ty++)
+            for (int tx = t.minX / (int)TILE_SIZE; tx <= t.maxX / (int)TILE_SIZE; tx++)
+                bins[ty * tilesX + tx].push_back(index);
+    }
+
+    // 从 x 开始的 LANES 个像素: 边函数放进 e 深度放进 z 返回在三角形内并通过深度测试的像素
+    static unsigned int EvaluateSegment(const Setup &t, int x, int y, const float *depthRow, float e[3][LANES], float z[LANES])
+    {
+        float py = y + 0.5f;
+#if defined(SOFT_RASTERIZER_AVX2)
+        __m256 px = _mm256_add_ps(_mm256_set1_ps(x + 0.5f), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+        __m256 zero = _mm256_setzero_ps();
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        __m256 edges[3];
+        for (int i = 0; i < 3; i++)
+        {
+            edges[i] = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(t.a[i]), _mm256_sub_ps(px, _mm256_set1_ps(t.x[i]))),
+                                     _mm256_set1_ps(t.b[i] * (py - t.y[i])));
+            inside = _mm256_and_ps(inside, t.topLeft[i] ? _mm256_cmp_ps(edges[i], zero, _CMP_GE_OQ) : _mm256_cmp_ps(edges[i], zero, _CMP_GT_OQ));
+        }
+        // 返回前清掉ymm寄存器的高半部分 片段着色器调用的库函数可能是不带VEX的SSE代码 否则每次切换都有很大的代价
+        if (_mm256_movemask_ps(inside) == 0)
+        {
+            _mm256_zeroupper();
+            return 0;
+        }
+        __m256 invArea = _mm256_set1_ps(t.invArea);
+        __m256 depthValue = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(
+            _mm256_mul_ps(edges[1], _mm256_set1_ps(t.z[0])),
+            _mm256_mul_ps(edges[2], _mm256_set1_ps(t.z[1]))),
+            _mm256_mul_ps(edges[0], _mm256_set1_ps(t.z[2]))), invArea);
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(depthValue, _mm256_loadu_ps(depthRow + x), _CMP_LT_OQ));
+        for (int i = 0; i < 3; i++)
+            _mm256_storeu_ps(e[i], edges[i]);
+        _mm256_storeu_ps(z, depthValue);
+        unsigned int bits = (unsigned int)_mm256_movemask_ps(inside);
+        _mm256_zeroupper();
+        return bits;
+#elif defined(SOFT_RASTERIZER_SSE)
+        __m128 px = _mm_add_ps(_mm_set1_ps(x + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+        __m128 zero = _mm_setzero_ps();
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128 edges[3];
+        for (int i = 0; i < 3; i++)
+        {
+            edges[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.a[i]), _mm_sub_ps(px, _mm_set1_ps(t.x[i]))),
+                                  _mm_set1_ps(t.b[i] * (py - t.y[i])));
+            inside = _mm_and_ps(inside, t.topLeft[i] ? _mm_cmpge_ps(edges[i], zero) : _mm_cmpgt_ps(edges[i], zero));
+        }
+        if (_mm_movemask_ps(inside) == 0)
+            return 0;
+        __m128 invArea = _mm_set1_ps(t.invArea);
+        __m128 depthValue = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(edges[1], _mm_set1_ps(t.z[0])),
+            _mm_mul_ps(edges[2], _mm_set1_ps(t.z[1]))),
+            _mm_mul_ps(edges[0], _mm_set1_ps(t.z[2]))), invArea);
+        inside = _mm_and_ps(inside, _mm_cmplt_ps(depthValue, _mm_loadu_ps(depthRow + x)));
+        for (int i = 0; i < 3; i++)
+            _mm_storeu_ps(e[i], edges[i]);
+        _mm_storeu_ps(z, depthValue);
+        return (unsigned int)_mm_movemask_ps(inside);
+#else
+        unsigned int bits = 0;
+        for (unsigned int lane = 0; lane < LANES; lane++)
+        {
+            float px = x + lane + 0.5f;
+            bool inside = true;
+            for (int i = 0; i < 3; i++)
+            {
+                e[i][lane] = t.a[i] * (px - t.x[i]) + t.b[i] * (py - t.y[i]);
+                inside = inside && (t.topLeft[i] ? e[i][lane] >= 0.0f : e[i][lane] > 0.0f);
+            }
+            z[lane] = (e[1][lane] * t.z[0] + e[2][lane] * t.z[1] + e[0][lane] * t.z[2]) * t.invArea;
+            if (inside && z[lane] < depthRow[x + lane])
+                bits |= 1u << lane;
+        }
+        return bits;
+#endif
+    }
+
+    template<class FragmentShader>
+    void RasterizeTriangle(const Setup &t, unsigned int tile, const FragmentShader &shader)
+    {
+        int tileX = (tile % tilesX) * TILE_SIZE;
+        int tileY = (tile / tilesX) * TILE_SIZE;
+        int x0 = std::max(t.minX, tileX);
+        int x1 = std::min(t.maxX, tileX + (int)TILE_SIZE - 1);
+        int y0 = std::max(t.minY, tileY);
+        int y1 = std::min(t.maxY, tileY + (int)TILE_SIZE - 1);
+        // 每段从 LANES 的倍数开始 块的宽度是 LANES 的倍数 所以一段不会跨过块的边界
+        x0 -= x0 % LANES;
+
+        float e[3][LANES];
+        float z[LANES];
+        float varyings[SOFT_MAX_VARYINGS];
+        unsigned long long fragments = 0;
+        for (int y = y0; y <= y1; y++)
+        {
+            float *depthRow = &depth[(size_t)y * stride];
+            unsigned char *colorRow = &color[(size_t)y * stride * 3];
+            for (int x = x0; x <= x1; x += LANES)
+            {
+                unsigned int bits = EvaluateSegment(t, x, y, depthRow, e, z);
+                for (unsigned int lane = 0; bits; lane++, bits >>= 1)
+                {
+                    // 补齐的列不在屏幕上
+                    if (!(bits & 1u) || x + (int)lane >= (int)Width)
+                        continue;
+                    // 透视校正: 1/w 和 varying/w 在屏幕空间是线性的
+                    float l0 = e[1][lane] * t.invArea, l1 = e[2][lane] * t.invArea, l2 = e[0][lane] * t.invArea;
+                    float w = 1.0f / (l0 * t.invW[0] + l1 * t.invW[1] + l2 * t.invW[2]);
+                    for (unsigned int k = 0; k < Varyings; k++)
+                        varyings[k] = (l0 * t.varyings[0][k] + l1 * t.varyings[1][k] + l2 * t.varyings[2][k]) * w;
+                    glm::vec3 result = shader(t.draw, varyings);
+                    int px = x + lane;
+                    depthRow[px] = z[lane];
+                    colorRow[px * 3] = ToUnorm8(result.r);
+                    colorRow[px * 3 + 1] = ToUnorm8(result.g);
+                    colorRow[px * 3 + 2] = ToUnorm8(result.b);
+                    fragments++;
+                }
+            }
+        }
+        tileFragments[tile] += fragments;
+    }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// 常驻的线程池
+// 每帧都创建和销毁线程的开销太大 线程在构造时创建 没有任务时在条件变量上等待
+// 调用 Run 的线程(通常是主线程)也参与执行 编号为0
+
+class ThreadPool
+{
+public:
+    // threads 为0时使用全部核心
+    ThreadPool(unsigned int threads = 0) : job(NULL), total(0), generation(0), pending(0), stopping(false)
+    {
+        if (threads == 0)
+            threads = std::thread::hardware_concurrency();
+        if (threads == 0)
+            threads = 1;
+        for (unsigned int i = 1; i < threads; i++)
+            workers.push_back(std::thread(&ThreadPool::Work, this, i));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    // 线程数(包括调用 Run 的线程)
+    unsigned int Size() const
+    {
+        return (unsigned int)workers.size() + 1;
+    }
+
+    // 对 [0, count) 中的每个编号调用 task(index, threadIndex)
+    // 每个线程每次领取一个编号 所有编号完成后才返回
+    void Run(unsigned int count, const std::function<void(unsigned int, unsigned int)> &task)
+    {
+        if (workers.empty())
+        {
+            for (unsigned int i = 0; i < count; i++)
+                task(i, 0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            total = count;
+            next.store(0);
+            pending = (unsigned int)workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        Drain(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        job = NULL;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(unsigned int, unsigned int)> *job;
+    std::atomic<unsigned int> next;
+    unsigned int total;
+    unsigned int generation;
+    unsigned int pending;
+    bool stopping;
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool &operator=(const ThreadPool&);
+
+    void Drain(unsigned int threadIndex)
+    {
+        unsigned int i;
+        while ((i = next.fetch_add(1)) < total)
+            (*job)(i, threadIndex);
+    }
+
+    void Work(unsigned int threadIndex)
+    {
+        unsigned int seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            Drain(threadIndex);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending--;
+                if (pending == 0)
+                    done.notify_one();
+            }
+        }
+    }
+};
+
+#endif
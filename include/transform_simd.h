@@ -0,0 +1,177 @@
+#ifndef TRANSFORM_SIMD_H
+#define TRANSFORM_SIMD_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <vector>
+#include <cstddef>
+
+#include "instanced_renderer.h"
+#include "thread_pool.h"
+#include "simd.h"
+
+// 大量物体的模型矩阵和法线矩阵
+//
+// 章节中每个物体 glm::translate 再 glm::rotate 各是一次完整的4x4矩阵乘法 再算一次 inverseTranspose
+// 这里每个物体只存平移 旋转(单位四元数)和缩放 按SoA存放: 每个分量各是一个数组
+// 相邻的 SIMD_WIDTH 个物体一次算完 直接写进 InstanceData(实例缓冲的布局)
+//
+// 模型矩阵 M = T * R * S 不需要矩阵乘法:
+//   第j列 = R的第j列 * s_j    第4列 = (t, 1)
+// 法线矩阵是左上3x3的逆的转置 (R S)^-T = R^-T S^-T = R S^-1:
+//   第j列 = R的第j列 / s_j    不需要求逆
+//
+// BuildInstancesReference 逐个物体用glm算 用来检查 BuildInstances
+// BuildInstancesParallel 把物体分成 TRANSFORM_BATCH 个一组 在线程池上计算 out 可以是映射的实例缓冲
+
+// 每个任务的物体数
+const size_t TRANSFORM_BATCH = 4096;
+
+// 数组的长度补齐到 SIMD_BLOCK 的倍数 补齐的物体参与计算但不写出
+struct TransformSoA {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;  // 单位四元数
+    std::vector<float> scaleX, scaleY, scaleZ;
+    size_t Count = 0;
+
+    // 补齐的物体是单位变换
+    void Resize(size_t count)
+    {
+        Count = count;
+        size_t padded = (count + SIMD_BLOCK - 1) / SIMD_BLOCK * SIMD_BLOCK;
+        std::vector<float> *zeros[] = { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ };
+        for (size_t i = 0; i < sizeof(zeros) / sizeof(zeros[0]); i++)
+            zeros[i]->assign(padded, 0.0f);
+        std::vector<float> *ones[] = { &rotationW, &scaleX, &scaleY, &scaleZ };
+        for (size_t i = 0; i < sizeof(ones) / sizeof(ones[0]); i++)
+            ones[i]->assign(padded, 1.0f);
+    }
+
+    size_t Padded() const
+    {
+        return positionX.size();
+    }
+
+    void Set(size_t i, const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+    {
+        SetPosition(i, position);
+        SetRotation(i, rotation);
+        scaleX[i] = scale.x; scaleY[i] = scale.y; scaleZ[i] = scale.z;
+    }
+
+    void SetPosition(size_t i, const glm::vec3 &position)
+    {
+        positionX[i] = position.x; positionY[i] = position.y; positionZ[i] = position.z;
+    }
+
+    void SetRotation(size_t i, const glm::quat &rotation)
+    {
+        rotationX[i] = rotation.x; rotationY[i] = rotation.y; rotationZ[i] = rotation.z; rotationW[i] = rotation.w;
+    }
+
+    glm::vec3 Position(size_t i) const { return glm::vec3(positionX[i], positionY[i], positionZ[i]); }
+    glm::quat Rotation(size_t i) const { return glm::quat(rotationW[i], rotationX[i], rotationY[i], rotationZ[i]); }
+    glm::vec3 Scale(size_t i) const { return glm::vec3(scaleX[i], scaleY[i], scaleZ[i]); }
+};
+
+// ---------------------------------------------------------------------------
+// 逐个物体 与章节中的写法相同
+
+inline void BuildInstancesReference(const TransformSoA &transforms, InstanceData *out, size_t first, size_t last)
+{
+    if (last > transforms.Count)
+        last = transforms.Count;
+    for (size_t i = first; i < last; i++)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, transforms.Position(i));
+        model = model * glm::mat4_cast(transforms.Rotation(i));
+        model = glm::scale(model, transforms.Scale(i));
+        out[i].model = model;
+        out[i].normalMatrix = glm::inverseTranspose(glm::mat3(model));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SIMD版本
+
+// 计算 [first, last) 的物体 first 是 SIMD_BLOCK 的倍数
+// 寄存器中的结果先存到栈上的数组 再逐个物体写进 InstanceData 的25个float
+inline void BuildInstances(const TransformSoA &transforms, InstanceData *out, size_t first, size_t last)
+{
+    if (last > transforms.Count)
+        last = transforms.Count;
+
+    const SimdFloat one = SimdSet(1.0f);
+    const SimdFloat two = SimdSet(2.0f);
+    // 每个物体的输出: 模型矩阵的12个分量(最后一行总是 0 0 0 1) 法线矩阵的9个分量
+    float lanes[21][SIMD_WIDTH];
+
+    for (size_t i = first; i < last; i += SIMD_WIDTH)
+    {
+        SimdFloat x = SimdLoad(&transforms.rotationX[i]);
+        SimdFloat y = SimdLoad(&transforms.rotationY[i]);
+        SimdFloat z = SimdLoad(&transforms.rotationZ[i]);
+        SimdFloat w = SimdLoad(&transforms.rotationW[i]);
+
+        // 与 glm::mat4_cast 相同的旋转矩阵 r[列][行]
+        SimdFloat xx = x * x, yy = y * y, zz = z * z;
+        SimdFloat xy = x * y, xz = x * z, yz = y * z;
+        SimdFloat wx = w * x, wy = w * y, wz = w * z;
+        SimdFloat r[3][3] = {
+            { one - two * (yy + zz), two * (xy + wz), two * (xz - wy) },
+            { two * (xy - wz), one - two * (xx + zz), two * (yz + wx) },
+            { two * (xz + wy), two * (yz - wx), one - two * (xx + yy) }
+        };
+
+        SimdFloat scale[3] = { SimdLoad(&transforms.scaleX[i]), SimdLoad(&transforms.scaleY[i]), SimdLoad(&transforms.scaleZ[i]) };
+        for (int c = 0; c < 3; c++)
+        {
+            SimdFloat inverse = one / scale[c];
+            for (int k = 0; k < 3; k++)
+            {
+                SimdStore(lanes[c * 3 + k], r[c][k] * scale[c]);
+                SimdStore(lanes[12 + c * 3 + k], r[c][k] * inverse);
+            }
+        }
+        SimdStore(lanes[9], SimdLoad(&transforms.positionX[i]));
+        SimdStore(lanes[10], SimdLoad(&transforms.positionY[i]));
+        SimdStore(lanes[11], SimdLoad(&transforms.positionZ[i]));
+
+        size_t count = last - i < SIMD_WIDTH ? last - i : SIMD_WIDTH;
+        for (size_t j = 0; j < count; j++)
+        {
+            InstanceData &data = out[i + j];
+            for (int c = 0; c < 4; c++)
+            {
+                data.model[c][0] = lanes[c * 3][j];
+                data.model[c][1] = lanes[c * 3 + 1][j];
+                data.model[c][2] = lanes[c * 3 + 2][j];
+                data.model[c][3] = c == 3 ? 1.0f : 0.0f;
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                data.normalMatrix[c][0] = lanes[12 + c * 3][j];
+                data.normalMatrix[c][1] = lanes[12 + c * 3 + 1][j];
+                data.normalMatrix[c][2] = lanes[12 + c * 3 + 2][j];
+            }
+        }
+    }
+#if defined(SIMD_AVX512) || defined(SIMD_AVX2)
+    _mm256_zeroupper();
+#endif
+}
+
+// 在线程池上计算全部物体 每个任务 TRANSFORM_BATCH 个
+inline void BuildInstancesParallel(ThreadPool &pool, const TransformSoA &transforms, InstanceData *out)
+{
+    unsigned int batches = (unsigned int)((transforms.Count + TRANSFORM_BATCH - 1) / TRANSFORM_BATCH);
+    pool.Run(batches, [&](unsigned int batch, unsigned int) {
+        BuildInstances(transforms, out, batch * TRANSFORM_BATCH, (batch + 1) * TRANSFORM_BATCH);
+    });
+}
+
+#endif
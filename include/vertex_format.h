@@ -0,0 +1,231 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "shader_m.h"
+
+// 压缩顶点格式
+// 章节中的顶点是 3个float位置 + 3个float法线 + 2个float纹理坐标 = 32字节
+// 这里把它压缩到16字节:
+//   位置: 3个half 或 3个在包围盒内归一化的unorm16 (第四个分量只做对齐)
+//   法线: 八面体编码到两个分量 存进 GL_INT_2_10_10_10_REV
+//   纹理坐标: 2个在uv范围内归一化的unorm16
+// 解码在顶点着色器中完成
+
+enum Position_Format {
+    POSITION_HALF,
+    POSITION_UNORM16
+};
+
+struct PackedVertex {
+    uint16_t position[4];
+    uint32_t normal;
+    uint16_t texCoords[2];
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+// 八面体编码: 把单位向量投影到 |x|+|y|+|z|=1 的八面体上，再把下半部分折叠到上半部分
+inline glm::vec2 OctEncode(glm::vec3 n)
+{
+    n /= (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+    glm::vec2 e(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        e.x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        e.y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return e;
+}
+
+// 与 shader.vs 中的 OctDecode 保持一致
+inline glm::vec3 OctDecode(glm::vec2 e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = glm::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+// 10位有符号整数 [-511, 511]
+// 属性以非归一化方式读取，在着色器中除以511，避免不同GL版本对snorm转换规则的差异
+inline uint32_t PackNormal(const glm::vec3 &n)
+{
+    glm::vec2 e = OctEncode(n);
+    int x = (int)std::lround(glm::clamp(e.x, -1.0f, 1.0f) * 511.0f);
+    int y = (int)std::lround(glm::clamp(e.y, -1.0f, 1.0f) * 511.0f);
+    return ((uint32_t)x & 0x3FFu) | (((uint32_t)y & 0x3FFu) << 10);
+}
+
+inline glm::vec3 UnpackNormal(uint32_t packed)
+{
+    // 符号扩展10位整数
+    int x = (int)(packed << 22) >> 22;
+    int y = (int)(packed << 12) >> 22;
+    glm::vec2 e(glm::clamp(x / 511.0f, -1.0f, 1.0f), glm::clamp(y / 511.0f, -1.0f, 1.0f));
+    return OctDecode(e);
+}
+
+inline uint16_t PackUnorm16(float v)
+{
+    return (uint16_t)std::lround(glm::clamp(v, 0.0f, 1.0f) * 65535.0f);
+}
+
+inline float UnpackUnorm16(uint16_t v)
+{
+    return v / 65535.0f;
+}
+
+class PackedMesh
+{
+public:
+    Position_Format Format;
+    // unorm16位置的解码范围 half格式时为 (0,0,0) 与 (1,1,1)
+    glm::vec3 PositionMin;
+    glm::vec3 PositionExtent;
+    glm::vec2 TexCoordMin;
+    glm::vec2 TexCoordExtent;
+    std::vector<PackedVertex> Vertices;
+
+    // vertices 为章节里使用的交错数组 每个顶点8个float
+    PackedMesh(const float *vertices, unsigned int vertexCount, Position_Format format = POSITION_UNORM16) : Format(format)
+    {
+        glm::vec3 boundsMin(vertices[0], vertices[1], vertices[2]);
+        glm::vec3 boundsMax = boundsMin;
+        glm::vec2 uvMin(vertices[6], vertices[7]);
+        glm::vec2 uvMax = uvMin;
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const float *v = vertices + i * 8;
+            boundsMin = glm::min(boundsMin, glm::vec3(v[0], v[1], v[2]));
+            boundsMax = glm::max(boundsMax, glm::vec3(v[0], v[1], v[2]));
+            uvMin = glm::min(uvMin, glm::vec2(v[6], v[7]));
+            uvMax = glm::max(uvMax, glm::vec2(v[6], v[7]));
+        }
+        if (Format == POSITION_HALF)
+        {
+            PositionMin = glm::vec3(0.0f);
+            PositionExtent = glm::vec3(1.0f);
+        }
+        else
+        {
+            PositionMin = boundsMin;
+            PositionExtent = glm::max(boundsMax - boundsMin, glm::vec3(1e-6f));
+        }
+        TexCoordMin = uvMin;
+        TexCoordExtent = glm::max(uvMax - uvMin, glm::vec2(1e-6f));
+
+        Vertices.resize(vertexCount);
+        for (unsigned int i = 0; i < vertexCount; i++)
+        {
+            const float *v = vertices + i * 8;
+            PackedVertex &p = Vertices[i];
+            glm::vec3 pos(v[0], v[1], v[2]);
+            if (Format == POSITION_HALF)
+            {
+                for (int c = 0; c < 3; c++)
+                    p.position[c] = glm::packHalf1x16(pos[c]);
+            }
+            else
+            {
+                glm::vec3 t = (pos - PositionMin) / PositionExtent;
+                for (int c = 0; c < 3; c++)
+                    p.position[c] = PackUnorm16(t[c]);
+            }
+            p.position[3] = 0;
+            p.normal = PackNormal(glm::vec3(v[3], v[4], v[5]));
+            glm::vec2 uv = (glm::vec2(v[6], v[7]) - TexCoordMin) / TexCoordExtent;
+            p.texCoords[0] = PackUnorm16(uv.x);
+            p.texCoords[1] = PackUnorm16(uv.y);
+        }
+    }
+
+    unsigned int SizeInBytes() const
+    {
+        return (unsigned int)(Vertices.size() * sizeof(PackedVertex));
+    }
+
+    // 在已绑定的VAO与VBO上设置顶点属性指针
+    // 替代章节中的 glVertexAttribPointer(..., 8 * sizeof(float), ...)
+    void SetupAttributes() const
+    {
+        GLenum positionType = Format == POSITION_HALF ? GL_HALF_FLOAT : GL_UNSIGNED_SHORT;
+        GLboolean positionNormalized = Format == POSITION_HALF ? GL_FALSE : GL_TRUE;
+        glVertexAttribPointer(0, 3, positionType, positionNormalized, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+        glEnableVertexAttribArray(2);
+    }
+
+    // 灯只需要位置属性
+    void SetupPositionAttribute() const
+    {
+        GLenum positionType = Format == POSITION_HALF ? GL_HALF_FLOAT : GL_UNSIGNED_SHORT;
+        GLboolean positionNormalized = Format == POSITION_HALF ? GL_FALSE : GL_TRUE;
+        glVertexAttribPointer(0, 3, positionType, positionNormalized, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+        glEnableVertexAttribArray(0);
+    }
+
+    // 着色器解码所需的uniform
+    void SetDecodeUniforms(const Shader &shader) const
+    {
+        shader.setVec3("positionMin", PositionMin);
+        shader.setVec3("positionExtent", PositionExtent);
+        shader.setVec2("texCoordMin", TexCoordMin);
+        shader.setVec2("texCoordExtent", TexCoordExtent);
+    }
+
+    // 以下在CPU上模拟着色器的解码 用于误差检验
+    glm::vec3 DecodePosition(unsigned int i) const
+    {
+        const PackedVertex &p = Vertices[i];
+        glm::vec3 t;
+        for (int c = 0; c < 3; c++)
+            t[c] = Format == POSITION_HALF ? glm::unpackHalf1x16(p.position[c]) : UnpackUnorm16(p.position[c]);
+        return PositionMin + t * PositionExtent;
+    }
+
+    glm::vec3 DecodeNormal(unsigned int i) const
+    {
+        return UnpackNormal(Vertices[i].normal);
+    }
+
+    glm::vec2 DecodeTexCoords(unsigned int i) const
+    {
+        const PackedVertex &p = Vertices[i];
+        return TexCoordMin + glm::vec2(UnpackUnorm16(p.texCoords[0]), UnpackUnorm16(p.texCoords[1])) * TexCoordExtent;
+    }
+
+    // 理论误差上界
+    // unorm16: 半个量化步长; half: 10位尾数 相对误差 2^-11
+    glm::vec3 PositionErrorBound(const glm::vec3 &maxAbs) const
+    {
+        if (Format == POSITION_HALF)
+            return maxAbs * (1.0f / 2048.0f) + glm::vec3(1e-7f);
+        return PositionExtent * (0.5f / 65535.0f) + glm::vec3(1e-6f);
+    }
+
+    glm::vec2 TexCoordErrorBound() const
+    {
+        return TexCoordExtent * (0.5f / 65535.0f) + glm::vec2(1e-6f);
+    }
+
+    // 10位八面体编码的角度误差上界(弧度) 量化步长为 1/511
+    // 每个分量最多偏差半步 八面体到球面的映射最多把误差放大约 sqrt(2)*2 倍
+    static float NormalErrorBound()
+    {
+        return 2.0f * 1.41421356f * (0.5f / 511.0f) * 2.0f;
+    }
+};
+
+#endif